@@ -0,0 +1,114 @@
+/*-------------------------------------------------------------------------
+ *
+ * gp_interconnect_stats.c
+ *    Functions for reporting cumulative interconnect flow control statistics
+ *
+ * Copyright (c) 2017-Present Pivotal Software, Inc.
+ *
+ *-------------------------------------------------------------------------
+*/
+#include "postgres.h"
+#include "funcapi.h"
+#include "cdb/cdbvars.h"
+#include "cdb/ml_ipc.h"
+#include "utils/builtins.h"
+
+PG_MODULE_MAGIC;
+
+/* The number of columns as defined in gp_interconnect_stats view */
+#define NUM_INTERCONNECT_STATS_ELEM (15 + IC_ACK_TIME_HIST_BUCKETS)
+
+Datum		gp_interconnect_stats(PG_FUNCTION_ARGS);
+
+PG_FUNCTION_INFO_V1(gp_interconnect_stats);
+
+/*
+ * Get the interconnect statistics accumulated on this segment since startup
+ *
+ * The counters are folded in by every UDPIFC interconnect teardown; the
+ * ack time histogram buckets are <100us, <1ms, <10ms, <100ms and >=100ms.
+ */
+Datum
+gp_interconnect_stats(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	ICCumulativeStats stats;
+	Datum		values[NUM_INTERCONNECT_STATS_ELEM];
+	bool		nulls[NUM_INTERCONNECT_STATS_ELEM];
+	HeapTuple	tuple;
+	int			i;
+
+	Assert(IC_ACK_TIME_HIST_BUCKETS == 5);
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		TupleDesc	tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		/* Switch to memory context appropriate for multiple function calls */
+		MemoryContext oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		/*
+		 * Build a tuple descriptor for our result type
+		 * The number and type of attributes have to match the definition of the
+		 * view gp_interconnect_stats
+		 */
+		tupdesc = CreateTemplateTupleDesc(NUM_INTERCONNECT_STATS_ELEM, false);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "segid", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "num_teardowns", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 3, "snd_pkt_num", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 4, "recv_pkt_num", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 5, "recv_ack_num", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 6, "retransmits", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 7, "crc_errors", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 8, "mismatch_pkt_num", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 9, "disordered_pkt_num", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 10, "duplicated_pkt_num", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 11, "status_query_msg_num", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 12, "capacity_stalls", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 13, "ack_wait_time_us", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 14, "min_ack_time_us", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 15, "max_ack_time_us", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 16, "ack_time_lt_100us", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 17, "ack_time_lt_1ms", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 18, "ack_time_lt_10ms", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 19, "ack_time_lt_100ms", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 20, "ack_time_ge_100ms", INT8OID, -1, 0);
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+
+	/* One row for this segment */
+	if (funcctx->call_cntr > 0)
+		SRF_RETURN_DONE(funcctx);
+
+	InterconnectGetStats(&stats);
+
+	MemSet(nulls, 0, sizeof(nulls));
+	values[0] = Int32GetDatum(GpIdentity.segindex);
+	values[1] = Int64GetDatum((int64) stats.numTeardowns);
+	values[2] = Int64GetDatum((int64) stats.sndPktNum);
+	values[3] = Int64GetDatum((int64) stats.recvPktNum);
+	values[4] = Int64GetDatum((int64) stats.recvAckNum);
+	values[5] = Int64GetDatum((int64) stats.retransmits);
+	values[6] = Int64GetDatum((int64) stats.crcErrors);
+	values[7] = Int64GetDatum((int64) stats.mismatchNum);
+	values[8] = Int64GetDatum((int64) stats.disorderedPktNum);
+	values[9] = Int64GetDatum((int64) stats.duplicatedPktNum);
+	values[10] = Int64GetDatum((int64) stats.statusQueryMsgNum);
+	values[11] = Int64GetDatum((int64) stats.capacityStalls);
+	values[12] = Int64GetDatum((int64) stats.ackWaitTimeUs);
+	values[13] = Int64GetDatum((int64) stats.minAckTimeUs);
+	values[14] = Int64GetDatum((int64) stats.maxAckTimeUs);
+	for (i = 0; i < IC_ACK_TIME_HIST_BUCKETS; i++)
+		values[15 + i] = Int64GetDatum((int64) stats.ackTimeHist[i]);
+
+	tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+
+	SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+}
@@ -277,6 +277,15 @@ AOCSMoveTuple(TupleTableSlot *slot,
 /*
  * Assumes that the segment file lock is already held.
  * Assumes that the segment file should be compacted.
+ *
+ * Unlike an ALTER TABLE rewrite, compaction does not copy column blocks with
+ * aocs_insert_copy_segfile().  That copies the blocks of a whole segment
+ * file and needs every row of it to move, while a segment file is only
+ * compacted when some of its rows are hidden.  Copying just the blocks whose
+ * rows are all visible would not line up either: each column is cut into
+ * blocks at its own row boundaries, so a block that can be copied in one
+ * column covers hidden rows in another.  The moved rows also get new index
+ * entries, for which the indexed columns must be decoded anyway.
  */
 static bool
 AOCSSegmentFileFullCompaction(Relation aorel,
@@ -286,28 +295,25 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 	const char *relname;
 	AppendOnlyVisimap visiMap;
 	AOCSScanDesc scanDesc;
+	AOCSScanBatch *batch;
 	TupleDesc	tupDesc;
 	TupleTableSlot *slot;
+	Datum	   *values;
+	bool	   *isnull;
+	int			natts;
 	int			compact_segno;
-	int64		movedTupleCount = 0;
 	ResultRelInfo *resultRelInfo;
-	MemTupleBinding *mt_bind;
 	EState	   *estate;
 	bool	   *proj;
 	int			i;
-	AOTupleId  *aoTupleId;
-	int64		tupleCount = 0;
-	int64		tuplePerPage = INT_MAX;
+	int			batchSize;
+	AppendOnlyCompactionProgress progress;
 
 	Assert(Gp_role == GP_ROLE_EXECUTE || Gp_role == GP_ROLE_UTILITY);
 	Assert(RelationIsAoCols(aorel));
 	Assert(insertDesc);
 
 	compact_segno = fsinfo->segno;
-	if (fsinfo->varblockcount > 0)
-	{
-		tuplePerPage = fsinfo->total_tupcount / fsinfo->varblockcount;
-	}
 	relname = RelationGetRelationName(aorel);
 
 	AppendOnlyVisimap_Init(&visiMap,
@@ -320,8 +326,9 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 		   LOG, "Compact AO segfile %d, relation %sd",
 		   compact_segno, relname);
 
-	proj = palloc0(sizeof(bool) * RelationGetNumberOfAttributes(aorel));
-	for (i = 0; i < RelationGetNumberOfAttributes(aorel); ++i)
+	natts = RelationGetNumberOfAttributes(aorel);
+	proj = palloc0(sizeof(bool) * natts);
+	for (i = 0; i < natts; ++i)
 	{
 		proj[i] = true;
 	}
@@ -331,7 +338,8 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 
 	tupDesc = RelationGetDescr(aorel);
 	slot = MakeSingleTupleTableSlot(tupDesc);
-	mt_bind = create_memtuple_binding(tupDesc);
+	values = slot_get_values(slot);
+	isnull = slot_get_isnull(slot);
 
 	/*
 	 * We need a ResultRelInfo and an EState so we can use the regular
@@ -347,43 +355,53 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 	estate->es_num_result_relations = 1;
 	estate->es_result_relation_info = resultRelInfo;
 
-	aocs_getnext(scanDesc, ForwardScanDirection, slot);
-	while (!TupIsNull(slot))
+	AppendOnlyCompaction_StartProgress(&progress, aorel, compact_segno,
+									   fsinfo->total_tupcount);
+
+	/*
+	 * Decode the segfile a block at a time.  The scan looks up the
+	 * visibility of the rows of a batch in the visi map a bitmap word at a
+	 * time, and leaves out the invisible ones.
+	 */
+	batchSize = Max(gp_aocs_scan_batch_size, 1);
+	while ((batch = aocs_getnextbatch(scanDesc, batchSize)) != NULL)
 	{
+		int			row;
+
 		CHECK_FOR_INTERRUPTS();
 
-		aoTupleId = (AOTupleId *) slot_get_ctid(slot);
-		if (AppendOnlyVisimap_IsVisible(&scanDesc->visibilityMap, aoTupleId))
+		for (row = 0; row < batch->nrows; row++)
 		{
-			AOCSMoveTuple(
-						  slot,
+			if (!batch->visible[row])
+				continue;
+
+			ExecClearTuple(slot);
+			for (i = 0; i < natts; i++)
+			{
+				values[i] = batch->values[i][row];
+				isnull[i] = batch->isnull[i][row];
+			}
+			TupSetVirtualTupleNValid(slot, natts);
+			slot_set_ctid(slot, (ItemPointer) &batch->tids[row]);
+
+			AOCSMoveTuple(slot,
 						  insertDesc,
 						  resultRelInfo,
 						  estate);
-			movedTupleCount++;
-		}
-		else
-		{
-			MemTuple	tuple = TupGetMemTuple(slot);
-
-			/* Tuple is invisible and needs to be dropped */
-			AppendOnlyThrowAwayTuple(aorel,
-									 tuple,
-									 slot,
-									 mt_bind);
 		}
+		progress.scannedTupleCount += batch->nrows;
+		progress.movedTupleCount += batch->nvisible;
 
 		/*
-		 * Check for vacuum delay point after approximatly a var block
+		 * Check for vacuum delay point after each batch, which is at most
+		 * a var block
 		 */
-		tupleCount++;
-		if (VacuumCostActive && tupleCount % tuplePerPage == 0)
+		if (VacuumCostActive)
 		{
 			vacuum_delay_point();
 		}
 
-		aocs_getnext(scanDesc, ForwardScanDirection, slot);
-
+		AppendOnlyCompaction_ReportProgress(&progress);
 	}
 
 	SetAOCSFileSegInfoState(aorel, compact_segno,
@@ -401,10 +419,7 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 												   0);
 	}
 
-	elogif(Debug_appendonly_print_compaction, LOG,
-		   "Finished compaction: "
-		   "AO segfile %d, relation %s, moved tuple count " INT64_FORMAT,
-		   compact_segno, relname, movedTupleCount);
+	AppendOnlyCompaction_FinishProgress(&progress);
 
 	AppendOnlyVisimap_Finish(&visiMap, NoLock);
 
@@ -412,7 +427,6 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 	FreeExecutorState(estate);
 
 	ExecDropSingleTupleTableSlot(slot);
-	destroy_memtuple_binding(mt_bind);
 
 	aocs_endscan(scanDesc);
 	pfree(proj);
@@ -49,6 +49,7 @@
 #include "utils/guc.h"
 #include "utils/inval.h"
 #include "utils/lsyscache.h"
+#include "utils/memutils.h"
 #include "utils/relcache.h"
 #include "utils/syscache.h"
 
@@ -59,6 +60,7 @@ static AOCSScanDesc aocs_beginscan_internal(Relation relation,
 						Snapshot snapshot,
 						Snapshot appendOnlyMetaDataSnapshot,
 						TupleDesc relationTupleDesc, bool *proj);
+static void aocs_free_batch(AOCSScanBatch *batch, int natts);
 
 /*
  * Open the segment file for a specified column associated with the datum
@@ -259,6 +261,30 @@ close_ds_write(DatumStreamWrite **ds, int nvp)
 }
 
 
+/*
+ * Let the decompression worker pool decompress the next block of the
+ * projected columns, in projection order, as far as the memory limit set
+ * by aocs_setdecompressahead() goes.
+ */
+static void
+aocs_enable_decompress_ahead(AOCSScanDesc scan)
+{
+	int64		memLeft = scan->decompressAheadMem;
+	int			i;
+
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		DatumStreamRead *ds = scan->ds[scan->proj_atts[i]];
+		int64		memNeeded = 2 * (int64) ds->maxAoBlockSize;
+
+		if (memNeeded > memLeft)
+			break;
+
+		if (datumstreamread_enable_decompress_ahead(ds))
+			memLeft -= memNeeded;
+	}
+}
+
 static void
 aocs_initscan(AOCSScanDesc scan)
 {
@@ -270,6 +296,7 @@ aocs_initscan(AOCSScanDesc scan)
 	open_ds_read(scan->aos_rel, scan->ds, scan->relationTupleDesc,
 				 scan->proj_atts, scan->num_proj_atts,
 				 scan->aos_rel->rd_appendonly->checksum);
+	aocs_enable_decompress_ahead(scan);
 
 	pgstat_count_heap_scan(scan->aos_rel);
 }
@@ -539,6 +566,9 @@ aocs_endscan(AOCSScanDesc scan)
 
 	AppendOnlyVisimap_Finish(&scan->visibilityMap, AccessShareLock);
 
+	if (scan->batch)
+		aocs_free_batch(scan->batch, scan->relationTupleDesc->natts);
+
 	pfree(scan);
 }
 
@@ -616,6 +646,222 @@ static void upgrade_datum_fetch(AOCSFetchDesc fetch, int attno, Datum values[],
 					   values, isnull, formatversion);
 }
 
+/*
+ * Can any value in [min, max] satisfy "column <strategy> value"?
+ */
+static bool
+zonemap_value_can_match(AOCSZoneMapKey *key, Datum value, Datum min, Datum max)
+{
+	int32		cmpmin = DatumGetInt32(FunctionCall2(&key->cmpfn, min, value));
+	int32		cmpmax;
+
+	switch (key->strategy)
+	{
+		case BTLessStrategyNumber:
+			return cmpmin < 0;
+		case BTLessEqualStrategyNumber:
+			return cmpmin <= 0;
+		case BTEqualStrategyNumber:
+			if (cmpmin > 0)
+				return false;
+			break;
+		case BTGreaterEqualStrategyNumber:
+		case BTGreaterStrategyNumber:
+			break;
+		default:
+			return true;
+	}
+
+	cmpmax = DatumGetInt32(FunctionCall2(&key->cmpfn, max, value));
+
+	switch (key->strategy)
+	{
+		case BTEqualStrategyNumber:
+		case BTGreaterEqualStrategyNumber:
+			return cmpmax >= 0;
+		case BTGreaterStrategyNumber:
+			return cmpmax > 0;
+		default:
+			return true;
+	}
+}
+
+/*
+ * Can any value in [min, max] satisfy the key?
+ */
+static bool
+zonemap_key_can_match(AOCSZoneMapKey *key, Datum min, Datum max)
+{
+	int			i;
+
+	if (key->values == NULL)
+		return zonemap_value_can_match(key, key->value, min, max);
+
+	for (i = 0; i < key->nvalues; i++)
+	{
+		if (zonemap_value_can_match(key, key->values[i], min, max))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Check the current block of the key's column against the key.
+ *
+ * A dictionary encoded block is checked value by value against its
+ * dictionary; any other block by its min/max range.  None of the
+ * restrictions can be satisfied by NULL, so a block holding only NULLs is
+ * always excluded.
+ */
+static bool
+zonemap_excludes_block(AOCSScanDesc scan, AOCSZoneMapKey *key)
+{
+	DatumStreamRead *ds = scan->ds[key->attno];
+	Datum		min;
+	Datum		max;
+	bool		allNull;
+	int32		dictCount;
+
+	key->checkedBlockOffset = ds->blockFileOffset;
+
+	/* Pre-4.0 blocks have no row numbers to line the other columns up by. */
+	if (ds->getBlockInfo.firstRow < 0)
+		return false;
+
+	/* A large object has no min/max or dictionary to go by. */
+	if (ds->largeObjectState != DatumStreamLargeObjectState_None)
+		return false;
+
+	dictCount = datumstreamread_block_dictcount(ds);
+	if (dictCount > 0)
+	{
+		int32		i;
+
+		scan->zonemapBlocksRead++;
+
+		for (i = 0; i < dictCount; i++)
+		{
+			Datum		value = DatumStreamBlockRead_DictValue(&ds->blockRead, i);
+
+			if (zonemap_key_can_match(key, value, value))
+				return false;
+		}
+
+		scan->zonemapBlocksSkipped++;
+		return true;
+	}
+
+	if (!datumstreamread_block_minmax(ds, &key->cmpfn, &min, &max, &allNull))
+		return false;
+
+	scan->zonemapBlocksRead++;
+
+	if (allNull || !zonemap_key_can_match(key, min, max))
+	{
+		scan->zonemapBlocksSkipped++;
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * Number of rows left in the current block of a datum stream.
+ */
+static inline int
+aocs_block_rows_left(DatumStreamRead *ds)
+{
+	if (ds->largeObjectState == DatumStreamLargeObjectState_None)
+		return ds->blockRead.logical_row_count -
+			(DatumStreamBlockRead_Nth(&ds->blockRead) + 1);
+
+	return (ds->largeObjectState == DatumStreamLargeObjectState_HaveAoContent) ? 1 : 0;
+}
+
+/*
+ * Before the next row is read, make sure that the blocks it comes from are
+ * not ruled out by any zone map key.  For every excluded block, the rows it
+ * covers are skipped in all projected columns; the blocks of the other
+ * columns that fall entirely within those rows are never decompressed.
+ *
+ * Returns false if the current segment file has no more rows.
+ */
+static bool
+aocs_skip_excluded_blocks(AOCSScanDesc scan)
+{
+	int			k;
+
+restart:
+	for (k = 0; k < scan->numZonemapKeys; k++)
+	{
+		AOCSZoneMapKey *key = &scan->zonemapKeys[k];
+		DatumStreamRead *ds = scan->ds[key->attno];
+		int64		targetRowNum;
+		int			i;
+
+		/* Load the block that the next row of this column comes from. */
+		if (aocs_block_rows_left(ds) == 0)
+		{
+			if (datumstreamread_block(ds, NULL, key->attno) < 0)
+				return false;
+		}
+
+		if (key->checkedBlockOffset == ds->blockFileOffset)
+			continue;
+
+		if (!zonemap_excludes_block(scan, key))
+			continue;
+
+		targetRowNum = ds->blockFirstRowNum + ds->blockRowCount;
+		scan->cur_seg_row += aocs_block_rows_left(ds);
+
+		for (i = 0; i < scan->num_proj_atts; i++)
+		{
+			if (!datumstreamread_skip_to_row(scan->ds[scan->proj_atts[i]],
+											 targetRowNum))
+				return false;
+		}
+
+		/* Blocks of the key columns may have moved on; check them again. */
+		goto restart;
+	}
+
+	return true;
+}
+
+/*
+ * Restrict the scan with zone map keys.  The keys must be sorted by attno
+ * and refer to projected columns; they are ignored when the scan builds the
+ * block directory, which needs to see every block.
+ */
+void
+aocs_setzonemapkeys(AOCSScanDesc scan, AOCSZoneMapKey *keys, int nkeys)
+{
+	int			k;
+
+	if (scan->blockDirectory)
+		return;
+
+	for (k = 0; k < nkeys; k++)
+		keys[k].checkedBlockOffset = -1;
+
+	scan->zonemapKeys = keys;
+	scan->numZonemapKeys = nkeys;
+}
+
+/*
+ * Allow the scan to use up to memLimit bytes for decompressing the blocks
+ * of its columns ahead in the decompression worker pool.  Nothing happens
+ * unless gp_aocs_decompress_workers is set.
+ */
+void
+aocs_setdecompressahead(AOCSScanDesc scan, int64 memLimit)
+{
+	scan->decompressAheadMem = memLimit;
+	aocs_enable_decompress_ahead(scan);
+}
+
 void
 aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot)
 {
@@ -650,11 +896,21 @@ ReadNext:
 				return;
 			}
 			scan->cur_seg_row = 0;
+
+			for (i = 0; i < scan->numZonemapKeys; i++)
+				scan->zonemapKeys[i].checkedBlockOffset = -1;
 		}
 
 		Assert(scan->cur_seg >= 0);
 		curseginfo = scan->seginfo[scan->cur_seg];
 
+		if (scan->numZonemapKeys > 0 && !aocs_skip_excluded_blocks(scan))
+		{
+			close_cur_scan_seg(scan);
+			err = -1;
+			goto ReadNext;
+		}
+
 		/* Read from cur_seg */
 		for (i = 0; i < scan->num_proj_atts; i++)
 		{
@@ -732,6 +988,218 @@ ReadNext:
 }
 
 
+static AOCSScanBatch *
+aocs_create_batch(AOCSScanDesc scan, int maxRows)
+{
+	MemoryContext oldcxt;
+	AOCSScanBatch *batch;
+	int			i;
+
+	/* The batch lives as long as the scan. */
+	oldcxt = MemoryContextSwitchTo(GetMemoryChunkContext(scan));
+
+	batch = (AOCSScanBatch *) palloc0(sizeof(AOCSScanBatch));
+	batch->maxRows = maxRows;
+	batch->values = (Datum **) palloc0(sizeof(Datum *) * scan->relationTupleDesc->natts);
+	batch->isnull = (bool **) palloc0(sizeof(bool *) * scan->relationTupleDesc->natts);
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		int			attno = scan->proj_atts[i];
+
+		batch->values[attno] = (Datum *) palloc(sizeof(Datum) * maxRows);
+		batch->isnull[attno] = (bool *) palloc(sizeof(bool) * maxRows);
+	}
+	batch->visible = (bool *) palloc(sizeof(bool) * maxRows);
+	batch->tids = (AOTupleId *) palloc(sizeof(AOTupleId) * maxRows);
+
+	MemoryContextSwitchTo(oldcxt);
+
+	return batch;
+}
+
+static void
+aocs_free_batch(AOCSScanBatch *batch, int natts)
+{
+	int			i;
+
+	for (i = 0; i < natts; i++)
+	{
+		if (batch->values[i])
+			pfree(batch->values[i]);
+		if (batch->isnull[i])
+			pfree(batch->isnull[i]);
+	}
+	pfree(batch->values);
+	pfree(batch->isnull);
+	pfree(batch->visible);
+	pfree(batch->tids);
+	pfree(batch);
+}
+
+/*
+ * aocs_getnextbatch
+ *
+ * Decode up to maxRows rows of every projected column in one go.  A batch
+ * never crosses a block boundary of any projected column, so each column
+ * is decoded by a tight loop over a single block, and the block-level
+ * bookkeeping of aocs_getnext() is done once per batch instead of once
+ * per row.
+ *
+ * Returns NULL at the end of the scan.  Batches without any visible row
+ * are not returned.
+ */
+AOCSScanBatch *
+aocs_getnextbatch(AOCSScanDesc scan, int maxRows)
+{
+	AOCSScanBatch *batch = scan->batch;
+	bool		isSnapshotAny = (scan->snapshot == SnapshotAny);
+	int			err = 0;
+
+	Assert(scan->num_proj_atts > 0);
+	Assert(maxRows > 0);
+
+	if (batch == NULL || batch->maxRows < maxRows)
+	{
+		if (batch)
+			aocs_free_batch(batch, scan->relationTupleDesc->natts);
+		batch = scan->batch = aocs_create_batch(scan, maxRows);
+	}
+
+	while (1)
+	{
+		AOCSFileSegInfo *curseginfo;
+		int64		firstRowNum = INT64CONST(-1);
+		int			nrows = maxRows;
+		int			i;
+		int			j;
+
+		/* If necessary, open next seg */
+		if (scan->cur_seg < 0 || err < 0)
+		{
+			err = open_next_scan_seg(scan);
+			if (err < 0)
+			{
+				/* No more seg, we are at the end */
+				scan->cur_seg = -1;
+				return NULL;
+			}
+			scan->cur_seg_row = 0;
+
+			for (i = 0; i < scan->numZonemapKeys; i++)
+				scan->zonemapKeys[i].checkedBlockOffset = -1;
+		}
+
+		Assert(scan->cur_seg >= 0);
+		curseginfo = scan->seginfo[scan->cur_seg];
+
+		if (scan->numZonemapKeys > 0 && !aocs_skip_excluded_blocks(scan))
+		{
+			close_cur_scan_seg(scan);
+			err = -1;
+			continue;
+		}
+
+		/*
+		 * Make sure every projected column has rows left in its current
+		 * block, and size the batch to the shortest of them.
+		 */
+		for (i = 0; i < scan->num_proj_atts; i++)
+		{
+			int			attno = scan->proj_atts[i];
+			int			left = aocs_block_rows_left(scan->ds[attno]);
+
+			if (left == 0)
+			{
+				err = datumstreamread_block(scan->ds[attno], scan->blockDirectory, attno);
+				if (err < 0)
+					break;
+				left = aocs_block_rows_left(scan->ds[attno]);
+			}
+
+			if (left < nrows)
+				nrows = left;
+		}
+
+		if (err < 0)
+		{
+			/* Cannot read next block, we need to go to next seg */
+			close_cur_scan_seg(scan);
+			continue;
+		}
+
+		/*
+		 * Upgraded values share a single conversion buffer per column, so
+		 * they have to be returned one at a time.
+		 */
+		if (curseginfo->formatversion < AORelationVersion_GetLatest())
+			nrows = 1;
+
+		Assert(nrows > 0);
+
+		for (i = 0; i < scan->num_proj_atts; i++)
+		{
+			int			attno = scan->proj_atts[i];
+			DatumStreamRead *ds = scan->ds[attno];
+			Datum	   *values = batch->values[attno];
+			bool	   *isnull = batch->isnull[attno];
+
+			for (j = 0; j < nrows; j++)
+			{
+				err = datumstreamread_advance(ds);
+				Assert(err > 0);
+				datumstreamread_get(ds, &values[j], &isnull[j]);
+			}
+
+			if (curseginfo->formatversion < AORelationVersion_GetLatest())
+			{
+				/* values/isnull hold just this column's single row. */
+				upgrade_datum_impl(ds, 0, values, isnull,
+								   curseginfo->formatversion);
+			}
+
+			/* Rows are numbered consecutively within a block. */
+			if (firstRowNum == INT64CONST(-1) &&
+				ds->blockFirstRowNum != INT64CONST(-1))
+			{
+				Assert(ds->blockFirstRowNum > 0);
+				firstRowNum = ds->blockFirstRowNum +
+					datumstreamread_nth(ds) - (nrows - 1);
+			}
+		}
+
+		if (firstRowNum == INT64CONST(-1))
+			firstRowNum = scan->cur_seg_row + 1;
+
+		batch->nrows = nrows;
+		for (j = 0; j < nrows; j++)
+		{
+			AOTupleId  *tid = &batch->tids[j];
+
+			AOTupleIdInit_Init(tid);
+			AOTupleIdInit_segmentFileNum(tid, curseginfo->segno);
+			AOTupleIdInit_rowNum(tid, firstRowNum + j);
+		}
+
+		if (isSnapshotAny)
+		{
+			memset(batch->visible, true, nrows);
+			batch->nvisible = nrows;
+		}
+		else
+			batch->nvisible =
+				AppendOnlyVisimap_GetVisibleRange(&scan->visibilityMap,
+												  curseginfo->segno,
+												  firstRowNum,
+												  nrows,
+												  batch->visible);
+		scan->cur_seg_row += nrows;
+
+		if (batch->nvisible > 0)
+			return batch;
+	}
+}
+
+
 /* Open next file segment for write.  See SetCurrentFileSegForWrite */
 /* XXX Right now, we put each column to different files */
 static void
@@ -907,7 +1375,12 @@ aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupl
 	{
 		void	   *toFree1;
 		Datum		datum = d[i];
-		int			err = datumstreamwrite_put(idesc->ds[i], datum, null[i], &toFree1);
+		int			err;
+
+		if (idesc->copiedCols != NULL && idesc->copiedCols[i])
+			continue;
+
+		err = datumstreamwrite_put(idesc->ds[i], datum, null[i], &toFree1);
 
 		if (toFree1 != NULL)
 		{
@@ -1025,6 +1498,167 @@ aocs_insert_finish(AOCSInsertDesc idesc)
 	close_ds_write(idesc->ds, rel->rd_att->natts);
 }
 
+/*
+ * Can the blocks of column attno of srcrel, laid out as srcTupDesc says, be
+ * copied unchanged to the same column of destrel?  Both columns must have
+ * the same type and the same compression and block size.
+ */
+bool
+aocs_column_can_copy(Relation srcrel, TupleDesc srcTupDesc,
+					 Relation destrel, int attno)
+{
+	Form_pg_attribute srcattr;
+	Form_pg_attribute destattr;
+	StdRdOptions **srcopts;
+	StdRdOptions **destopts;
+	char	   *srcct;
+	char	   *destct;
+
+	Assert(RelationIsAoCols(srcrel));
+	Assert(RelationIsAoCols(destrel));
+
+	if (attno >= srcTupDesc->natts ||
+		attno >= RelationGetNumberOfAttributes(srcrel) ||
+		attno >= RelationGetNumberOfAttributes(destrel))
+		return false;
+
+	srcattr = srcTupDesc->attrs[attno];
+	destattr = RelationGetDescr(destrel)->attrs[attno];
+
+	if (srcattr->attisdropped || destattr->attisdropped)
+		return false;
+	if (srcattr->atttypid != destattr->atttypid ||
+		srcattr->atttypmod != destattr->atttypmod ||
+		srcattr->attlen != destattr->attlen ||
+		srcattr->attbyval != destattr->attbyval ||
+		srcattr->attalign != destattr->attalign)
+		return false;
+
+	srcopts = RelationGetAttributeOptions(srcrel);
+	destopts = RelationGetAttributeOptions(destrel);
+	if (srcopts[attno] == NULL || destopts[attno] == NULL)
+		return false;
+
+	srcct = srcopts[attno]->compresstype;
+	destct = destopts[attno]->compresstype;
+	if (srcct == NULL || srcct[0] == '\0')
+		srcct = "none";
+	if (destct == NULL || destct[0] == '\0')
+		destct = "none";
+
+	return pg_strcasecmp(srcct, destct) == 0 &&
+		srcopts[attno]->compresslevel == destopts[attno]->compresslevel &&
+		srcopts[attno]->blocksize == destopts[attno]->blocksize;
+}
+
+/*
+ * Have aocs_insert_values() leave alone the columns set in copiedCols,
+ * which the caller fills with aocs_insert_copy_segfile() instead.
+ */
+void
+aocs_insert_setcopiedcols(AOCSInsertDesc idesc, bool *copiedCols)
+{
+	idesc->copiedCols = copiedCols;
+}
+
+/*
+ * Copy the blocks of the copied columns of segment file segno of srcrel to
+ * the end of the insert's segment file, without decoding them.  See
+ * aocs_column_can_copy().
+ *
+ * The rows of the copied blocks are numbered as if they were inserted next.
+ * The caller must then insert all the rows of the source segment file, in
+ * order, with aocs_insert_values(), so that the other columns get the same
+ * row numbers.
+ *
+ * Returns the number of rows copied.
+ */
+int64
+aocs_insert_copy_segfile(AOCSInsertDesc idesc, Relation srcrel,
+						 TupleDesc srcTupDesc, int segno)
+{
+	char	   *basepath = relpath(srcrel->rd_node, MAIN_FORKNUM);
+	int			natts = srcTupDesc->natts;
+	int64		firstRowNum = idesc->lastSequence + 1;
+	int64		copiedRows = 0;
+	AOCSFileSegInfo *seginfo;
+	DatumStreamRead **ds;
+	int		   *proj_atts;
+	int			num_proj_atts = 0;
+	int			i;
+
+	Assert(idesc->copiedCols != NULL);
+
+#ifdef FAULT_INJECTOR
+	FaultInjector_InjectFaultIfSet(
+								   AOCSRewriteCopyBlocks,
+								   DDLNotSpecified,
+								   "",	/* databaseName */
+								   "");	/* tableName */
+#endif
+
+	seginfo = GetAOCSFileSegInfo(srcrel, SnapshotNow, segno);
+	if (seginfo == NULL)
+		elog(ERROR, "file seginfo for AOCS relation %s (segno=%d) is missing",
+			 RelationGetRelationName(srcrel), segno);
+
+	/* Blocks of older versions may need converting on the way. */
+	if (seginfo->formatversion != idesc->fsInfo->formatversion)
+		elog(ERROR, "cannot copy blocks of AOCS relation %s segno %d of format version %d to format version %d",
+			 RelationGetRelationName(srcrel), segno,
+			 seginfo->formatversion, idesc->fsInfo->formatversion);
+
+	proj_atts = (int *) palloc(sizeof(int) * natts);
+	for (i = 0; i < natts && i < RelationGetNumberOfAttributes(idesc->aoi_rel); i++)
+	{
+		if (idesc->copiedCols[i])
+			proj_atts[num_proj_atts++] = i;
+	}
+
+	ds = (DatumStreamRead **) palloc0(sizeof(DatumStreamRead *) * natts);
+	open_ds_read(srcrel, ds, srcTupDesc, proj_atts, num_proj_atts,
+				 srcrel->rd_appendonly->checksum);
+
+	for (i = 0; i < num_proj_atts; i++)
+	{
+		int			attno = proj_atts[i];
+		int64		rows = 0;
+		int			n;
+
+		open_datumstreamread_segfile(basepath, srcrel->rd_node, seginfo,
+									 ds[attno], attno);
+
+		while ((n = datumstreamread_copy_block(ds[attno],
+											   idesc->ds[attno],
+											   firstRowNum + rows,
+											   &idesc->blockDirectory,
+											   attno)) >= 0)
+			rows += n;
+
+		datumstreamread_close_file(ds[attno]);
+
+		/* Every column must hold the same rows. */
+		if (i > 0 && rows != copiedRows)
+			elog(ERROR, "column %d of AOCS relation %s segno %d has " INT64_FORMAT " rows, expected " INT64_FORMAT,
+				 attno + 1, RelationGetRelationName(srcrel), segno,
+				 rows, copiedRows);
+		copiedRows = rows;
+	}
+
+	elogif(Debug_appendonly_print_insert, LOG,
+		   "Copied %d columns of AOCS relation %s segno %d, " INT64_FORMAT " rows from row number " INT64_FORMAT,
+		   num_proj_atts, RelationGetRelationName(srcrel), segno,
+		   copiedRows, firstRowNum);
+
+	close_ds_read(ds, natts);
+	pfree(ds);
+	pfree(proj_atts);
+	pfree(seginfo);
+	pfree(basepath);
+
+	return copiedRows;
+}
+
 static void
 positionFirstBlockOfRange(DatumStreamFetchDesc datumStreamFetchDesc)
 {
@@ -329,6 +329,98 @@ AppendOnlyThrowAwayTuple(Relation rel,
 		   AOTupleIdGet_segmentFileNum(oldAoTupleId), AOTupleIdGet_rowNum(oldAoTupleId));
 }
 
+#define COMPACTION_PROGRESS_CHECK_TUPLES 4096
+
+/*
+ * Tuples per second since the start of the compaction.
+ */
+static double
+AppendOnlyCompaction_Throughput(AppendOnlyCompactionProgress *progress,
+								TimestampTz now, double *elapsed)
+{
+	long		secs;
+	int			usecs;
+
+	TimestampDifference(progress->startTime, now, &secs, &usecs);
+	*elapsed = secs + usecs / 1000000.0;
+
+	if (*elapsed <= 0)
+		return 0;
+	return progress->scannedTupleCount / *elapsed;
+}
+
+void
+AppendOnlyCompaction_StartProgress(AppendOnlyCompactionProgress *progress,
+								   Relation aorel, int segno,
+								   int64 totalTupleCount)
+{
+	progress->relname = RelationGetRelationName(aorel);
+	progress->segno = segno;
+	progress->totalTupleCount = totalTupleCount;
+	progress->scannedTupleCount = 0;
+	progress->movedTupleCount = 0;
+	progress->nextCheckTupleCount = COMPACTION_PROGRESS_CHECK_TUPLES;
+	progress->startTime = GetCurrentTimestamp();
+	progress->lastReportTime = progress->startTime;
+}
+
+/*
+ * Called as the tuple counts go up.  Logs how far the compaction of the
+ * segment file got once gp_appendonly_compaction_progress_interval has
+ * passed since the last message.
+ */
+void
+AppendOnlyCompaction_ReportProgress(AppendOnlyCompactionProgress *progress)
+{
+	TimestampTz now;
+	double		elapsed;
+	double		throughput;
+
+	if (gp_appendonly_compaction_progress_interval <= 0 ||
+		progress->scannedTupleCount < progress->nextCheckTupleCount)
+		return;
+
+	progress->nextCheckTupleCount =
+		progress->scannedTupleCount + COMPACTION_PROGRESS_CHECK_TUPLES;
+
+	now = GetCurrentTimestamp();
+	if (!TimestampDifferenceExceeds(progress->lastReportTime, now,
+									gp_appendonly_compaction_progress_interval * 1000))
+		return;
+	progress->lastReportTime = now;
+
+	throughput = AppendOnlyCompaction_Throughput(progress, now, &elapsed);
+
+	elog(LOG, "compacting AO segfile %d of relation %s: "
+		 "scanned " INT64_FORMAT " of " INT64_FORMAT " tuples, "
+		 "moved " INT64_FORMAT ", %.0f tuples/s",
+		 progress->segno, progress->relname,
+		 progress->scannedTupleCount, progress->totalTupleCount,
+		 progress->movedTupleCount, throughput);
+}
+
+void
+AppendOnlyCompaction_FinishProgress(AppendOnlyCompactionProgress *progress)
+{
+	double		elapsed;
+	double		throughput;
+
+	if (!Debug_appendonly_print_compaction &&
+		gp_appendonly_compaction_progress_interval <= 0)
+		return;
+
+	throughput = AppendOnlyCompaction_Throughput(progress,
+												 GetCurrentTimestamp(),
+												 &elapsed);
+
+	elog(LOG, "Finished compaction: "
+		 "AO segfile %d, relation %s, moved tuple count " INT64_FORMAT
+		 ", scanned tuple count " INT64_FORMAT ", %.3f s, %.0f tuples/s",
+		 progress->segno, progress->relname,
+		 progress->movedTupleCount, progress->scannedTupleCount,
+		 elapsed, throughput);
+}
+
 /*
  * Assumes that the segment file lock is already held.
  * Assumes that the segment file should be compacted.
@@ -347,12 +439,11 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 	TupleTableSlot *slot;
 	MemTupleBinding *mt_bind;
 	int			compact_segno;
-	int64		movedTupleCount = 0;
 	ResultRelInfo *resultRelInfo;
 	EState	   *estate;
 	AOTupleId  *aoTupleId;
-	int64		tupleCount = 0;
 	int64		tuplePerPage = INT_MAX;
+	AppendOnlyCompactionProgress progress;
 
 	Assert(Gp_role == GP_ROLE_EXECUTE || Gp_role == GP_ROLE_UTILITY);
 	Assert(RelationIsAoRows(aorel));
@@ -403,6 +494,9 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 	estate->es_num_result_relations = 1;
 	estate->es_result_relation_info = resultRelInfo;
 
+	AppendOnlyCompaction_StartProgress(&progress, aorel, compact_segno,
+									   fsinfo->total_tupcount);
+
 	/*
 	 * Go through all visible tuples and move them to a new segfile.
 	 */
@@ -412,7 +506,7 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 		CHECK_FOR_INTERRUPTS();
 
 		aoTupleId = (AOTupleId *) slot_get_ctid(slot);
-		if (AppendOnlyVisimap_IsVisible(&scanDesc->visibilityMap, aoTupleId))
+		if (appendonly_tuple_visible_in_scan(scanDesc, aoTupleId))
 		{
 			AppendOnlyMoveTuple(tuple,
 								slot,
@@ -420,7 +514,7 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 								insertDesc,
 								resultRelInfo,
 								estate);
-			movedTupleCount++;
+			progress.movedTupleCount++;
 		}
 		else
 		{
@@ -434,11 +528,13 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 		/*
 		 * Check for vacuum delay point after approximately a var block
 		 */
-		tupleCount++;
-		if (VacuumCostActive && tupleCount % tuplePerPage == 0)
+		progress.scannedTupleCount++;
+		if (VacuumCostActive && progress.scannedTupleCount % tuplePerPage == 0)
 		{
 			vacuum_delay_point();
 		}
+
+		AppendOnlyCompaction_ReportProgress(&progress);
 	}
 
 	SetFileSegInfoState(aorel, compact_segno, AOSEG_STATE_AWAITING_DROP);
@@ -454,10 +550,7 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 												   0);
 	}
 
-	elogif(Debug_appendonly_print_compaction, LOG,
-		   "Finished compaction: "
-		   "AO segfile %d, relation %s, moved tuple count " INT64_FORMAT,
-		   compact_segno, relname, movedTupleCount);
+	AppendOnlyCompaction_FinishProgress(&progress);
 
 	AppendOnlyVisimap_Finish(&visiMap, NoLock);
 
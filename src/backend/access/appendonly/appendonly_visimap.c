@@ -214,6 +214,73 @@ AppendOnlyVisimap_IsVisible(
 											aoTupleId);
 }
 
+/*
+ * Checks the visibility of nrows consecutive rows of the given segment
+ * file, starting at firstRowNum, setting visible[i] for each.
+ *
+ * Gives the same answers as calling AppendOnlyVisimap_IsVisible for each
+ * row, but only moves the visimap entry once per range of rows it covers.
+ *
+ * Returns the number of visible rows.
+ *
+ * Assumes that the visibility has been initialized and not finished.
+ */
+int
+AppendOnlyVisimap_GetVisibleRange(
+								  AppendOnlyVisimap *visiMap,
+								  int segno,
+								  int64 firstRowNum,
+								  int nrows,
+								  bool *visible)
+{
+	int			nvisible = 0;
+	int			done = 0;
+
+	Assert(visiMap);
+	Assert(nrows >= 0);
+
+	elogif(Debug_appendonly_print_visimap, LOG,
+		   "Append-only visi map: Visibility check of range: "
+		   "(segno, firstRowNum, nrows) = (%d, " INT64_FORMAT ", %d)",
+		   segno, firstRowNum, nrows);
+
+	while (done < nrows)
+	{
+		AOTupleId	aoTupleId;
+		int64		rowNum = firstRowNum + done;
+		int64		entryAfterRowNum;
+		int			n;
+
+		AOTupleIdInit_Init(&aoTupleId);
+		AOTupleIdInit_segmentFileNum(&aoTupleId, segno);
+		AOTupleIdInit_rowNum(&aoTupleId, rowNum);
+
+		if (!AppendOnlyVisimapEntry_CoversTuple(&visiMap->visimapEntry,
+												&aoTupleId))
+		{
+			/* if necessary persist the current entry before moving. */
+			if (AppendOnlyVisimapEntry_HasChanged(&visiMap->visimapEntry))
+			{
+				AppendOnlyVisimap_Store(visiMap);
+			}
+
+			AppendOnlyVisimap_Find(visiMap, &aoTupleId);
+		}
+
+		entryAfterRowNum = visiMap->visimapEntry.firstRowNum +
+			APPENDONLY_VISIMAP_MAX_RANGE;
+		n = (int) Min((int64) (nrows - done), entryAfterRowNum - rowNum);
+
+		nvisible += AppendOnlyVisimapEntry_GetVisibleRange(&visiMap->visimapEntry,
+														   rowNum,
+														   n,
+														   visible + done);
+		done += n;
+	}
+
+	return nvisible;
+}
+
 /*
  * Stores the current visibility map entry information
  * in the relation either as update or delete.
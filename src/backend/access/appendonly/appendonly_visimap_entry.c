@@ -481,6 +481,79 @@ AppendOnlyVisimapEntry_IsVisible(
 	return visibilityBit;
 }
 
+/*
+ * Checks the visibility of nrows consecutive rows starting at firstRowNum,
+ * setting visible[i] for each.  All rows must be covered by the entry.
+ *
+ * The bitmap is applied a word at a time; words without any hidden row,
+ * and entries without any at all, are not looked at bit by bit.
+ *
+ * Returns the number of visible rows.
+ */
+int
+AppendOnlyVisimapEntry_GetVisibleRange(
+									   AppendOnlyVisimapEntry *visiMapEntry,
+									   int64 firstRowNum,
+									   int nrows,
+									   bool *visible)
+{
+	Bitmapset  *bitmap;
+	int64		offset;
+	int			nvisible;
+	int			i;
+
+	Assert(visiMapEntry);
+	Assert(AppendOnlyVisimapEntry_IsValid(visiMapEntry));
+	Assert(nrows >= 0);
+	Assert(firstRowNum >= visiMapEntry->firstRowNum);
+	Assert(firstRowNum + nrows <=
+		   visiMapEntry->firstRowNum + APPENDONLY_VISIMAP_MAX_RANGE);
+
+	bitmap = visiMapEntry->bitmap;
+	if (AppendOnlyVisimapEntry_AreAllVisible(visiMapEntry))
+	{
+		memset(visible, true, nrows);
+		return nrows;
+	}
+
+	AppendOnlyVisimapEntry_GetRownumOffset(visiMapEntry,
+										   firstRowNum, &offset);
+
+	nvisible = 0;
+	i = 0;
+	while (i < nrows)
+	{
+		int64		bit = offset + i;
+		int			wordnum = (int) (bit / BITS_PER_BITMAPWORD);
+		int			bitnum = (int) (bit % BITS_PER_BITMAPWORD);
+		int			n = Min(BITS_PER_BITMAPWORD - bitnum, nrows - i);
+		bitmapword	word;
+
+		word = (wordnum < bitmap->nwords) ? bitmap->words[wordnum] : 0;
+		word >>= bitnum;
+
+		if (word == 0)
+		{
+			memset(visible + i, true, n);
+			nvisible += n;
+		}
+		else
+		{
+			int			k;
+
+			for (k = 0; k < n; k++)
+			{
+				visible[i + k] = ((word >> k) & 1) == 0;
+				nvisible += visible[i + k];
+			}
+		}
+
+		i += n;
+	}
+
+	return nvisible;
+}
+
 /*
  * The minimal size (in uint32's elements) the entry array needs to have to
  * cover the given offset
@@ -1284,6 +1284,72 @@ getNextBlock(AppendOnlyScanDesc scan)
 	return true;
 }
 
+/*
+ * Look up the visibility of all the rows of the block just read, so that
+ * the tuples can be checked without going to the visi map one by one.
+ */
+static void
+appendonly_block_visibility(AppendOnlyScanDesc scan)
+{
+	AppendOnlyExecutorReadBlock *executorReadBlock = &scan->executorReadBlock;
+	int			rowCount = executorReadBlock->rowCount;
+	int			nvisible;
+
+	if (rowCount > scan->blockVisibleMaxCount)
+	{
+		if (scan->blockVisible != NULL)
+			pfree(scan->blockVisible);
+		scan->blockVisibleMaxCount = rowCount;
+		scan->blockVisible = MemoryContextAlloc(scan->aoScanInitContext,
+												scan->blockVisibleMaxCount * sizeof(bool));
+	}
+
+	nvisible = AppendOnlyVisimap_GetVisibleRange(&scan->visibilityMap,
+												 executorReadBlock->segmentFileNum,
+												 executorReadBlock->blockFirstRowNum,
+												 rowCount,
+												 scan->blockVisible);
+
+	scan->blockVisibleFirstRowNum = executorReadBlock->blockFirstRowNum;
+	scan->blockVisibleCount = rowCount;
+	scan->blockAllVisible = (nvisible == rowCount);
+}
+
+/*
+ * Is the tuple visible according to the visi map?
+ */
+static inline bool
+appendonly_tuple_visible(AppendOnlyScanDesc scan, AOTupleId *aoTupleId)
+{
+	int64		index;
+
+	if (scan->blockAllVisible)
+		return true;
+
+	index = AOTupleIdGet_rowNum(aoTupleId) - scan->blockVisibleFirstRowNum;
+	if (index >= 0 && index < scan->blockVisibleCount)
+		return scan->blockVisible[index];
+
+	return AppendOnlyVisimap_IsVisible(&scan->visibilityMap, aoTupleId);
+}
+
+/*
+ * Is a tuple just returned by appendonly_getnext() visible according to the
+ * visi map?
+ *
+ * For scans with SnapshotAny, which return the invisible tuples too.  The
+ * visibility of the whole block is looked up with the first tuple asked
+ * about, so that the caller doesn't go to the visi map for every tuple.
+ */
+bool
+appendonly_tuple_visible_in_scan(AppendOnlyScanDesc scan, AOTupleId *aoTupleId)
+{
+	if (scan->blockVisibleCount == 0 && !scan->blockAllVisible)
+		appendonly_block_visibility(scan);
+
+	return appendonly_tuple_visible(scan, aoTupleId);
+}
+
 /* ----------------
  *		appendonlygettup - fetch next appendonly tuple
  *
@@ -1327,6 +1393,15 @@ appendonlygettup(AppendOnlyScanDesc scan,
 			}
 
 			scan->bufferDone = false;
+
+			if (!isSnapshotAny)
+				appendonly_block_visibility(scan);
+			else
+			{
+				/* Looked up on demand by appendonly_tuple_visible_in_scan() */
+				scan->blockVisibleCount = 0;
+				scan->blockAllVisible = false;
+			}
 		}
 
 		tuple = AppendOnlyExecutorReadBlock_ScanNextTuple(
@@ -1342,7 +1417,7 @@ appendonlygettup(AppendOnlyScanDesc scan,
 			 */
 			AOTupleId  *aoTupleId = (AOTupleId *) slot_get_ctid(slot);
 
-			if (!isSnapshotAny && !AppendOnlyVisimap_IsVisible(&scan->visibilityMap, aoTupleId))
+			if (!isSnapshotAny && !appendonly_tuple_visible(scan, aoTupleId))
 			{
 				/*
 				 * The tuple is invisible.
@@ -1777,6 +1852,8 @@ appendonly_endscan(AppendOnlyScanDesc scan)
 	AppendOnlyExecutorReadBlock_Finish(&scan->executorReadBlock);
 
 	AppendOnlyVisimap_Finish(&scan->visibilityMap, AccessShareLock);
+	if (scan->blockVisible != NULL)
+		pfree(scan->blockVisible);
 	pfree(scan->aos_filenamepath);
 
 	pfree(scan->title);
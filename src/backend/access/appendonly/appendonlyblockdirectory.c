@@ -28,6 +28,7 @@
 
 int			gp_blockdirectory_entry_min_range = 0;
 int			gp_blockdirectory_minipage_size = NUM_MINIPAGE_ENTRIES;
+int			gp_blockdirectory_cache_size = 64;
 
 static inline uint32
 minipage_size(uint32 nEntry)
@@ -62,6 +63,17 @@ static bool insert_new_entry(AppendOnlyBlockDirectory *blockDirectory,
 				 int64 fileOffset,
 				 int64 rowCount,
 				 bool addColAction);
+static bool get_cached_minipages(AppendOnlyBlockDirectory *blockDirectory,
+					 int segmentFileNum,
+					 int64 rowNum);
+static void cache_minipage(AppendOnlyBlockDirectory *blockDirectory,
+			   int segmentFileNum,
+			   int columnGroupNo);
+static MinipageCacheGroup *find_minipage_cache_group(AppendOnlyBlockDirectory *blockDirectory,
+						  int segmentFileNum,
+						  int columnGroupNo,
+						  HASHACTION action);
+static int	find_cached_minipage_pos(MinipageCacheGroup *group, int64 rowNum);
 
 void
 AppendOnlyBlockDirectoryEntry_GetBeginRange(
@@ -154,6 +166,16 @@ init_internal(AppendOnlyBlockDirectory *blockDirectory)
 		minipageInfo->numMinipageEntries = 0;
 	}
 
+	/* The minipage cache is only set up for searches. */
+	blockDirectory->minipageCache = NULL;
+	blockDirectory->minipageCacheGroups = NULL;
+	blockDirectory->minipageCacheFound = NULL;
+	blockDirectory->minipageCacheSize = 0;
+	blockDirectory->numCachedMinipages = 0;
+	blockDirectory->minipageCacheClock = 0;
+	blockDirectory->minipageCacheHits = 0;
+	blockDirectory->minipageCacheMisses = 0;
+
 	MemoryContextSwitchTo(oldcxt);
 }
 
@@ -214,6 +236,30 @@ AppendOnlyBlockDirectory_Init_forSearch(
 		index_open(aoRel->rd_appendonly->blkdiridxid, AccessShareLock);
 
 	init_internal(blockDirectory);
+
+	if (gp_blockdirectory_cache_size > 0)
+	{
+		HASHCTL		hash_ctl;
+
+		MemSet(&hash_ctl, 0, sizeof(hash_ctl));
+		hash_ctl.keysize = sizeof(MinipageCacheKey);
+		hash_ctl.entrysize = sizeof(MinipageCacheGroup);
+		hash_ctl.hash = tag_hash;
+		hash_ctl.hcxt = blockDirectory->memoryContext;
+		blockDirectory->minipageCacheGroups =
+			hash_create("block directory minipage cache",
+						numColumnGroups * 4,
+						&hash_ctl,
+						HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+
+		blockDirectory->minipageCacheSize = gp_blockdirectory_cache_size;
+		blockDirectory->minipageCache =
+			MemoryContextAllocZero(blockDirectory->memoryContext,
+								   sizeof(MinipageCacheEntry) * gp_blockdirectory_cache_size);
+		blockDirectory->minipageCacheFound =
+			MemoryContextAllocZero(blockDirectory->memoryContext,
+								   sizeof(MinipageCacheEntry *) * numColumnGroups);
+	}
 }
 
 /*
@@ -552,6 +598,27 @@ AppendOnlyBlockDirectory_GetEntry(
 
 	Assert(fsInfo != NULL);
 
+	/*
+	 * Try the minipages cached from earlier searches before going to the
+	 * btree index.
+	 */
+	if (blockDirectory->minipageCacheSize > 0 &&
+		get_cached_minipages(blockDirectory, segmentFileNum, rowNum))
+	{
+		blockDirectory->currentSegmentFileNum = segmentFileNum;
+		blockDirectory->currentSegmentFileInfo = fsInfo;
+
+		entry_no = find_minipage_entry(minipageInfo->minipage,
+									   minipageInfo->numMinipageEntries,
+									   rowNum);
+		Assert(entry_no != -1);
+
+		return set_directoryentry_range(blockDirectory,
+										columnGroupNo,
+										entry_no,
+										directoryEntry);
+	}
+
 	/*
 	 * Search the btree index to find the minipage that contains the rowNum.
 	 * We find the minipages for all column groups, since currently we will
@@ -598,6 +665,9 @@ AppendOnlyBlockDirectory_GetEntry(
 							 tuple,
 							 heapTupleDesc,
 							 tmpGroupNo);
+
+			if (blockDirectory->minipageCacheSize > 0)
+				cache_minipage(blockDirectory, segmentFileNum, tmpGroupNo);
 		}
 		else
 		{
@@ -643,6 +713,232 @@ AppendOnlyBlockDirectory_GetEntry(
 	return false;
 }
 
+/*
+ * get_cached_minipages
+ *
+ * Load the minipages of all projected column groups that cover rowNum from
+ * the minipage cache.  Returns false, leaving the in-memory minipages alone,
+ * unless every one of them is cached.
+ */
+static bool
+get_cached_minipages(AppendOnlyBlockDirectory *blockDirectory,
+					 int segmentFileNum,
+					 int64 rowNum)
+{
+	MinipageCacheEntry **found = blockDirectory->minipageCacheFound;
+	int			groupNo;
+
+	for (groupNo = 0; groupNo < blockDirectory->numColumnGroups; groupNo++)
+	{
+		MinipageCacheGroup *group;
+		int			pos;
+
+		found[groupNo] = NULL;
+
+		if (blockDirectory->proj && !blockDirectory->proj[groupNo])
+			continue;
+
+		group = find_minipage_cache_group(blockDirectory, segmentFileNum,
+										  groupNo, HASH_FIND);
+		if (group != NULL)
+		{
+			pos = find_cached_minipage_pos(group, rowNum);
+			if (pos >= 0)
+			{
+				MinipageCacheEntry *cacheEntry = group->entries[pos];
+
+				if (cacheEntry->lastRowNum >= rowNum &&
+					find_minipage_entry(cacheEntry->minipageInfo.minipage,
+										cacheEntry->minipageInfo.numMinipageEntries,
+										rowNum) != -1)
+					found[groupNo] = cacheEntry;
+			}
+		}
+
+		if (found[groupNo] == NULL)
+		{
+			blockDirectory->minipageCacheMisses++;
+			return false;
+		}
+	}
+
+	for (groupNo = 0; groupNo < blockDirectory->numColumnGroups; groupNo++)
+	{
+		MinipagePerColumnGroup *minipageInfo = &blockDirectory->minipages[groupNo];
+		MinipageCacheEntry *cacheEntry = found[groupNo];
+
+		if (cacheEntry == NULL)
+			continue;
+
+		memcpy(minipageInfo->minipage, cacheEntry->minipageInfo.minipage,
+			   minipage_size(cacheEntry->minipageInfo.numMinipageEntries));
+		minipageInfo->numMinipageEntries = cacheEntry->minipageInfo.numMinipageEntries;
+		ItemPointerCopy(&cacheEntry->minipageInfo.tupleTid, &minipageInfo->tupleTid);
+
+		cacheEntry->lastUsed = ++blockDirectory->minipageCacheClock;
+	}
+
+	blockDirectory->minipageCacheHits++;
+
+	return true;
+}
+
+/*
+ * find_minipage_cache_group
+ *
+ * Look up the cached minipages of a column group of a segment file.  With
+ * HASH_ENTER, an empty group is created if there is none yet.
+ */
+static MinipageCacheGroup *
+find_minipage_cache_group(AppendOnlyBlockDirectory *blockDirectory,
+						  int segmentFileNum,
+						  int columnGroupNo,
+						  HASHACTION action)
+{
+	MinipageCacheKey key;
+	MinipageCacheGroup *group;
+	bool		found;
+
+	MemSet(&key, 0, sizeof(key));
+	key.segmentFileNum = segmentFileNum;
+	key.columnGroupNo = columnGroupNo;
+
+	group = (MinipageCacheGroup *) hash_search(blockDirectory->minipageCacheGroups,
+											   &key, action, &found);
+	if (action == HASH_ENTER && !found)
+	{
+		group->numEntries = 0;
+		group->entries =
+			MemoryContextAlloc(blockDirectory->memoryContext,
+							   sizeof(MinipageCacheEntry *) * blockDirectory->minipageCacheSize);
+	}
+
+	return group;
+}
+
+/*
+ * find_cached_minipage_pos
+ *
+ * Binary search the cached minipages of a group for the last one starting
+ * at or before rowNum.  Returns its position, or -1 if there is none.
+ */
+static int
+find_cached_minipage_pos(MinipageCacheGroup *group, int64 rowNum)
+{
+	int			low = 0;
+	int			high = group->numEntries - 1;
+	int			pos = -1;
+
+	while (low <= high)
+	{
+		int			mid = (low + high) / 2;
+
+		if (group->entries[mid]->firstRowNum <= rowNum)
+		{
+			pos = mid;
+			low = mid + 1;
+		}
+		else
+			high = mid - 1;
+	}
+
+	return pos;
+}
+
+/*
+ * cache_minipage
+ *
+ * Add the in-memory minipage of the column group, just loaded from the
+ * block directory relation, to the minipage cache.
+ */
+static void
+cache_minipage(AppendOnlyBlockDirectory *blockDirectory,
+			   int segmentFileNum,
+			   int columnGroupNo)
+{
+	MinipagePerColumnGroup *minipageInfo = &blockDirectory->minipages[columnGroupNo];
+	MinipageCacheGroup *group;
+	MinipageCacheEntry *cacheEntry;
+	MinipageEntry *lastEntry;
+	int64		firstRowNum;
+	int			pos;
+	int			i;
+
+	if (minipageInfo->numMinipageEntries == 0)
+		return;
+
+	firstRowNum = minipageInfo->minipage->entry[0].firstRowNum;
+
+	group = find_minipage_cache_group(blockDirectory, segmentFileNum,
+									  columnGroupNo, HASH_ENTER);
+	pos = find_cached_minipage_pos(group, firstRowNum);
+
+	if (pos >= 0 && group->entries[pos]->firstRowNum == firstRowNum)
+	{
+		/* Already cached, possibly with fewer entries; refresh it. */
+		cacheEntry = group->entries[pos];
+	}
+	else
+	{
+		if (blockDirectory->numCachedMinipages < blockDirectory->minipageCacheSize)
+		{
+			cacheEntry = &blockDirectory->minipageCache[blockDirectory->numCachedMinipages++];
+			cacheEntry->minipageInfo.minipage =
+				MemoryContextAlloc(blockDirectory->memoryContext,
+								   minipage_size(NUM_MINIPAGE_ENTRIES));
+		}
+		else
+		{
+			MinipageCacheGroup *victimGroup;
+			int			victimPos;
+
+			/* Replace the least recently used one. */
+			cacheEntry = &blockDirectory->minipageCache[0];
+			for (i = 1; i < blockDirectory->numCachedMinipages; i++)
+			{
+				if (blockDirectory->minipageCache[i].lastUsed < cacheEntry->lastUsed)
+					cacheEntry = &blockDirectory->minipageCache[i];
+			}
+
+			victimGroup = find_minipage_cache_group(blockDirectory,
+													cacheEntry->segmentFileNum,
+													cacheEntry->columnGroupNo,
+													HASH_FIND);
+			Assert(victimGroup != NULL);
+			victimPos = find_cached_minipage_pos(victimGroup, cacheEntry->firstRowNum);
+			Assert(victimPos >= 0 && victimGroup->entries[victimPos] == cacheEntry);
+			memmove(&victimGroup->entries[victimPos],
+					&victimGroup->entries[victimPos + 1],
+					sizeof(MinipageCacheEntry *) * (victimGroup->numEntries - victimPos - 1));
+			victimGroup->numEntries--;
+
+			if (victimGroup == group)
+				pos = find_cached_minipage_pos(group, firstRowNum);
+		}
+
+		/* Keep the group sorted by first row number. */
+		pos++;
+		memmove(&group->entries[pos + 1],
+				&group->entries[pos],
+				sizeof(MinipageCacheEntry *) * (group->numEntries - pos));
+		group->entries[pos] = cacheEntry;
+		group->numEntries++;
+	}
+
+	lastEntry = &minipageInfo->minipage->entry[minipageInfo->numMinipageEntries - 1];
+
+	cacheEntry->segmentFileNum = segmentFileNum;
+	cacheEntry->columnGroupNo = columnGroupNo;
+	cacheEntry->firstRowNum = firstRowNum;
+	cacheEntry->lastRowNum = lastEntry->firstRowNum + lastEntry->rowCount - 1;
+	cacheEntry->lastUsed = ++blockDirectory->minipageCacheClock;
+
+	memcpy(cacheEntry->minipageInfo.minipage, minipageInfo->minipage,
+		   minipage_size(minipageInfo->numMinipageEntries));
+	cacheEntry->minipageInfo.numMinipageEntries = minipageInfo->numMinipageEntries;
+	ItemPointerCopy(&minipageInfo->tupleTid, &cacheEntry->minipageInfo.tupleTid);
+}
+
 /*
  * AppendOnlyBlockDirectory_InsertEntry
  *
@@ -1274,10 +1570,13 @@ AppendOnlyBlockDirectory_End_forSearch(
 	ereportif(Debug_appendonly_print_blockdirectory, LOG,
 			  (errmsg("Append-only block directory end for search: "
 					  "(totalSegfiles, numColumnGroups, isAOCol)="
-					  "(%d, %d, %d)",
+					  "(%d, %d, %d), "
+					  "minipage cache (hits, misses) = (" INT64_FORMAT ", " INT64_FORMAT ")",
 					  blockDirectory->totalSegfiles,
 					  blockDirectory->numColumnGroups,
-					  blockDirectory->isAOCol)));
+					  blockDirectory->isAOCol,
+					  blockDirectory->minipageCacheHits,
+					  blockDirectory->minipageCacheMisses)));
 
 	pfree(blockDirectory->values);
 	pfree(blockDirectory->nulls);
@@ -71,6 +71,45 @@ test__AppendOnlyVisimapEntry_CoversTuple(void **state)
 	assert_true(result);
 }
 
+void
+test__AppendOnlyVisimapEntry_GetVisibleRange(void **state)
+{
+	bool		visible[200];
+	int			result;
+	int			i;
+
+	AppendOnlyVisimapEntry* visiMapEntry = malloc(sizeof(AppendOnlyVisimapEntry));
+
+	visiMapEntry->segmentFileNum = 1;
+	visiMapEntry->firstRowNum = 32768;
+	visiMapEntry->bitmap = NULL;
+
+	/* Nothing hidden in the entry. */
+	result = AppendOnlyVisimapEntry_GetVisibleRange(visiMapEntry, 32768 + 100, 100, visible);
+	assert_int_equal(result, 100);
+	for (i = 0; i < 100; i++)
+		assert_true(visible[i]);
+
+	/* Hidden rows on both sides of a word boundary, and past the bitmap. */
+	visiMapEntry->bitmap = bms_add_member(NULL, 3);
+	visiMapEntry->bitmap = bms_add_member(visiMapEntry->bitmap, 31);
+	visiMapEntry->bitmap = bms_add_member(visiMapEntry->bitmap, 32);
+	visiMapEntry->bitmap = bms_add_member(visiMapEntry->bitmap, 100);
+
+	result = AppendOnlyVisimapEntry_GetVisibleRange(visiMapEntry, 32768, 200, visible);
+	assert_int_equal(result, 196);
+	for (i = 0; i < 200; i++)
+		assert_true(visible[i] == !(i == 3 || i == 31 || i == 32 || i == 100));
+
+	/* A range starting in the middle of a word. */
+	result = AppendOnlyVisimapEntry_GetVisibleRange(visiMapEntry, 32768 + 30, 5, visible);
+	assert_int_equal(result, 3);
+	assert_true(visible[0]);
+	assert_false(visible[1]);
+	assert_false(visible[2]);
+	assert_true(visible[3]);
+	assert_true(visible[4]);
+}
 
 int
 main(int argc, char *argv[])
@@ -79,7 +118,8 @@ main(int argc, char *argv[])
 
 	const		UnitTest tests[] = {
 		unit_test(test__AppendOnlyVisimapEntry_GetFirstRowNum),
-		unit_test(test__AppendOnlyVisimapEntry_CoversTuple)
+		unit_test(test__AppendOnlyVisimapEntry_CoversTuple),
+		unit_test(test__AppendOnlyVisimapEntry_GetVisibleRange)
 	};
 
 	MemoryContextInit();
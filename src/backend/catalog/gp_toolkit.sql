@@ -2009,7 +2009,8 @@ $$ LANGUAGE plpgsql;
 --        int - sessionid,
 --        int - command_cnt,
 --        timestamptz - time of query start,
---        int - number of files
+--        int - number of files,
+--        bigint - bytes written before compression
 --
 -- @doc:
 --        UDF to retrieve workfile sets currently present on disk on one segment
@@ -2055,7 +2056,8 @@ WITH all_entries AS (
             sessionid int,
             commandid int,
             query_start timestamptz,
-            numfiles int
+            numfiles int,
+            uncompressed_size bigint
           )
     UNION ALL
     SELECT C.*
@@ -2071,7 +2073,8 @@ WITH all_entries AS (
             sessionid int,
             commandid int,
             query_start timestamptz,
-            numfiles int
+            numfiles int,
+            uncompressed_size bigint
           ))
 SELECT S.datname,
        (CASE WHEN (C.state = 1) THEN S.procpid ELSE NULL END) AS procpid,
@@ -2086,7 +2089,8 @@ SELECT S.datname,
        C.size,
        C.numfiles,
        C.path as directory,
-       (CASE WHEN (C.state = 1) THEN 'RUNNING' WHEN (C.state = 2) THEN 'CACHED' WHEN (C.state = 3) THEN 'DELETING' ELSE 'UNKNOWN' END) as state
+       (CASE WHEN (C.state = 1) THEN 'RUNNING' WHEN (C.state = 2) THEN 'CACHED' WHEN (C.state = 3) THEN 'DELETING' ELSE 'UNKNOWN' END) as state,
+       C.uncompressed_size
 FROM all_entries C LEFT OUTER JOIN
 pg_stat_activity as S
 ON C.sessionid = S.sess_id;
@@ -2185,6 +2189,100 @@ ORDER BY segid;
 
 GRANT SELECT ON gp_toolkit.gp_workfile_mgr_used_diskspace TO public;
 
+--------------------------------------------------------------------------------
+-- @function:
+--        gp_toolkit.__gp_interconnect_stats_f
+--
+-- @in:
+--
+-- @out:
+--        int - segment id
+--        bigint - interconnect instances torn down
+--        bigint - packet, ack, retransmit and error counters
+--        bigint - send buffer stalls and time spent waiting for acks (us)
+--        bigint - min/max ack time (us) and ack time histogram
+--
+-- @doc:
+--        UDF to retrieve cumulative interconnect statistics per segment
+--
+--------------------------------------------------------------------------------
+
+CREATE FUNCTION gp_toolkit.__gp_interconnect_stats_f_on_master()
+RETURNS SETOF record
+AS '$libdir/gp_interconnect_stats', 'gp_interconnect_stats'
+LANGUAGE C VOLATILE EXECUTE ON MASTER;
+
+GRANT EXECUTE ON FUNCTION gp_toolkit.__gp_interconnect_stats_f_on_master() TO public;
+
+CREATE FUNCTION gp_toolkit.__gp_interconnect_stats_f_on_segments()
+RETURNS SETOF record
+AS '$libdir/gp_interconnect_stats', 'gp_interconnect_stats'
+LANGUAGE C VOLATILE EXECUTE ON ALL SEGMENTS;
+
+GRANT EXECUTE ON FUNCTION gp_toolkit.__gp_interconnect_stats_f_on_segments() TO public;
+
+--------------------------------------------------------------------------------
+-- @view:
+--        gp_toolkit.gp_interconnect_stats
+--
+-- @doc:
+--        Interconnect flow control statistics accumulated per segment since
+--        startup: packet and ack counts, retransmissions, send buffer stalls
+--        and a histogram of ack round trip times
+--
+--------------------------------------------------------------------------------
+CREATE VIEW gp_toolkit.gp_interconnect_stats AS
+  SELECT C.*
+	FROM gp_toolkit.__gp_interconnect_stats_f_on_master() as C (
+	  segid int,
+	  num_teardowns bigint,
+	  snd_pkt_num bigint,
+	  recv_pkt_num bigint,
+	  recv_ack_num bigint,
+	  retransmits bigint,
+	  crc_errors bigint,
+	  mismatch_pkt_num bigint,
+	  disordered_pkt_num bigint,
+	  duplicated_pkt_num bigint,
+	  status_query_msg_num bigint,
+	  capacity_stalls bigint,
+	  ack_wait_time_us bigint,
+	  min_ack_time_us bigint,
+	  max_ack_time_us bigint,
+	  ack_time_lt_100us bigint,
+	  ack_time_lt_1ms bigint,
+	  ack_time_lt_10ms bigint,
+	  ack_time_lt_100ms bigint,
+	  ack_time_ge_100ms bigint
+	)
+  UNION ALL
+  SELECT C.*
+	FROM gp_toolkit.__gp_interconnect_stats_f_on_segments() as C (
+	  segid int,
+	  num_teardowns bigint,
+	  snd_pkt_num bigint,
+	  recv_pkt_num bigint,
+	  recv_ack_num bigint,
+	  retransmits bigint,
+	  crc_errors bigint,
+	  mismatch_pkt_num bigint,
+	  disordered_pkt_num bigint,
+	  duplicated_pkt_num bigint,
+	  status_query_msg_num bigint,
+	  capacity_stalls bigint,
+	  ack_wait_time_us bigint,
+	  min_ack_time_us bigint,
+	  max_ack_time_us bigint,
+	  ack_time_lt_100us bigint,
+	  ack_time_lt_1ms bigint,
+	  ack_time_lt_10ms bigint,
+	  ack_time_lt_100ms bigint,
+	  ack_time_ge_100ms bigint
+	)
+ORDER BY segid;
+
+GRANT SELECT ON gp_toolkit.gp_interconnect_stats TO public;
+
 --------------------------------------------------------------------------------
 
 -- Finalize install
@@ -1104,6 +1104,18 @@ AppendOnlyStorageRead_CurrentHeaderOffsetInFile(AppendOnlyStorageRead *storageRe
 	return storageRead->current.headerOffsetInFile;
 }
 
+/*
+ * Return the header kind of the current Append-Only Storage Block.
+ */
+int
+AppendOnlyStorageRead_CurrentHeaderKind(AppendOnlyStorageRead *storageRead)
+{
+	Assert(storageRead != NULL);
+	Assert(storageRead->isActive);
+
+	return storageRead->current.headerKind;
+}
+
 /*
  * Return the compressed length of the content of the current Append-Only
  * Storage Block.
@@ -1233,6 +1245,33 @@ AppendOnlyStorageRead_GetBuffer(AppendOnlyStorageRead *storageRead)
 	return content;
 }
 
+/*
+ * Get a pointer to the *small* compressed content, still compressed.
+ *
+ * Like ~_GetBuffer, the pointer is directly into the read buffer and is only
+ * valid until the next block is read.  The block checksum has been verified.
+ * Used to hand a block to a decompression worker.
+ */
+uint8 *
+AppendOnlyStorageRead_GetCompressedBuffer(AppendOnlyStorageRead *storageRead,
+										  int32 *compressedLen)
+{
+	uint8	   *header;
+	uint8	   *content;
+
+	Assert(storageRead != NULL);
+	Assert(storageRead->isActive);
+	Assert(!storageRead->current.isLarge);
+	Assert(storageRead->current.isCompressed);
+
+	AppendOnlyStorageRead_InternalGetBuffer(storageRead,
+											&header,
+											&content);
+
+	*compressedLen = storageRead->current.compressedLen;
+	return content;
+}
+
 /*
  * Copy the large and/or decompressed content out.
  *
@@ -1763,6 +1763,150 @@ AppendOnlyStorageWrite_Content(AppendOnlyStorageWrite *storageWrite,
 	Assert(storageWrite->currentCompleteHeaderLen == 0);
 }
 
+/*
+ * Write a "small" block read from another segment file with the same
+ * storage attributes, without decompressing and compressing it again.  Only
+ * the header is made anew, for the first row number set with
+ * AppendOnlyStorageWrite_SetFirstRowNum.
+ *
+ * aoHeaderKind		- header kind of the block that was read.
+ * data				- the content as stored, compressed if compressedLen > 0.
+ * contentLen		- byte length of the uncompressed content.
+ * compressedLen	- byte length of the compressed content, or 0 when the
+ *					  block was stored uncompressed.
+ * executorBlockKind - executor block kind of the block that was read.
+ * rowCount			- number of rows stored in the content.
+ */
+void
+AppendOnlyStorageWrite_CopyBlock(AppendOnlyStorageWrite *storageWrite,
+								 int aoHeaderKind,
+								 uint8 *data,
+								 int32 contentLen,
+								 int32 compressedLen,
+								 int executorBlockKind,
+								 int rowCount)
+{
+	uint8	   *header;
+	uint8	   *dataBuffer;
+	int32		dataLen;
+	int32		dataRoundedUpLen;
+	int32		completeHeaderLen;
+
+	Assert(storageWrite != NULL);
+	Assert(storageWrite->isActive);
+	Assert(storageWrite->currentCompleteHeaderLen == 0);
+
+	dataLen = (compressedLen > 0) ? compressedLen : contentLen;
+
+	completeHeaderLen =
+		AppendOnlyStorageWrite_CompleteHeaderLen(storageWrite, aoHeaderKind);
+	if (contentLen > storageWrite->maxBufferLen - completeHeaderLen)
+		elog(ERROR,
+			 "Append-only content too large AO storage block (table '%s', "
+			 "content length = %d, maximum buffer length %d, complete header length %d)",
+			 storageWrite->relationName,
+			 contentLen,
+			 storageWrite->maxBufferLen,
+			 completeHeaderLen);
+
+	header = BufferedAppendGetMaxBuffer(&storageWrite->bufferedAppend);
+	if (header == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("We do not expect files to be have a maximum length"),
+				 errcontext_appendonly_write_storage_block(storageWrite)));
+
+	storageWrite->getBufferAoHeaderKind = aoHeaderKind;
+	storageWrite->currentCompleteHeaderLen = completeHeaderLen;
+
+	dataRoundedUpLen = AOStorage_RoundUp(dataLen, storageWrite->formatVersion);
+	dataBuffer = &header[completeHeaderLen];
+	memcpy(dataBuffer, data, dataLen);
+	AOStorage_ZeroPad(dataBuffer, dataLen, dataRoundedUpLen);
+
+	/* Make the header and compute the checksum if necessary. */
+	switch (aoHeaderKind)
+	{
+		case AoHeaderKind_SmallContent:
+			AppendOnlyStorageFormat_MakeSmallContentHeader
+				(header,
+				 storageWrite->storageAttributes.checksum,
+				 storageWrite->isFirstRowNumSet,
+				 storageWrite->formatVersion,
+				 storageWrite->firstRowNum,
+				 executorBlockKind,
+				 rowCount,
+				 contentLen,
+				 compressedLen);
+			break;
+
+		case AoHeaderKind_NonBulkDenseContent:
+			Assert(compressedLen == 0);
+			AppendOnlyStorageFormat_MakeNonBulkDenseContentHeader
+				(header,
+				 storageWrite->storageAttributes.checksum,
+				 storageWrite->isFirstRowNumSet,
+				 storageWrite->formatVersion,
+				 storageWrite->firstRowNum,
+				 executorBlockKind,
+				 rowCount,
+				 contentLen);
+			break;
+
+		case AoHeaderKind_BulkDenseContent:
+			AppendOnlyStorageFormat_MakeBulkDenseContentHeader
+				(header,
+				 storageWrite->storageAttributes.checksum,
+				 storageWrite->isFirstRowNumSet,
+				 storageWrite->formatVersion,
+				 storageWrite->firstRowNum,
+				 executorBlockKind,
+				 rowCount,
+				 contentLen,
+				 compressedLen);
+			break;
+
+		default:
+			elog(ERROR, "unexpected Append-Only header kind %d",
+				 aoHeaderKind);
+			break;
+	}
+
+	if (Debug_appendonly_print_storage_headers)
+	{
+		AppendOnlyStorageWrite_LogBlockHeader(
+			storageWrite,
+			BufferedAppendCurrentBufferPosition(&storageWrite->bufferedAppend),
+			header);
+	}
+
+	elogif(Debug_appendonly_print_insert, LOG,
+		   "Append-only insert copied block for table '%s' "
+		   "(segment file '%s', header offset in file " INT64_FORMAT ", "
+		   "content length = %d, stored length %d, item count %d, block count "
+		   INT64_FORMAT ")",
+		   storageWrite->relationName,
+		   storageWrite->segmentFileName,
+		   BufferedAppendCurrentBufferPosition(&storageWrite->bufferedAppend),
+		   contentLen,
+		   dataLen,
+		   rowCount,
+		   storageWrite->bufferCount);
+
+	storageWrite->logicalBlockStartOffset =
+		BufferedAppendNextBufferPosition(&(storageWrite->bufferedAppend));
+
+	BufferedAppendFinishBuffer(&storageWrite->bufferedAppend,
+							   completeHeaderLen + dataRoundedUpLen,
+							   completeHeaderLen +
+							   AOStorage_RoundUp(contentLen, storageWrite->formatVersion) /* non-compressed size */ );
+
+	/* Declare it finished. */
+	storageWrite->currentCompleteHeaderLen = 0;
+	storageWrite->currentBuffer = NULL;
+	storageWrite->isFirstRowNumSet = false;
+}
+
 /*----------------------------------------------------------------
  * Optional: Set First Row Number
  *----------------------------------------------------------------
@@ -22,6 +22,8 @@
 
 static void BufferedReadIo(
 			   BufferedRead *bufferedRead);
+static void BufferedReadPrefetch(
+			   BufferedRead *bufferedRead);
 static uint8 *BufferedReadUseBeforeBuffer(
 							BufferedRead *bufferedRead,
 							int32 maxReadAheadLen,
@@ -143,6 +145,8 @@ BufferedReadSetFile(
 	bufferedRead->haveTemporaryLimitInEffect = false;
 	bufferedRead->temporaryLimitFileLen = 0;
 
+	bufferedRead->prefetchPosition = 0;
+
 	if (fileLen > 0)
 	{
 		/*
@@ -156,6 +160,46 @@ BufferedReadSetFile(
 	}
 }
 
+/*
+ * Keep gp_appendonly_prefetch_reads large reads beyond the current one
+ * prefetched, so the kernel reads them in while we process the current one.
+ * The window is topped up by one large read each time one is consumed.
+ */
+static void
+BufferedReadPrefetch(
+					 BufferedRead *bufferedRead)
+{
+	int64		inEffectFileLen;
+	int64		readAfterPos;
+	int64		windowEnd;
+
+	if (gp_appendonly_prefetch_reads <= 0)
+		return;
+
+	if (bufferedRead->haveTemporaryLimitInEffect)
+		inEffectFileLen = bufferedRead->temporaryLimitFileLen;
+	else
+		inEffectFileLen = bufferedRead->fileLen;
+
+	readAfterPos = bufferedRead->largeReadPosition + bufferedRead->largeReadLen;
+	windowEnd = readAfterPos +
+		(int64) gp_appendonly_prefetch_reads * bufferedRead->maxLargeReadLen;
+	if (windowEnd > inEffectFileLen)
+		windowEnd = inEffectFileLen;
+
+	if (bufferedRead->prefetchPosition < readAfterPos)
+		bufferedRead->prefetchPosition = readAfterPos;
+
+	if (windowEnd <= bufferedRead->prefetchPosition)
+		return;
+
+	(void) FilePrefetch(bufferedRead->file,
+						bufferedRead->prefetchPosition,
+						(int) (windowEnd - bufferedRead->prefetchPosition));
+
+	bufferedRead->prefetchPosition = windowEnd;
+}
+
 /*
  * Perform a large read i/o.
  */
@@ -166,6 +210,8 @@ BufferedReadIo(
 	int32		largeReadLen;
 	uint8	   *largeReadMemory;
 	int32		offset;
+	instr_time	startTime;
+	instr_time	endTime;
 
 	largeReadLen = bufferedRead->largeReadLen;
 	Assert(bufferedRead->largeReadLen > 0);
@@ -194,6 +240,10 @@ BufferedReadIo(
 	}
 #endif
 
+	BufferedReadPrefetch(bufferedRead);
+
+	INSTR_TIME_SET_CURRENT(startTime);
+
 	offset = 0;
 	while (largeReadLen > 0)
 	{
@@ -241,6 +291,10 @@ BufferedReadIo(
 		offset += actualLen;
 	}
 
+	INSTR_TIME_SET_CURRENT(endTime);
+	INSTR_TIME_ACCUM_DIFF(bufferedRead->ioWaitTime, endTime, startTime);
+	bufferedRead->numLargeReads++;
+
 	if (VacuumCostActive)
 		VacuumCostBalance += VacuumCostPageMiss;
 }
@@ -444,6 +498,11 @@ BufferedReadSetTemporaryRange(
 
 		bufferedRead->largeReadPosition = beginFileOffset;
 
+		/* Prefetch only within the new range. */
+		bufferedRead->prefetchPosition = 0;
+		bufferedRead->haveTemporaryLimitInEffect = true;
+		bufferedRead->temporaryLimitFileLen = afterFileOffset;
+
 		if (bufferedRead->largeReadLen > 0)
 			BufferedReadIo(bufferedRead);
 	}
@@ -699,6 +758,8 @@ BufferedReadCompleteFile(
 
 	bufferedRead->largeReadPosition = 0;
 	bufferedRead->largeReadLen = 0;
+
+	bufferedRead->prefetchPosition = 0;
 }
 
 
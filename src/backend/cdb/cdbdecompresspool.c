@@ -0,0 +1,426 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbdecompresspool.c
+ *	  Pool of threads that decompress Append-Only storage blocks ahead of
+ *	  the executor.
+ *
+ * A column store scan reads one block of every projected column for each
+ * batch of rows, and decompressing those blocks one after the other is
+ * often what bounds the scan.  The datum stream reader hands the next
+ * compressed block of each column to this pool as soon as it has read it,
+ * so the blocks of different columns are decompressed in parallel while the
+ * executor is still consuming the current ones.
+ *
+ * The workers run no backend code at all: no palloc, no elog, no fmgr.  They
+ * only call the thread-safe raw library routine of the codec, on buffers
+ * owned by the pool.  The backend allocates those buffers in the pool's own
+ * memory context before it submits any job, so that they are accounted like
+ * any other backend memory but cannot be freed by an error while a worker
+ * uses them.  Any failure is just reported back; the caller then
+ * decompresses the block again with the regular compression functions,
+ * which raise the proper error.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/cdb/cdbdecompresspool.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include <pthread.h>
+#include <zlib.h>
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+
+#include "postgres.h"
+
+#include "access/xact.h"
+#include "cdb/cdbdecompresspool.h"
+#include "cdb/cdbgang.h"
+#include "miscadmin.h"
+#include "utils/guc.h"
+#include "utils/memutils.h"
+
+typedef enum DecompressCodec
+{
+	DecompressCodec_None = 0,
+	DecompressCodec_Zlib,
+	DecompressCodec_Zstd
+} DecompressCodec;
+
+typedef enum DecompressJobState
+{
+	DecompressJobState_Idle = 0,
+	DecompressJobState_Queued,
+	DecompressJobState_Running,
+	DecompressJobState_Done
+} DecompressJobState;
+
+struct DecompressJob
+{
+	DecompressCodec codec;
+
+	/* Both buffers are bufferLen bytes. */
+	int32		bufferLen;
+	uint8	   *compressed;
+	uint8	   *uncompressed;
+
+	int32		compressedLen;
+	int32		uncompressedLen;
+
+	/* Protected by poolLock. */
+	DecompressJobState state;
+	bool		succeeded;
+	DecompressJob *queueNext;
+
+	/* Links of all acquired jobs, only touched by the backend. */
+	DecompressJob *allPrev;
+	DecompressJob *allNext;
+};
+
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t jobQueued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t jobDone = PTHREAD_COND_INITIALIZER;
+
+static DecompressJob *queueHead = NULL;
+static DecompressJob *queueTail = NULL;
+
+static DecompressJob *allJobs = NULL;
+
+static int	numWorkers = 0;
+static bool xactCallbackRegistered = false;
+
+/* Holds all jobs and their buffers; only touched by the backend. */
+static MemoryContext DecompressPoolContext = NULL;
+
+static DecompressCodec
+DecompressPool_LookupCodec(const char *compressType)
+{
+	if (compressType == NULL)
+		return DecompressCodec_None;
+
+	if (pg_strcasecmp(compressType, "zlib") == 0)
+		return DecompressCodec_Zlib;
+#ifdef HAVE_LIBZSTD
+	if (pg_strcasecmp(compressType, "zstd") == 0)
+		return DecompressCodec_Zstd;
+#endif
+
+	return DecompressCodec_None;
+}
+
+/*
+ * Can blocks compressed with compressType be handed to the pool?
+ */
+bool
+DecompressPool_CodecSupported(const char *compressType)
+{
+	return DecompressPool_LookupCodec(compressType) != DecompressCodec_None;
+}
+
+/*
+ * Decompress one job.  Runs in a worker thread, or in the backend when it
+ * gets to a job before any worker does.
+ */
+static bool
+DecompressPool_RunJob(DecompressJob *job)
+{
+	switch (job->codec)
+	{
+		case DecompressCodec_Zlib:
+			{
+				uLongf		len = job->uncompressedLen;
+
+				if (uncompress(job->uncompressed, &len,
+							   job->compressed, job->compressedLen) != Z_OK)
+					return false;
+				return len == (uLongf) job->uncompressedLen;
+			}
+
+#ifdef HAVE_LIBZSTD
+		case DecompressCodec_Zstd:
+			{
+				size_t		len;
+
+				len = ZSTD_decompress(job->uncompressed, job->uncompressedLen,
+									  job->compressed, job->compressedLen);
+				if (ZSTD_isError(len))
+					return false;
+				return len == (size_t) job->uncompressedLen;
+			}
+#endif
+
+		default:
+			return false;
+	}
+}
+
+/* Remove a queued job from the queue.  Caller holds poolLock. */
+static void
+DecompressPool_Dequeue(DecompressJob *job)
+{
+	DecompressJob *prev = NULL;
+	DecompressJob *cur;
+
+	for (cur = queueHead; cur != NULL; prev = cur, cur = cur->queueNext)
+	{
+		if (cur != job)
+			continue;
+
+		if (prev == NULL)
+			queueHead = cur->queueNext;
+		else
+			prev->queueNext = cur->queueNext;
+		if (queueTail == cur)
+			queueTail = prev;
+		cur->queueNext = NULL;
+		return;
+	}
+}
+
+static void *
+DecompressPool_WorkerMain(void *arg)
+{
+	gp_set_thread_sigmasks();
+
+	pthread_mutex_lock(&poolLock);
+	for (;;)
+	{
+		DecompressJob *job;
+		bool		succeeded;
+
+		while (queueHead == NULL)
+			pthread_cond_wait(&jobQueued, &poolLock);
+
+		job = queueHead;
+		DecompressPool_Dequeue(job);
+		job->state = DecompressJobState_Running;
+		pthread_mutex_unlock(&poolLock);
+
+		succeeded = DecompressPool_RunJob(job);
+
+		pthread_mutex_lock(&poolLock);
+		job->succeeded = succeeded;
+		job->state = DecompressJobState_Done;
+		pthread_cond_broadcast(&jobDone);
+	}
+
+	return NULL;
+}
+
+/*
+ * Start workers up to gp_aocs_decompress_workers.  Workers stay around for
+ * the life of the backend, waiting for jobs.
+ */
+static bool
+DecompressPool_StartWorkers(void)
+{
+	while (numWorkers < gp_aocs_decompress_workers)
+	{
+		pthread_t	thread;
+		int			pthread_err;
+
+		pthread_err = gp_pthread_create(&thread, DecompressPool_WorkerMain,
+										NULL, "DecompressPool_StartWorkers");
+		if (pthread_err != 0)
+		{
+			elog(LOG, "could not start decompression worker: error %d",
+				 pthread_err);
+			break;
+		}
+		pthread_detach(thread);
+		numWorkers++;
+	}
+
+	return numWorkers > 0;
+}
+
+/*
+ * Jobs must not outlive the transaction: the datum streams that own them
+ * go away with the executor's memory at abort without releasing them.
+ */
+static void
+DecompressPool_XactCallback(XactEvent event, void *arg)
+{
+	if (event != XACT_EVENT_COMMIT && event != XACT_EVENT_ABORT)
+		return;
+
+	while (allJobs != NULL)
+		DecompressPool_ReleaseJob(allJobs);
+}
+
+/*
+ * Get a job able to hold blocks of up to bufferLen bytes.
+ *
+ * Returns NULL if the pool is disabled, the codec cannot run in a worker,
+ * or no worker is available; the caller then decompresses the block itself
+ * as usual.
+ */
+DecompressJob *
+DecompressPool_AcquireJob(const char *compressType, int32 bufferLen)
+{
+	DecompressCodec codec;
+	DecompressJob *job;
+
+	if (gp_aocs_decompress_workers <= 0)
+		return NULL;
+
+	codec = DecompressPool_LookupCodec(compressType);
+	if (codec == DecompressCodec_None)
+		return NULL;
+
+	if (!DecompressPool_StartWorkers())
+		return NULL;
+
+	/*
+	 * Jobs are released at the latest at transaction end, see
+	 * DecompressPool_XactCallback(), but must survive an abort until then.
+	 */
+	if (DecompressPoolContext == NULL)
+		DecompressPoolContext = AllocSetContextCreate(TopMemoryContext,
+													  "DecompressPool",
+													  ALLOCSET_DEFAULT_MINSIZE,
+													  ALLOCSET_DEFAULT_INITSIZE,
+													  ALLOCSET_DEFAULT_MAXSIZE);
+
+	job = MemoryContextAllocZero(DecompressPoolContext, sizeof(DecompressJob));
+	job->compressed = MemoryContextAlloc(DecompressPoolContext, bufferLen);
+	job->uncompressed = MemoryContextAlloc(DecompressPoolContext, bufferLen);
+	job->codec = codec;
+	job->bufferLen = bufferLen;
+	job->state = DecompressJobState_Idle;
+
+	job->allNext = allJobs;
+	if (allJobs != NULL)
+		allJobs->allPrev = job;
+	allJobs = job;
+
+	if (!xactCallbackRegistered)
+	{
+		RegisterXactCallback(DecompressPool_XactCallback, NULL);
+		xactCallbackRegistered = true;
+	}
+
+	return job;
+}
+
+/*
+ * Give a job back to the pool, waiting for it first if a worker is on it.
+ */
+void
+DecompressPool_ReleaseJob(DecompressJob *job)
+{
+	DecompressPool_Cancel(job);
+
+	if (job->allPrev != NULL)
+		job->allPrev->allNext = job->allNext;
+	else
+		allJobs = job->allNext;
+	if (job->allNext != NULL)
+		job->allNext->allPrev = job->allPrev;
+
+	pfree(job->compressed);
+	pfree(job->uncompressed);
+	pfree(job);
+}
+
+/*
+ * The buffer to copy the compressed block into before submitting the job.
+ */
+uint8 *
+DecompressPool_JobBuffer(DecompressJob *job)
+{
+	Assert(job->state == DecompressJobState_Idle);
+
+	return job->compressed;
+}
+
+/*
+ * Length of the compressed block last submitted with the job.
+ */
+int32
+DecompressPool_JobCompressedLen(DecompressJob *job)
+{
+	return job->compressedLen;
+}
+
+/*
+ * Queue the compressed block in the job buffer for decompression.
+ */
+void
+DecompressPool_Submit(DecompressJob *job, int32 compressedLen,
+					  int32 uncompressedLen)
+{
+	Assert(job->state == DecompressJobState_Idle);
+	Assert(compressedLen <= job->bufferLen);
+	Assert(uncompressedLen <= job->bufferLen);
+
+	job->compressedLen = compressedLen;
+	job->uncompressedLen = uncompressedLen;
+	job->succeeded = false;
+
+	pthread_mutex_lock(&poolLock);
+	job->state = DecompressJobState_Queued;
+	if (queueTail == NULL)
+		queueHead = job;
+	else
+		queueTail->queueNext = job;
+	queueTail = job;
+	pthread_cond_signal(&jobQueued);
+	pthread_mutex_unlock(&poolLock);
+}
+
+/*
+ * Wait for a submitted job and return its uncompressed block.  A job that no
+ * worker has picked up yet is run right here rather than waited for.
+ *
+ * The returned buffer stays valid until the job is submitted again or
+ * released.  *succeeded is false if the codec reported an error.
+ */
+uint8 *
+DecompressPool_Wait(DecompressJob *job, bool *succeeded)
+{
+	pthread_mutex_lock(&poolLock);
+	Assert(job->state != DecompressJobState_Idle);
+
+	if (job->state == DecompressJobState_Queued)
+	{
+		DecompressPool_Dequeue(job);
+		job->state = DecompressJobState_Running;
+		pthread_mutex_unlock(&poolLock);
+
+		job->succeeded = DecompressPool_RunJob(job);
+
+		pthread_mutex_lock(&poolLock);
+		job->state = DecompressJobState_Done;
+	}
+
+	while (job->state == DecompressJobState_Running)
+		pthread_cond_wait(&jobDone, &poolLock);
+
+	job->state = DecompressJobState_Idle;
+	*succeeded = job->succeeded;
+	pthread_mutex_unlock(&poolLock);
+
+	return job->uncompressed;
+}
+
+/*
+ * Drop a submitted job whose result is no longer wanted.
+ */
+void
+DecompressPool_Cancel(DecompressJob *job)
+{
+	pthread_mutex_lock(&poolLock);
+
+	if (job->state == DecompressJobState_Queued)
+		DecompressPool_Dequeue(job);
+
+	while (job->state == DecompressJobState_Running)
+		pthread_cond_wait(&jobDone, &poolLock);
+
+	job->state = DecompressJobState_Idle;
+	pthread_mutex_unlock(&poolLock);
+}
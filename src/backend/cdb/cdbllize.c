@@ -85,6 +85,7 @@ static bool adjustPlanFlow(Plan *plan,
 			   List *hashExpr);
 
 static void motion_sanity_check(PlannerInfo *root, Plan *plan);
+static void hot_key_sanity_check(PlannerInfo *root, Plan *plan);
 static bool loci_compatible(List *hashExpr1, List *hashExpr2);
 static Plan *materialize_subplan(PlannerInfo *root, Plan *subplan);
 
@@ -281,6 +282,9 @@ cdbparallelize(PlannerInfo *root,
 	if (gp_enable_motion_deadlock_sanity)
 		motion_sanity_check(root, plan);
 
+	if (gp_motion_split_hot_keys)
+		hot_key_sanity_check(root, plan);
+
 	return plan;
 }
 
@@ -1504,6 +1508,117 @@ motion_sanity_walker(Node *node, sanity_result_t *result)
 	return false;
 }
 
+typedef struct hot_key_context
+{
+	plan_tree_base_prefix base; /* Required prefix for
+								 * plan_tree_walker/mutator */
+	bool		anyDistribution;	/* may rows be on any segment? */
+} hot_key_context;
+
+static bool
+has_hot_keys(Plan *plan)
+{
+	return plan && IsA(plan, Motion) &&
+		((Motion *) plan)->motionType == MOTIONTYPE_HASH &&
+		((Motion *) plan)->numHotKeys > 0;
+}
+
+static void
+clear_hot_keys(Plan *plan)
+{
+	if (plan && IsA(plan, Motion))
+	{
+		((Motion *) plan)->numHotKeys = 0;
+		((Motion *) plan)->hotKeyHashes = NULL;
+	}
+}
+
+/*
+ * A hash join whose motions split hot keys (see split_hot_join_keys()) does
+ * not return its rows distributed by the join key.  That is fine as long as
+ * every node between the join and the next Motion above it works on any
+ * distribution of its input; otherwise put the hot keys back where they
+ * hash to.
+ */
+static bool
+hot_key_sanity_walker(Node *node, hot_key_context *context)
+{
+	bool		saved = context->anyDistribution;
+	bool		result;
+
+	if (node == NULL)
+		return false;
+
+	if (!is_plan_node(node))
+	{
+		/* The consumer of a SubPlan may expect anything of it. */
+		if (IsA(node, SubPlan))
+			context->anyDistribution = false;
+		result = plan_tree_walker(node, hot_key_sanity_walker, context);
+		context->anyDistribution = saved;
+		return result;
+	}
+
+	switch (nodeTag(node))
+	{
+		case T_Motion:
+			context->anyDistribution = true;
+			break;
+
+		case T_Result:
+			if (((Result *) node)->hashFilter)
+				context->anyDistribution = false;
+			break;
+
+		case T_Agg:
+			if (((Agg *) node)->aggstrategy != AGG_PLAIN)
+				context->anyDistribution = false;
+			break;
+
+		case T_Material:
+		case T_Sort:
+		case T_Limit:
+		case T_SubqueryScan:
+		case T_Append:
+			break;
+
+		case T_HashJoin:
+			{
+				Plan	   *outer = ((Plan *) node)->lefttree;
+				Plan	   *inner = ((Plan *) node)->righttree->lefttree;
+
+				/* Both sides must still split the keys the planner chose. */
+				if (!context->anyDistribution ||
+					!has_hot_keys(outer) || !has_hot_keys(inner))
+				{
+					clear_hot_keys(outer);
+					clear_hot_keys(inner);
+				}
+			}
+			context->anyDistribution = false;
+			break;
+
+		default:
+			context->anyDistribution = false;
+			break;
+	}
+
+	result = plan_tree_walker(node, hot_key_sanity_walker, context);
+	context->anyDistribution = saved;
+	return result;
+}
+
+static void
+hot_key_sanity_check(PlannerInfo *root, Plan *plan)
+{
+	hot_key_context context;
+
+	planner_init_plan_tree_base(&context.base, root);
+	context.anyDistribution = false;
+
+	hot_key_sanity_walker((Node *) plan, &context);
+}
+
 static void
 motion_sanity_check(PlannerInfo *root, Plan *plan)
 {
@@ -231,6 +231,7 @@ double		gp_motion_cost_per_row = 0;
 int			gp_segments_for_planner = 0;
 
 int			gp_hashagg_default_nbatches = 32;
+double		gp_hashagg_stream_min_reduction = 1.5;
 
 bool		gp_adjust_selectivity_for_outerjoins = TRUE;
 bool		gp_selectivity_damping_for_scans = false;
@@ -239,7 +240,10 @@ double		gp_selectivity_damping_factor = 1;
 bool		gp_selectivity_damping_sigsort = true;
 
 int			gp_hashjoin_tuples_per_bucket = 5;
-int			gp_hashagg_groups_per_bucket = 5;
+bool		gp_enable_runtime_filter = false;
+bool		gp_enable_hashjoin_radix = false;
+int			gp_hashjoin_radix_partition_kb = 512;
+bool		gp_motion_split_hot_keys = false;
 
 
 /* default value to 0, which means we do not try to control number of spill batches */
@@ -294,6 +298,11 @@ double		gp_workfile_limit_per_query = 0;
 
 /* Maximum number of workfiles to be created by a query */
 int			gp_workfile_limit_files_per_query = 0;
+
+/* Reuse spilled results across queries, within this much disk space in kilobytes */
+bool		gp_workfile_caching = false;
+int			gp_workfile_cache_size = 1048576;
+
 int			gp_workfile_bytes_to_checksum = 16;
 
 /* The type of work files that HashJoin should use */
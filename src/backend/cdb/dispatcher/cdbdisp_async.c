@@ -78,6 +78,19 @@ typedef struct CdbDispatchCmdAsync
 	char	   *query_text;
 	int			query_text_len;
 
+	/*
+	 * Poll set of the QEs that are still running, kept compact so that
+	 * collecting results only looks at those.  pollResults[k] is the index
+	 * into dispatchResultPtrArray of the QE whose socket is in pollFds[k].
+	 * QEs are added as they are dispatched and dropped once they finish.
+	 * Both arrays are sized for the largest possible dispatchCount, as is
+	 * flushFds, the poll set of cdbdisp_waitDispatchFinish_async().
+	 */
+	struct pollfd *pollFds;
+	int		   *pollResults;
+	int			numPolled;
+	struct pollfd *flushFds;
+
 } CdbDispatchCmdAsync;
 
 static void *cdbdisp_makeDispatchParams_async(int maxSlices, char *queryText, int len);
@@ -125,7 +138,7 @@ static void
 			handlePollError(CdbDispatchCmdAsync *pParms);
 
 static void
-			handlePollSuccess(CdbDispatchCmdAsync *pParms, struct pollfd *fds);
+			handlePollSuccess(CdbDispatchCmdAsync *pParms, int nfds);
 
 /*
  * Check dispatch result.
@@ -196,15 +209,20 @@ cdbdisp_waitDispatchFinish_async(struct CdbDispatcherState *ds)
 				i;
 	CdbDispatchCmdAsync *pParms = (CdbDispatchCmdAsync *) ds->dispatchParams;
 	int			dispatchCount = pParms->dispatchCount;
+	TimestampTz beforeSend = 0;
+	long		secs;
+	int			usecs;
+
+	if (DEBUG1 >= log_min_messages)
+		beforeSend = GetCurrentTimestamp();
 
-	fds = (struct pollfd *) palloc(dispatchCount * sizeof(struct pollfd));
+	fds = pParms->flushFds;
 
 	while (true)
 	{
 		int			pollRet;
 
 		nfds = 0;
-		memset(fds, 0, dispatchCount * sizeof(struct pollfd));
 
 		for (i = 0; i < dispatchCount; i++)
 		{
@@ -232,6 +250,7 @@ cdbdisp_waitDispatchFinish_async(struct CdbDispatcherState *ds)
 				Assert(sock >= 0);
 				fds[nfds].fd = sock;
 				fds[nfds].events = POLLOUT;
+				fds[nfds].revents = 0;
 				nfds++;
 			}
 			else if (ret < 0)
@@ -264,7 +283,14 @@ cdbdisp_waitDispatchFinish_async(struct CdbDispatcherState *ds)
 			elog(ERROR, "Poll failed during dispatch");
 	}
 
-	pfree(fds);
+	if (DEBUG1 >= log_min_messages)
+	{
+		TimestampDifference(beforeSend, GetCurrentTimestamp(), &secs, &usecs);
+
+		if (secs != 0 || usecs > 1000)	/* Time > 1ms? */
+			elog(LOG, "time for flushing dispatch to %d QEs %ld.%06d",
+				 dispatchCount, secs, usecs);
+	}
 }
 
 /*
@@ -318,6 +344,12 @@ cdbdisp_dispatchToGang_async(struct CdbDispatcherState *ds,
 		pParms->dispatchResultPtrArray[pParms->dispatchCount++] = qeResult;
 
 		dispatchCommand(qeResult, pParms->query_text, pParms->query_text_len);
+
+		/* Collect results from it from now on */
+		pParms->pollFds[pParms->numPolled].fd = PQsocket(segdbDesc->conn);
+		pParms->pollFds[pParms->numPolled].events = POLLIN;
+		pParms->pollResults[pParms->numPolled] = pParms->dispatchCount - 1;
+		pParms->numPolled++;
 	}
 }
 
@@ -377,6 +409,10 @@ cdbdisp_makeDispatchParams_async(int maxSlices, char *queryText, int len)
 	pParms->waitMode = DISPATCH_WAIT_NONE;
 	pParms->query_text = queryText;
 	pParms->query_text_len = len;
+	pParms->pollFds = (struct pollfd *) palloc(maxResults * sizeof(struct pollfd));
+	pParms->pollResults = (int *) palloc(maxResults * sizeof(int));
+	pParms->numPolled = 0;
+	pParms->flushFds = (struct pollfd *) palloc(maxResults * sizeof(struct pollfd));
 
 	return (void *) pParms;
 }
@@ -404,9 +440,15 @@ checkDispatchResult(CdbDispatcherState *ds,
 	bool		sentSignal = false;
 	struct pollfd *fds;
 	uint8 ftsVersion = 0;
+	TimestampTz beforeWait = 0;
+	long		secs;
+	int			usecs;
+
+	if (wait && DEBUG1 >= log_min_messages)
+		beforeWait = GetCurrentTimestamp();
 
 	db_count = pParms->dispatchCount;
-	fds = (struct pollfd *) palloc(db_count * sizeof(struct pollfd));
+	fds = pParms->pollFds;
 
 	/*
 	 * OK, we are finished submitting the command to the segdbs. Now, we have
@@ -414,7 +456,7 @@ checkDispatchResult(CdbDispatcherState *ds,
 	 */
 	for (;;)
 	{
-		int			sock;
+		int			k;
 		int			n;
 		int			nfds = 0;
 		PGconn		*conn;
@@ -435,13 +477,14 @@ checkDispatchResult(CdbDispatcherState *ds,
 			pParms->waitMode = DISPATCH_WAIT_CANCEL;
 
 		/*
-		 * Which QEs are still running and could send results to us?
+		 * Which QEs are still running and could send results to us?  Drop
+		 * the ones that have finished from the poll set.
 		 */
-		for (i = 0; i < db_count; i++)
+		for (k = 0; k < pParms->numPolled; k++)
 		{
+			i = pParms->pollResults[k];
 			dispatchResult = pParms->dispatchResultPtrArray[i];
 			segdbDesc = dispatchResult->segdbDesc;
-			conn = segdbDesc->conn;
 
 			/*
 			 * Already finished with this QE?
@@ -449,6 +492,8 @@ checkDispatchResult(CdbDispatcherState *ds,
 			if (!dispatchResult->stillRunning)
 				continue;
 
+			conn = segdbDesc->conn;
+
 			Assert(!cdbconn_isBadConnection(segdbDesc));
 
 			/*
@@ -468,14 +513,16 @@ checkDispatchResult(CdbDispatcherState *ds,
 			}
 
 			/*
-			 * Add socket to fd_set if still connected.
+			 * Keep its socket in the poll set.
 			 */
-			sock = PQsocket(conn);
-			Assert(sock >= 0);
-			fds[nfds].fd = sock;
+			Assert(PQsocket(conn) == fds[k].fd);
+			fds[nfds].fd = fds[k].fd;
 			fds[nfds].events = POLLIN;
+			fds[nfds].revents = 0;
+			pParms->pollResults[nfds] = i;
 			nfds++;
 		}
+		pParms->numPolled = nfds;
 
 		/*
 		 * Break out when no QEs still running.
@@ -559,10 +606,17 @@ checkDispatchResult(CdbDispatcherState *ds,
 		}
 		/* We have data waiting on one or more of the connections. */
 		else
-			handlePollSuccess(pParms, fds);
+			handlePollSuccess(pParms, nfds);
 	}
 
-	pfree(fds);
+	if (wait && DEBUG1 >= log_min_messages)
+	{
+		TimestampDifference(beforeWait, GetCurrentTimestamp(), &secs, &usecs);
+
+		if (secs != 0 || usecs > 1000)	/* Time > 1ms? */
+			elog(LOG, "time for collecting results from %d QEs %ld.%06d",
+				 db_count, secs, usecs);
+	}
 }
 
 /*
@@ -662,39 +716,30 @@ handlePollError(CdbDispatchCmdAsync *pParms)
  * Receive and process results from QEs.
  */
 static void
-handlePollSuccess(CdbDispatchCmdAsync *pParms,
-				  struct pollfd *fds)
+handlePollSuccess(CdbDispatchCmdAsync *pParms, int nfds)
 {
-	int			currentFdNumber = 0;
-	int			i = 0;
+	struct pollfd *fds = pParms->pollFds;
+	int			k;
 
 	/*
-	 * We have data waiting on one or more of the connections.
+	 * We have data waiting on one or more of the connections.  Only the QEs
+	 * that were polled need to be looked at; with large gangs most of them
+	 * have usually finished already.
 	 */
-	for (i = 0; i < pParms->dispatchCount; i++)
+	for (k = 0; k < nfds; k++)
 	{
 		bool		finished;
-		int			sock;
+		int			i = pParms->pollResults[k];
 		CdbDispatchResult *dispatchResult = pParms->dispatchResultPtrArray[i];
 		SegmentDatabaseDescriptor *segdbDesc = dispatchResult->segdbDesc;
 
-		/*
-		 * Skip if already finished or didn't dispatch.
-		 */
-		if (!dispatchResult->stillRunning)
-			continue;
-
-		ELOG_DISPATCHER_DEBUG("looking for results from %d of %d (%s)",
-							  i + 1, pParms->dispatchCount, segdbDesc->whoami);
-
-		sock = PQsocket(segdbDesc->conn);
-		Assert(sock >= 0);
-		Assert(sock == fds[currentFdNumber].fd);
+		Assert(dispatchResult->stillRunning);
+		Assert(PQsocket(segdbDesc->conn) == fds[k].fd);
 
 		/*
 		 * Skip this connection if it has no input available.
 		 */
-		if (!(fds[currentFdNumber++].revents & POLLIN))
+		if (!(fds[k].revents & POLLIN))
 			continue;
 
 		ELOG_DISPATCHER_DEBUG("PQsocket says there are results from %d of %d (%s)",
@@ -19,6 +19,9 @@
 #include "miscadmin.h"
 #include "libpq/libpq-be.h"
 #include "libpq/ip.h"
+#include "portability/instr_time.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
 #include "utils/builtins.h"
 #include "utils/memutils.h"
 
@@ -76,6 +79,18 @@ static uint16 savedSeqServerPort = 0;
 static interconnect_handle_t *open_interconnect_handles;
 static bool interconnect_resowner_callback_registered;
 
+/* Cumulative statistics of this segment, in shared memory. */
+typedef struct ICSharedStats
+{
+	slock_t		mutex;
+	ICCumulativeStats stats;
+} ICSharedStats;
+
+static ICSharedStats *icSharedStats = NULL;
+
+/* Setup/teardown accounting for this session, see ml_ipc.h */
+ICSessionStats ic_session_stats;
+
 /*=========================================================================
  * FUNCTIONS PROTOTYPES
  */
@@ -683,6 +698,8 @@ SetupInterconnect(EState *estate)
 	interconnect_handle_t *h;
 	ChunkTransportState *icContext = NULL;
 	MemoryContext oldContext;
+	instr_time	startTime;
+	instr_time	elapsed;
 
 	if (estate->interconnect_context)
 	{
@@ -698,6 +715,8 @@ SetupInterconnect(EState *estate)
 	Assert(InterconnectContext != NULL);
 	oldContext = MemoryContextSwitchTo(InterconnectContext);
 
+	INSTR_TIME_SET_CURRENT(startTime);
+
 	if (Gp_interconnect_type == INTERCONNECT_TYPE_UDPIFC)
 		icContext = SetupUDPIFCInterconnect(estate->es_sliceTable);
 	else if (Gp_interconnect_type == INTERCONNECT_TYPE_TCP)
@@ -705,8 +724,15 @@ SetupInterconnect(EState *estate)
 	else
 		Assert("unsupported expected interconnect type");
 
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, startTime);
+
 	/* add back-pointer for dispatch check. */
 	icContext->estate = estate;
+	icContext->setupTimeUs = INSTR_TIME_GET_MICROSEC(elapsed);
+
+	ic_session_stats.setupCount++;
+	ic_session_stats.setupTimeUs += icContext->setupTimeUs;
 
 	MemoryContextSwitchTo(oldContext);
 
@@ -745,6 +771,15 @@ TeardownInterconnect(ChunkTransportState *transportStates,
 					 bool forceEOS, bool hasError)
 {
 	interconnect_handle_t *h = find_interconnect_handle(transportStates);
+	instr_time	startTime;
+	instr_time	elapsed;
+	uint64		setupTimeUs = 0;
+	uint64		teardownTimeUs;
+
+	INSTR_TIME_SET_CURRENT(startTime);
+
+	if (transportStates != NULL)
+		setupTimeUs = transportStates->setupTimeUs;
 
 	if (Gp_interconnect_type == INTERCONNECT_TYPE_UDPIFC)
 	{
@@ -757,6 +792,194 @@ TeardownInterconnect(ChunkTransportState *transportStates,
 
 	if (h != NULL)
 		destroy_interconnect_handle(h);
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, startTime);
+	teardownTimeUs = INSTR_TIME_GET_MICROSEC(elapsed);
+
+	ic_session_stats.teardownCount++;
+	ic_session_stats.teardownTimeUs += teardownTimeUs;
+
+	/*
+	 * Don't log while unwinding from an error; Teardown must not throw (see
+	 * TeardownUDPIFCInterconnect_Internal).
+	 */
+	if (!hasError &&
+		(gp_interconnect_log_stats || gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG))
+		elog((gp_interconnect_log_stats ? LOG : DEBUG1),
+			 "Interconnect setup %.3f ms, teardown %.3f ms "
+			 "(session: " UINT64_FORMAT " setups, %.3f ms setup, %.3f ms teardown)",
+			 setupTimeUs / 1000.0, teardownTimeUs / 1000.0,
+			 ic_session_stats.setupCount,
+			 ic_session_stats.setupTimeUs / 1000.0,
+			 ic_session_stats.teardownTimeUs / 1000.0);
+}
+
+/*
+ * InterconnectShmemSize
+ *		Size of the shared interconnect statistics.
+ */
+Size
+InterconnectShmemSize(void)
+{
+	return MAXALIGN(sizeof(ICSharedStats));
+}
+
+/*
+ * InterconnectShmemInit
+ *		Create or attach to the shared interconnect statistics.
+ */
+void
+InterconnectShmemInit(void)
+{
+	bool		found;
+
+	icSharedStats = (ICSharedStats *)
+		ShmemInitStruct("Interconnect Statistics", InterconnectShmemSize(), &found);
+
+	if (!found)
+	{
+		MemSet(icSharedStats, 0, sizeof(ICSharedStats));
+		SpinLockInit(&icSharedStats->mutex);
+	}
+}
+
+/*
+ * InterconnectAccumulateStats
+ *		Add the statistics of one interconnect instance to the segment totals.
+ *
+ * Called from interconnect teardown, so this must not throw.
+ */
+void
+InterconnectAccumulateStats(const ICCumulativeStats *delta)
+{
+	ICCumulativeStats *stats;
+	int			i;
+
+	if (icSharedStats == NULL)
+		return;
+
+	stats = &icSharedStats->stats;
+
+	SpinLockAcquire(&icSharedStats->mutex);
+
+	stats->numTeardowns += delta->numTeardowns;
+	stats->sndPktNum += delta->sndPktNum;
+	stats->recvPktNum += delta->recvPktNum;
+	stats->recvAckNum += delta->recvAckNum;
+	stats->retransmits += delta->retransmits;
+	stats->crcErrors += delta->crcErrors;
+	stats->mismatchNum += delta->mismatchNum;
+	stats->disorderedPktNum += delta->disorderedPktNum;
+	stats->duplicatedPktNum += delta->duplicatedPktNum;
+	stats->statusQueryMsgNum += delta->statusQueryMsgNum;
+	stats->capacityStalls += delta->capacityStalls;
+	stats->ackWaitTimeUs += delta->ackWaitTimeUs;
+
+	if (delta->minAckTimeUs != 0 &&
+		(stats->minAckTimeUs == 0 || delta->minAckTimeUs < stats->minAckTimeUs))
+		stats->minAckTimeUs = delta->minAckTimeUs;
+	stats->maxAckTimeUs = Max(stats->maxAckTimeUs, delta->maxAckTimeUs);
+
+	for (i = 0; i < IC_ACK_TIME_HIST_BUCKETS; i++)
+		stats->ackTimeHist[i] += delta->ackTimeHist[i];
+
+	SpinLockRelease(&icSharedStats->mutex);
+}
+
+/*
+ * InterconnectGetStats
+ *		Return a consistent copy of the segment's interconnect statistics.
+ */
+void
+InterconnectGetStats(ICCumulativeStats *stats)
+{
+	if (icSharedStats == NULL)
+	{
+		MemSet(stats, 0, sizeof(ICCumulativeStats));
+		return;
+	}
+
+	SpinLockAcquire(&icSharedStats->mutex);
+	memcpy(stats, &icSharedStats->stats, sizeof(ICCumulativeStats));
+	SpinLockRelease(&icSharedStats->mutex);
+}
+
+/*
+ * InterconnectExplainMotion
+ *		Append interconnect statistics of a sending motion to an EXPLAIN
+ *		ANALYZE buffer.
+ */
+void
+InterconnectExplainMotion(ChunkTransportState *transportStates, int motNodeID,
+						  StringInfo buf)
+{
+	if (transportStates == NULL)
+		return;
+
+	if (Gp_interconnect_type == INTERCONNECT_TYPE_UDPIFC)
+		ExplainUDPIFCMotionStats(transportStates, motNodeID, buf);
+}
+
+/*
+ * getInterconnectPeerAddr
+ *		Convert a peer's numeric listener address and port into a sockaddr.
+ */
+void
+getInterconnectPeerAddr(const char *listenerAddr, int listenerPort, int socktype,
+				struct sockaddr_storage *peer, socklen_t *peer_len)
+{
+	int			ret;
+	char		portNumberStr[32];
+	char	   *service;
+	struct addrinfo *addrs = NULL;
+	struct addrinfo hint;
+
+	/* Initialize hint structure */
+	MemSet(&hint, 0, sizeof(hint));
+	hint.ai_socktype = socktype;
+	hint.ai_family = AF_UNSPEC; /* Allow for any family (v4, v6, even unix in
+								 * the future)  */
+#ifdef AI_NUMERICSERV
+	hint.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;	/* Never do name
+														 * resolution */
+#else
+	hint.ai_flags = AI_NUMERICHOST; /* Never do name resolution */
+#endif
+
+	snprintf(portNumberStr, sizeof(portNumberStr), "%d", listenerPort);
+	service = portNumberStr;
+
+	ret = pg_getaddrinfo_all(listenerAddr, service, &hint, &addrs);
+	if (ret || !addrs)
+	{
+		if (addrs)
+			pg_freeaddrinfo_all(hint.ai_family, addrs);
+
+		/* Keep the message each transport reported before sharing this */
+		if (socktype == SOCK_STREAM)
+			ereport(ERROR,
+					(errmsg("could not translate host addr \"%s\", port \"%d\" to address: %s",
+							listenerAddr, listenerPort, gai_strerror(ret))));
+		else
+			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+							errmsg("Interconnect Error: Could not parse remote listener"
+								   "address: '%s' port '%d': %s", listenerAddr, listenerPort, gai_strerror(ret)),
+							errdetail("getaddrinfo() unable to parse address: '%s'",
+									  listenerAddr)));
+		return;
+	}
+
+	/*
+	 * Since we aren't using name resolution, getaddrinfo will return only 1
+	 * entry
+	 */
+	elog(DEBUG1, "GetSockAddr socket ai_family %d ai_socktype %d ai_protocol %d for %s ", addrs->ai_family, addrs->ai_socktype, addrs->ai_protocol, listenerAddr);
+	memset(peer, 0, sizeof(struct sockaddr_storage));
+	memcpy(peer, addrs->ai_addr, addrs->ai_addrlen);
+	*peer_len = addrs->ai_addrlen;
+
+	pg_freeaddrinfo_all(hint.ai_family, addrs);
 }
 
 /*=========================================================================
@@ -626,11 +626,8 @@ setupOutgoingConnection(ChunkTransportState *transportStates, ChunkTransportStat
 	int			sockopt;
 	int			n;
 
-	int			ret;
-	char		portNumberStr[32];
-	char	   *service;
-	struct addrinfo *addrs = NULL;
-	struct addrinfo hint;
+	struct sockaddr_storage peer;
+	socklen_t	peer_len;
 
 	Assert(conn->cdbProc);
 	Assert(conn->state == mcsSetupOutgoingConnection);
@@ -661,43 +658,17 @@ setupOutgoingConnection(ChunkTransportState *transportStates, ChunkTransportStat
 		conn->sockfd = -1;
 	}
 
-	/* Initialize hint structure */
-	MemSet(&hint, 0, sizeof(hint));
-	hint.ai_socktype = SOCK_STREAM;
-	hint.ai_family = AF_UNSPEC; /* Allow for IPv4 or IPv6  */
-#ifdef AI_NUMERICSERV
-	hint.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;	/* Never do name
-														 * resolution */
-#else
-	hint.ai_flags = AI_NUMERICHOST; /* Never do name resolution */
-#endif
-
-	snprintf(portNumberStr, sizeof(portNumberStr), "%d", cdbProc->listenerPort);
-	service = portNumberStr;
-
-	ret = pg_getaddrinfo_all(cdbProc->listenerAddr, service, &hint, &addrs);
-	if (ret || !addrs)
-	{
-		if (addrs)
-			pg_freeaddrinfo_all(hint.ai_family, addrs);
-
-		ereport(ERROR,
-				(errmsg("could not translate host addr \"%s\", port \"%d\" to address: %s",
-						cdbProc->listenerAddr, cdbProc->listenerPort, gai_strerror(ret))));
-
-		return;
-	}
-
 	/*
-	 * Since we aren't using name resolution, getaddrinfo will return only 1
-	 * entry
+	 * Get socketaddr to connect to.  The QE's listener doesn't move for the
+	 * life of the session, so this is normally answered from the peer cache.
 	 */
+	getInterconnectPeerAddr(cdbProc->listenerAddr, cdbProc->listenerPort, SOCK_STREAM,
+							&peer, &peer_len);
 
 	/*
-	 * Create a socket.  getaddrinfo() returns the parameters needed by
-	 * socket()
+	 * Create a socket.
 	 */
-	conn->sockfd = socket(addrs->ai_family, addrs->ai_socktype, addrs->ai_protocol);
+	conn->sockfd = socket(peer.ss_family, SOCK_STREAM, 0);
 	if (conn->sockfd < 0)
 		ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
 						errmsg("Interconnect error setting up outgoing "
@@ -737,11 +708,11 @@ setupOutgoingConnection(ChunkTransportState *transportStates, ChunkTransportStat
 
 
 	struct sockaddr_storage saddr;
-	int			saddr_len = addrs->ai_addrlen;
+	int			saddr_len = peer_len;
 
 	memset(&saddr, 0, sizeof(saddr));
 
-	if (MyProcPort->laddr.addr.ss_family == addrs->ai_family)
+	if (MyProcPort->laddr.addr.ss_family == peer.ss_family)
 	{
 		/* We need to copy the address so we can clear the port */
 
@@ -768,7 +739,7 @@ setupOutgoingConnection(ChunkTransportState *transportStates, ChunkTransportStat
 		 * use bind() but this allows us to get the system assigned source IP
 		 * and port without waiting until after the connect() call.
 		 */
-		saddr.ss_family = addrs->ai_family;
+		saddr.ss_family = peer.ss_family;
 
 		/*
 		 * We could set the address to INADDR_ANY or INADDR_ANY6 but those are
@@ -812,13 +783,12 @@ setupOutgoingConnection(ChunkTransportState *transportStates, ChunkTransportStat
 	{							/* connect() EINTR retry loop */
 		ML_CHECK_FOR_INTERRUPTS(transportStates->teardownActive);
 
-		n = connect(conn->sockfd, addrs->ai_addr, addrs->ai_addrlen);
+		n = connect(conn->sockfd, (struct sockaddr *) &peer, peer_len);
 
 		/* Non-blocking socket never connects immediately, but check anyway. */
 		if (n == 0)
 		{
 			sendRegisterMessage(transportStates, pEntry, conn);
-			pg_freeaddrinfo_all(hint.ai_family, addrs);
 			return;
 		}
 
@@ -831,11 +801,9 @@ setupOutgoingConnection(ChunkTransportState *transportStates, ChunkTransportStat
 			errno == EWOULDBLOCK)
 		{
 			conn->state = mcsConnecting;
-			pg_freeaddrinfo_all(hint.ai_family, addrs);
 			return;
 		}
 
-		pg_freeaddrinfo_all(hint.ai_family, addrs);
 		/* connect() failed.  Log the error.  Caller should retry. */
 		updateOutgoingConnection(transportStates, pEntry, conn, errno);
 		return;
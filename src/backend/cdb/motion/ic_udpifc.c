@@ -608,6 +608,10 @@ typedef struct AckSendParam
  * duplicatedPktNum          - duplicate packet number.
  * recvAckNum                - the number of Acks received.
  * statusQueryMsgNum         - the number of status query messages sent.
+ * capacityStalls            - the number of sends that had to wait for a buffer.
+ * ackWaitTime               - usecs the sender spent waiting for acks.
+ * minAckTime/maxAckTime     - fastest and slowest ack seen (loss based fc only).
+ * ackTimeHist               - histogram of ack times, see IC_ACK_TIME_BUCKET.
  *
  */
 typedef struct ICStatistics
@@ -629,6 +633,11 @@ typedef struct ICStatistics
 	int32		duplicatedPktNum;
 	int32		recvAckNum;
 	int32		statusQueryMsgNum;
+	int32		capacityStalls;
+	uint64		ackWaitTime;
+	uint64		minAckTime;
+	uint64		maxAckTime;
+	uint64		ackTimeHist[IC_ACK_TIME_HIST_BUCKETS];
 } ICStatistics;
 
 /* Statistics for UDP interconnect. */
@@ -655,7 +664,6 @@ static void setRxThreadError(int eno);
 static void resetRxThreadError(void);
 static void SendDummyPacket(void);
 
-static void getSockAddr(struct sockaddr_storage *peer, socklen_t *peer_len, const char *listenerAddr, int listenerPort);
 static void setXmitSocketOptions(int txfd);
 static uint32 setSocketBufferSize(int fd, int type, int expectedSize, int leastSize);
 static void setupUDPListeningSocket(int *listenerSocketFd, uint16 *listenerPort, int *txFamily);
@@ -2662,65 +2670,6 @@ startOutgoingUDPConnections(ChunkTransportState *transportStates,
 }
 
 
-/*
- * getSockAddr
- * 		Convert IP addr and port to sockaddr
- */
-static void
-getSockAddr(struct sockaddr_storage *peer, socklen_t *peer_len, const char *listenerAddr, int listenerPort)
-{
-	int			ret;
-	char		portNumberStr[32];
-	char	   *service;
-	struct addrinfo *addrs = NULL;
-	struct addrinfo hint;
-
-	/*
-	 * Get socketaddr to connect to.
-	 */
-
-	/* Initialize hint structure */
-	MemSet(&hint, 0, sizeof(hint));
-	hint.ai_socktype = SOCK_DGRAM;	/* UDP */
-	hint.ai_family = AF_UNSPEC; /* Allow for any family (v4, v6, even unix in
-								 * the future)  */
-#ifdef AI_NUMERICSERV
-	hint.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;	/* Never do name
-														 * resolution */
-#else
-	hint.ai_flags = AI_NUMERICHOST; /* Never do name resolution */
-#endif
-
-	snprintf(portNumberStr, sizeof(portNumberStr), "%d", listenerPort);
-	service = portNumberStr;
-
-	ret = pg_getaddrinfo_all(listenerAddr, service, &hint, &addrs);
-	if (ret || !addrs)
-	{
-		if (addrs)
-			pg_freeaddrinfo_all(hint.ai_family, addrs);
-
-		ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
-						errmsg("Interconnect Error: Could not parse remote listener"
-							   "address: '%s' port '%d': %s", listenerAddr, listenerPort, gai_strerror(ret)),
-						errdetail("getaddrinfo() unable to parse address: '%s'",
-								  listenerAddr)));
-		return;
-	}
-
-	/*
-	 * Since we aren't using name resolution, getaddrinfo will return only 1
-	 * entry
-	 */
-
-	elog(DEBUG1, "GetSockAddr socket ai_family %d ai_socktype %d ai_protocol %d for %s ", addrs->ai_family, addrs->ai_socktype, addrs->ai_protocol, listenerAddr);
-	memset(peer, 0, sizeof(struct sockaddr_storage));
-	memcpy(peer, addrs->ai_addr, addrs->ai_addrlen);
-	*peer_len = addrs->ai_addrlen;
-
-	pg_freeaddrinfo_all(addrs->ai_family, addrs);
-}
-
 /*
  * setupOutgoingUDPConnection
  *		Setup outgoing UDP connection.
@@ -2748,7 +2697,8 @@ setupOutgoingUDPConnection(ChunkTransportState *transportStates, ChunkTransportS
 	/*
 	 * Get socketaddr to connect to.
 	 */
-	getSockAddr(&conn->peer, &conn->peer_len, cdbProc->listenerAddr, cdbProc->listenerPort);
+	getInterconnectPeerAddr(cdbProc->listenerAddr, cdbProc->listenerPort, SOCK_DGRAM,
+							&conn->peer, &conn->peer_len);
 
 	/* Save the destination IP address */
 	formatSockAddr((struct sockaddr *) &conn->peer, conn->remoteHostAndPort,
@@ -3534,6 +3484,32 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 		 (minRtt == ~((uint64) 0) ? 0 : minRtt), (minDev == ~((uint64) 0) ? 0 : minDev), avgRtt, avgDev, maxRtt, maxDev,
 		 snd_control_info.cwnd, ic_statistics.statusQueryMsgNum);
 
+	/* fold this query's counters into the segment-wide totals */
+	{
+		ICCumulativeStats delta;
+		int			b;
+
+		MemSet(&delta, 0, sizeof(delta));
+		delta.numTeardowns = 1;
+		delta.sndPktNum = ic_statistics.sndPktNum;
+		delta.recvPktNum = ic_statistics.recvPktNum;
+		delta.recvAckNum = ic_statistics.recvAckNum;
+		delta.retransmits = ic_statistics.retransmits;
+		delta.crcErrors = ic_statistics.crcErrors;
+		delta.mismatchNum = ic_statistics.mismatchNum;
+		delta.disorderedPktNum = ic_statistics.disorderedPktNum;
+		delta.duplicatedPktNum = ic_statistics.duplicatedPktNum;
+		delta.statusQueryMsgNum = ic_statistics.statusQueryMsgNum;
+		delta.capacityStalls = ic_statistics.capacityStalls;
+		delta.ackWaitTimeUs = ic_statistics.ackWaitTime;
+		delta.minAckTimeUs = ic_statistics.minAckTime;
+		delta.maxAckTimeUs = ic_statistics.maxAckTime;
+		for (b = 0; b < IC_ACK_TIME_HIST_BUCKETS; b++)
+			delta.ackTimeHist[b] = ic_statistics.ackTimeHist[b];
+
+		InterconnectAccumulateStats(&delta);
+	}
+
 	ic_control_info.isSender = false;
 	memset(&ic_statistics, 0, sizeof(ICStatistics));
 
@@ -4085,6 +4061,11 @@ handleAckedPacket(MotionConn *ackConn, ICBuffer *buf, uint64 now)
 
 		ackTime = now - buf->sentTime;
 
+		if (ic_statistics.minAckTime == 0 || ackTime < ic_statistics.minAckTime)
+			ic_statistics.minAckTime = ackTime;
+		ic_statistics.maxAckTime = Max(ic_statistics.maxAckTime, ackTime);
+		ic_statistics.ackTimeHist[IC_ACK_TIME_BUCKET(ackTime)]++;
+
 		/*
 		 * In udp_testmode, we do not change rtt dynamically due to the large
 		 * number of packet losses introduced by fault injection code. This
@@ -5284,6 +5265,7 @@ SendChunkUDPIFC(ChunkTransportState *transportStates,
 	int			retry = 0;
 	bool		doCheckExpiration = false;
 	bool		gotStops = false;
+	bool		stalled = false;
 
 	Assert(conn->msgSize > 0);
 
@@ -5331,6 +5313,9 @@ SendChunkUDPIFC(ChunkTransportState *transportStates,
 	{
 		int			timeout = (doCheckExpiration ? 0 : computeTimeout(conn, retry));
 
+		if (!doCheckExpiration)
+			stalled = true;
+
 		if (pollAcks(transportStates, pEntry->txfd, timeout))
 		{
 			if (handleAcks(transportStates, pEntry))
@@ -5348,6 +5333,17 @@ SendChunkUDPIFC(ChunkTransportState *transportStates,
 		doCheckExpiration = false;
 	}
 
+	/* account the time we were blocked for lack of a send buffer */
+	if (stalled)
+	{
+		uint64		waited = getCurrentTime() - now;
+
+		pEntry->stat_count_stalls++;
+		pEntry->stat_ack_wait_time += waited;
+		ic_statistics.capacityStalls++;
+		ic_statistics.ackWaitTime += waited;
+	}
+
 	conn->pBuff = (uint8 *) conn->curBuff->pkt;
 
 	if (gotStops)
@@ -5390,6 +5386,8 @@ SendEosUDPIFC(ChunkTransportState *transportStates,
 	int			retry = 0;
 	int			activeCount = 0;
 	int			timeout = 0;
+	uint64		waitStart;
+	uint64		waited;
 
 	if (!transportStates)
 	{
@@ -5464,6 +5462,8 @@ SendEosUDPIFC(ChunkTransportState *transportStates,
 	 *
 	 */
 
+	waitStart = getCurrentTime();
+
 	while (activeCount > 0)
 	{
 		activeCount = 0;
@@ -5506,6 +5506,10 @@ SendEosUDPIFC(ChunkTransportState *transportStates,
 		}
 	}
 
+	waited = getCurrentTime() - waitStart;
+	pEntry->stat_ack_wait_time += waited;
+	ic_statistics.ackWaitTime += waited;
+
 	if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG)
 		elog(DEBUG1, "SendEosUDPIFC leaving, activeCount %d", activeCount);
 }
@@ -6923,3 +6927,66 @@ getActiveMotionConns(void)
 {
 	return ic_statistics.activeConnectionsNum;
 }
+
+/*
+ * ExplainUDPIFCMotionStats
+ *		Describe the flow control behaviour of a sending motion for EXPLAIN
+ *		ANALYZE: ack latency, retransmissions, time spent waiting for send
+ *		buffers and the receiver that was slowest to ack.
+ */
+void
+ExplainUDPIFCMotionStats(ChunkTransportState *transportStates, int motNodeID,
+						 StringInfo buf)
+{
+	ChunkTransportStateEntry *pEntry;
+	MotionConn *slowest = NULL;
+	double		slowestAvg = 0;
+	int			i;
+
+	if (!chunkTransportStateEntryInitialized(transportStates, motNodeID))
+		return;
+
+	pEntry = &transportStates->states[motNodeID - 1];
+	if (pEntry->conns == NULL)
+		return;
+
+	aggregateStatistics(pEntry);
+
+	if (pEntry->stat_count_acks == 0 && pEntry->stat_count_stalls == 0)
+		return;
+
+	for (i = 0; i < pEntry->numConns; i++)
+	{
+		MotionConn *conn = &pEntry->conns[i];
+		double		avg;
+
+		if (conn->stat_count_acks == 0)
+			continue;
+
+		avg = (double) conn->stat_total_ack_time / conn->stat_count_acks;
+		if (slowest == NULL || avg > slowestAvg)
+		{
+			slowest = conn;
+			slowestAvg = avg;
+		}
+	}
+
+	appendStringInfo(buf, "Interconnect: " UINT64_FORMAT " acks", pEntry->stat_count_acks);
+	if (pEntry->stat_count_acks > 0)
+		appendStringInfo(buf, ", ack time avg %.3f min %.3f max %.3f ms",
+						 (double) pEntry->stat_total_ack_time / pEntry->stat_count_acks / 1000.0,
+						 (double) pEntry->stat_min_ack_time / 1000.0,
+						 (double) pEntry->stat_max_ack_time / 1000.0);
+	appendStringInfo(buf, ", " UINT64_FORMAT " resent (max " UINT64_FORMAT ")",
+					 pEntry->stat_count_resent, pEntry->stat_max_resent);
+	if (pEntry->stat_count_dropped > 0)
+		appendStringInfo(buf, ", " UINT64_FORMAT " dropped",
+						 pEntry->stat_count_dropped);
+	appendStringInfo(buf, ", " UINT64_FORMAT " stalls waiting %.3f ms",
+					 pEntry->stat_count_stalls,
+					 (double) pEntry->stat_ack_wait_time / 1000.0);
+	if (slowest != NULL && pEntry->numConns > 1)
+		appendStringInfo(buf, ", slowest receiver seg%d (%.3f ms avg)",
+						 slowest->remoteContentId, slowestAvg / 1000.0);
+	appendStringInfoString(buf, ".\n");
+}
@@ -848,6 +848,128 @@ DeserializeTuple(SerTupInfo *pSerInfo, StringInfo serialTup)
 	return htup;
 }
 
+/*
+ * Form a tuple from its serialized representation.
+ *
+ * 'serData' holds exactly one serialized tuple (no chunk headers).  The
+ * result is palloc'd in the current memory context; 'serData' is not
+ * modified except for its cursor, so it may point straight into a receive
+ * buffer.  Returns NULL for the special record-cache tuple.
+ */
+static GenericTuple
+CvtSerializedDataToTup(StringInfo serData, SerTupInfo *pSerInfo, TupleRemapper *remapper)
+{
+	TupSerHeader *tshp;
+	unsigned int datalen;
+	unsigned int nullslen;
+	unsigned int hoff;
+	HeapTupleHeader t_data;
+	HeapTuple	htup;
+	GenericTuple tup;
+	char	   *pos = (char *) serData->data;
+
+	tshp = (TupSerHeader *) pos;
+
+	if (!(tshp->tuplen & MEMTUP_LEAD_BIT) &&
+		tshp->natts == RECORD_CACHE_MAGIC_NATTS &&
+		tshp->infomask == RECORD_CACHE_MAGIC_INFOMASK)
+	{
+		uint32		tuplen = tshp->tuplen & ~MEMTUP_LEAD_BIT;
+
+		/* a special tuple with record type cache */
+		List	   *typelist = (List *) deserializeNode(pos + sizeof(TupSerHeader),
+														tuplen - sizeof(TupSerHeader));
+
+		TRHandleTypeLists(remapper, typelist);
+
+		return NULL;
+	}
+
+	if ((tshp->tuplen & MEMTUP_LEAD_BIT) != 0)
+	{
+		uint32		tuplen = memtuple_size_from_uint32(tshp->tuplen);
+
+		tup = (GenericTuple) palloc(tuplen);
+		memcpy(tup, pos, tuplen);
+
+		return tup;
+	}
+
+	pos += sizeof(TupSerHeader);
+
+	/*
+	 * if the tuple had toasted elements we have to deserialize the old slow
+	 * way.
+	 */
+	if ((tshp->infomask & HEAP_HASEXTERNAL) != 0)
+	{
+		serData->cursor += sizeof(TupSerHeader);
+
+		return (GenericTuple) DeserializeTuple(pSerInfo, serData);
+	}
+
+	/* reconstruct lengths of null bitmap and data part */
+	if (tshp->infomask & HEAP_HASNULL)
+		nullslen = BITMAPLEN(tshp->natts);
+	else
+		nullslen = 0;
+
+	if (tshp->tuplen < sizeof(TupSerHeader) + nullslen)
+		ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+						errmsg("Interconnect error: cannot convert chunks to a  heap tuple."),
+						errdetail("tuple len %d < nullslen %d + headersize (%d)",
+								  tshp->tuplen, nullslen, (int) sizeof(TupSerHeader))));
+
+	datalen = tshp->tuplen - sizeof(TupSerHeader) - TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen);
+
+	/* determine overhead size of tuple (should match heap_form_tuple) */
+	hoff = offsetof(HeapTupleHeaderData, t_bits) + TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen);
+	if (tshp->infomask & HEAP_HASOID)
+		hoff += sizeof(Oid);
+	hoff = MAXALIGN(hoff);
+
+	/* Allocate the space in one chunk, like heap_form_tuple */
+	htup = (HeapTuple) palloc(HEAPTUPLESIZE + hoff + datalen);
+	tup = (GenericTuple) htup;
+
+	t_data = (HeapTupleHeader) ((char *) htup + HEAPTUPLESIZE);
+
+	/* make sure unused header fields are zeroed */
+	MemSetAligned(t_data, 0, hoff);
+
+	/* reconstruct the HeapTupleData fields */
+	htup->t_len = hoff + datalen;
+	ItemPointerSetInvalid(&(htup->t_self));
+	htup->t_data = t_data;
+
+	/* reconstruct the HeapTupleHeaderData fields */
+	ItemPointerSetInvalid(&(t_data->t_ctid));
+	HeapTupleHeaderSetNatts(t_data, tshp->natts);
+	t_data->t_infomask = tshp->infomask & ~HEAP_XACT_MASK;
+	t_data->t_infomask |= HEAP_XMIN_INVALID | HEAP_XMAX_INVALID;
+	t_data->t_hoff = hoff;
+
+	if (nullslen)
+	{
+		memcpy((void *) t_data->t_bits, pos, nullslen);
+		pos += TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen);
+	}
+
+	/*
+	 * does the tuple descriptor expect an OID ? Note: we don't have to set
+	 * the oid itself, just the flag! (see heap_formtuple())
+	 */
+	if (pSerInfo->tupdesc->tdhasoid)	/* else leave infomask = 0 */
+	{
+		t_data->t_infomask |= HEAP_HASOID;
+	}
+
+	/* and now the data proper */
+	memcpy((char *) t_data + hoff, pos, datalen);
+
+	return tup;
+}
+
 GenericTuple
 CvtChunksToTup(TupleChunkList tcList, SerTupInfo *pSerInfo, TupleRemapper *remapper)
 {
@@ -878,12 +1000,35 @@ CvtChunksToTup(TupleChunkList tcList, SerTupInfo *pSerInfo, TupleRemapper *remap
 			return (GenericTuple)
 				heap_form_tuple(pSerInfo->tupdesc, pSerInfo->values, pSerInfo->nulls);
 		}
+
+		if (tcType != TC_WHOLE)
+		{
+			ereport(ERROR, (errcode(ERRCODE_PROTOCOL_VIOLATION),
+							errmsg("Single chunk's type must be TC_WHOLE.")));
+		}
+
+		/*
+		 * Fast path for the common case of a tuple that fits in one chunk:
+		 * form the tuple straight from the chunk data, which is still valid
+		 * (it may well be an in-place receive buffer) until we clear the
+		 * list, instead of copying it into a staging buffer first.
+		 */
+		serData.data = (char *) GetChunkDataPtr(tcItem) + TUPLE_CHUNK_HEADER_SIZE;
+		serData.len = tcItem->chunk_length - TUPLE_CHUNK_HEADER_SIZE;
+		serData.maxlen = serData.len;
+		serData.cursor = 0;
+
+		tup = CvtSerializedDataToTup(&serData, pSerInfo, remapper);
+
+		clearTCList(NULL, tcList);
+
+		return tup;
 	}
 
 	/*
 	 * Dump all of the data in the tuple chunk list into a single StringInfo,
 	 * so that we can convert it into a HeapTuple.	Check chunk types based on
-	 * whether there is only one chunk, or multiple chunks.
+	 * whether this is the first, a middle, or the last chunk.
 	 *
 	 * We know roughly how much space we'll need, allocate all in one go.
 	 *
@@ -898,23 +1043,11 @@ CvtChunksToTup(TupleChunkList tcList, SerTupInfo *pSerInfo, TupleRemapper *remap
 		GetChunkType(tcItem, &tcType);
 		if (i == 0)
 		{
-			if (tcItem->p_next == NULL)
-			{
-				if (tcType != TC_WHOLE)
-				{
-					ereport(ERROR, (errcode(ERRCODE_PROTOCOL_VIOLATION),
-									errmsg("Single chunk's type must be TC_WHOLE.")));
-				}
-			}
-			else
-				/* tcItem->p_next != NULL */
+			if (tcType != TC_PARTIAL_START)
 			{
-				if (tcType != TC_PARTIAL_START)
-				{
-					ereport(ERROR, (errcode(ERRCODE_PROTOCOL_VIOLATION),
-									errmsg("First chunk of collection must have type"
-										   " TC_PARTIAL_START.")));
-				}
+				ereport(ERROR, (errcode(ERRCODE_PROTOCOL_VIOLATION),
+								errmsg("First chunk of collection must have type"
+									   " TC_PARTIAL_START.")));
 			}
 		}
 		else
@@ -955,128 +1088,7 @@ CvtChunksToTup(TupleChunkList tcList, SerTupInfo *pSerInfo, TupleRemapper *remap
 	/* we've finished with the TCList, free it now. */
 	clearTCList(NULL, tcList);
 
-	{
-		TupSerHeader *tshp;
-		unsigned int datalen;
-		unsigned int nullslen;
-		unsigned int hoff;
-		HeapTupleHeader t_data;
-		char	   *pos = (char *) serData.data;
-
-		tshp = (TupSerHeader *) pos;
-
-		if (!(tshp->tuplen & MEMTUP_LEAD_BIT) &&
-			tshp->natts == RECORD_CACHE_MAGIC_NATTS &&
-			tshp->infomask == RECORD_CACHE_MAGIC_INFOMASK)
-		{
-			uint32		tuplen = tshp->tuplen & ~MEMTUP_LEAD_BIT;
-
-			/* a special tuple with record type cache */
-			List	   *typelist = (List *) deserializeNode(pos + sizeof(TupSerHeader),
-															tuplen - sizeof(TupSerHeader));
-
-			TRHandleTypeLists(remapper, typelist);
-
-			/* Free up memory we used. */
-			pfree(serData.data);
-
-			return NULL;
-		}
-
-		if ((tshp->tuplen & MEMTUP_LEAD_BIT) != 0)
-		{
-			uint32		tuplen = memtuple_size_from_uint32(tshp->tuplen);
-
-			tup = (GenericTuple) palloc(tuplen);
-			memcpy(tup, pos, tuplen);
-
-			pos += TYPEALIGN(TUPLE_CHUNK_ALIGN, tuplen);
-		}
-		else
-		{
-			HeapTuple htup;
-
-			pos += sizeof(TupSerHeader);
-
-			/*
-			 * if the tuple had toasted elements we have to deserialize the
-			 * old slow way.
-			 */
-			if ((tshp->infomask & HEAP_HASEXTERNAL) != 0)
-			{
-				serData.cursor += sizeof(TupSerHeader);
-
-				tup = (GenericTuple) DeserializeTuple(pSerInfo, &serData);
-
-				/* Free up memory we used. */
-				pfree(serData.data);
-				return tup;
-			}
-
-			/* reconstruct lengths of null bitmap and data part */
-			if (tshp->infomask & HEAP_HASNULL)
-				nullslen = BITMAPLEN(tshp->natts);
-			else
-				nullslen = 0;
-
-			if (tshp->tuplen < sizeof(TupSerHeader) + nullslen)
-				ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
-								errmsg("Interconnect error: cannot convert chunks to a  heap tuple."),
-								errdetail("tuple len %d < nullslen %d + headersize (%d)",
-										  tshp->tuplen, nullslen, (int) sizeof(TupSerHeader))));
-
-			datalen = tshp->tuplen - sizeof(TupSerHeader) - TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen);
-
-			/* determine overhead size of tuple (should match heap_form_tuple) */
-			hoff = offsetof(HeapTupleHeaderData, t_bits) + TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen);
-			if (tshp->infomask & HEAP_HASOID)
-				hoff += sizeof(Oid);
-			hoff = MAXALIGN(hoff);
-
-			/* Allocate the space in one chunk, like heap_form_tuple */
-			htup = (HeapTuple) palloc(HEAPTUPLESIZE + hoff + datalen);
-			tup = (GenericTuple) htup;
-
-			t_data = (HeapTupleHeader) ((char *) htup + HEAPTUPLESIZE);
-
-			/* make sure unused header fields are zeroed */
-			MemSetAligned(t_data, 0, hoff);
-
-			/* reconstruct the HeapTupleData fields */
-			htup->t_len = hoff + datalen;
-			ItemPointerSetInvalid(&(htup->t_self));
-			htup->t_data = t_data;
-
-			/* reconstruct the HeapTupleHeaderData fields */
-			ItemPointerSetInvalid(&(t_data->t_ctid));
-			HeapTupleHeaderSetNatts(t_data, tshp->natts);
-			t_data->t_infomask = tshp->infomask & ~HEAP_XACT_MASK;
-			t_data->t_infomask |= HEAP_XMIN_INVALID | HEAP_XMAX_INVALID;
-			t_data->t_hoff = hoff;
-
-			if (nullslen)
-			{
-				memcpy((void *) t_data->t_bits, pos, nullslen);
-				pos += TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen);
-			}
-
-			/*
-			 * does the tuple descriptor expect an OID ? Note: we don't have
-			 * to set the oid itself, just the flag! (see heap_formtuple())
-			 */
-			if (pSerInfo->tupdesc->tdhasoid)	/* else leave infomask = 0 */
-			{
-				t_data->t_infomask |= HEAP_HASOID;
-			}
-
-			/*
-			 * and now the data proper (it would be nice if we could just
-			 * point our caller into our existing buffer in-place, but we'll
-			 * leave that for another day)
-			 */
-			memcpy((char *) t_data + hoff, pos, datalen);
-		}
-	}
+	tup = CvtSerializedDataToTup(&serData, pSerInfo, remapper);
 
 	/* Free up memory we used. */
 	pfree(serData.data);
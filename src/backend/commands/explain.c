@@ -1617,6 +1617,11 @@ ExplainNode(Plan *plan, PlanState *planstate,
 							pMotion->sortColIdx,
 							"Merge Key",
 							es);
+				if (pMotion->numHotKeys > 0)
+					ExplainPropertyInteger(pMotion->hotKeysBroadcast ?
+										   "Hot Keys Broadcast" :
+										   "Hot Keys Spread",
+										   pMotion->numHotKeys, es);
 			}
 			break;
 		case T_AssertOp:
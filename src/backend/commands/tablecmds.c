@@ -17,6 +17,7 @@
 #include "postgres.h"
 
 #include "access/aocs_compaction.h"
+#include "access/appendonly_visimap.h"
 #include "access/appendonlywriter.h"
 #include "access/bitmap.h"
 #include "access/genam.h"
@@ -72,6 +73,7 @@
 #include "optimizer/plancat.h"
 #include "optimizer/planner.h"
 #include "optimizer/prep.h"
+#include "optimizer/var.h"
 #include "parser/gramparse.h"
 #include "parser/parse_clause.h"
 #include "parser/parse_coerce.h"
@@ -284,6 +286,9 @@ static void ATAocsWriteNewColumns(
 		AOCSAddColumnDesc idesc, AOCSHeaderScanDesc sdesc,
 		AlteredTableInfo *tab, ExprContext *econtext, TupleTableSlot *slot);
 static bool ATAocsNoRewrite(AlteredTableInfo *tab);
+static bool *ATAocsCopiedColumns(AlteredTableInfo *tab, Relation oldrel,
+					Relation newrel, TupleDesc oldTupDesc,
+					List *notnull_attrs, bool *proj);
 static AlteredTableInfo *ATGetQueueEntry(List **wqueue, Relation rel);
 static void ATSimplePermissions(Relation rel, bool allowView);
 static void ATSimplePermissionsRelationOrIndex(Relation rel);
@@ -5154,6 +5159,130 @@ column_to_scan(AOCSFileSegInfo **segInfos, int nseg, int natts, Relation aocsrel
 	return scancol;
 }
 
+/*
+ * ATAocsCopiedColumns: Find the columns of an AOCS table rewrite whose
+ * blocks can be copied to the new table as they are, and take out of the
+ * scan projection proj those that no longer need to be decoded.
+ *
+ * A column is copied if the rewrite computes no new value for it and its
+ * type and encoding are the same in both tables.  It is still decoded if a
+ * new column value or a constraint refers to it.  Copying relies on every
+ * row of an old segment file being inserted into the new table, so it is
+ * not done when the visibility map hides any row of the old table.
+ *
+ * Return NULL if no column can be copied.
+ */
+static bool *
+ATAocsCopiedColumns(AlteredTableInfo *tab, Relation oldrel, Relation newrel,
+					TupleDesc oldTupDesc, List *notnull_attrs, bool *proj)
+{
+	AppendOnlyVisimap visiMap;
+	AOCSFileSegInfo **segInfos;
+	int			nseg;
+	int64		hiddenTupcount;
+	Bitmapset  *refattrs = NULL;
+	bool	   *copiedCols;
+	int			firstCopied = -1;
+	bool		anyProjected = false;
+	ListCell   *l;
+	int			i;
+
+	if (!gp_aocs_rewrite_copy_blocks)
+		return NULL;
+
+	AppendOnlyVisimap_Init(&visiMap,
+						   oldrel->rd_appendonly->visimaprelid,
+						   oldrel->rd_appendonly->visimapidxid,
+						   AccessShareLock,
+						   SnapshotNow);
+	hiddenTupcount = AppendOnlyVisimap_GetRelationHiddenTupleCount(&visiMap);
+	AppendOnlyVisimap_Finish(&visiMap, AccessShareLock);
+	if (hiddenTupcount > 0)
+		return NULL;
+
+	/* Blocks of older format versions are converted as they are read */
+	segInfos = GetAllAOCSFileSegInfo(oldrel, SnapshotNow, &nseg);
+	for (i = 0; i < nseg; i++)
+	{
+		if (segInfos[i]->state != AOSEG_STATE_AWAITING_DROP &&
+			segInfos[i]->formatversion != AORelationVersion_GetLatest())
+			break;
+	}
+	if (segInfos)
+	{
+		FreeAllAOCSSegFileInfo(segInfos, nseg);
+		pfree(segInfos);
+	}
+	if (i < nseg)
+		return NULL;
+
+	foreach(l, tab->newvals)
+	{
+		NewColumnValue *ex = lfirst(l);
+
+		pull_varattnos((Node *) ex->expr, &refattrs);
+	}
+	foreach(l, tab->constraints)
+	{
+		NewConstraint *con = lfirst(l);
+
+		if (con->contype == CONSTR_CHECK)
+			pull_varattnos(con->qual, &refattrs);
+	}
+
+	/* A whole-row reference needs all the columns */
+	if (bms_is_member(InvalidAttrNumber - FirstLowInvalidHeapAttributeNumber,
+					  refattrs))
+		return NULL;
+
+	copiedCols = palloc0(sizeof(bool) * RelationGetNumberOfAttributes(newrel));
+
+	for (i = 0; i < oldTupDesc->natts; i++)
+	{
+		bool		copy;
+
+		if (!proj[i])
+			continue;
+
+		copy = aocs_column_can_copy(oldrel, oldTupDesc, newrel, i);
+		foreach(l, tab->newvals)
+		{
+			NewColumnValue *ex = lfirst(l);
+
+			if (ex->attnum - 1 == i)
+				copy = false;
+		}
+
+		if (!copy)
+		{
+			anyProjected = true;
+			continue;
+		}
+
+		copiedCols[i] = true;
+		if (firstCopied < 0)
+			firstCopied = i;
+
+		if (bms_is_member(i + 1 - FirstLowInvalidHeapAttributeNumber, refattrs) ||
+			list_member_int(notnull_attrs, i))
+			anyProjected = true;
+		else
+			proj[i] = false;
+	}
+
+	if (firstCopied < 0)
+	{
+		pfree(copiedCols);
+		return NULL;
+	}
+
+	/* The scan still has to go through the rows */
+	if (!anyProjected)
+		proj[firstCopied] = true;
+
+	return copiedCols;
+}
+
 /*
  * ATAocsNoRewrite: Leverage column orientation to avoid rewrite.
  *
@@ -5746,6 +5875,10 @@ ATRewriteTable(AlteredTableInfo *tab, Oid OIDNewHeap)
 			AOCSScanDesc sdesc = NULL;
 			int nvp = oldrel->rd_att->natts;
 			bool *proj = palloc0(sizeof(bool) * nvp);
+			bool *copiedCols = NULL;
+			int copySegno = -1;
+			int64 copySegRows = 0;
+			int64 copySegInserted = 0;
 
 			/*
 			 * We use the old tuple descriptor instead of oldrel's tuple descriptor,
@@ -5760,14 +5893,47 @@ ATRewriteTable(AlteredTableInfo *tab, Oid OIDNewHeap)
 				memset(proj, true, nvp);
 
 			if(newrel)
+			{
 				idesc = aocs_insert_init(newrel, segno, false);
 
+				/*
+				 * Columns that come out of the rewrite unchanged have their
+				 * blocks copied a segment file at a time, ahead of the rows
+				 * of the segment file.
+				 */
+				copiedCols = ATAocsCopiedColumns(tab, oldrel, newrel, oldTupDesc,
+												 notnull_attrs, proj);
+				if (copiedCols)
+					aocs_insert_setcopiedcols(idesc, copiedCols);
+			}
+
 			sdesc = aocs_beginscan(oldrel, SnapshotNow, SnapshotNow, oldTupDesc, proj);
 
 			aocs_getnext(sdesc, ForwardScanDirection, oldslot);
 
 			while(!TupIsNull(oldslot))
 			{
+				if (copiedCols)
+				{
+					int rowSegno = AOTupleIdGet_segmentFileNum((AOTupleId *) slot_get_ctid(oldslot));
+
+					if (rowSegno != copySegno)
+					{
+						if (copySegno >= 0 && copySegInserted != copySegRows)
+							elog(ERROR, "copied " INT64_FORMAT " rows of segno %d of relation \"%s\" but scanned " INT64_FORMAT,
+								 copySegRows, copySegno,
+								 RelationGetRelationName(oldrel),
+								 copySegInserted);
+
+						copySegRows = aocs_insert_copy_segfile(idesc, oldrel,
+															   oldTupDesc,
+															   rowSegno);
+						copySegno = rowSegno;
+						copySegInserted = 0;
+					}
+					copySegInserted++;
+				}
+
 				oldCxt = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
 				econtext->ecxt_scantuple = oldslot;
 
@@ -5860,9 +6026,17 @@ ATRewriteTable(AlteredTableInfo *tab, Oid OIDNewHeap)
 
 			aocs_endscan(sdesc);
 
+			if (copySegno >= 0 && copySegInserted != copySegRows)
+				elog(ERROR, "copied " INT64_FORMAT " rows of segno %d of relation \"%s\" but scanned " INT64_FORMAT,
+					 copySegRows, copySegno,
+					 RelationGetRelationName(oldrel),
+					 copySegInserted);
+
 			if(newrel)
 				aocs_insert_finish(idesc);
 
+			if (copiedCols)
+				pfree(copiedCols);
 			pfree(proj);
 		}
 		else if (relstorage_is_ao(relstorage) && Gp_role == GP_ROLE_DISPATCH)
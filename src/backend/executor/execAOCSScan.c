@@ -14,11 +14,238 @@
  */
 #include "postgres.h"
 
+#include "access/nbtree.h"
+#include "catalog/pg_am.h"
+#include "commands/defrem.h"
+#include "utils/array.h"
+#include "utils/guc.h"
+#include "utils/lsyscache.h"
 #include "utils/snapmgr.h"
 #include "executor/executor.h"
+#include "executor/instrument.h"
+#include "lib/stringinfo.h"
 #include "nodes/execnodes.h"
 #include "cdb/cdbaocsam.h"
 
+static void AOCSScanExplainEnd(PlanState *planstate, struct StringInfoData *buf);
+
+/*
+ * Add the zone map and read statistics of a scan to instr.
+ */
+static void
+AccumAOCSScanStats(AOCSScanDesc scandesc, Instrumentation *instr)
+{
+	int			i;
+
+	instr->zonemapBlocksRead += scandesc->zonemapBlocksRead;
+	instr->zonemapBlocksSkipped += scandesc->zonemapBlocksSkipped;
+	scandesc->zonemapBlocksRead = 0;
+	scandesc->zonemapBlocksSkipped = 0;
+
+	for (i = 0; i < scandesc->num_proj_atts; i++)
+	{
+		DatumStreamRead *ds = scandesc->ds[scandesc->proj_atts[i]];
+
+		if (ds)
+		{
+			AccumAppendOnlyReadStats(&ds->ao_read.bufferedRead,
+									 &instr->aoLargeReads,
+									 &instr->aoReadWaitTime);
+			ds->ao_read.bufferedRead.numLargeReads = 0;
+			INSTR_TIME_SET_ZERO(ds->ao_read.bufferedRead.ioWaitTime);
+		}
+	}
+}
+
+/*
+ * Turn a "column op constant" or "column IN (constants)" qual into a zone
+ * map key, if the operator is a btree comparison of the column's type.
+ *
+ * Blocks of any type can be checked against their dictionary, when they have
+ * one; otherwise only the blocks of fixed-length, pass-by-value types can be
+ * summarized by datumstreamread_block_minmax(), and the blocks of other types
+ * are simply never skipped.
+ */
+static bool
+MakeZoneMapKey(Expr *clause, Index scanrelid, TupleDesc tupdesc,
+			   AOCSZoneMapKey *key)
+{
+	List	   *args;
+	Oid			opno;
+	bool		isInList;
+	Node	   *left;
+	Node	   *right;
+	Var		   *var;
+	Const	   *con;
+	bool		varonleft;
+	Form_pg_attribute attr;
+	Oid			lefttype;
+	Oid			righttype;
+	Oid			opclass;
+	Oid			opfamily;
+	Oid			cmpproc;
+	int			strategy;
+
+	if (IsA(clause, OpExpr))
+	{
+		args = ((OpExpr *) clause)->args;
+		opno = ((OpExpr *) clause)->opno;
+		isInList = false;
+	}
+	else if (IsA(clause, ScalarArrayOpExpr) &&
+			 ((ScalarArrayOpExpr *) clause)->useOr)
+	{
+		args = ((ScalarArrayOpExpr *) clause)->args;
+		opno = ((ScalarArrayOpExpr *) clause)->opno;
+		isInList = true;
+	}
+	else
+		return false;
+
+	if (list_length(args) != 2)
+		return false;
+
+	left = (Node *) linitial(args);
+	right = (Node *) lsecond(args);
+	if (IsA(left, Var) && IsA(right, Const))
+	{
+		var = (Var *) left;
+		con = (Const *) right;
+		varonleft = true;
+	}
+	else if (IsA(left, Const) && IsA(right, Var) && !isInList)
+	{
+		var = (Var *) right;
+		con = (Const *) left;
+		varonleft = false;
+	}
+	else
+		return false;
+
+	if (var->varno != scanrelid || var->varlevelsup != 0 ||
+		var->varattno <= 0 || var->varattno > tupdesc->natts ||
+		con->constisnull)
+		return false;
+
+	attr = tupdesc->attrs[var->varattno - 1];
+	if (attr->attisdropped)
+		return false;
+
+	op_input_types(opno, &lefttype, &righttype);
+	if (lefttype != attr->atttypid || righttype != attr->atttypid)
+		return false;
+
+	opclass = GetDefaultOpClass(attr->atttypid, BTREE_AM_OID);
+	if (!OidIsValid(opclass))
+		return false;
+	opfamily = get_opclass_family(opclass);
+
+	strategy = get_op_opfamily_strategy(opno, opfamily);
+	if (strategy == 0)
+		return false;
+	if (isInList && strategy != BTEqualStrategyNumber)
+		return false;
+	if (!varonleft)
+		strategy = BTCommuteStrategyNumber(strategy);
+
+	cmpproc = get_opfamily_proc(opfamily, attr->atttypid, attr->atttypid,
+								BTORDER_PROC);
+	if (!OidIsValid(cmpproc))
+		return false;
+
+	key->attno = var->varattno - 1;
+	key->strategy = (StrategyNumber) strategy;
+	key->value = con->constvalue;
+	key->values = NULL;
+	key->nvalues = 0;
+
+	if (isInList)
+	{
+		ArrayType  *arr = DatumGetArrayTypeP(con->constvalue);
+		int16		elmlen;
+		bool		elmbyval;
+		char		elmalign;
+		Datum	   *elems;
+		bool	   *nulls;
+		int			nelems;
+		int			i;
+
+		get_typlenbyvalalign(ARR_ELEMTYPE(arr), &elmlen, &elmbyval, &elmalign);
+		deconstruct_array(arr, ARR_ELEMTYPE(arr), elmlen, elmbyval, elmalign,
+						  &elems, &nulls, &nelems);
+
+		/* NULL elements cannot match anything. */
+		for (i = 0; i < nelems; i++)
+		{
+			if (!nulls[i])
+				elems[key->nvalues++] = elems[i];
+		}
+		pfree(nulls);
+
+		if (key->nvalues == 0)
+		{
+			pfree(elems);
+			return false;
+		}
+		key->value = (Datum) 0;
+		key->values = elems;
+	}
+
+	fmgr_info(cmpproc, &key->cmpfn);
+	key->checkedBlockOffset = -1;
+
+	return true;
+}
+
+static int
+CompareZoneMapKeys(const void *a, const void *b)
+{
+	const AOCSZoneMapKey *ka = (const AOCSZoneMapKey *) a;
+	const AOCSZoneMapKey *kb = (const AOCSZoneMapKey *) b;
+
+	return ka->attno - kb->attno;
+}
+
+/*
+ * Collect the zone map keys of a plain table scan from its qual.
+ */
+static void
+InitAOCSZoneMapKeys(ScanState *scanState)
+{
+	AOCSScanOpaqueData *opaque = ((AOCSScanState *) scanState)->opaque;
+	List	   *qual = scanState->ps.plan->qual;
+	Index		scanrelid = ((Scan *) scanState->ps.plan)->scanrelid;
+	TupleDesc	tupdesc = scanState->ss_currentRelation->rd_att;
+	ListCell   *lc;
+
+	opaque->zonemapKeys = NULL;
+	opaque->numZonemapKeys = 0;
+
+	/*
+	 * Dynamic scans switch partitions under the same scan state; leave them
+	 * alone.
+	 */
+	if (!gp_enable_aocs_zonemaps || !IsA(scanState, TableScanState) ||
+		qual == NIL)
+		return;
+
+	foreach(lc, qual)
+	{
+		AOCSZoneMapKey key;
+
+		if (!MakeZoneMapKey((Expr *) lfirst(lc), scanrelid, tupdesc, &key))
+			continue;
+
+		if (opaque->zonemapKeys == NULL)
+			opaque->zonemapKeys = palloc(sizeof(AOCSZoneMapKey) * list_length(qual));
+		opaque->zonemapKeys[opaque->numZonemapKeys++] = key;
+	}
+
+	if (opaque->numZonemapKeys > 1)
+		qsort(opaque->zonemapKeys, opaque->numZonemapKeys,
+			  sizeof(AOCSZoneMapKey), CompareZoneMapKeys);
+}
+
 static void
 InitAOCSScanOpaque(ScanState *scanState)
 {
@@ -64,10 +291,62 @@ FreeAOCSScanOpaque(ScanState *scanState)
 	AOCSScanOpaqueData *opaque = (AOCSScanOpaqueData *)state->opaque;
 	Assert(opaque->proj != NULL);
 	pfree(opaque->proj);
+	if (opaque->zonemapKeys != NULL)
+		pfree(opaque->zonemapKeys);
 	pfree(state->opaque);
 	state->opaque = NULL;
 }
 
+/*
+ * Return the next visible row of the current batch, fetching a new batch
+ * when it is used up.
+ */
+static TupleTableSlot *
+AOCSScanNextFromBatch(AOCSScanState *node)
+{
+	AOCSScanOpaqueData *opaque = node->opaque;
+	AOCSScanDesc scandesc = opaque->scandesc;
+	TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
+	AOCSScanBatch *batch = opaque->batch;
+	Datum	   *values;
+	bool	   *isnull;
+	int			row;
+	int			i;
+
+	do
+	{
+		if (batch == NULL || opaque->batchNext >= batch->nrows)
+		{
+			batch = aocs_getnextbatch(scandesc, opaque->batchSize);
+			opaque->batch = batch;
+			opaque->batchNext = 0;
+			if (batch == NULL)
+			{
+				ExecClearTuple(slot);
+				return slot;
+			}
+		}
+
+		row = opaque->batchNext++;
+	} while (!batch->visible[row]);
+
+	values = slot_get_values(slot);
+	isnull = slot_get_isnull(slot);
+	for (i = 0; i < scandesc->num_proj_atts; i++)
+	{
+		int			attno = scandesc->proj_atts[i];
+
+		values[attno] = batch->values[attno][row];
+		isnull[attno] = batch->isnull[attno][row];
+	}
+
+	scandesc->cdb_fake_ctid = *((ItemPointer) &batch->tids[row]);
+
+	TupSetVirtualTupleNValid(slot, slot->tts_tupleDescriptor->natts);
+	slot_set_ctid(slot, &scandesc->cdb_fake_ctid);
+	return slot;
+}
+
 TupleTableSlot *
 AOCSScanNext(ScanState *scanState)
 {
@@ -77,6 +356,9 @@ AOCSScanNext(ScanState *scanState)
 	Assert(node->opaque != NULL &&
 		   node->opaque->scandesc != NULL);
 
+	if (node->opaque->batchSize > 0)
+		return AOCSScanNextFromBatch(node);
+
 	aocs_getnext(node->opaque->scandesc, node->ss.ps.state->es_direction, node->ss.ss_ScanTupleSlot);
 	return node->ss.ss_ScanTupleSlot;
 }
@@ -111,6 +393,28 @@ BeginScanAOCSRelation(ScanState *scanState)
 					   NULL /* relationTupleDesc */,
 					   node->opaque->proj);
 
+	/* Fixed for the life of the scan, batches must not be mixed with rows. */
+	node->opaque->batchSize = gp_aocs_scan_batch_size;
+	node->opaque->batch = NULL;
+	node->opaque->batchNext = 0;
+
+	InitAOCSZoneMapKeys(scanState);
+	if (node->opaque->numZonemapKeys > 0)
+		aocs_setzonemapkeys(node->opaque->scandesc,
+							node->opaque->zonemapKeys,
+							node->opaque->numZonemapKeys);
+
+	/*
+	 * Decompression ahead of the scan takes its buffers out of the
+	 * operator's memory quota.
+	 */
+	if (gp_aocs_decompress_workers > 0)
+		aocs_setdecompressahead(node->opaque->scandesc,
+								(int64) PlanStateOperatorMemKB(&scanState->ps) * 1024L);
+
+	if (scanState->ps.instrument && scanState->ps.instrument->need_cdb)
+		scanState->ps.cdbexplainfun = AOCSScanExplainEnd;
+
 	node->ss.scan_state = SCAN_SCAN;
 }
  
@@ -125,6 +429,9 @@ EndScanAOCSRelation(ScanState *scanState)
 	Assert(node->opaque != NULL &&
 		   node->opaque->scandesc != NULL);
 
+	if (scanState->ps.instrument)
+		AccumAOCSScanStats(node->opaque->scandesc, scanState->ps.instrument);
+
 	aocs_endscan(node->opaque->scandesc);
         
 	FreeAOCSScanOpaque(scanState);
@@ -141,5 +448,38 @@ ReScanAOCSRelation(ScanState *scanState)
 	Assert(node->opaque != NULL &&
 		   node->opaque->scandesc != NULL);
 
+	/* The rescan recreates the column readers, with fresh statistics. */
+	if (scanState->ps.instrument)
+		AccumAOCSScanStats(node->opaque->scandesc, scanState->ps.instrument);
+
 	aocs_rescan(node->opaque->scandesc); 
+	node->opaque->batch = NULL;
+	node->opaque->batchNext = 0;
+}
+
+/*
+ * AOCSScanExplainEnd
+ *		Called before ExecutorEnd to finish EXPLAIN ANALYZE reporting.
+ *
+ * Reports how many blocks of the restricted columns the zone maps ruled out,
+ * and how long the scan waited for its column file reads.
+ */
+static void
+AOCSScanExplainEnd(PlanState *planstate, struct StringInfoData *buf)
+{
+	AOCSScanState *node = (AOCSScanState *) planstate;
+	Instrumentation *instr = planstate->instrument;
+
+	/* The scan may still be open if the node was not run to completion. */
+	if ((node->ss.scan_state & SCAN_SCAN) != 0 &&
+		node->opaque != NULL && node->opaque->scandesc != NULL)
+		AccumAOCSScanStats(node->opaque->scandesc, instr);
+
+	if (instr->zonemapBlocksRead > 0)
+		appendStringInfo(buf,
+						 "Zone maps skipped " INT64_FORMAT " of " INT64_FORMAT
+						 " blocks.\n",
+						 instr->zonemapBlocksSkipped, instr->zonemapBlocksRead);
+
+	ExplainAppendOnlyReads(buf, instr->aoLargeReads, instr->aoReadWaitTime);
 }
@@ -15,10 +15,14 @@
 #include "postgres.h"
 
 #include "executor/executor.h"
+#include "executor/instrument.h"
+#include "lib/stringinfo.h"
 #include "nodes/execnodes.h"
 #include "cdb/cdbappendonlyam.h"
 #include "utils/snapmgr.h"
 
+static void AppendOnlyScanExplainEnd(PlanState *planstate, struct StringInfoData *buf);
+
 TupleTableSlot *
 AppendOnlyScanNext(ScanState *scanState)
 {
@@ -77,6 +81,9 @@ BeginScanAppendOnlyRelation(ScanState *scanState)
 			appendOnlyMetaDataSnapshot,
 			0, NULL);
 	node->ss.scan_state = SCAN_SCAN;
+
+	if (scanState->ps.instrument && scanState->ps.instrument->need_cdb)
+		scanState->ps.cdbexplainfun = AppendOnlyScanExplainEnd;
 }
 
 void
@@ -88,6 +95,12 @@ EndScanAppendOnlyRelation(ScanState *scanState)
 	Assert(node->aos_ScanDesc != NULL);
 
 	Assert((node->ss.scan_state & SCAN_SCAN) != 0);
+
+	if (scanState->ps.instrument)
+		AccumAppendOnlyReadStats(&node->aos_ScanDesc->storageRead.bufferedRead,
+								 &scanState->ps.instrument->aoLargeReads,
+								 &scanState->ps.instrument->aoReadWaitTime);
+
 	appendonly_endscan(node->aos_ScanDesc);
 
 	node->aos_ScanDesc = NULL;
@@ -105,3 +118,46 @@ ReScanAppendOnlyRelation(ScanState *scanState)
 
 	appendonly_rescan(node->aos_ScanDesc, NULL /* new scan keys */);
 }
+
+/*
+ * Add the read statistics of a segment file reader to the given totals.
+ */
+void
+AccumAppendOnlyReadStats(BufferedRead *bufferedRead,
+						 int64 *numReads, double *waitTime)
+{
+	*numReads += bufferedRead->numLargeReads;
+	*waitTime += INSTR_TIME_GET_DOUBLE(bufferedRead->ioWaitTime);
+}
+
+/*
+ * Report how long an append-only scan waited for its segment file reads.
+ */
+void
+ExplainAppendOnlyReads(StringInfo buf, int64 numReads, double waitTime)
+{
+	if (numReads > 0)
+		appendStringInfo(buf,
+						 "Segment file reads: " INT64_FORMAT
+						 ", waited %.3f ms.\n",
+						 numReads, 1000.0 * waitTime);
+}
+
+/*
+ * AppendOnlyScanExplainEnd
+ *		Called before ExecutorEnd to finish EXPLAIN ANALYZE reporting.
+ */
+static void
+AppendOnlyScanExplainEnd(PlanState *planstate, struct StringInfoData *buf)
+{
+	AppendOnlyScanState *node = (AppendOnlyScanState *) planstate;
+	int64		numReads = planstate->instrument->aoLargeReads;
+	double		waitTime = planstate->instrument->aoReadWaitTime;
+
+	/* The scan may still be open if the node was not run to completion. */
+	if ((node->ss.scan_state & SCAN_SCAN) != 0 && node->aos_ScanDesc != NULL)
+		AccumAppendOnlyReadStats(&node->aos_ScanDesc->storageRead.bufferedRead,
+								 &numReads, &waitTime);
+
+	ExplainAppendOnlyReads(buf, numReads, waitTime);
+}
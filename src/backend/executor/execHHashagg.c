@@ -18,6 +18,10 @@
  */
 #include "postgres.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "miscadmin.h" /* work_mem */
 #include "executor/executor.h"
 #include "nodes/execnodes.h"
@@ -30,6 +34,7 @@
 #include "utils/memutils.h"
 #include "utils/lsyscache.h"
 #include "utils/elog.h"
+#include "utils/fmgroids.h"
 #include "cdb/memquota.h"
 #include "utils/workfile_mgr.h"
 
@@ -91,16 +96,59 @@ typedef enum InputRecordType
 #define HAVE_FREESPACE(hashtable) \
 		(AVAIL_MEM(hashtable) > 0)
 
-/* Actual memory needed per bucket = entry pointer + bloom value */
-#define OVERHEAD_PER_BUCKET (sizeof(HashAggBucket) + sizeof(uint64))
+/*
+ * The hash table is open addressed, with linear probing.  Next to the entry
+ * pointer, each bucket has a tag byte: 0 if the bucket is empty, else the
+ * high bit set and 7 bits of the hash value of the entry.  A lookup compares
+ * the tags of HHA_GROUP_WIDTH consecutive buckets at once and only looks at
+ * the entries whose tag matches, so that most of the buckets it goes
+ * through cost no cache miss on the entry.  The tags of the first
+ * HHA_GROUP_WIDTH buckets are repeated past the end of the tag array, so
+ * that a group of tags can start at any bucket.
+ *
+ * Entries are only ever removed all at once, when the table is spilled or
+ * reset, so empty buckets end every probe sequence and no tombstones are
+ * needed.  The table is kept at most HHA_MAX_FILL full.
+ */
+#define HHA_GROUP_WIDTH 16
+
+#define HHA_TAG_EMPTY 0
+#define HHA_TAG(hashkey) ((uint8) (0x80 | ((hashkey) >> 25)))
 
-#define BLOOMVAL(hashkey) ((uint64)1) << (((hashkey) >> 23) & 0x3f);
+#define HHA_MAX_FILL 0.875
+#define HHA_FULL(hashtable) \
+		((hashtable)->num_entries >= (hashtable)->nbuckets * HHA_MAX_FILL)
+
+#define TAGS_SIZE(nbuckets) ((nbuckets) + HHA_GROUP_WIDTH)
+
+/* Actual memory needed per bucket = entry pointer + tag */
+#define OVERHEAD_PER_BUCKET (sizeof(HashAggBucket) + sizeof(uint8))
 
 #define BUCKET_IDX(hashtable, hashkey) \
 		(((hashkey) >> (hashtable)->pshift) & ((hashtable)->nbuckets - 1))
 
+/*
+ * How a grouping key is compared.  Keys of the common integer types are
+ * compared inline on their Datum, the others with their equality function.
+ */
+typedef enum HashAggKeyCompare
+{
+	HHA_KEY_COMPARE_FMGR = 0,
+	HHA_KEY_COMPARE_CHAR,
+	HHA_KEY_COMPARE_INT16,
+	HHA_KEY_COMPARE_INT32,
+	HHA_KEY_COMPARE_INT64
+} HashAggKeyCompare;
+
 #define LOG2(x) (ceil(log((x)) / log(2)))
 
+/*
+ * Bounds on the length of a pass-through run, in units of the input rows
+ * consumed by the hashing window that triggered it.
+ */
+#define PASSTHRU_MIN_BACKOFF 4
+#define PASSTHRU_MAX_BACKOFF 64
+
 /* Methods that handle batch files */
 static SpillSet *createSpillSet(unsigned branching_factor, unsigned parent_hash_bit);
 static int closeSpillFile(AggState *aggstate, SpillSet *spill_set, int file_no);
@@ -126,6 +174,7 @@ static void agg_hash_table_stat_upd(HashAggTable *ht);
 static void reset_agg_hash_table(AggState *aggstate, int64 nentries);
 static bool agg_hash_reload(AggState *aggstate);
 static void reCalcNumberBatches(HashAggTable *hashtable, SpillFile *spill_file);
+static void agg_hash_adapt_streaming(AggState *aggstate);
 static inline void *mpool_cxt_alloc(void *manager, Size len);
 
 static inline void *mpool_cxt_alloc(void *manager, Size len)
@@ -133,6 +182,126 @@ static inline void *mpool_cxt_alloc(void *manager, Size len)
  	return mpool_alloc((MPool *)manager, len);
 }
 
+/*
+ * Return a bit mask of the buckets, among the HHA_GROUP_WIDTH buckets whose
+ * tags start at group, that have the given tag.
+ */
+static inline uint32
+match_group_tags(const uint8 *group, uint8 tag)
+{
+#ifdef __SSE2__
+	__m128i tags = _mm_loadu_si128((const __m128i *) group);
+
+	return (uint32) _mm_movemask_epi8(_mm_cmpeq_epi8(tags, _mm_set1_epi8((char) tag)));
+#else
+	uint32 mask = 0;
+	int i;
+
+	for (i = 0; i < HHA_GROUP_WIDTH; i++)
+	{
+		if (group[i] == tag)
+			mask |= ((uint32) 1) << i;
+	}
+	return mask;
+#endif
+}
+
+/*
+ * Find the empty bucket in which a new entry with the given hash key goes.
+ * The table must not be full.
+ */
+static inline unsigned
+find_empty_bucket(HashAggTable *hashtable, uint32 hashkey)
+{
+	unsigned bucket_idx = BUCKET_IDX(hashtable, hashkey);
+
+	for (;;)
+	{
+		uint32 empty = match_group_tags(&hashtable->tags[bucket_idx], HHA_TAG_EMPTY);
+
+		if (empty != 0)
+			return (bucket_idx + ffs(empty) - 1) & (hashtable->nbuckets - 1);
+
+		bucket_idx = (bucket_idx + HHA_GROUP_WIDTH) & (hashtable->nbuckets - 1);
+	}
+}
+
+/*
+ * Put an entry in the given empty bucket.
+ */
+static inline void
+set_bucket(HashAggTable *hashtable, unsigned bucket_idx, HashAggEntry *entry)
+{
+	uint8 tag = HHA_TAG(entry->hashvalue);
+
+	Assert(hashtable->tags[bucket_idx] == HHA_TAG_EMPTY);
+
+	hashtable->buckets[bucket_idx] = entry;
+	hashtable->tags[bucket_idx] = tag;
+	if (bucket_idx < HHA_GROUP_WIDTH)
+		hashtable->tags[hashtable->nbuckets + bucket_idx] = tag;
+}
+
+/*
+ * Choose how to compare each grouping key.
+ */
+static void
+init_key_compare(AggState *aggstate, HashAggTable *hashtable)
+{
+	Agg *agg = (Agg *) aggstate->ss.ps.plan;
+	int i;
+
+	hashtable->key_compare = (uint8 *) palloc0(Max(agg->numCols, 1) * sizeof(uint8));
+
+	for (i = 0; i < agg->numCols; i++)
+	{
+		switch (aggstate->eqfunctions[i].fn_oid)
+		{
+			case F_BOOLEQ:
+			case F_CHAREQ:
+				hashtable->key_compare[i] = HHA_KEY_COMPARE_CHAR;
+				break;
+			case F_INT2EQ:
+				hashtable->key_compare[i] = HHA_KEY_COMPARE_INT16;
+				break;
+			case F_INT4EQ:
+			case F_OIDEQ:
+			case F_DATE_EQ:
+				hashtable->key_compare[i] = HHA_KEY_COMPARE_INT32;
+				break;
+#ifdef USE_FLOAT8_BYVAL
+			case F_INT8EQ:
+				hashtable->key_compare[i] = HHA_KEY_COMPARE_INT64;
+				break;
+#endif
+			default:
+				hashtable->key_compare[i] = HHA_KEY_COMPARE_FMGR;
+				break;
+		}
+	}
+}
+
+/*
+ * Are two non-NULL values of the i'th grouping key equal?
+ */
+static inline bool
+key_datums_equal(AggState *aggstate, int i, Datum a, Datum b)
+{
+	switch (aggstate->hhashtable->key_compare[i])
+	{
+		case HHA_KEY_COMPARE_CHAR:
+			return DatumGetChar(a) == DatumGetChar(b);
+		case HHA_KEY_COMPARE_INT16:
+			return DatumGetInt16(a) == DatumGetInt16(b);
+		case HHA_KEY_COMPARE_INT32:
+			return DatumGetInt32(a) == DatumGetInt32(b);
+		case HHA_KEY_COMPARE_INT64:
+			return DatumGetInt64(a) == DatumGetInt64(b);
+		default:
+			return DatumGetBool(FunctionCall2(&aggstate->eqfunctions[i], a, b));
+	}
+}
+
 /* Function: calc_hash_value
  *
  * Calculate the hash value for the given input tuple.
@@ -268,7 +437,6 @@ makeHashAggEntryForInput(AggState *aggstate, TupleTableSlot *inputslot, uint32 h
 	entry->tuple_and_aggs = NULL;
 	entry->hashvalue = hashvalue;
 	entry->is_primodial = !(hashtable->is_spilling);
-	entry->next = NULL;
 
 	/*
 	 * Copy memtuple into group_buf. Remember to always allocate
@@ -339,7 +507,6 @@ makeHashAggEntryForGroup(AggState *aggstate, void *tuple_and_aggs,
 	entry->hashvalue = hashvalue;
 	entry->is_primodial = !(hashtable->is_spilling);
 	entry->tuple_and_aggs = copy_tuple_and_aggs;
-	entry->next = NULL;
 
 	/* Initialize per group data */
 	adjustInputGroup(aggstate, entry->tuple_and_aggs);
@@ -367,6 +534,55 @@ setGroupAggs(HashAggTable *hashtable, HashAggEntry *entry)
 	}
 }
 
+/*
+ * Function: entry_matches_input
+ *
+ * Do the grouping keys of the input record and of an entry match?
+ */
+static inline bool
+entry_matches_input(AggState *aggstate, HashAggEntry *entry,
+					void *input_record, InputRecordType input_type)
+{
+	MemTupleBinding *mt_bind = aggstate->hashslot->tts_mt_bind;
+	Agg *agg = (Agg*)aggstate->ss.ps.plan;
+	MemTuple mtup = (MemTuple) entry->tuple_and_aggs;
+	int i;
+
+	for (i = 0; i < agg->numCols; i++)
+	{
+		AttrNumber	att = agg->grpColIdx[i];
+		Datum input_datum = 0;
+		Datum entry_datum = 0;
+		bool input_isNull = false;
+		bool entry_isNull = false;
+
+		switch(input_type)
+		{
+			case INPUT_RECORD_TUPLE:
+				input_datum = slot_getattr((TupleTableSlot *)input_record, att, &input_isNull);
+				break;
+			case INPUT_RECORD_GROUP_AND_AGGS:
+				input_datum = memtuple_getattr((MemTuple)input_record, mt_bind, att, &input_isNull);
+				break;
+			default:
+				insist_log(false, "invalid record type %d", input_type);
+		}
+
+		entry_datum = memtuple_getattr(mtup, mt_bind, att, &entry_isNull);
+
+		if (input_isNull || entry_isNull)
+		{
+			/* NULLs match in group keys. */
+			if (input_isNull != entry_isNull)
+				return false;
+		}
+		else if (!key_datums_equal(aggstate, i, input_datum, entry_datum))
+			return false;
+	}
+
+	return true;
+}
+
 /*
  * Function: lookup_agg_hash_entry
  *
@@ -390,85 +606,71 @@ lookup_agg_hash_entry(AggState *aggstate,
 					  InputRecordType input_type, int32 input_size,
 					  uint32 hashkey, bool *p_isnew)
 {
-	HashAggEntry *entry;
+	HashAggEntry *entry = NULL;
 	HashAggTable *hashtable = aggstate->hhashtable;
-	MemTupleBinding *mt_bind = aggstate->hashslot->tts_mt_bind;
 	ExprContext *tmpcontext = aggstate->tmpcontext; /* per input tuple context */
-	Agg *agg = (Agg*)aggstate->ss.ps.plan;
 	MemoryContext oldcxt;
 	unsigned int bucket_idx;
-	uint64 bloomval;			/* bloom filter value */
-   
-	Assert(mt_bind != NULL);
+	unsigned int mask = hashtable->nbuckets - 1;
+	uint8 tag = HHA_TAG(hashkey);
+
+	Assert(aggstate->hashslot->tts_mt_bind != NULL);
 
 	if (p_isnew != NULL)
 		*p_isnew = false;
 
 	oldcxt = MemoryContextSwitchTo(tmpcontext->ecxt_per_tuple_memory);
 
-	bucket_idx = BUCKET_IDX(hashtable, hashkey);
-	bloomval = BLOOMVAL(hashkey);
-	entry = (0 == (hashtable->bloom[bucket_idx] & bloomval) ? NULL :
-			 hashtable->buckets[bucket_idx]);
-
 	/*
-	 * Search entry chain for the bucket. If such an entry found in the
-	 * chain, move it to the front of the chain. Otherwise, if there
-	 * are any space left, create a new entry, and insert it in
-	 * the front of the chain.
+	 * Probe a group of buckets at a time, from the bucket of the hash key,
+	 * until either an entry matches or a group has an empty bucket.
 	 */
-	while (entry != NULL)
+	bucket_idx = BUCKET_IDX(hashtable, hashkey);
+	for (;;)
 	{
-		MemTuple mtup = (MemTuple) entry->tuple_and_aggs;
-		int i;
-		bool match = true;
+		const uint8 *group = &hashtable->tags[bucket_idx];
+		uint32 matches = match_group_tags(group, tag);
 
-		if (hashkey != entry->hashvalue)
+		while (matches != 0)
 		{
-			entry = entry->next;
-			continue;
-		}
-		
-		for (i = 0; match && i < agg->numCols; i++)
-		{
-			AttrNumber	att = agg->grpColIdx[i];
-			Datum input_datum = 0;
-			Datum entry_datum = 0;
-			bool input_isNull = false;
-			bool entry_isNull = false;
-				
-			switch(input_type)
+			HashAggEntry *candidate =
+				hashtable->buckets[(bucket_idx + ffs(matches) - 1) & mask];
+
+			if (candidate->hashvalue == hashkey &&
+				entry_matches_input(aggstate, candidate, input_record, input_type))
 			{
-				case INPUT_RECORD_TUPLE:
-					input_datum = slot_getattr((TupleTableSlot *)input_record, att, &input_isNull);
-					break;
-				case INPUT_RECORD_GROUP_AND_AGGS:
-					input_datum = memtuple_getattr((MemTuple)input_record, mt_bind, att, &input_isNull);
-					break;
-				default:
-					insist_log(false, "invalid record type %d", input_type);
+				entry = candidate;
+				break;
 			}
-
-			entry_datum = memtuple_getattr(mtup, mt_bind, att, &entry_isNull);
-
-			if ( !input_isNull && !entry_isNull &&
-				 (DatumGetBool(FunctionCall2(&aggstate->eqfunctions[i],
-											 input_datum,
-											 entry_datum)) ) )
-				continue; /* Both non-NULL and equal. */
-			match = (input_isNull && entry_isNull);/* NULLs match in group keys. */
+			matches &= matches - 1;
 		}
-		
-		/* Break if found an existing matching entry. */
-		if (match)
+
+		if (entry != NULL ||
+			match_group_tags(group, HHA_TAG_EMPTY) != 0)
 			break;
 
-		entry = entry->next;
+		bucket_idx = (bucket_idx + HHA_GROUP_WIDTH) & mask;
 	}
 
 	if (entry == NULL)
 	{
-		/* Entry not found! Create a new matching entry. */
+		/*
+		 * Entry not found! Create a new matching entry, if there is a free
+		 * bucket for it.
+		 */
+		if (HHA_FULL(hashtable) && hashtable->expandable)
+		{
+			/* The hashtable is denser than envisioned; increase the number of buckets */
+			expand_hash_table(aggstate);
+		}
+
+		if (HHA_FULL(hashtable))
+		{
+			/* No room; the caller spills the table. */
+			(void) MemoryContextSwitchTo(oldcxt);
+			return NULL;
+		}
+
 		switch(input_type)
 		{
 			case INPUT_RECORD_TUPLE:
@@ -483,18 +685,7 @@ lookup_agg_hash_entry(AggState *aggstate,
 			
 		if (entry != NULL)
 		{
-			if (hashtable->expandable &&
-					hashtable->num_entries >= (hashtable->nbuckets * gp_hashagg_groups_per_bucket))
-			{
-				/* The hashtable is denser than envisioned; increase the number of buckets */
-				expand_hash_table(aggstate);
-				/* Recompute bucket_idx in case nbuckets changed */
-				bucket_idx = BUCKET_IDX(hashtable, hashkey);
-			}
-
-			entry->next = hashtable->buckets[bucket_idx];
-			hashtable->buckets[bucket_idx] = entry;
-			hashtable->bloom[bucket_idx] |= bloomval;
+			set_bucket(hashtable, find_empty_bucket(hashtable, hashkey), entry);
 			
 			++hashtable->num_ht_groups;
 			++hashtable->num_entries;
@@ -548,7 +739,7 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 	Assert(ngroups >= 0);
 
 	/* Estimate the overhead per entry in the hash table */
-	entrysize = entrywidth + OVERHEAD_PER_BUCKET / (double) gp_hashagg_groups_per_bucket;
+	entrysize = entrywidth + OVERHEAD_PER_BUCKET / HHA_MAX_FILL;
 
 	elog(HHA_MSG_LVL, "HashAgg: ngroups = %g, memquota = %g, entrysize = %g",
 		 ngroups, memquota, entrysize);
@@ -586,7 +777,7 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 	nentries = Min(ngroups, nentries);
 
 	/* but at least a few hash entries as required */
-	nentries = Max(nentries, gp_hashagg_groups_per_bucket);
+	nentries = Max(nentries, floor(HHA_GROUP_WIDTH * HHA_MAX_FILL));
 	entries_mem = nentries * entrywidth;
 
 	/*
@@ -601,8 +792,8 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 
 	memquota -= entries_mem;
 
-	/* Determine the number of buckets */
-	nbuckets = ceil(nentries / gp_hashagg_groups_per_bucket);
+	/* Determine the number of buckets, leaving some of them empty */
+	nbuckets = ceil(nentries / HHA_MAX_FILL);
 
 	/* Use only as many allowed by memory */
 	nbuckets = Min(nbuckets, floor(memquota / OVERHEAD_PER_BUCKET));
@@ -626,6 +817,9 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 	 * Note: gp_hashagg_default_nbatches must be a power of two
 	 */
 	nbuckets = Max(nbuckets, gp_hashagg_default_nbatches);
+
+	/* A lookup reads the tags of HHA_GROUP_WIDTH buckets at once */
+	nbuckets = Max(nbuckets, HHA_GROUP_WIDTH);
 	buckets_mem = nbuckets * OVERHEAD_PER_BUCKET;
 
 	/* Reserve memory for the entries + hash table */
@@ -636,8 +830,7 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 		elog(HHA_MSG_LVL, "HashAgg: not enough memory for the hash table parameters chosen:");
 		elog(HHA_MSG_LVL, "HashAgg: nbuckets = %d, nentries = %d, nbatches = %d",
 			 (int)nbuckets, (int)nentries, (int)nbatches);
-		elog(HHA_MSG_LVL, "HashAgg: ngroups = %d, gp_hashagg_groups_per_bucket = %d",
-			 (int)ngroups, (int)gp_hashagg_groups_per_bucket);
+		elog(HHA_MSG_LVL, "HashAgg: ngroups = %d", (int)ngroups);
 		return false;
 	}
 
@@ -770,7 +963,9 @@ create_agg_hash_table(AggState *aggstate)
 	/* Initialize the hash buckets */
 	hashtable->nbuckets = hashtable->hats.nbuckets;
 	hashtable->buckets = (HashAggBucket *) palloc0(hashtable->nbuckets * sizeof(HashAggBucket));
-	hashtable->bloom = (uint64 *) palloc0(hashtable->nbuckets * sizeof(uint64));
+	hashtable->tags = (uint8 *) palloc0(TAGS_SIZE(hashtable->nbuckets) * sizeof(uint8));
+
+	init_key_compare(aggstate, hashtable);
 
 	hashtable->pshift = 0;
 	hashtable->expandable = true;
@@ -799,6 +994,14 @@ create_agg_hash_table(AggState *aggstate)
 
 	hashtable->prev_slot = NULL;
 
+	/*
+	 * Only plain grouping can pass rows through; rollup levels need the
+	 * grouping columns of a representative tuple from the hash table.
+	 */
+	hashtable->passthru_enabled = agg->streaming && !agg->inputHasGrouping &&
+		!agg->lastAgg && gp_hashagg_stream_min_reduction > 1.0;
+	hashtable->passthru_backoff = PASSTHRU_MIN_BACKOFF;
+
 	MemSet(padding_dummy, 0, MAXIMUM_ALIGNOF);
 	
 	init_agg_hash_iter(hashtable);
@@ -910,6 +1113,7 @@ agg_hash_initial_pass(AggState *aggstate)
 				Assert(tuple_remaining);
 				hashtable->prev_slot = outerslot;
 				/* Stream existing entries instead of spilling */
+				agg_hash_adapt_streaming(aggstate);
 				break;
 			}
 
@@ -940,6 +1144,7 @@ agg_hash_initial_pass(AggState *aggstate)
 		advance_aggregates(aggstate, hashtable->groupaggs->aggs, &(aggstate->mem_manager));
 		
 		hashtable->num_tuples++;
+		hashtable->window_tuples++;
 
 		/* Reset per-input-tuple context after each tuple */
 		ResetExprContext(tmpcontext);
@@ -949,6 +1154,7 @@ agg_hash_initial_pass(AggState *aggstate)
 			Assert(tuple_remaining);
 			ExecClearTuple(aggstate->hashslot);
 			/* Pause and stream entries before reading the next tuple */
+			agg_hash_adapt_streaming(aggstate);
 			break;
 		}
 
@@ -1249,11 +1455,11 @@ obtain_spill_set(HashAggTable *hashtable)
 /* Spill all entries from the hash table to file in order to make room
  * for new hash entries.
  *
- * We want to maximize the sequential writes to each spill file. Since
- * the number of buckets and the number of batches (#batches) are the power of 2,
- * We simply write bucket 0, #batches, 2 * #batches, ... to the batch 0;
- * write bucket 1, (#batches + 1), (2 * #batches + 1), ... to the batch 1;
- * and etc.
+ * Since the number of buckets and the number of batches (#batches) are the
+ * power of 2, an entry whose hash key belongs in bucket b is written to the
+ * batch b mod #batches.  With open addressing an entry does not always sit
+ * in the bucket of its hash key, so the batch is computed from the hash key
+ * of each entry as the buckets are scanned.
  */
 static void
 spill_hash_table(AggState *aggstate)
@@ -1262,7 +1468,7 @@ spill_hash_table(AggState *aggstate)
 	elog(HHA_MSG_LVL, "Spilling hash table at %ld entries", hashtable->num_entries);
 	SpillSet *spill_set;
 	SpillFile *spill_file;
-	int bucket_no;
+	unsigned bucket_no;
 	int file_no;
 	MemoryContext oldcxt;
 	uint64 old_num_spill_groups = hashtable->num_spill_groups;
@@ -1274,7 +1480,7 @@ spill_hash_table(AggState *aggstate)
 	/* Spill set does not have a workfile_set. Use existing or create new one as needed */
 	if (hashtable->work_set == NULL)
 	{
-		hashtable->work_set = workfile_mgr_create_set(BFZ, true /* can_be_reused */, &aggstate->ss.ps);
+		hashtable->work_set = workfile_mgr_create_set(BFZ, false /* can_be_reused */, &aggstate->ss.ps);
 		//aggstate->workfiles_created = true;
 	}
 
@@ -1284,7 +1490,7 @@ spill_hash_table(AggState *aggstate)
 	Assert(hashtable->nbuckets > spill_set->num_spill_files);
 
 	/*
-	 * Write each spill file. Write the last spill file first, since it will
+	 * Open each spill file. Open the last spill file first, since it will
 	 * be processed the last.
 	 */
 	for (file_no = spill_set->num_spill_files - 1; file_no >= 0; file_no--)
@@ -1313,38 +1519,33 @@ spill_hash_table(AggState *aggstate)
 			
 			CheckSendPlanStateGpmonPkt(&aggstate->ss.ps);
 		}
+	}
 
-		for (bucket_no = file_no; bucket_no < hashtable->nbuckets;
-			 bucket_no += spill_set->num_spill_files)
-		{
-			HashAggEntry *entry = hashtable->buckets[bucket_no];
-			
-			/* Ignore empty chains. */
-			if (entry == NULL) continue;
-			
-			/* Write all entries in the hash chain. */
-			while ( entry  != NULL )
-			{
-				HashAggEntry *spill_entry = entry;
-				entry = spill_entry->next;
-
-				if (spill_entry != NULL)
-				{
-					int32 written_bytes;
-					
-					written_bytes = writeHashEntry(aggstate, spill_file->file_info, spill_entry);
-					spill_file->file_info->ntuples++;
-					spill_file->file_info->total_bytes += written_bytes;
-
-					hashtable->num_spill_groups++;
-				}
-			}
+	/* Write each entry to the spill file of its hash key. */
+	for (bucket_no = 0; bucket_no < hashtable->nbuckets; bucket_no++)
+	{
+		HashAggEntry *spill_entry;
+		int32 written_bytes;
 
-			hashtable->buckets[bucket_no] = NULL;
-			hashtable->bloom[bucket_no] = 0;
-		}
+		/* Ignore empty buckets. */
+		if (hashtable->tags[bucket_no] == HHA_TAG_EMPTY)
+			continue;
+
+		spill_entry = hashtable->buckets[bucket_no];
+		file_no = BUCKET_IDX(hashtable, spill_entry->hashvalue) &
+			(spill_set->num_spill_files - 1);
+		spill_file = &spill_set->spill_files[file_no];
+
+		written_bytes = writeHashEntry(aggstate, spill_file->file_info, spill_entry);
+		spill_file->file_info->ntuples++;
+		spill_file->file_info->total_bytes += written_bytes;
+
+		hashtable->num_spill_groups++;
 	}
 
+	MemSet(hashtable->buckets, 0, hashtable->nbuckets * sizeof(HashAggBucket));
+	MemSet(hashtable->tags, 0, TAGS_SIZE(hashtable->nbuckets) * sizeof(uint8));
+
 	/* Reset the buffer */
 	mpool_reset(hashtable->group_buf);
 
@@ -1360,10 +1561,10 @@ spill_hash_table(AggState *aggstate)
 static void
 expand_hash_table(AggState *aggstate)
 {
-	unsigned mem_needed, old_nbuckets, bucket_idx, new_bucket_idx;
-	uint32 hashkey;
-	uint64 bloomval;
-	HashAggEntry *entry, *nextentry;
+	unsigned mem_needed, old_nbuckets, bucket_idx;
+	HashAggBucket *old_buckets;
+	uint8 *old_tags;
+	MemoryContext oldcxt;
 	HashAggTable *hashtable = aggstate->hhashtable;
 
 #ifdef USE_ASSERT_CHECKING
@@ -1373,7 +1574,11 @@ expand_hash_table(AggState *aggstate)
 	Assert(hashtable);
 	old_nbuckets = hashtable->nbuckets;
 
-	/* Make sure there is memory available for additional buckets */
+	/*
+	 * Make sure there is memory available for additional buckets.  The old
+	 * and the new bucket arrays are both around while the entries move, but
+	 * only for a moment.
+	 */
 	mem_needed = old_nbuckets * OVERHEAD_PER_BUCKET;
 	if (mem_needed > AVAIL_MEM(hashtable) || hashtable->nbuckets > (UINT_MAX / 2))
 	{
@@ -1397,42 +1602,34 @@ expand_hash_table(AggState *aggstate)
 
 	Assert(GET_TOTAL_USED_SIZE(hashtable) < hashtable->max_mem);
 
-	hashtable->buckets = (HashAggBucket *) repalloc(hashtable->buckets,
-		hashtable->nbuckets * sizeof(HashAggBucket));
-	hashtable->bloom =  (uint64 *) repalloc(hashtable->bloom,
-		hashtable->nbuckets * sizeof(uint64));
+	old_buckets = hashtable->buckets;
+	old_tags = hashtable->tags;
 
-	memset(hashtable->bloom, 0, hashtable->nbuckets * sizeof(uint64));
-	memset(hashtable->buckets + old_nbuckets, 0, old_nbuckets * sizeof(HashAggBucket));
+	oldcxt = MemoryContextSwitchTo(aggstate->aggcontext);
+	hashtable->buckets = (HashAggBucket *)
+		palloc0(hashtable->nbuckets * sizeof(HashAggBucket));
+	hashtable->tags = (uint8 *)
+		palloc0(TAGS_SIZE(hashtable->nbuckets) * sizeof(uint8));
+	MemoryContextSwitchTo(oldcxt);
 
-	/* Iterate all the entries from the hashtable move them as needed */
-	for(bucket_idx=0; bucket_idx < old_nbuckets; ++bucket_idx)
+	/* Move all the entries to the new buckets */
+	for (bucket_idx = 0; bucket_idx < old_nbuckets; ++bucket_idx)
 	{
-		entry = hashtable->buckets[bucket_idx];
-		hashtable->buckets[bucket_idx] = NULL;
-
-		while(entry != NULL)
-		{
-			nextentry = entry->next;
-			hashkey = entry->hashvalue;
-			bloomval = BLOOMVAL(hashkey);
-
-			new_bucket_idx = BUCKET_IDX(hashtable, hashkey);
-
-			Assert(new_bucket_idx == bucket_idx ||
-					new_bucket_idx == bucket_idx + old_nbuckets);
+		HashAggEntry *entry;
 
-			/* Insert this at the head of the bucket */
-			entry->next = hashtable->buckets[new_bucket_idx];
-			hashtable->buckets[new_bucket_idx] = entry;
-			hashtable->bloom[new_bucket_idx] |= bloomval;
+		if (old_tags[bucket_idx] == HHA_TAG_EMPTY)
+			continue;
 
-			entry = nextentry;
+		entry = old_buckets[bucket_idx];
+		set_bucket(hashtable, find_empty_bucket(hashtable, entry->hashvalue), entry);
 #ifdef USE_ASSERT_CHECKING
-			++nentries;
+		++nentries;
 #endif
-		}
 	}
+
+	pfree(old_buckets);
+	pfree(old_tags);
+
 	hashtable->num_expansions++;
 	Assert(hashtable->mem_for_metadata > 0);
 	Assert(nentries == hashtable->num_entries);
@@ -1518,8 +1715,9 @@ writeHashEntry(AggState *aggstate, BatchFileInfo *file_info,
 
 /*
  * agg_hash_table_stat_upd
- *   Collect buckets and hash chain statistics of the in-memory hash table for
- *   EXPLAIN ANALYZE
+ *   Collect buckets and probe length statistics of the in-memory hash table
+ *   for EXPLAIN ANALYZE.  The probe length of an entry is the number of
+ *   buckets from the bucket of its hash key to the one it is in, inclusive.
  */
 static void
 agg_hash_table_stat_upd(HashAggTable *hashtable)
@@ -1528,21 +1726,22 @@ agg_hash_table_stat_upd(HashAggTable *hashtable)
 
 	for (i = 0; i < hashtable->nbuckets; i++)
 	{
-		HashAggEntry   *entry = hashtable->buckets[i];
-		int             chainlength = 0;
+		HashAggEntry   *entry;
+		unsigned int	probelength;
 
-		if (entry)
-		{
-			for (chainlength = 0; entry; chainlength++)
-				entry = entry->next;
-			cdbexplain_agg_upd(&hashtable->chainlength, chainlength, i);
-		}
+		if (hashtable->tags[i] == HHA_TAG_EMPTY)
+			continue;
+
+		entry = hashtable->buckets[i];
+		probelength = ((i - BUCKET_IDX(hashtable, entry->hashvalue)) &
+					   (hashtable->nbuckets - 1)) + 1;
+		cdbexplain_agg_upd(&hashtable->probelength, probelength, i);
 	}
 
 	hashtable->total_buckets += hashtable->nbuckets;
 
 	/* Cannot use more buckets than have been created */
-	Assert(hashtable->chainlength.vcnt <= hashtable->total_buckets);
+	Assert(hashtable->probelength.vcnt <= hashtable->total_buckets);
 }
 
 /* Function: init_agg_hash_iter
@@ -1553,7 +1752,6 @@ void init_agg_hash_iter(HashAggTable* hashtable)
 	Assert( hashtable != NULL && hashtable->buckets != NULL && hashtable->nbuckets > 0 );
 	
 	hashtable->curr_bucket_idx = -1;
-	hashtable->next_entry = NULL;
 }
 
 /* Function: agg_hash_iter
@@ -1569,7 +1767,7 @@ HashAggEntry *
 agg_hash_iter(AggState *aggstate)
 {
 	HashAggTable* hashtable = aggstate->hhashtable;
-	HashAggEntry *entry = hashtable->next_entry;
+	HashAggEntry *entry = NULL;
 	SpillSet *spill_set = hashtable->spill_set;
 	MemoryContext oldcxt;
 
@@ -1580,23 +1778,18 @@ agg_hash_iter(AggState *aggstate)
 	
 	oldcxt = MemoryContextSwitchTo(hashtable->entry_cxt);
 
-	while (entry == NULL &&
-		   hashtable->nbuckets > ++ hashtable->curr_bucket_idx)
+	while (hashtable->nbuckets > ++ hashtable->curr_bucket_idx)
 	{
-		entry = hashtable->buckets[hashtable->curr_bucket_idx];
-		if (entry != NULL)
+		if (hashtable->tags[hashtable->curr_bucket_idx] != HHA_TAG_EMPTY)
 		{
+			entry = hashtable->buckets[hashtable->curr_bucket_idx];
 			Assert(entry->is_primodial);
 			break;
 		}
 	}
 
 	if (entry != NULL)
-	{
 		hashtable->num_output_groups++;
-		hashtable->next_entry = entry->next;
-		entry->next = NULL;
-	}
 
 	MemoryContextSwitchTo(oldcxt);
 
@@ -1665,16 +1858,57 @@ readHashEntry(AggState *aggstate, BatchFileInfo *file_info,
 bool
 agg_hash_stream(AggState *aggstate)
 {
+	HashAggTable *hashtable = aggstate->hhashtable;
+
 	Assert( ((Agg *) aggstate->ss.ps.plan)->streaming );
 	
 	elog(HHA_MSG_LVL,
 		"HashAgg: streaming");
 
 	reset_agg_hash_table(aggstate, 0 /* don't reallocate buckets */);
+	hashtable->window_tuples = 0;
 	
 	return agg_hash_initial_pass(aggstate);
 }
 
+/*
+ * Function: agg_hash_adapt_streaming
+ *
+ * Called when a streaming hash table is full. If the groups in the table
+ * reduced the input by less than gp_hashagg_stream_min_reduction, the
+ * grouping keys are close to unique and building the table again would only
+ * delay rows on their way to the next stage. Switch to pass-through mode
+ * (see agg_retrieve_passthrough in nodeAgg.c) for a number of rows that grows
+ * each time the ratio stays poor, then hash again to re-measure it.
+ */
+static void
+agg_hash_adapt_streaming(AggState *aggstate)
+{
+	HashAggTable *hashtable = aggstate->hhashtable;
+	double reduction;
+
+	if (!hashtable->passthru_enabled || hashtable->num_ht_groups == 0)
+		return;
+
+	reduction = (double) hashtable->window_tuples / (double) hashtable->num_ht_groups;
+
+	if (reduction >= gp_hashagg_stream_min_reduction)
+	{
+		hashtable->passthru_backoff = PASSTHRU_MIN_BACKOFF;
+		return;
+	}
+
+	hashtable->passthrough = true;
+	hashtable->passthru_remaining = hashtable->window_tuples * hashtable->passthru_backoff;
+	hashtable->passthru_backoff = Min(hashtable->passthru_backoff * 2, PASSTHRU_MAX_BACKOFF);
+	hashtable->num_passthru_switches++;
+
+	elog(HHA_MSG_LVL,
+		 "HashAgg: reduction %.2f below %.2f, passing " INT64_FORMAT " tuples through",
+		 reduction, gp_hashagg_stream_min_reduction,
+		 hashtable->passthru_remaining);
+}
+
 /*
  * Function: agg_hash_load
  *
@@ -2092,16 +2326,27 @@ agg_hash_explain(AggState *aggstate)
 		appendStringInfo(hbuf, ".\n");
 	}
 
-	/* Hash chain statistics */
-	if (hashtable->chainlength.vcnt > 0)
+	/* Adaptive streaming */
+	if (hashtable->num_passthru_switches > 0)
+	{
+		appendStringInfo(hbuf,
+				"Passed " INT64_FORMAT " of " INT64_FORMAT " input rows through"
+				" unaggregated; switched to pass-through %d times.\n",
+				hashtable->num_passthru_tuples,
+				hashtable->num_tuples,
+				hashtable->num_passthru_switches);
+	}
+
+	/* Hash probe statistics */
+	if (hashtable->probelength.vcnt > 0)
 	{
 		appendStringInfo(hbuf,
-				"Hash chain length %.1f avg, %.0f max,"
+				"Hash probe length %.1f avg, %.0f max,"
 				" using %d of " INT64_FORMAT " buckets"
 				"; total %d expansions.\n",
-				cdbexplain_agg_avg(&hashtable->chainlength),
-				hashtable->chainlength.vmax,
-				hashtable->chainlength.vcnt,
+				cdbexplain_agg_avg(&hashtable->probelength),
+				hashtable->probelength.vmax,
+				hashtable->probelength.vcnt,
 				hashtable->total_buckets,
 				hashtable->num_expansions);
 	}
@@ -2130,7 +2375,7 @@ void reset_agg_hash_table(AggState *aggstate, int64 nentries)
 		"HashAgg: resetting " INT64_FORMAT "-entry hash table",
 		hashtable->num_ht_groups);
 
-	Assert(hashtable->buckets && hashtable->bloom);
+	Assert(hashtable->buckets && hashtable->tags);
 
 	/*
 	 * Determine whether to reallocate buckets. Especially avoid re-allocation if
@@ -2162,10 +2407,10 @@ void reset_agg_hash_table(AggState *aggstate, int64 nentries)
 		hashtable->hats.nentries = hats.nentries;
 
 		pfree(hashtable->buckets);
-		pfree(hashtable->bloom);
+		pfree(hashtable->tags);
 
 		hashtable->buckets = (HashAggBucket *) palloc0(hashtable->nbuckets * sizeof(HashAggBucket));
-		hashtable->bloom = (uint64 *) palloc0(hashtable->nbuckets * sizeof(uint64));
+		hashtable->tags = (uint8 *) palloc0(TAGS_SIZE(hashtable->nbuckets) * sizeof(uint8));
 
 		hashtable->expandable = true;
 
@@ -2179,7 +2424,7 @@ void reset_agg_hash_table(AggState *aggstate, int64 nentries)
 	{
 		/* No need to reallocated buckets. Reset to zero. */
 		MemSet(hashtable->buckets, 0, hashtable->nbuckets * sizeof(HashAggBucket));
-		MemSet(hashtable->bloom, 0, hashtable->nbuckets * sizeof(uint64));
+		MemSet(hashtable->tags, 0, TAGS_SIZE(hashtable->nbuckets) * sizeof(uint8));
 	}
 
 	Assert(hashtable->mem_for_metadata > 0);
@@ -2217,7 +2462,8 @@ void destroy_agg_hash_table(AggState *aggstate)
 
 		/* destroy_batches(aggstate->hhashtable); */
 		pfree(aggstate->hhashtable->buckets);
-		pfree(aggstate->hhashtable->bloom);
+		pfree(aggstate->hhashtable->tags);
+		pfree(aggstate->hhashtable->key_compare);
 		if (aggstate->hhashtable->hashkey_buf)
 			pfree(aggstate->hhashtable->hashkey_buf);
 
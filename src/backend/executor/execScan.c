@@ -17,6 +17,7 @@
 #include "postgres.h"
 
 #include "executor/executor.h"
+#include "executor/nodeHash.h"
 #include "miscadmin.h"
 #include "utils/memutils.h"
 
@@ -148,18 +149,20 @@ ExecScan(ScanState *node,
 	ExprContext *econtext;
 	List	   *qual;
 	ProjectionInfo *projInfo;
+	HashJoinRuntimeFilter *runtimeFilter;
 
 	/*
 	 * Fetch data from node
 	 */
 	qual = node->ps.qual;
 	projInfo = node->ps.ps_ProjInfo;
+	runtimeFilter = node->ss_runtimeFilter;
 
 	/*
 	 * If we have neither a qual to check nor a projection to do, just skip
 	 * all the overhead and return the raw scan tuple.
 	 */
-	if (!qual && !projInfo)
+	if (!qual && !projInfo && !runtimeFilter)
 		return ExecScanFetch(node, accessMtd, recheckMtd);
 
 	/*
@@ -221,15 +224,16 @@ ExecScan(ScanState *node,
 				 * Form a projection tuple, store it in the result tuple slot
 				 * and return it.
 				 */
-				return ExecProject(projInfo, NULL);
+				slot = ExecProject(projInfo, NULL);
 			}
-			else
-			{
-				/*
-				 * Here, we aren't projecting, so just return scan tuple.
-				 */
+
+			/*
+			 * Return the tuple, unless the hash join above us has told us
+			 * that it cannot find a match for it.
+			 */
+			if (!runtimeFilter ||
+				ExecHashRuntimeFilterCheck(runtimeFilter, slot))
 				return slot;
-			}
 		}
 
 		/*
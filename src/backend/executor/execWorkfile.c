@@ -281,6 +281,11 @@ ExecWorkFile_Write(ExecWorkFile *workfile,
 			insist_log(false, "invalid work file type: %d", workfile->fileType);
 	}
 
+	if (NULL != workfile->work_set)
+	{
+		workfile->work_set->uncompressed_size += size;
+	}
+
 	return true;
 }
 
@@ -729,8 +734,10 @@ ExecWorkFile_AdjustBFZSize(ExecWorkFile *workfile, int64 file_size)
 		/* Actual file on disk is bigger than expected. This can happen when:
 		 *  - added checksums to an uncompressed file
 		 *  - closing empty or very small compressed file (zlib header overhead larger than saved space)
+		 *  - closing a zstd compressed file of incompressible data (every block
+		 *    is stored raw behind a frame header)
 		 */
-		Assert( (bfz_file->has_checksum && bfz_file->compression_index == 0) || (bfz_file->compression_index > 0 && workfile->size < BFZ_BUFFER_SIZE));
+		Assert( (bfz_file->has_checksum && bfz_file->compression_index == 0) || bfz_file->compression_index > 0);
 
 		/*
 		 * If we're already under disk full, don't try to reserve, as it will
@@ -171,6 +171,7 @@ static bool find_unaggregated_cols_walker(Node *node, Bitmapset **colnos);
 static void clear_agg_object(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_direct(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_hash_table(AggState *aggstate);
+static TupleTableSlot *agg_retrieve_passthrough(AggState *aggstate, bool *input_done);
 static void ExecAggExplainEnd(PlanState *planstate, struct StringInfoData *buf);
 
 
@@ -1022,7 +1023,30 @@ ExecAgg(AggState *node)
 		 * aggstate to prevent future calls.
 		 */
 
-	
+		/*
+		 * A non-streaming aggregation whose input is fixed by the contents
+		 * of append-only tables may replay the result of an earlier
+		 * identical aggregation that spilled, instead of recomputing it.
+		 */
+		if (node->hhashtable == NULL && !node->wfresult_replay &&
+			gp_workfile_caching && !streaming)
+		{
+			if (node->wfresult == NULL)
+				node->wfresult = workfile_result_create(&node->ss.ps);
+			node->wfresult_replay = workfile_result_lookup(node->wfresult);
+		}
+
+		if (node->wfresult_replay)
+		{
+			tuple = workfile_result_get(node->wfresult, node->ss.ps.ps_ResultTupleSlot);
+			if (tuple == NULL)
+			{
+				node->agg_done = true;
+				ExecEagerFreeAgg(node);
+			}
+			return tuple;
+		}
+
 		if (node->hhashtable == NULL)
 		{
 			bool		tupremain;
@@ -1031,6 +1055,10 @@ ExecAgg(AggState *node)
 			node->hashaggstatus = HASHAGG_BEFORE_FIRST_PASS;
 			tupremain = agg_hash_initial_pass(node);
 
+			/* Only results that were expensive enough to spill are kept */
+			if (node->wfresult != NULL && node->hhashtable->work_set != NULL)
+				workfile_result_begin_write(node->wfresult);
+
 			if (streaming)
 			{
 				if (tupremain)
@@ -1051,13 +1079,18 @@ ExecAgg(AggState *node)
 		 */
 		for (;;)
 		{
-			if (!node->hhashtable->is_spilling)
+			if (!node->hhashtable->is_spilling &&
+				node->hashaggstatus != HASHAGG_PASSTHROUGH)
 			{
 				tuple = agg_retrieve_hash_table(node);
 				node->agg_done = false; /* Not done 'til batches used up. */
 
 				if (tuple != NULL)
+				{
+					if (node->wfresult != NULL)
+						workfile_result_put(node->wfresult, tuple);
 					return tuple;
+				}
 			}
 
 			switch (node->hashaggstatus)
@@ -1077,6 +1110,8 @@ ExecAgg(AggState *node)
 
 				case HASHAGG_END_OF_PASSES:
 					node->agg_done = true;
+					if (node->wfresult != NULL)
+						workfile_result_finish(node->wfresult);
 					/* Append stats before destroying the htable for EXPLAIN ANALYZE */
 					if (node->ss.ps.instrument && (node->ss.ps.instrument)->need_cdb)
 					{
@@ -1087,10 +1122,32 @@ ExecAgg(AggState *node)
 
 				case HASHAGG_STREAMING:
 					Assert(streaming);
+					if (node->hhashtable->passthrough)
+					{
+						/* The table has been emptied; see agg_hash_adapt_streaming */
+						node->hashaggstatus = HASHAGG_PASSTHROUGH;
+						continue;
+					}
 					if (!agg_hash_stream(node))
 						node->hashaggstatus = HASHAGG_END_OF_PASSES;
 					continue;
 
+				case HASHAGG_PASSTHROUGH:
+					{
+						bool		input_done;
+
+						tuple = agg_retrieve_passthrough(node, &input_done);
+						if (tuple != NULL)
+							return tuple;
+
+						/* Either out of input, or time to hash again */
+						if (input_done)
+							node->hashaggstatus = HASHAGG_END_OF_PASSES;
+						else
+							node->hashaggstatus = HASHAGG_STREAMING;
+						continue;
+					}
+
 				case HASHAGG_BEFORE_FIRST_PASS:
 				default:
 					elog(ERROR, "hybrid hash aggregation sequencing error");
@@ -1697,6 +1754,96 @@ agg_retrieve_hash_table(AggState *aggstate)
 	return NULL;
 }
 
+/*
+ * ExecAgg for the pass-through mode of a streaming hashed aggregate.
+ *
+ * Each input tuple becomes a group of its own: its transition states are
+ * initialized, advanced once and finalized without touching the hash table.
+ * Returns NULL when the pass-through run is over; *input_done tells whether
+ * that is because the input is exhausted.
+ */
+static TupleTableSlot *
+agg_retrieve_passthrough(AggState *aggstate, bool *input_done)
+{
+	HashAggTable *hashtable = aggstate->hhashtable;
+	Agg		   *node = (Agg *) aggstate->ss.ps.plan;
+	ExprContext *econtext = aggstate->ss.ps.ps_ExprContext;
+	ExprContext *tmpcontext = aggstate->tmpcontext;
+	Datum	   *aggvalues = econtext->ecxt_aggvalues;
+	bool	   *aggnulls = econtext->ecxt_aggnulls;
+	AggStatePerAgg peragg = aggstate->peragg;
+	MemoryManagerContainer mem_manager;
+	int			aggno;
+
+	Assert(hashtable->passthrough);
+	*input_done = false;
+
+	if (hashtable->passthru_aggs == NULL)
+		hashtable->passthru_aggs = (AggStatePerGroup)
+			MemoryContextAlloc(aggstate->aggcontext,
+							   Max(aggstate->numaggs, 1) * sizeof(AggStatePerGroupData));
+
+	/* Transition values only live as long as the output tuple */
+	mem_manager.alloc = cxt_alloc;
+	mem_manager.free = cxt_free;
+	mem_manager.manager = econtext->ecxt_per_tuple_memory;
+	mem_manager.realloc_ratio = 1;
+
+	while (hashtable->passthru_remaining > 0)
+	{
+		TupleTableSlot *outerslot;
+
+		/* A tuple may be left over from the hash table filling up */
+		if (hashtable->prev_slot != NULL)
+		{
+			outerslot = hashtable->prev_slot;
+			hashtable->prev_slot = NULL;
+		}
+		else
+			outerslot = ExecProcNode(outerPlanState(aggstate));
+
+		if (TupIsNull(outerslot))
+		{
+			*input_done = true;
+			return NULL;
+		}
+
+		hashtable->passthru_remaining--;
+		hashtable->num_tuples++;
+		hashtable->num_passthru_tuples++;
+
+		ResetExprContext(econtext);
+
+		MemSet(hashtable->passthru_aggs, 0,
+			   aggstate->numaggs * sizeof(AggStatePerGroupData));
+		initialize_aggregates(aggstate, peragg, hashtable->passthru_aggs, &mem_manager);
+
+		tmpcontext->ecxt_outertuple = outerslot;
+		advance_aggregates(aggstate, hashtable->passthru_aggs, &mem_manager);
+		ResetExprContext(tmpcontext);
+
+		for (aggno = 0; aggno < aggstate->numaggs; aggno++)
+		{
+			Assert(peragg[aggno].numSortCols == 0);
+			finalize_aggregate(aggstate, &peragg[aggno],
+							   &hashtable->passthru_aggs[aggno],
+							   &aggvalues[aggno], &aggnulls[aggno]);
+		}
+
+		/* The input tuple is its own representative tuple */
+		econtext->ecxt_outertuple = outerslot;
+		econtext->group_id = node->rollupGSTimes;
+		econtext->grouping = node->grouping;
+
+		if (ExecQual(aggstate->ss.ps.qual, econtext, false))
+			return ExecProject(aggstate->ss.ps.ps_ProjInfo, NULL);
+	}
+
+	/* Hash the next window of input to re-measure the reduction */
+	hashtable->passthrough = false;
+	return NULL;
+}
+
 /* -----------------
  * ExecInitAgg
  *
@@ -2293,6 +2440,12 @@ ExecEndAgg(AggState *node)
 
 	ExecEagerFreeAgg(node);
 
+	if (node->wfresult != NULL)
+	{
+		workfile_result_free(node->wfresult);
+		node->wfresult = NULL;
+	}
+
 	/* And ensure any agg shutdown callbacks have been called */
 	ReScanExprContext(node->ss.ps.ps_ExprContext);
 
@@ -2598,6 +2751,11 @@ ExecEagerFreeAgg(AggState *node)
 	{
 		destroy_agg_hash_table(node);
 
+		/* Discard a result still being recorded or replayed */
+		if (node->wfresult != NULL)
+			workfile_result_close(node->wfresult);
+		node->wfresult_replay = false;
+
 		/**
 		 * Clean out the tuple descriptor.
 		 */
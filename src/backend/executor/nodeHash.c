@@ -27,7 +27,9 @@
 #include <limits.h>
 
 #include "access/hash.h"
+#include "catalog/pg_opfamily.h"
 #include "catalog/pg_statistic.h"
+#include "catalog/pg_type.h"
 #include "commands/tablespace.h"
 #include "executor/execdebug.h"
 #include "executor/hashjoin.h"
@@ -35,6 +37,7 @@
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
 #include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
 #include "parser/parse_expr.h"
 #include "utils/dynahash.h"
 #include "utils/memutils.h"
@@ -53,6 +56,9 @@ static void ExecHashSkewTableInsert(HashState *hashState, HashJoinTable hashtabl
 						uint32 hashvalue,
 						int bucketNumber);
 static void ExecHashRemoveNextSkewBucket(HashState *hashState, HashJoinTable hashtable);
+static int	ExecHashChooseRadixPartitions(HashJoinTable hashtable, int tupwidth);
+static void *dense_alloc(HashJoinTable hashtable, int partno, Size size);
+static void ExecHashCountSpilledRows(HashJoinTable hashtable, uint64 nrows);
 
 static void ExecHashTableExplainEnd(PlanState *planstate, struct StringInfoData *buf);
 static void
@@ -65,6 +71,9 @@ ExecHashTableExplainBatches(HashJoinTable   hashtable,
 /* Amount of metadata memory required per bucket */
 #define MD_MEM_PER_BUCKET (sizeof(HashJoinTuple) + sizeof(uint64))
 
+/* Upper limit on the number of radix partitions of a hash table */
+#define HJ_MAX_LOG2_NPARTS		12
+
 /* ----------------------------------------------------------------
  *		ExecHash
  *
@@ -94,6 +103,7 @@ MultiExecHash(HashState *node)
 	TupleTableSlot *slot;
 	ExprContext *econtext;
 	uint32		hashvalue;
+	HashJoinRuntimeFilter *filter;
 
 	/* must provide our own instrumentation support */
 	if (node->ps.instrument)
@@ -104,6 +114,7 @@ MultiExecHash(HashState *node)
 	 */
 	outerNode = outerPlanState(node);
 	hashtable = node->hashtable;
+	filter = hashtable->hjstate ? hashtable->hjstate->hj_RuntimeFilter : NULL;
 
 	/*
 	 * set expression context
@@ -144,6 +155,9 @@ MultiExecHash(HashState *node)
 				ExecHashTableInsert(node, hashtable, slot, hashvalue);
 			}
 			hashtable->totalTuples += 1;
+
+			if (filter)
+				ExecHashRuntimeFilterAdd(filter, econtext, hashkeys, hashvalue);
 		}
 
 		if (hashkeys_null)
@@ -158,6 +172,9 @@ MultiExecHash(HashState *node)
 	}
 	MemoryAccounting_DeclareDone();
 
+	if (hashtable->stats)
+		hashtable->stats->innerrows += hashtable->totalTuples;
+
 	/* Now we have set up all the initial batches & primary overflow batches. */
 	hashtable->nbatch_outstart = hashtable->nbatch;
 
@@ -414,6 +431,23 @@ ExecHashTableCreate(HashState *hashState, HashJoinState *hjstate, List *hashOper
 	hashtable->buckets = (HashJoinTuple *)
 		palloc0(nbuckets * sizeof(HashJoinTuple));
 
+	hashtable->log2_nparts = ExecHashChooseRadixPartitions(hashtable,
+														   outerNode->plan_width);
+	hashtable->chunks = (HashMemoryChunk *)
+		palloc0((1 << hashtable->log2_nparts) * sizeof(HashMemoryChunk));
+
+	/*
+	 * The buffer of outer tuples for probing a partition at a time comes out
+	 * of our memory too (see notes in executor/hashjoin.h).
+	 */
+	hashtable->radixProbeSpace = 0;
+	if (hashtable->log2_nparts > 0)
+	{
+		hashtable->radixProbeSpace = Min(HJ_RADIX_PROBE_BYTES,
+										 hashtable->spaceAllowed / 8);
+		hashtable->spaceAllowed -= hashtable->radixProbeSpace;
+	}
+
 	/*
 	 * Set up for skew optimization, if possible and there's a need for more
 	 * than one batch.	(In a one-batch join, there's no point in it.)
@@ -763,63 +797,74 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 	hashtable->nbatch = nbatch;
 
 	/*
-	 * Scan through the existing hash table entries and dump out any that are
-	 * no longer of the current batch.
+	 * Scan through the chunks of tuples in memory and dump out any that are
+	 * no longer of the current batch.  The tuples we keep are copied into
+	 * new chunks, so that the space of the others is released, and the
+	 * bucket chains are rebuilt from them.
 	 */
 	ninmemory = nfreed = 0;
 
-	for (i = 0; i < hashtable->nbuckets; i++)
+	memset(hashtable->buckets, 0, hashtable->nbuckets * sizeof(HashJoinTuple));
+
+	for (i = 0; i < (1 << hashtable->log2_nparts); i++)
 	{
-		HashJoinTuple prevtuple;
-		HashJoinTuple tuple;
+		HashMemoryChunk oldchunks = hashtable->chunks[i];
 
-		prevtuple = NULL;
-		tuple = hashtable->buckets[i];
+		hashtable->chunks[i] = NULL;
 
-		while (tuple != NULL)
+		while (oldchunks != NULL)
 		{
-			/* save link in case we delete */
-			HashJoinTuple nexttuple = tuple->next;
-			int			bucketno;
-			int			batchno;
-
-			ninmemory++;
-			ExecHashGetBucketAndBatch(hashtable, tuple->hashvalue,
-									  &bucketno, &batchno);
-			Assert(bucketno == i);
-			if (batchno == curbatch)
-			{
-				/* keep tuple */
-				prevtuple = tuple;
-			}
-			else
+			HashMemoryChunk nextchunk = oldchunks->next;
+			Size		idx = 0;
+
+			while (idx < oldchunks->used)
 			{
-				Size    spaceTuple;
-
-				/* dump it out */
-				Assert(batchno > curbatch);
-				ExecHashJoinSaveTuple(NULL, HJTUPLE_MINTUPLE(tuple),
-									  tuple->hashvalue,
-									  hashtable,
-									  &hashtable->innerBatchFile[batchno],
-									  hashtable->bfCxt);
-				/* and remove from hash table */
-				if (prevtuple)
-					prevtuple->next = nexttuple;
-				else
-					hashtable->buckets[i] = nexttuple;
-				/* prevtuple doesn't change */
+				HashJoinTuple tuple = (HashJoinTuple) (oldchunks->data + idx);
+				Size		spaceTuple;
+				int			bucketno;
+				int			batchno;
+
 				spaceTuple = HJTUPLE_OVERHEAD + memtuple_get_size(HJTUPLE_MINTUPLE(tuple));
-				hashtable->spaceUsed -= spaceTuple;
-				spaceFreed += spaceTuple;
-				if (stats)
-					stats->batchstats[batchno].spillspace_in += spaceTuple;
 
-				pfree(tuple);
-				nfreed++;
+				ninmemory++;
+				ExecHashGetBucketAndBatch(hashtable, tuple->hashvalue,
+										  &bucketno, &batchno);
+				Assert(HJ_BUCKET_PARTITION(hashtable, bucketno) == i);
+				if (batchno == curbatch)
+				{
+					/* keep tuple */
+					HashJoinTuple copyTuple;
+
+					copyTuple = (HashJoinTuple) dense_alloc(hashtable, i,
+															spaceTuple);
+					memcpy(copyTuple, tuple, spaceTuple);
+
+					copyTuple->next = hashtable->buckets[bucketno];
+					hashtable->buckets[bucketno] = copyTuple;
+				}
+				else
+				{
+					/* dump it out */
+					Assert(batchno > curbatch);
+					ExecHashJoinSaveTuple(NULL, HJTUPLE_MINTUPLE(tuple),
+										  tuple->hashvalue,
+										  hashtable,
+										  &hashtable->innerBatchFile[batchno],
+										  hashtable->bfCxt);
+					hashtable->spaceUsed -= spaceTuple;
+					spaceFreed += spaceTuple;
+					if (stats)
+						stats->batchstats[batchno].spillspace_in += spaceTuple;
+
+					nfreed++;
+				}
+
+				idx += MAXALIGN(spaceTuple);
 			}
 
-			tuple = nexttuple;
+			/* we're done with the old chunk */
+			pfree(oldchunks);
+			oldchunks = nextchunk;
 		}
 	}
 
@@ -835,6 +880,7 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 		stats->batchstats[curbatch].spillspace_out += spaceFreed;
 		stats->batchstats[curbatch].spillrows_out += nfreed;
 	}
+	ExecHashCountSpilledRows(hashtable, nfreed);
 
 	/*
 	 * If we dumped out either all or none of the tuples in the table, disable
@@ -896,8 +942,9 @@ ExecHashTableInsert(HashState *hashState, HashJoinTable hashtable,
 		 */
 		HashJoinTuple hashTuple;
 
-		hashTuple = (HashJoinTuple) MemoryContextAlloc(hashtable->batchCxt,
-													   hashTupleSize);
+		hashTuple = (HashJoinTuple)
+			dense_alloc(hashtable, HJ_BUCKET_PARTITION(hashtable, bucketno),
+						hashTupleSize);
 		hashTuple->hashvalue = hashvalue;
 		memcpy(HJTUPLE_MINTUPLE(hashTuple), tuple, memtuple_get_size(tuple));
 		hashTuple->next = hashtable->buckets[bucketno];
@@ -932,6 +979,7 @@ ExecHashTableInsert(HashState *hashState, HashJoinTable hashtable,
 							  hashtable,
 							  &hashtable->innerBatchFile[batchno],
 							  hashtable->bfCxt);
+		ExecHashCountSpilledRows(hashtable, 1);
 	}
 	}
 	END_MEMORY_ACCOUNT();
@@ -939,6 +987,143 @@ ExecHashTableInsert(HashState *hashState, HashJoinTable hashtable,
 	return (batchno == hashtable->curbatch);
 }
 
+/*
+ * ExecHashChooseRadixPartitions
+ *		Choose the number of radix partitions of a hash table, as a power
+ *		of 2 (see notes in executor/hashjoin.h).
+ *
+ * A partition should hold about gp_hashjoin_radix_partition_kb of the
+ * in-memory part of the inner relation, so that probing one partition at
+ * a time stays in cache.  Every partition keeps a partly filled chunk, so
+ * their number is limited to a small fraction of the memory we have.
+ */
+static int
+ExecHashChooseRadixPartitions(HashJoinTable hashtable, int tupwidth)
+{
+	double		expected_bytes;
+	double		partition_bytes;
+	int			log2_nparts = 0;
+
+	if (!gp_enable_hashjoin_radix)
+		return 0;
+
+	expected_bytes = (double) hashtable->nbuckets *
+		(gp_hashjoin_tuples_per_bucket * ExecHashRowSize(tupwidth) +
+		 sizeof(HashJoinTuple));
+	expected_bytes = Min(expected_bytes, (double) hashtable->spaceAllowed);
+	partition_bytes = gp_hashjoin_radix_partition_kb * 1024.0;
+
+	while (log2_nparts < hashtable->log2_nbuckets &&
+		   log2_nparts < HJ_MAX_LOG2_NPARTS &&
+		   expected_bytes / (1 << log2_nparts) > partition_bytes &&
+		   (double) (2 << log2_nparts) * HASH_CHUNK_SIZE * 8 <=
+		   (double) hashtable->spaceAllowed)
+		log2_nparts++;
+
+	return log2_nparts;
+}
+
+/*
+ * ExecHashUseRadixProbe
+ *		Should the outer tuples of the current batch be probed a partition
+ *		at a time?
+ *
+ * Only worth the buffering when the in-memory hash table is much larger
+ * than a partition; otherwise it stays in cache anyway.
+ */
+bool
+ExecHashUseRadixProbe(HashJoinTable hashtable)
+{
+	double		tablebytes;
+
+	if (hashtable->log2_nparts == 0)
+		return false;
+
+	tablebytes = (double) hashtable->spaceUsed +
+		(double) hashtable->nbuckets * sizeof(HashJoinTuple);
+
+	return tablebytes > 2.0 * gp_hashjoin_radix_partition_kb * 1024.0;
+}
+
+/*
+ * dense_alloc
+ *		Allocate space for a tuple in the chunks of the given partition of
+ *		the hash table (see notes in executor/hashjoin.h).
+ *
+ * The chunk of an oversized tuple goes after the head of the list, so that
+ * the head can still be filled.
+ */
+static void *
+dense_alloc(HashJoinTable hashtable, int partno, Size size)
+{
+	HashMemoryChunk newChunk;
+	HashMemoryChunk head = hashtable->chunks[partno];
+	char	   *ptr;
+
+	/* just in case the size is not already aligned properly */
+	size = MAXALIGN(size);
+
+	/* oversized tuples get a separate chunk */
+	if (size > HASH_CHUNK_THRESHOLD)
+	{
+		newChunk = (HashMemoryChunk) MemoryContextAlloc(hashtable->batchCxt,
+										HASH_CHUNK_HEADER_SIZE + size);
+		newChunk->maxlen = size;
+		newChunk->used = size;
+
+		if (head != NULL)
+		{
+			newChunk->next = head->next;
+			head->next = newChunk;
+		}
+		else
+		{
+			newChunk->next = NULL;
+			hashtable->chunks[partno] = newChunk;
+		}
+
+		return newChunk->data;
+	}
+
+	/* start a new chunk if the current one has no room */
+	if (head == NULL || head->maxlen - head->used < size)
+	{
+		newChunk = (HashMemoryChunk) MemoryContextAlloc(hashtable->batchCxt,
+										HASH_CHUNK_HEADER_SIZE + HASH_CHUNK_SIZE);
+		newChunk->maxlen = HASH_CHUNK_SIZE;
+		newChunk->used = size;
+		newChunk->next = head;
+		hashtable->chunks[partno] = newChunk;
+
+		return newChunk->data;
+	}
+
+	/* there's enough space in the current chunk */
+	ptr = head->data + head->used;
+	head->used += size;
+
+	return ptr;
+}
+
+/*
+ * ExecHashCountSpilledRows
+ *		Count inner rows written to batch files, for EXPLAIN ANALYZE.
+ *
+ * Rows spilled while batch 0 is built are counted apart from those that
+ * later batches write again when they have to be split further.
+ */
+static void
+ExecHashCountSpilledRows(HashJoinTable hashtable, uint64 nrows)
+{
+	if (!hashtable->stats)
+		return;
+
+	if (hashtable->curbatch == 0)
+		hashtable->stats->innerrows_spilled += nrows;
+	else
+		hashtable->stats->innerrows_respilled += nrows;
+}
+
 /*
  * ExecHashGetHashValue
  *		Compute the hash value for a tuple
@@ -1180,6 +1365,8 @@ ExecHashTableReset(HashState *hashState, HashJoinTable hashtable)
 	/* Reallocate and reinitialize the hash bucket headers. */
 	hashtable->buckets = (HashJoinTuple *)
 		palloc0(nbuckets * sizeof(HashJoinTuple));
+	hashtable->chunks = (HashMemoryChunk *)
+		palloc0((1 << hashtable->log2_nparts) * sizeof(HashMemoryChunk));
 
 	hashtable->spaceUsed = 0;
 	hashtable->totalTuples = 0;
@@ -1335,6 +1522,17 @@ ExecHashTableExplainEnd(PlanState *planstate, struct StringInfoData *buf)
 				hashtable->nbatch_outstart,
 				hashtable->nbatch,
 				"Secondary Overflow");
+
+        /* Report how much of the inner side did not fit in memory. */
+        if (stats->innerrows > 0)
+            appendStringInfo(buf,
+                             "Inner rows spilled to batch files: "
+                             UINT64_FORMAT " of " UINT64_FORMAT " (%.1f%%)"
+                             ", " UINT64_FORMAT " rewritten by later batches.\n",
+                             stats->innerrows_spilled,
+                             stats->innerrows,
+                             100.0 * stats->innerrows_spilled / stats->innerrows,
+                             stats->innerrows_respilled);
     }
 
     /* Report hash chain statistics. */
@@ -1354,6 +1552,30 @@ ExecHashTableExplainEnd(PlanState *planstate, struct StringInfoData *buf)
                              hashtable->nbatch - stats->nonemptybatches);
         appendStringInfoChar(buf, '\n');
     }
+
+    /* Report how much of the outer side the runtime filter removed. */
+    if (hjstate->hj_RuntimeFilter &&
+        hjstate->hj_RuntimeFilter->nchecked > 0)
+    {
+        HashJoinRuntimeFilter *filter = hjstate->hj_RuntimeFilter;
+
+        appendStringInfo(buf,
+                         "Runtime filter removed %.0f of %.0f outer rows (%.1f%%)%s.\n",
+                         filter->nremoved,
+                         filter->nchecked,
+                         100.0 * filter->nremoved / filter->nchecked,
+                         filter->abandoned ? ", then was turned off" : "");
+    }
+
+    /* Report how many outer rows were probed a partition at a time. */
+    if (hjstate->hj_RadixProbe &&
+        hjstate->hj_RadixProbe->nprobed > 0)
+    {
+        appendStringInfo(buf,
+                         "Probed %.0f outer rows a partition at a time, in %d partitions.\n",
+                         hjstate->hj_RadixProbe->nprobed,
+                         1 << hashtable->log2_nparts);
+    }
 }                               /* ExecHashTableExplainEnd */
 
 
@@ -1869,9 +2091,17 @@ ExecHashRemoveNextSkewBucket(HashState *hashState, HashJoinTable hashtable)
 		/* Decide whether to put the tuple in the hash table or a temp file */
 		if (batchno == hashtable->curbatch)
 		{
-			/* Move the tuple to the main hash table */
-			hashTuple->next = hashtable->buckets[bucketno];
-			hashtable->buckets[bucketno] = hashTuple;
+			/* Move the tuple to the main hash table, and into its chunks */
+			HashJoinTuple copyTuple;
+
+			copyTuple = (HashJoinTuple)
+				dense_alloc(hashtable, HJ_BUCKET_PARTITION(hashtable, bucketno),
+							tupleSize);
+			memcpy(copyTuple, hashTuple, tupleSize);
+			pfree(hashTuple);
+
+			copyTuple->next = hashtable->buckets[bucketno];
+			hashtable->buckets[bucketno] = copyTuple;
 			/* We have reduced skew space, but overall space doesn't change */
 			hashtable->spaceUsedSkew -= tupleSize;
 		}
@@ -1883,6 +2113,7 @@ ExecHashRemoveNextSkewBucket(HashState *hashState, HashJoinTable hashtable)
 								  hashvalue,
 								  hashtable,
 								  &hashtable->innerBatchFile[batchno], hashtable->bfCxt);
+			ExecHashCountSpilledRows(hashtable, 1);
 			pfree(hashTuple);
 			hashtable->spaceUsed -= tupleSize;
 			hashtable->spaceUsedSkew -= tupleSize;
@@ -1924,3 +2155,286 @@ ExecHashRemoveNextSkewBucket(HashState *hashState, HashJoinTable hashtable)
 		hashtable->spaceUsedSkew = 0;
 	}
 }
+
+/* ----------------------------------------------------------------
+ *		runtime join filter
+ *
+ * See hashjoin.h.  The filter is created once per join, and rebuilt
+ * alongside the hash table each time the inner side is scanned.
+ * ----------------------------------------------------------------
+ */
+
+/* Bloom filter bits per inner row aimed for, and the least acceptable */
+#define RUNTIME_FILTER_BITS_PER_ROW			16
+#define RUNTIME_FILTER_MIN_BITS_PER_ROW		4
+
+/* Bloom filter size bounds: 1 kB to 1 MB */
+#define RUNTIME_FILTER_MIN_LOG2BITS			13
+#define RUNTIME_FILTER_MAX_LOG2BITS			23
+
+/*
+ * After this many outer rows, a filter that removed less than the given
+ * fraction of them is turned off for the rest of the query.
+ */
+#define RUNTIME_FILTER_SAMPLE_ROWS			10000
+#define RUNTIME_FILTER_MIN_REMOVED			0.1
+
+/* The two bits of the Bloom filter a hash value maps to */
+#define RUNTIME_FILTER_BIT1(hashvalue, log2bits) \
+	((hashvalue) & ((((uint32) 1) << (log2bits)) - 1))
+#define RUNTIME_FILTER_BIT2(hashvalue, log2bits) \
+	(((uint32) ((hashvalue) * 0x9E3779B1U)) >> (32 - (log2bits)))
+
+#define RUNTIME_FILTER_SET_BIT(bloom, bit) \
+	((bloom)[(bit) >> 6] |= UINT64CONST(1) << ((bit) & 63))
+#define RUNTIME_FILTER_TEST_BIT(bloom, bit) \
+	(((bloom)[(bit) >> 6] & (UINT64CONST(1) << ((bit) & 63))) != 0)
+
+static bool
+runtime_filter_int_type(Oid typid)
+{
+	return typid == INT2OID || typid == INT4OID || typid == INT8OID;
+}
+
+static int64
+runtime_filter_key_value(Oid typid, Datum value)
+{
+	switch (typid)
+	{
+		case INT2OID:
+			return (int64) DatumGetInt16(value);
+		case INT4OID:
+			return (int64) DatumGetInt32(value);
+		default:
+			Assert(typid == INT8OID);
+			return DatumGetInt64(value);
+	}
+}
+
+/*
+ * ExecHashRuntimeFilterCreate
+ *		Set up a runtime filter for the outer side of a hash join.
+ *
+ * Returns NULL if the join cannot use one: rows of the outer side may only
+ * be dropped in an inner or semi join, and only a scan right below the
+ * join can check the filter.  Must be called once the outer hash keys of
+ * the join are set up.
+ */
+HashJoinRuntimeFilter *
+ExecHashRuntimeFilterCreate(HashJoinState *hjstate)
+{
+	PlanState  *outerNode = outerPlanState(hjstate);
+	HashJoinRuntimeFilter *filter;
+
+	if (hjstate->js.jointype != JOIN_INNER &&
+		hjstate->js.jointype != JOIN_SEMI)
+		return NULL;
+
+	/* IS NOT DISTINCT FROM joins match NULL keys */
+	if (hjstate->hj_nonequijoin || hjstate->hj_OuterHashKeys == NIL)
+		return NULL;
+
+	if (outerNode == NULL || !IsA(outerNode, TableScanState))
+		return NULL;
+
+	filter = (HashJoinRuntimeFilter *) palloc0(sizeof(HashJoinRuntimeFilter));
+	filter->hjstate = hjstate;
+	filter->econtext = CreateExprContext(hjstate->js.ps.state);
+
+	/* The range is kept for a single key compared with integer equality */
+	if (list_length(hjstate->hj_OuterHashKeys) == 1 &&
+		op_in_opfamily(linitial_oid(hjstate->hj_HashOperators),
+					   INTEGER_BTREE_FAM_OID))
+	{
+		ExprState  *outer_key = (ExprState *) linitial(hjstate->hj_OuterHashKeys);
+		ExprState  *inner_key = (ExprState *) linitial(hjstate->hj_InnerHashKeys);
+
+		filter->outer_key = outer_key;
+		filter->outer_keytype = exprType((Node *) outer_key->expr);
+		filter->inner_keytype = exprType((Node *) inner_key->expr);
+		filter->use_range = runtime_filter_int_type(filter->outer_keytype) &&
+			runtime_filter_int_type(filter->inner_keytype);
+	}
+
+	((ScanState *) outerNode)->ss_runtimeFilter = filter;
+
+	return filter;
+}
+
+/*
+ * ExecHashRuntimeFilterReset
+ *		Empty the filter before the inner side is scanned, sizing the Bloom
+ *		filter for the expected number of inner rows.
+ */
+void
+ExecHashRuntimeFilterReset(HashJoinRuntimeFilter *filter, double ntuples)
+{
+	double		nbits = Max(ntuples, 1.0) * RUNTIME_FILTER_BITS_PER_ROW;
+	int			log2bits = RUNTIME_FILTER_MIN_LOG2BITS;
+	int			nwords;
+
+	filter->active = false;
+	if (filter->abandoned)
+		return;
+
+	while (log2bits < RUNTIME_FILTER_MAX_LOG2BITS &&
+		   (double) (((uint32) 1) << log2bits) < nbits)
+		log2bits++;
+	nwords = (((uint32) 1) << log2bits) / 64;
+
+	if (nwords > filter->bloom_nwords)
+	{
+		if (filter->bloom)
+			pfree(filter->bloom);
+		filter->bloom = (uint64 *)
+			MemoryContextAlloc(filter->hjstate->js.ps.state->es_query_cxt,
+							   nwords * sizeof(uint64));
+		filter->bloom_nwords = nwords;
+	}
+	memset(filter->bloom, 0, nwords * sizeof(uint64));
+	filter->bloom_log2bits = log2bits;
+	filter->use_bloom = true;
+
+	filter->min_value = INT64CONST(0x7FFFFFFFFFFFFFFF);
+	filter->max_value = -INT64CONST(0x7FFFFFFFFFFFFFFF) - 1;
+}
+
+/*
+ * ExecHashRuntimeFilterAdd
+ *		Add an inner row to the filter.
+ *
+ * The row must be in econtext->ecxt_innertuple, and its hash value must
+ * have been computed from the given hash keys.
+ */
+void
+ExecHashRuntimeFilterAdd(HashJoinRuntimeFilter *filter,
+						 ExprContext *econtext, List *hashkeys,
+						 uint32 hashvalue)
+{
+	int			log2bits = filter->bloom_log2bits;
+
+	if (filter->abandoned)
+		return;
+
+	RUNTIME_FILTER_SET_BIT(filter->bloom, RUNTIME_FILTER_BIT1(hashvalue, log2bits));
+	RUNTIME_FILTER_SET_BIT(filter->bloom, RUNTIME_FILTER_BIT2(hashvalue, log2bits));
+
+	if (filter->use_range)
+	{
+		MemoryContext oldContext;
+		Datum		keyval;
+		bool		isNull;
+
+		oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+		keyval = ExecEvalExpr((ExprState *) linitial(hashkeys), econtext,
+							  &isNull, NULL);
+		if (!isNull)
+		{
+			int64		value = runtime_filter_key_value(filter->inner_keytype,
+														 keyval);
+
+			if (value < filter->min_value)
+				filter->min_value = value;
+			if (value > filter->max_value)
+				filter->max_value = value;
+		}
+		MemoryContextSwitchTo(oldContext);
+	}
+}
+
+/*
+ * ExecHashRuntimeFilterFinish
+ *		Start checking the filter, now that the inner side is all in.
+ */
+void
+ExecHashRuntimeFilterFinish(HashJoinRuntimeFilter *filter, double ntuples)
+{
+	if (filter->abandoned)
+		return;
+
+	/*
+	 * If the planner underestimated the inner side badly, the Bloom filter
+	 * is too small to tell much apart; don't pay for checking it.
+	 */
+	if (ntuples * RUNTIME_FILTER_MIN_BITS_PER_ROW >
+		(double) (((uint32) 1) << filter->bloom_log2bits))
+		filter->use_bloom = false;
+
+	filter->active = filter->use_bloom || filter->use_range;
+}
+
+/*
+ * ExecHashRuntimeFilterCheck
+ *		Can the row in the slot find a match in the hash join?
+ *
+ * Called by the scan on the outer side of the join, on each row it is
+ * about to return.  A false result means the row has no match, and can be
+ * dropped.
+ */
+bool
+ExecHashRuntimeFilterCheck(HashJoinRuntimeFilter *filter, TupleTableSlot *slot)
+{
+	HashJoinState *hjstate = filter->hjstate;
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	ExprContext *econtext = filter->econtext;
+	uint32		hashvalue;
+	bool		hashkeys_null = false;
+	bool		pass;
+
+	if (!filter->active ||
+		hashtable == NULL ||
+		hashtable->eagerlyReleased)
+		return true;
+
+	econtext->ecxt_outertuple = slot;
+
+	/* A row with a NULL key can't match */
+	pass = ExecHashGetHashValue((HashState *) innerPlanState(hjstate),
+								hashtable, econtext,
+								hjstate->hj_OuterHashKeys,
+								true,	/* outer tuple */
+								false,	/* keep_nulls */
+								&hashvalue,
+								&hashkeys_null);
+
+	if (pass && filter->use_range)
+	{
+		MemoryContext oldContext;
+		Datum		keyval;
+		bool		isNull;
+
+		oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+		keyval = ExecEvalExpr(filter->outer_key, econtext, &isNull, NULL);
+		if (!isNull)
+		{
+			int64		value = runtime_filter_key_value(filter->outer_keytype,
+														 keyval);
+
+			pass = (value >= filter->min_value && value <= filter->max_value);
+		}
+		MemoryContextSwitchTo(oldContext);
+	}
+
+	if (pass && filter->use_bloom)
+	{
+		int			log2bits = filter->bloom_log2bits;
+
+		pass = RUNTIME_FILTER_TEST_BIT(filter->bloom,
+									   RUNTIME_FILTER_BIT1(hashvalue, log2bits)) &&
+			RUNTIME_FILTER_TEST_BIT(filter->bloom,
+									RUNTIME_FILTER_BIT2(hashvalue, log2bits));
+	}
+
+	filter->nchecked += 1;
+	if (!pass)
+		filter->nremoved += 1;
+
+	if (filter->nchecked == RUNTIME_FILTER_SAMPLE_ROWS &&
+		filter->nremoved < filter->nchecked * RUNTIME_FILTER_MIN_REMOVED)
+	{
+		filter->active = false;
+		filter->abandoned = true;
+	}
+
+	return pass;
+}
@@ -34,10 +34,20 @@
 static TupleTableSlot *ExecHashJoinOuterGetTuple(PlanState *outerNode,
 						  HashJoinState *hjstate,
 						  uint32 *hashvalue);
+static TupleTableSlot *ExecHashJoinBatchGetTuple(PlanState *outerNode,
+						  HashJoinState *hjstate,
+						  uint32 *hashvalue);
+static TupleTableSlot *ExecHashJoinRadixGetTuple(PlanState *outerNode,
+						  HashJoinState *hjstate,
+						  uint32 *hashvalue);
+static void ExecHashJoinRadixProbeCreate(HashJoinState *hjstate);
+static void ExecHashJoinRadixProbeReset(HashJoinState *hjstate);
+static void ExecHashJoinRadixProbeFree(HashJoinState *hjstate);
 static TupleTableSlot *ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 						  ExecWorkFile *file,
 						  uint32 *hashvalue,
-						  TupleTableSlot *tupleSlot);
+						  TupleTableSlot *tupleSlot,
+						  char **buf, Size *buflen);
 static int	ExecHashJoinNewBatch(HashJoinState *hjstate);
 static bool isNotDistinctJoin(List *qualList);
 
@@ -98,6 +108,14 @@ ExecHashJoin(HashJoinState *node)
 	 */
 	if (hashtable == NULL)
 	{
+		/*
+		 * The runtime filter, if any, belongs to the previous hash table
+		 * (on a rescan). Our outer side must not check it until it's
+		 * rebuilt below.
+		 */
+		if (node->hj_RuntimeFilter)
+			node->hj_RuntimeFilter->active = false;
+
 		/*
 		 * MPP-4165: My fix for MPP-3300 was correct in that we avoided
 		 * the *deadlock* but had very unexpected (and painful)
@@ -172,6 +190,10 @@ ExecHashJoin(HashJoinState *node)
 										PlanStateOperatorMemKB((PlanState *) hashNode));
 		node->hj_HashTable = hashtable;
 
+		if (node->hj_RuntimeFilter)
+			ExecHashRuntimeFilterReset(node->hj_RuntimeFilter,
+									   outerPlan(hashNode->ps.plan)->plan_rows);
+
 		/*
 		 * CDB: Offer extra info for EXPLAIN ANALYZE.
 		 */
@@ -221,6 +243,14 @@ ExecHashJoin(HashJoinState *node)
 			return NULL;
 		}
 
+		/*
+		 * All inner keys are in the runtime filter now; let the scan on our
+		 * outer side start dropping the rows that can't match.
+		 */
+		if (node->hj_RuntimeFilter)
+			ExecHashRuntimeFilterFinish(node->hj_RuntimeFilter,
+										hashtable->totalTuples);
+
 		/*
 		 * We just scanned the entire inner side and built the hashtable
 		 * (and its overflow batches). Check here and remember if the inner
@@ -626,6 +656,20 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	/* child Hash node needs to evaluate inner hash keys, too */
 	((HashState *) innerPlanState(hjstate))->hashkeys = rclauses;
 
+	/*
+	 * If a scan feeds our outer side directly, hand it a runtime filter
+	 * over the inner keys.
+	 */
+	hjstate->hj_RuntimeFilter = NULL;
+	if (gp_enable_runtime_filter)
+		hjstate->hj_RuntimeFilter = ExecHashRuntimeFilterCreate(hjstate);
+
+	/*
+	 * The buffer for probing a partitioned hash table a partition at a time
+	 * is set up by the first batch that needs it.
+	 */
+	hjstate->hj_RadixProbe = NULL;
+
 	hjstate->hj_NeedNewOuter = true;
 	hjstate->hj_MatchedOuter = false;
 	hjstate->hj_OuterNotEmpty = false;
@@ -669,6 +713,19 @@ ExecEndHashJoin(HashJoinState *node)
 	ExecClearTuple(node->hj_OuterTupleSlot);
 	ExecClearTuple(node->hj_HashTupleSlot);
 
+	ExecHashJoinRadixProbeFree(node);
+
+	if (node->hj_InnerReadBuf)
+	{
+		pfree(node->hj_InnerReadBuf);
+		node->hj_InnerReadBuf = NULL;
+	}
+	if (node->hj_OuterReadBuf)
+	{
+		pfree(node->hj_OuterReadBuf);
+		node->hj_OuterReadBuf = NULL;
+	}
+
 	/*
 	 * clean up subtrees
 	 */
@@ -693,6 +750,60 @@ static TupleTableSlot *
 ExecHashJoinOuterGetTuple(PlanState *outerNode,
 						  HashJoinState *hjstate,
 						  uint32 *hashvalue)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	int			curbatch;
+	TupleTableSlot *slot;
+
+	/*
+	 * Loop allows us to advance to new batches as needed.  NOTE: nbatch could
+	 * increase inside ExecHashJoinNewBatch, so don't try to optimize this
+	 * loop.
+	 */
+	for (;;)
+	{
+		if (ExecHashUseRadixProbe(hashtable))
+			slot = ExecHashJoinRadixGetTuple(outerNode, hjstate, hashvalue);
+		else
+			slot = ExecHashJoinBatchGetTuple(outerNode, hjstate, hashvalue);
+		if (!TupIsNull(slot))
+			return slot;
+
+		if (QueryFinishPending)
+			return NULL;
+
+		/*
+		 * We have reached the end of the batch. Try to switch to a saved
+		 * batch.
+		 */
+
+		/* SFR: This can cause re-spill! */
+		curbatch = ExecHashJoinNewBatch(hjstate);
+
+#ifdef HJDEBUG
+		elog(gp_workfile_caching_loglevel, "HashJoin built table with %.1f tuples for batch %d", hashtable->totalTuples, curbatch);
+#endif
+
+		/* Out of batches... */
+		if (curbatch >= hashtable->nbatch)
+			return NULL;
+
+		CheckSendPlanStateGpmonPkt(&hjstate->js.ps);
+	}
+}
+
+/*
+ * ExecHashJoinBatchGetTuple
+ *
+ *		get the next outer tuple of the current batch, without moving on
+ *		to the next batch.
+ *
+ * Returns a null slot at the end of the batch.
+ */
+static TupleTableSlot *
+ExecHashJoinBatchGetTuple(PlanState *outerNode,
+						  HashJoinState *hjstate,
+						  uint32 *hashvalue)
 {
 	HashJoinTable hashtable = hjstate->hj_HashTable;
 	int			curbatch = hashtable->curbatch;
@@ -718,7 +829,7 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 			}
 
 			if (TupIsNull(slot))
-				break;
+				return NULL;
 
 			/*
 			 * We have to compute the tuple's hash value.
@@ -747,57 +858,228 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 			 * continue with the next one.
 			 */
 		}
+	}
 
-		/*
-		 * We have just reached the end of the first pass. Try to switch to a
-		 * saved batch.
-		 */
+	if (curbatch >= hashtable->nbatch)
+		return NULL;
 
-		/* SFR: This can cause re-spill! */
-		curbatch = ExecHashJoinNewBatch(hjstate);
+	/*
+	 * For batches > 0, we can be reading many many outer tuples from disk
+	 * and probing them against the hashtable. If we don't find any
+	 * matches, we'll keep coming back here to read tuples from disk and
+	 * returning them (MPP-23213). Break this long tight loop here.
+	 */
+	CHECK_FOR_INTERRUPTS();
 
+	if (QueryFinishPending)
+		return NULL;
 
-#ifdef HJDEBUG
-		elog(gp_workfile_caching_loglevel, "HashJoin built table with %.1f tuples for batch %d", hashtable->totalTuples, curbatch);
-#endif
+	return ExecHashJoinGetSavedTuple(hjstate,
+									 hashtable->outerBatchFile[curbatch],
+									 hashvalue,
+									 hjstate->hj_OuterTupleSlot,
+									 &hjstate->hj_OuterReadBuf,
+									 &hjstate->hj_OuterReadBufLen);
+}
 
-	} /* if (curbatch == 0) */
+/*
+ * ExecHashJoinRadixGetTuple
+ *
+ *		get the next outer tuple of the current batch, in the order of the
+ *		radix partitions of the hash table (see notes in
+ *		executor/hashjoin.h).
+ *
+ * The buffered tuples are returned in hj_OuterTupleSlot.  Returns a null
+ * slot at the end of the batch.
+ */
+static TupleTableSlot *
+ExecHashJoinRadixGetTuple(PlanState *outerNode,
+						  HashJoinState *hjstate,
+						  uint32 *hashvalue)
+{
+	HashJoinRadixProbe *probe = hjstate->hj_RadixProbe;
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	MemTuple	tuple;
 
-	/*
-	 * Try to read from a temp file. Loop allows us to advance to new batches
-	 * as needed.  NOTE: nbatch could increase inside ExecHashJoinNewBatch, so
-	 * don't try to optimize this loop.
-	 */
-	while (curbatch < hashtable->nbatch)
+	/* Set up the buffer on first use, or for a rebuilt hash table */
+	if (probe == NULL || probe->space != hashtable->radixProbeSpace)
 	{
-		/*
-		 * For batches > 0, we can be reading many many outer tuples from disk
-		 * and probing them against the hashtable. If we don't find any
-		 * matches, we'll keep coming back here to read tuples from disk and
-		 * returning them (MPP-23213). Break this long tight loop here.
-		 */
-		CHECK_FOR_INTERRUPTS();
+		Assert(probe == NULL || probe->ntuples == 0);
+		ExecHashJoinRadixProbeCreate(hjstate);
+		probe = hjstate->hj_RadixProbe;
+	}
 
-		if (QueryFinishPending)
+	if (probe->next >= probe->ntuples)
+	{
+		MemoryContext oldcxt;
+		Size		nbytes = 0;
+		int			nparts = 1 << hashtable->log2_nparts;
+		int		   *counts;
+		int			i;
+
+		if (probe->exhausted)
+		{
+			/* the end of the batch; the next call starts on the next one */
+			ExecHashJoinRadixProbeReset(hjstate);
 			return NULL;
+		}
 
-		slot = ExecHashJoinGetSavedTuple(hjstate,
-										 hashtable->outerBatchFile[curbatch],
-										 hashvalue,
-										 hjstate->hj_OuterTupleSlot);
-		if (!TupIsNull(slot))
-			return slot;
-		curbatch = ExecHashJoinNewBatch(hjstate);
+		/* the slot may point into the buffer we're about to release */
+		ExecClearTuple(hjstate->hj_OuterTupleSlot);
+		MemoryContextReset(probe->tupcxt);
+		probe->ntuples = 0;
+		probe->next = 0;
 
-#ifdef HJDEBUG
-		elog(gp_workfile_caching_loglevel, "HashJoin built table with %.1f tuples for batch %d", hashtable->totalTuples, curbatch);
-#endif
+		/* Read ahead as many outer tuples as fit in the buffer */
+		while (probe->ntuples < probe->maxtuples &&
+			   nbytes < probe->maxbytes)
+		{
+			TupleTableSlot *slot;
+			uint32		hv;
 
-		CheckSendPlanStateGpmonPkt(&hjstate->js.ps);
+			slot = ExecHashJoinBatchGetTuple(outerNode, hjstate, &hv);
+			if (TupIsNull(slot))
+			{
+				probe->exhausted = true;
+				break;
+			}
+
+			oldcxt = MemoryContextSwitchTo(probe->tupcxt);
+			tuple = ExecCopySlotMemTuple(slot);
+			MemoryContextSwitchTo(oldcxt);
+
+			probe->tuples[probe->ntuples] = tuple;
+			probe->hashvalues[probe->ntuples] = hv;
+			probe->ntuples++;
+			nbytes += memtuple_get_size(tuple);
+		}
+
+		if (probe->ntuples == 0)
+		{
+			ExecHashJoinRadixProbeReset(hjstate);
+			return NULL;
+		}
+
+		/* Counting sort of the buffer by partition */
+		counts = (int *) MemoryContextAllocZero(probe->tupcxt,
+												(nparts + 1) * sizeof(int));
+		for (i = 0; i < probe->ntuples; i++)
+		{
+			int			bucketno;
+			int			batchno;
+
+			ExecHashGetBucketAndBatch(hashtable, probe->hashvalues[i],
+									  &bucketno, &batchno);
+			counts[HJ_BUCKET_PARTITION(hashtable, bucketno) + 1]++;
+		}
+		for (i = 1; i <= nparts; i++)
+			counts[i] += counts[i - 1];
+		for (i = 0; i < probe->ntuples; i++)
+		{
+			int			bucketno;
+			int			batchno;
+			int			pos;
+
+			ExecHashGetBucketAndBatch(hashtable, probe->hashvalues[i],
+									  &bucketno, &batchno);
+			pos = counts[HJ_BUCKET_PARTITION(hashtable, bucketno)]++;
+			probe->sorted_tuples[pos] = probe->tuples[i];
+			probe->sorted_hashvalues[pos] = probe->hashvalues[i];
+		}
+	}
+
+	*hashvalue = probe->sorted_hashvalues[probe->next];
+	tuple = probe->sorted_tuples[probe->next];
+	probe->next++;
+	probe->nprobed += 1;
+
+	return ExecStoreMinimalTuple(tuple, hjstate->hj_OuterTupleSlot, false);
+}
+
+/*
+ * ExecHashJoinRadixProbeCreate
+ *		set up the buffer of outer tuples for radix partitioned probing,
+ *		in the space the hash table set aside for it.
+ */
+static void
+ExecHashJoinRadixProbeCreate(HashJoinState *hjstate)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	MemoryContext cxt = hjstate->js.ps.state->es_query_cxt;
+	HashJoinRadixProbe *probe;
+	Size		slotsize = 2 * (sizeof(MemTuple) + sizeof(uint32));
+	double		nprobed = 0;
+	int			maxtuples;
+
+	Assert(hashtable->radixProbeSpace > 0);
+
+	if (hjstate->hj_RadixProbe != NULL)
+	{
+		nprobed = hjstate->hj_RadixProbe->nprobed;
+		ExecHashJoinRadixProbeFree(hjstate);
 	}
 
-	/* Out of batches... */
-	return NULL;
+	/* At most half of the space goes to the arrays, the rest to tuples */
+	maxtuples = Min(HJ_RADIX_PROBE_TUPLES,
+					hashtable->radixProbeSpace / 2 / slotsize);
+	maxtuples = Max(maxtuples, 1);
+
+	probe = (HashJoinRadixProbe *) MemoryContextAllocZero(cxt, sizeof(HashJoinRadixProbe));
+	probe->space = hashtable->radixProbeSpace;
+	probe->maxtuples = maxtuples;
+	probe->maxbytes = hashtable->radixProbeSpace - maxtuples * slotsize;
+	probe->nprobed = nprobed;
+	probe->tuples = (MemTuple *) MemoryContextAlloc(cxt, maxtuples * sizeof(MemTuple));
+	probe->hashvalues = (uint32 *) MemoryContextAlloc(cxt, maxtuples * sizeof(uint32));
+	probe->sorted_tuples = (MemTuple *) MemoryContextAlloc(cxt, maxtuples * sizeof(MemTuple));
+	probe->sorted_hashvalues = (uint32 *) MemoryContextAlloc(cxt, maxtuples * sizeof(uint32));
+	probe->tupcxt = AllocSetContextCreate(cxt,
+										  "HashJoinRadixProbe",
+										  ALLOCSET_DEFAULT_MINSIZE,
+										  ALLOCSET_DEFAULT_INITSIZE,
+										  ALLOCSET_DEFAULT_MAXSIZE);
+
+	hjstate->hj_RadixProbe = probe;
+}
+
+/*
+ * ExecHashJoinRadixProbeReset
+ *		forget the outer tuples buffered for radix partitioned probing.
+ */
+static void
+ExecHashJoinRadixProbeReset(HashJoinState *hjstate)
+{
+	HashJoinRadixProbe *probe = hjstate->hj_RadixProbe;
+
+	if (probe == NULL)
+		return;
+
+	ExecClearTuple(hjstate->hj_OuterTupleSlot);
+	MemoryContextReset(probe->tupcxt);
+	probe->ntuples = 0;
+	probe->next = 0;
+	probe->exhausted = false;
+}
+
+/*
+ * ExecHashJoinRadixProbeFree
+ *		release the buffer of outer tuples for radix partitioned probing.
+ */
+static void
+ExecHashJoinRadixProbeFree(HashJoinState *hjstate)
+{
+	HashJoinRadixProbe *probe = hjstate->hj_RadixProbe;
+
+	if (probe == NULL)
+		return;
+
+	MemoryContextDelete(probe->tupcxt);
+	pfree(probe->tuples);
+	pfree(probe->hashvalues);
+	pfree(probe->sorted_tuples);
+	pfree(probe->sorted_hashvalues);
+	pfree(probe);
+	hjstate->hj_RadixProbe = NULL;
 }
 
 /*
@@ -1008,7 +1290,7 @@ ExecHashJoinSaveTuple(PlanState *ps, MemTuple tuple, uint32 hashvalue,
 
 		oldcxt = MemoryContextSwitchTo(bfCxt);
 		hashtable->work_set = workfile_mgr_create_set(gp_workfile_type_hashjoin,
-				true, /* can_be_reused */
+				false, /* can_be_reused */
 				&hashtable->hjstate->js.ps);
 		MemoryContextSwitchTo(oldcxt);
 	}
@@ -1053,16 +1335,23 @@ ExecHashJoinSaveTuple(PlanState *ps, MemTuple tuple, uint32 hashvalue,
  *
  * On success, *hashvalue is set to the tuple's hash value, and the tuple
  * itself is stored in the given slot.
+ *
+ * The tuple is read into *buf, which is enlarged as needed and reused for
+ * the next tuple, rather than into a palloc'd copy of its own; it stays
+ * valid only until the next call with the same buffer.  Inner tuples are
+ * copied into the hash table's chunks by ExecHashTableInsert anyway.
  */
 static TupleTableSlot *
 ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 						  ExecWorkFile *file,
 						  uint32 *hashvalue,
-						  TupleTableSlot *tupleSlot)
+						  TupleTableSlot *tupleSlot,
+						  char **buf, Size *buflen)
 {
 	uint32		header[2];
 	size_t		nread;
 	MemTuple	tuple;
+	Size		tuplen;
 
 	/*
 	 * Since both the hash value and the MinimalTuple length word are uint32,
@@ -1077,7 +1366,19 @@ ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 	}
 
 	*hashvalue = header[0];
-	tuple = (MemTuple) palloc(memtuple_size_from_uint32(header[1]));
+	tuplen = memtuple_size_from_uint32(header[1]);
+	if (*buflen < tuplen)
+	{
+		Size		newlen = Max(tuplen, Max(*buflen * 2, 1024));
+
+		/* the slot may still point into the old buffer */
+		ExecClearTuple(tupleSlot);
+		if (*buf)
+			pfree(*buf);
+		*buf = MemoryContextAlloc(hjstate->js.ps.state->es_query_cxt, newlen);
+		*buflen = newlen;
+	}
+	tuple = (MemTuple) *buf;
 	memtuple_set_mtlen(tuple, header[1]);
 
 	nread = ExecWorkFile_Read(file,
@@ -1088,7 +1389,7 @@ ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 		ereport(ERROR,
 				(errcode_for_file_access(),
 				 errmsg("could not read from hash-join temporary file")));
-	return ExecStoreMinimalTuple(tuple, tupleSlot, true);
+	return ExecStoreMinimalTuple(tuple, tupleSlot, false);
 }
 
 
@@ -1164,6 +1465,7 @@ ExecReScanHashJoin(HashJoinState *node, ExprContext *exprCtxt)
 	node->hj_NeedNewOuter = true;
 	node->hj_MatchedOuter = false;
 	node->hj_FirstOuterTupleSlot = NULL;
+	ExecHashJoinRadixProbeReset(node);
 
 	/*
 	 * if chgParam of subnode is not null then plan will be re-scanned by
@@ -1205,7 +1507,7 @@ ReleaseHashTable(HashJoinState *node)
 	node->hj_NeedNewOuter = true;
 	node->hj_MatchedOuter = false;
 	node->hj_FirstOuterTupleSlot = NULL;
-
+	ExecHashJoinRadixProbeReset(node);
 }
 
 /* Is this an IS-NOT-DISTINCT-join qual list (as opposed the an equijoin)?
@@ -1316,7 +1618,9 @@ ExecHashJoinReloadHashTable(HashJoinState *hjstate)
 			slot = ExecHashJoinGetSavedTuple(hjstate,
 											 hashtable->innerBatchFile[curbatch],
 											 &hashvalue,
-											 hjstate->hj_HashTupleSlot);
+											 hjstate->hj_HashTupleSlot,
+											 &hjstate->hj_InnerReadBuf,
+											 &hjstate->hj_InnerReadBufLen);
 			if (!slot)
 				break;
 
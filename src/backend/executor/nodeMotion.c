@@ -22,8 +22,10 @@
 #include "cdb/cdbutil.h"
 #include "cdb/cdbvars.h"
 #include "cdb/cdbhash.h"
+#include "cdb/ml_ipc.h"
 #include "executor/executor.h"
 #include "executor/execdebug.h"
+#include "executor/instrument.h"
 #include "executor/nodeMotion.h"
 #include "optimizer/clauses.h"
 #include "parser/parse_oper.h"
@@ -94,6 +96,33 @@ typedef struct CdbMergeComparatorContext
 	MemTupleBinding    *mt_bind;
 } CdbMergeComparatorContext;
 
+/*
+ * MotionSkewStats
+ *
+ * Skew statistics for a sending redistribute motion, collected only when
+ * EXPLAIN ANALYZE is active.  Besides the number of rows sent to each
+ * target, we keep a small "space-saving" summary of the most frequent key
+ * hash values, so that a single hot key (e.g. a default customer id) can be
+ * told apart from a generally uneven distribution.
+ */
+#define MOTION_SKEW_NUM_KEYS	8
+
+typedef struct MotionSkewKey
+{
+	uint32		hash;			/* full hash value of the key */
+	int16		targetRoute;	/* route the key is sent to */
+	int64		count;			/* upper bound of rows with this key */
+	int64		error;			/* max overestimation of count */
+} MotionSkewKey;
+
+typedef struct MotionSkewStats
+{
+	int			numRoutes;
+	int64	   *routeTuples;	/* rows sent to each route */
+	int			numKeys;		/* used entries in keys[] */
+	MotionSkewKey keys[MOTION_SKEW_NUM_KEYS];
+} MotionSkewStats;
+
 static CdbMergeComparatorContext *
 CdbMergeComparator_CreateContext(TupleDesc      tupDesc,
                                  int            numSortCols,
@@ -121,6 +150,9 @@ static uint32 evalHashKey(ExprContext *econtext, List *hashkeys, List *hashtypes
 
 static void doSendEndOfStream(Motion * motion, MotionState * node);
 static void doSendTuple(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot);
+static void motionSkewCount(MotionState *node, uint32 hash, int16 targetRoute);
+static bool motionIsHotKey(Motion *motion, uint32 hash);
+static void ExecMotionExplainEnd(PlanState *planstate, struct StringInfoData *buf);
 
 
 /*=========================================================================
@@ -865,6 +897,12 @@ ExecInitMotion(Motion * node, EState *estate, int eflags)
 	motionstate->stopRequested = false;
 	motionstate->hashExpr = NULL;
 	motionstate->cdbhash = NULL;
+	motionstate->skewStats = NULL;
+
+	/* Start each sender's round-robin of hot keys at a different target. */
+	motionstate->hotKeyNextRoute =
+		node->numOutputSegs > 0 ? Max(GpIdentity.segindex, 0) % node->numOutputSegs : 0;
+	motionstate->numHotKeyTuples = 0;
 
     /* Look up the sending gang's slice table entry. */
     sendSlice = (Slice *)list_nth(sliceTable->slices, node->motionID);
@@ -986,6 +1024,13 @@ ExecInitMotion(Motion * node, EState *estate, int eflags)
 		motionstate->cdbhash = makeCdbHash(node->numOutputSegs);
     }
 
+	/*
+	 * Report interconnect flow control, and for redistribute motions the
+	 * skew of the redistribution, in EXPLAIN ANALYZE.
+	 */
+	if (motionstate->mstype == MOTIONSTATE_SEND && estate->es_instrument)
+		motionstate->ps.cdbexplainfun = ExecMotionExplainEnd;
+
 	/* Merge Receive: Set up the key comparator and priority queue. */
     if (node->sendSorted && motionstate->mstype == MOTIONSTATE_RECV) 
 	{
@@ -1429,14 +1474,33 @@ doSendTuple(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot)
 		 * we assign it to an int16. See below. */
 		targetRoute = motion->outputSegIdx[hval];
 
+		if (motion->numHotKeys > 0 &&
+			motionIsHotKey(motion, node->cdbhash->hash))
+		{
+			if (motion->hotKeysBroadcast)
+				targetRoute = BROADCAST_SEGIDX;
+			else
+			{
+				targetRoute = motion->outputSegIdx[node->hotKeyNextRoute];
+				if (++node->hotKeyNextRoute == motion->numOutputSegs)
+					node->hotKeyNextRoute = 0;
+			}
+			node->numHotKeyTuples++;
+		}
+
 		/* see MPP-2099, let's not run into this one again! NOTE: the
 		 * definition of BROADCAST_SEGIDX is key here, it *cannot* be
 		 * a valid route which our map (above) will *ever* return.
 		 * 
 		 * Note the "mapping" is generated at *planning* time in
 		 * makeDefaultSegIdxArray() in cdbmutate.c (it is the trivial
-		 * map, and is passed around our system a fair amount!). */
-		Assert(targetRoute != BROADCAST_SEGIDX);
+		 * map, and is passed around our system a fair amount!). Only
+		 * the hot keys of a join are broadcast on purpose. */
+		Assert(targetRoute != BROADCAST_SEGIDX || motion->hotKeysBroadcast);
+
+		if (node->ps.instrument && node->ps.instrument->need_cdb &&
+			targetRoute != BROADCAST_SEGIDX)
+			motionSkewCount(node, node->cdbhash->hash, targetRoute);
 	}
 	else /* ExplicitRedistribute */
 	{
@@ -1490,6 +1554,164 @@ doSendTuple(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot)
 }
 	
 
+/*
+ * motionIsHotKey
+ *		Is 'hash' one of the join keys the planner chose to split?
+ */
+static bool
+motionIsHotKey(Motion *motion, uint32 hash)
+{
+	int			i;
+
+	for (i = 0; i < motion->numHotKeys; i++)
+	{
+		if (motion->hotKeyHashes[i] == hash)
+			return true;
+	}
+	return false;
+}
+
+/*
+ * motionSkewCount
+ *		Account one row sent to 'targetRoute' with key hash 'hash'.
+ *
+ * The hot key summary uses the space-saving algorithm: a key that is not
+ * being tracked replaces the least frequent tracked key, inheriting its count
+ * as the error bound.  Any key that makes up more than 1/MOTION_SKEW_NUM_KEYS
+ * of the rows is guaranteed to be in the summary.
+ */
+static void
+motionSkewCount(MotionState *node, uint32 hash, int16 targetRoute)
+{
+	MotionSkewStats *stats = node->skewStats;
+	MotionSkewKey *key;
+	int			i;
+	int			minIdx;
+
+	if (stats == NULL)
+	{
+		MemoryContext oldcxt;
+
+		oldcxt = MemoryContextSwitchTo(node->ps.state->es_query_cxt);
+		stats = (MotionSkewStats *) palloc0(sizeof(MotionSkewStats));
+		stats->numRoutes = getgpsegmentCount();
+		stats->routeTuples = (int64 *) palloc0(stats->numRoutes * sizeof(int64));
+		MemoryContextSwitchTo(oldcxt);
+
+		node->skewStats = stats;
+	}
+
+	if (targetRoute >= 0 && targetRoute < stats->numRoutes)
+		stats->routeTuples[targetRoute]++;
+
+	minIdx = 0;
+	for (i = 0; i < stats->numKeys; i++)
+	{
+		key = &stats->keys[i];
+		if (key->hash == hash)
+		{
+			key->count++;
+			return;
+		}
+		if (key->count < stats->keys[minIdx].count)
+			minIdx = i;
+	}
+
+	if (stats->numKeys < MOTION_SKEW_NUM_KEYS)
+	{
+		key = &stats->keys[stats->numKeys++];
+		key->error = 0;
+		key->count = 1;
+	}
+	else
+	{
+		key = &stats->keys[minIdx];
+		key->error = key->count;
+		key->count++;
+	}
+	key->hash = hash;
+	key->targetRoute = targetRoute;
+}
+
+/*
+ * ExecMotionExplainEnd
+ *		Called before ExecutorEnd to finish EXPLAIN ANALYZE reporting.
+ *
+ * Reports the sender's interconnect flow control statistics, how evenly a
+ * redistribute motion spread its rows over the receiving segments, and
+ * whether a single key is responsible for it.
+ */
+static void
+ExecMotionExplainEnd(PlanState *planstate, struct StringInfoData *buf)
+{
+	MotionState *node = (MotionState *) planstate;
+	Motion	   *motion = (Motion *) planstate->plan;
+	MotionSkewStats *stats = node->skewStats;
+	MotionSkewKey *hottest = NULL;
+	int64		total = 0;
+	int64		maxTuples = -1;
+	int			maxRoute = -1;
+	int			nroutes = 0;
+	int			i;
+
+	InterconnectExplainMotion(planstate->state->interconnect_context,
+							  motion->motionID, buf);
+
+	if (motion->numHotKeys > 0)
+		appendStringInfo(buf,
+						 "%s " INT64_FORMAT " rows of %d hot keys %s all segments.\n",
+						 motion->hotKeysBroadcast ? "Broadcast" : "Spread",
+						 node->numHotKeyTuples, motion->numHotKeys,
+						 motion->hotKeysBroadcast ? "to" : "over");
+
+	if (stats == NULL)
+		return;
+
+	for (i = 0; i < stats->numRoutes; i++)
+	{
+		total += stats->routeTuples[i];
+		if (stats->routeTuples[i] > maxTuples)
+		{
+			maxTuples = stats->routeTuples[i];
+			maxRoute = i;
+		}
+		if (stats->routeTuples[i] > 0)
+			nroutes++;
+	}
+
+	if (total == 0)
+		return;
+
+	appendStringInfo(buf,
+					 "Rows sent: " INT64_FORMAT " to %d of %d segments"
+					 "; max " INT64_FORMAT " to seg%d, %.1fx avg.\n",
+					 total, nroutes, stats->numRoutes,
+					 maxTuples, maxRoute,
+					 (double) maxTuples * stats->numRoutes / total);
+
+	for (i = 0; i < stats->numKeys; i++)
+	{
+		if (hottest == NULL ||
+			stats->keys[i].count - stats->keys[i].error >
+			hottest->count - hottest->error)
+			hottest = &stats->keys[i];
+	}
+
+	/*
+	 * Only mention the hottest key if it accounts for a noticeably larger
+	 * share of rows than an even spread would give a single segment.
+	 */
+	if (hottest != NULL &&
+		(hottest->count - hottest->error) * stats->numRoutes > total)
+		appendStringInfo(buf,
+						 "Hottest key (hash %08x) sent at least " INT64_FORMAT
+						 " rows (%.1f%%) to seg%d.\n",
+						 hottest->hash,
+						 hottest->count - hottest->error,
+						 100.0 * (hottest->count - hottest->error) / total,
+						 (int) hottest->targetRoute);
+}
+
 /*
  * ExecReScanMotion
  *
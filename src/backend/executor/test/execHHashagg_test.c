@@ -172,8 +172,9 @@ test__destroy_agg_hash_table__check_for_leaks(void **state)
 #define NUM_SPILL_FILES 3
 #define NUM_BUCKETS 1024
 
-	ht->buckets = MemoryContextAllocZero(testContext, sizeof(HashAggEntry) * NUM_BUCKETS);
-	ht->bloom = MemoryContextAllocZero(testContext, NUM_BUCKETS / (sizeof(uint64) * 8 /* bits */));
+	ht->buckets = MemoryContextAllocZero(testContext, sizeof(HashAggBucket) * NUM_BUCKETS);
+	ht->tags = MemoryContextAllocZero(testContext, TAGS_SIZE(NUM_BUCKETS));
+	ht->key_compare = MemoryContextAllocZero(testContext, sizeof(uint8));
 
 	SpillSet *spill_set = createSpillSet(NUM_SPILL_FILES, 0 /* parent_hash_bit */);
 	ht->spill_set = spill_set;
@@ -200,6 +201,53 @@ test__destroy_agg_hash_table__check_for_leaks(void **state)
 	assert_true(aggState.hhashtable == NULL);
 }
 
+/* ==================== find_empty_bucket ==================== */
+/*
+ * Test that entries whose buckets are taken go to the next empty bucket,
+ * wrapping around the end of the table, and that the tags of the first
+ * buckets are mirrored past the end.
+ */
+void
+test__find_empty_bucket__probe_wraps_around(void **state)
+{
+#define NUM_PROBE_BUCKETS 32
+	HashAggTable *ht = palloc0(sizeof(HashAggTable));
+	HashAggEntry entries[HHA_GROUP_WIDTH + 2];
+	uint32 hashkey = 0xfe000000 | (NUM_PROBE_BUCKETS - 2);
+	unsigned bucket_idx;
+	int i;
+
+	ht->nbuckets = NUM_PROBE_BUCKETS;
+	ht->pshift = 0;
+	ht->buckets = palloc0(sizeof(HashAggBucket) * NUM_PROBE_BUCKETS);
+	ht->tags = palloc0(TAGS_SIZE(NUM_PROBE_BUCKETS));
+
+	/* All the entries have the same hash key, in the second last bucket */
+	for (i = 0; i < HHA_GROUP_WIDTH + 2; i++)
+	{
+		entries[i].hashvalue = hashkey;
+		bucket_idx = find_empty_bucket(ht, hashkey);
+		assert_int_equal(bucket_idx, (NUM_PROBE_BUCKETS - 2 + i) % NUM_PROBE_BUCKETS);
+		set_bucket(ht, bucket_idx, &entries[i]);
+	}
+
+	/* The entries took the last two buckets and the first HHA_GROUP_WIDTH */
+	for (i = 0; i < HHA_GROUP_WIDTH; i++)
+	{
+		assert_int_equal(ht->tags[i], HHA_TAG(hashkey));
+		assert_int_equal(ht->tags[NUM_PROBE_BUCKETS + i], HHA_TAG(hashkey));
+	}
+	assert_int_equal(ht->tags[HHA_GROUP_WIDTH], HHA_TAG_EMPTY);
+
+	/* A group starting in the last bucket sees the first buckets too */
+	assert_int_equal(match_group_tags(&ht->tags[NUM_PROBE_BUCKETS - 1], HHA_TAG(hashkey)),
+					 (uint32) 0xffff);
+	assert_int_equal(match_group_tags(&ht->tags[NUM_PROBE_BUCKETS - 2], HHA_TAG_EMPTY),
+					 (uint32) 0);
+	assert_int_equal(match_group_tags(&ht->tags[2], HHA_TAG_EMPTY),
+					 (uint32) 0xc000);
+}
+
 /* ==================== main ==================== */
 int
 main(int argc, char* argv[])
@@ -209,7 +257,8 @@ main(int argc, char* argv[])
 	const UnitTest tests[] = {
 		unit_test(test__getSpillFile__Initialize_wfile_success),
 		unit_test(test__getSpillFile__Initialize_wfile_exception),
-		unit_test(test__destroy_agg_hash_table__check_for_leaks)
+		unit_test(test__destroy_agg_hash_table__check_for_leaks),
+		unit_test(test__find_empty_bucket__probe_wraps_around)
 	};
 
 	MemoryContextInit();
@@ -1249,6 +1249,10 @@ _copyMotion(Motion *from)
 
 	COPY_SCALAR_FIELD(segidColIdx);
 
+	COPY_SCALAR_FIELD(numHotKeys);
+	COPY_POINTER_FIELD(hotKeyHashes, from->numHotKeys * sizeof(uint32));
+	COPY_SCALAR_FIELD(hotKeysBroadcast);
+
 	return newnode;
 }
 
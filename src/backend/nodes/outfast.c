@@ -554,6 +554,10 @@ _outMotion(StringInfo str, Motion *node)
 
 	WRITE_INT_FIELD(segidColIdx);
 
+	WRITE_INT_FIELD(numHotKeys);
+	WRITE_INT_ARRAY(hotKeyHashes, node->numHotKeys, uint32);
+	WRITE_BOOL_FIELD(hotKeysBroadcast);
+
 	_outPlanInfo(str, (Plan *) node);
 }
 
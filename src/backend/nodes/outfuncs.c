@@ -1112,6 +1112,12 @@ _outMotion(StringInfo str, Motion *node)
 
 	WRITE_INT_FIELD(segidColIdx);
 
+	WRITE_INT_FIELD(numHotKeys);
+	appendStringInfoLiteral(str, " :hotKeyHashes");
+	for (i = 0; i < node->numHotKeys; i++)
+		appendStringInfo(str, " %u", node->hotKeyHashes[i]);
+	WRITE_BOOL_FIELD(hotKeysBroadcast);
+
 	_outPlanInfo(str, (Plan *) node);
 }
 #endif /* COMPILING_BINARY_FUNCS */
@@ -2238,6 +2238,10 @@ _readMotion(void)
 
 	READ_INT_FIELD(segidColIdx);
 
+	READ_INT_FIELD(numHotKeys);
+	READ_INT_ARRAY(hotKeyHashes, local_node->numHotKeys, uint32);
+	READ_BOOL_FIELD(hotKeysBroadcast);
+
 	readPlanInfo((Plan *)local_node);
 
 	READ_DONE();
@@ -22,6 +22,7 @@
 #include <math.h>
 
 #include "catalog/pg_exttable.h"
+#include "catalog/pg_statistic.h"	/* STATISTIC_KIND_MCV */
 #include "catalog/pg_type.h"	/* INT8OID */
 #include "access/skey.h"
 #include "nodes/makefuncs.h"
@@ -41,8 +42,10 @@
 #include "parser/parsetree.h"
 #include "parser/parse_oper.h"	/* ordering_oper_opid */
 #include "utils/lsyscache.h"
+#include "utils/selfuncs.h"	/* examine_variable() */
 #include "utils/uri.h"
 
+#include "cdb/cdbhash.h"
 #include "cdb/cdbllize.h"		/* pull_up_Flow() */
 #include "cdb/cdbmutate.h"
 #include "cdb/cdbpath.h"		/* cdbpath_rows() */
@@ -103,6 +106,10 @@ static MergeJoin *create_mergejoin_plan(PlannerInfo *root, MergePath *best_path,
 					  Plan *outer_plan, Plan *inner_plan);
 static HashJoin *create_hashjoin_plan(PlannerInfo *root, HashPath *best_path,
 					 Plan *outer_plan, Plan *inner_plan);
+static void split_hot_join_keys(PlannerInfo *root, JoinType jointype,
+					List *hashclauses, Plan *outer_plan, Plan *inner_plan);
+static int	hot_key_hashes(PlannerInfo *root, Node *key, Oid hashtype,
+			   int numsegs, uint32 **hashes);
 static List *fix_indexqual_references(List *indexquals, IndexPath *index_path);
 static List *get_switched_clauses(List *clauses, Relids outerrelids);
 static List *order_qual_clauses(PlannerInfo *root, List *clauses);
@@ -3321,6 +3328,9 @@ create_hashjoin_plan(PlannerInfo *root,
 		}
 	}
 
+	split_hot_join_keys(root, best_path->jpath.jointype, hashclauses,
+						outer_plan, inner_plan);
+
 	/*
 	 * Build the hash node and hash join node.
 	 */
@@ -3365,6 +3375,172 @@ create_hashjoin_plan(PlannerInfo *root,
 	return join_plan;
 }
 
+/*
+ * Most keys a redistribute motion will treat as hot.
+ */
+#define MAX_HOT_JOIN_KEYS	16
+
+/*
+ * split_hot_join_keys
+ *	  Mark the most common join keys of a hash join whose inputs are both
+ *	  redistributed on the join key, so that the outer motion spreads their
+ *	  rows over all segments and the inner motion broadcasts them.
+ *
+ * Without this, all outer rows of a key that makes up a large fraction of
+ * the outer side land on one segment, which then does most of the join.
+ * Every outer row still meets every inner row of its key, so the result is
+ * unchanged for joins that emit each outer row at most once per match.  The
+ * join's output is no longer distributed by the join key, though; the
+ * cdbparallelize pass clears the marks again if anything above the join
+ * relies on that.
+ */
+static void
+split_hot_join_keys(PlannerInfo *root, JoinType jointype, List *hashclauses,
+					Plan *outer_plan, Plan *inner_plan)
+{
+	Motion	   *outer_motion;
+	Motion	   *inner_motion;
+	OpExpr	   *clause;
+	Node	   *outer_key;
+	Node	   *inner_key;
+	Oid			hashtype;
+	uint32	   *outer_hot;
+	uint32	   *inner_hot;
+	int			n_outer_hot;
+	int			n_inner_hot;
+	int			numsegs;
+	int			i;
+	int			j;
+	int			n;
+
+	if (!gp_motion_split_hot_keys)
+		return;
+
+	/*
+	 * A join that returns unmatched inner rows would return the broadcast
+	 * ones once per segment.
+	 */
+	if (jointype != JOIN_INNER && jointype != JOIN_LEFT &&
+		jointype != JOIN_SEMI && jointype != JOIN_ANTI)
+		return;
+
+	if (list_length(hashclauses) != 1 || outer_plan == NULL ||
+		!IsA(outer_plan, Motion) || !IsA(inner_plan, Motion))
+		return;
+
+	outer_motion = (Motion *) outer_plan;
+	inner_motion = (Motion *) inner_plan;
+	if (outer_motion->motionType != MOTIONTYPE_HASH ||
+		inner_motion->motionType != MOTIONTYPE_HASH ||
+		list_length(outer_motion->hashExpr) != 1 ||
+		list_length(inner_motion->hashExpr) != 1)
+		return;
+
+	/* Both sides must hash a key to the same value. */
+	hashtype = linitial_oid(outer_motion->hashDataTypes);
+	if (hashtype != linitial_oid(inner_motion->hashDataTypes))
+		return;
+
+	/* ... and be redistributed on the keys of this join. */
+	clause = (OpExpr *) linitial(hashclauses);
+	outer_key = strip_implicit_coercions((Node *) linitial(clause->args));
+	inner_key = strip_implicit_coercions((Node *) lsecond(clause->args));
+	if (!equal(strip_implicit_coercions(linitial(outer_motion->hashExpr)), outer_key) ||
+		!equal(strip_implicit_coercions(linitial(inner_motion->hashExpr)), inner_key))
+		return;
+
+	/*
+	 * The MCVs of a key are values of the key's own type.  If the motion
+	 * hashes a coercion of the key, as in a cross-type join, they can't be
+	 * hashed as the motion hashes its rows.
+	 */
+	if (exprType(outer_key) != hashtype || exprType(inner_key) != hashtype)
+		return;
+
+	numsegs = outer_motion->numOutputSegs;
+	if (numsegs < 2)
+		return;
+
+	n_outer_hot = hot_key_hashes(root, outer_key, hashtype, numsegs, &outer_hot);
+	if (n_outer_hot == 0)
+		return;
+
+	/*
+	 * Broadcasting the inner rows of a key that is common on the inner side
+	 * too would cost more than it saves.
+	 */
+	n_inner_hot = hot_key_hashes(root, inner_key, hashtype, numsegs, &inner_hot);
+	n = 0;
+	for (i = 0; i < n_outer_hot; i++)
+	{
+		for (j = 0; j < n_inner_hot; j++)
+		{
+			if (inner_hot[j] == outer_hot[i])
+				break;
+		}
+		if (j == n_inner_hot)
+			outer_hot[n++] = outer_hot[i];
+	}
+	if (n == 0)
+		return;
+
+	outer_motion->numHotKeys = n;
+	outer_motion->hotKeyHashes = outer_hot;
+	outer_motion->hotKeysBroadcast = false;
+
+	inner_motion->numHotKeys = n;
+	inner_motion->hotKeyHashes = (uint32 *) palloc(n * sizeof(uint32));
+	memcpy(inner_motion->hotKeyHashes, outer_hot, n * sizeof(uint32));
+	inner_motion->hotKeysBroadcast = true;
+}
+
+/*
+ * hot_key_hashes
+ *	  Collect the cdbhash values of the most common values of 'key' that
+ *	  would each give a single segment at least an even share of the rows.
+ *
+ * Returns the number of such values; *hashes is set to a palloc'd array.
+ */
+static int
+hot_key_hashes(PlannerInfo *root, Node *key, Oid hashtype, int numsegs,
+			   uint32 **hashes)
+{
+	VariableStatData vardata;
+	AttStatsSlot sslot;
+	int			nhot = 0;
+
+	*hashes = NULL;
+
+	examine_variable(root, key, 0, &vardata);
+	if (HeapTupleIsValid(vardata.statsTuple) &&
+		get_attstatsslot(&sslot, vardata.statsTuple,
+						 STATISTIC_KIND_MCV, InvalidOid,
+						 ATTSTATSSLOT_VALUES | ATTSTATSSLOT_NUMBERS))
+	{
+		CdbHash    *h = makeCdbHash(numsegs);
+		int			i;
+
+		*hashes = (uint32 *) palloc(MAX_HOT_JOIN_KEYS * sizeof(uint32));
+
+		/* The MCV list is sorted by decreasing frequency. */
+		for (i = 0; i < sslot.nnumbers && nhot < MAX_HOT_JOIN_KEYS; i++)
+		{
+			if (sslot.numbers[i] * numsegs < 1.0)
+				break;
+
+			cdbhashinit(h);
+			cdbhash(h, sslot.values[i], hashtype);
+			(*hashes)[nhot++] = h->hash;
+		}
+
+		pfree(h);
+		free_attstatsslot(&sslot);
+	}
+	ReleaseVariableStats(vardata);
+
+	return nhot;
+}
+
 
 /*****************************************************************************
  *
@@ -32,6 +32,9 @@ static const struct{
 {
     {{"none", "false", "no", "off", "0", 0}, bfz_nothing_init},
     {{"zlib", 0}, bfz_zlib_init},
+#ifdef HAVE_LIBZSTD
+    {{"zstd", 0}, bfz_zstd_init},
+#endif
     {{0}}
 };
 
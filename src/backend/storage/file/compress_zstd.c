@@ -0,0 +1,265 @@
+/* compress_zstd.c */
+#include "postgres.h"
+
+#include "storage/bfz.h"
+
+#ifdef HAVE_LIBZSTD
+
+/* for ZSTD_customMem and the _advanced constructors */
+#define ZSTD_STATIC_LINKING_ONLY
+#include <zstd.h>
+
+#include "utils/memutils.h"
+
+/*
+ * Spill files are written and read once, so favour speed over ratio.
+ */
+#define BFZ_ZSTD_LEVEL		1
+
+/*
+ * bfz hands the codec one bfz buffer at a time, each of them at most
+ * BFZ_BUFFER_SIZE bytes, and on reading expects exactly the same buffers
+ * back: the checksum of a buffer, if any, is at its end.  So every buffer
+ * is compressed on its own and written as a frame, preceded by a header
+ * with its raw and stored lengths.  A buffer that does not get smaller is
+ * stored as it is, with both lengths equal.
+ */
+typedef struct bfz_zstd_frame_header
+{
+	int32		rawLen;
+	int32		storedLen;
+} bfz_zstd_frame_header;
+
+#define COMPRESSION_BUFFER_SIZE		ZSTD_COMPRESSBOUND(BFZ_BUFFER_SIZE)
+
+struct bfz_zstd_freeable_stuff
+{
+	struct bfz_freeable_stuff super;
+
+	/* true if compressing, false if decompressing */
+	bool		compressing;
+
+	ZSTD_CCtx  *cctx;
+	ZSTD_DCtx  *dctx;
+
+	/* A frame header followed by the stored data of the frame */
+	char		buf[sizeof(bfz_zstd_frame_header) + COMPRESSION_BUFFER_SIZE];
+};
+
+/* This file implements bfz compression algorithm "zstd". */
+
+/*
+ * bfz_zstd_close_ex
+ *	Close buffers etc. Does not close the underlying file!
+ */
+static void
+bfz_zstd_close_ex(bfz_t *thiz)
+{
+	struct bfz_zstd_freeable_stuff *fs = (void *) thiz->freeable_stuff;
+
+	if (NULL != fs)
+	{
+		if (fs->cctx)
+			ZSTD_freeCCtx(fs->cctx);
+		if (fs->dctx)
+			ZSTD_freeDCtx(fs->dctx);
+
+		pfree(fs);
+		thiz->freeable_stuff = NULL;
+	}
+}
+
+/*
+ * bfz_zstd_write_ex
+ *	 Compress a bfz buffer and write it as a frame.
+ *	 An exception is thrown if the data cannot be written for any reason.
+ */
+static void
+bfz_zstd_write_ex(bfz_t *thiz, const char *buffer, int size)
+{
+	struct bfz_zstd_freeable_stuff *fs = (void *) thiz->freeable_stuff;
+	bfz_zstd_frame_header header;
+	char	   *data = fs->buf + sizeof(header);
+	size_t		compressedLen;
+	int			have;
+	int			written;
+
+	Assert(size <= BFZ_BUFFER_SIZE);
+
+	compressedLen = ZSTD_compressCCtx(fs->cctx, data, COMPRESSION_BUFFER_SIZE,
+									  buffer, size, BFZ_ZSTD_LEVEL);
+	if (ZSTD_isError(compressedLen))
+		ereport(ERROR,
+				(errmsg("zstd compression failed"),
+				 errdetail("%s", ZSTD_getErrorName(compressedLen))));
+
+	header.rawLen = size;
+	if (compressedLen < (size_t) size)
+		header.storedLen = compressedLen;
+	else
+	{
+		header.storedLen = size;
+		memcpy(data, buffer, size);
+	}
+	memcpy(fs->buf, &header, sizeof(header));
+
+	/* Write until the frame is out */
+	have = sizeof(header) + header.storedLen;
+	written = 0;
+	while (have > 0)
+	{
+		int			n = FileWrite(thiz->file, fs->buf + written, have);
+
+		if (n < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not write to temporary file: %m")));
+		written += n;
+		have -= n;
+	}
+}
+
+/*
+ * Read exactly size bytes from the underlying file, unless it ends first.
+ * Returns the number of bytes read.
+ */
+static int
+bfz_zstd_read_fully(bfz_t *thiz, char *buffer, int size)
+{
+	int			done = 0;
+
+	while (done < size)
+	{
+		int			n = FileRead(thiz->file, buffer + done, size - done);
+
+		if (n < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read from temporary file: %m")));
+		if (n == 0)
+			break;
+		done += n;
+	}
+
+	return done;
+}
+
+/*
+ * bfz_zstd_read_ex
+ *	Read the next frame from an already opened compressed file, and
+ *	decompress it into the given buffer.
+ *
+ *	The buffer pointer must be valid and have at least size bytes.
+ *	An exception is thrown if the data cannot be read for any reason.
+ *
+ * Returns the size of the bfz buffer the frame holds, 0 at end of file.
+ */
+static int
+bfz_zstd_read_ex(bfz_t *thiz, char *buffer, int size)
+{
+	struct bfz_zstd_freeable_stuff *fs = (void *) thiz->freeable_stuff;
+	bfz_zstd_frame_header header;
+	int			n;
+	size_t		rawLen;
+
+	n = bfz_zstd_read_fully(thiz, (char *) &header, sizeof(header));
+	if (n == 0)
+		return 0;
+
+	if (n != sizeof(header) ||
+		header.rawLen < 0 || header.rawLen > size ||
+		header.storedLen < 0 || header.storedLen > header.rawLen)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("invalid frame in temporary file")));
+
+	if (header.storedLen == header.rawLen)
+	{
+		if (bfz_zstd_read_fully(thiz, buffer, header.rawLen) != header.rawLen)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("unexpected end of temporary file")));
+		return header.rawLen;
+	}
+
+	if (bfz_zstd_read_fully(thiz, fs->buf, header.storedLen) != header.storedLen)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("unexpected end of temporary file")));
+
+	rawLen = ZSTD_decompressDCtx(fs->dctx, buffer, size,
+								 fs->buf, header.storedLen);
+	if (ZSTD_isError(rawLen))
+		ereport(ERROR,
+				(errmsg("could not uncompress data from temporary file"),
+				 errdetail("%s", ZSTD_getErrorName(rawLen))));
+	if (rawLen != (size_t) header.rawLen)
+		ereport(ERROR,
+				(errmsg("could not uncompress data from temporary file"),
+				 errdetail("Expected %d bytes, got %d.",
+						   header.rawLen, (int) rawLen)));
+
+	return header.rawLen;
+}
+
+/*
+ * zstd allocates its contexts through these, in the memory context of the
+ * file, so that they go away with it when a spill is aborted.
+ */
+static void *
+zstd_alloc(void *opaque, size_t size)
+{
+	if (size > MaxAllocSize)
+		return NULL;
+
+	return MemoryContextAlloc((MemoryContext) opaque, size);
+}
+
+static void
+zstd_free(void *opaque, void *address)
+{
+	if (address != NULL)
+		pfree(address);
+}
+
+/*
+ * bfz_zstd_init
+ *	Initialize the zstd subsystem for a file.
+ *
+ *	The underlying file descriptor fd should already be opened
+ *	and valid. Memory is allocated in the current memory context.
+ */
+void
+bfz_zstd_init(bfz_t *thiz)
+{
+	struct bfz_zstd_freeable_stuff *fs = palloc(sizeof *fs);
+	ZSTD_customMem mem;
+
+	mem.customAlloc = zstd_alloc;
+	mem.customFree = zstd_free;
+	mem.opaque = CurrentMemoryContext;
+
+	fs->compressing = (thiz->mode == BFZ_MODE_APPEND);
+	fs->cctx = NULL;
+	fs->dctx = NULL;
+
+	if (fs->compressing)
+		fs->cctx = ZSTD_createCCtx_advanced(mem);
+	else
+		fs->dctx = ZSTD_createDCtx_advanced(mem);
+	if (fs->cctx == NULL && fs->dctx == NULL)
+	{
+		pfree(fs);
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory"),
+				 errdetail("Failed to create a zstd context.")));
+	}
+
+	thiz->freeable_stuff = &fs->super;
+	fs->super.read_ex = bfz_zstd_read_ex;
+	fs->super.write_ex = bfz_zstd_write_ex;
+	fs->super.close_ex = bfz_zstd_close_ex;
+}
+
+#endif   /* HAVE_LIBZSTD */
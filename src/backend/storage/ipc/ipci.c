@@ -26,6 +26,7 @@
 #include "access/appendonlywriter.h"
 #include "cdb/cdblocaldistribxact.h"
 #include "cdb/cdbvars.h"
+#include "cdb/ml_ipc.h"
 #include "commands/async.h"
 #include "miscadmin.h"
 #include "pgstat.h"
@@ -59,6 +60,7 @@
 #include "executor/spi.h"
 #include "utils/workfile_mgr.h"
 #include "utils/session_state.h"
+#include "utils/tuplestorenew.h"
 
 shmem_startup_hook_type shmem_startup_hook = NULL;
 
@@ -166,8 +168,10 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 		size = add_size(size, FtsShmemSize());
 		size = add_size(size, tmShmemSize());
 		size = add_size(size, SeqServerShmemSize());
+		size = add_size(size, InterconnectShmemSize());
 		size = add_size(size, CheckpointerShmemSize());
 		size = add_size(size, CancelBackendMsgShmemSize());
+		size = add_size(size, NTupleStoreShmemSize());
 
 #ifdef FAULT_INJECTOR
 		size = add_size(size, FaultInjector_ShmemSize());
@@ -307,6 +311,7 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 	WalRcvShmemInit();
 	AutoVacuumShmemInit();
 	SeqServerShmemInit();
+	InterconnectShmemInit();
 
 #ifdef FAULT_INJECTOR
 	FaultInjector_ShmemInit();
@@ -320,6 +325,7 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 	AsyncShmemInit();
 	workfile_mgr_cache_init();
 	BackendCancelShmemInit();
+	NTupleStoreShmemInit();
 
 	/*
 	 * Set up Instrumentation free list
@@ -1248,6 +1248,58 @@ cmp_numerics(Numeric num1, Numeric num2)
 	return result;
 }
 
+/*
+ * numeric_abbrev_key() -
+ *
+ *	An order preserving 64-bit prefix of a numeric, for sorting: if
+ *	num1 < num2 then the key of num1 is <= the key of num2, unsigned.  Equal
+ *	keys must be resolved with cmp_numerics.
+ *
+ *	The magnitude packs the weight, biased by 44 into 7 bits, above the first
+ *	four NBASE digits of 14 bits each; weights out of that range collapse to
+ *	the smallest or largest key.  Positive values go above 2^63 and negative
+ *	ones below it, mirrored.  NaN, larger than any number, gets the top key.
+ */
+uint64
+numeric_abbrev_key(Numeric num)
+{
+	NumericDigit *digits = NUMERIC_DIGITS(num);
+	int			ndigits = NUMERIC_NDIGITS(num);
+	int			weight = NUMERIC_WEIGHT(num);
+	uint64		mag;
+
+	if (NUMERIC_IS_NAN(num))
+		return PG_UINT64_MAX;
+
+	if (ndigits == 0 || weight < -44)
+		mag = 0;
+	else if (weight > 83)
+		mag = (UINT64CONST(1) << 63) - 1;
+	else
+	{
+		mag = ((uint64) (weight + 44)) << 56;
+		switch (ndigits)
+		{
+			default:
+				mag |= (uint64) digits[3];
+				/* FALLTHROUGH */
+			case 3:
+				mag |= ((uint64) digits[2]) << 14;
+				/* FALLTHROUGH */
+			case 2:
+				mag |= ((uint64) digits[1]) << 28;
+				/* FALLTHROUGH */
+			case 1:
+				mag |= ((uint64) digits[0]) << 42;
+				break;
+		}
+	}
+
+	if (NUMERIC_SIGN(num) == NUMERIC_NEG)
+		return (UINT64CONST(1) << 63) - mag;
+	return (UINT64CONST(1) << 63) + mag;
+}
+
 Datum
 hash_numeric(PG_FUNCTION_ARGS)
 {
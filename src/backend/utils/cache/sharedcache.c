@@ -641,6 +641,126 @@ Cache_Insert(Cache *cache, CacheEntry *entry)
 			&cacheStats->maxTimeInsert);
 }
 
+/*
+ * Look up a cached entry with the given key.
+ *
+ * Only entries in the CACHED state are visible to lookups. The matching entry
+ * is returned pinned and registered for cleanup; the client must give it back
+ * with Cache_Release.
+ *
+ * Returns NULL if no entry matches.
+ */
+CacheEntry *
+Cache_Lookup(Cache *cache, const void *key)
+{
+	Assert(NULL != cache);
+	Assert(NULL != key);
+
+	Cache_Stats *cacheStats = &cache->cacheHdr->cacheStats;
+	Cache_AddPerfCounter(&cacheStats->noLookups, 1 /* delta */);
+
+	uint32 hashvalue = cache->hash(key, cache->cacheHdr->keySize);
+	volatile CacheAnchor *anchor = SyncHTLookup(cache->syncHashtable, &hashvalue);
+	if (NULL == anchor)
+	{
+		return NULL;
+	}
+
+	CacheEntry *foundEntry = NULL;
+
+	/* Acquire anchor lock to walk the chain */
+	SpinLockAcquire(&anchor->spinlock);
+
+	CacheEntry *crtEntry = anchor->firstEntry;
+	while (NULL != crtEntry)
+	{
+		if (CACHE_ENTRY_CACHED == crtEntry->state)
+		{
+			void *crtKey = (char *) CACHE_ENTRY_PAYLOAD(crtEntry) + cache->cacheHdr->keyOffset;
+
+			Cache_AddPerfCounter(&cacheStats->noCompares, 1 /* delta */);
+			if (0 == cache->match(crtKey, key, cache->cacheHdr->keySize))
+			{
+				Cache_EntryAddRef(cache, crtEntry);
+				foundEntry = crtEntry;
+				break;
+			}
+		}
+		crtEntry = crtEntry->nextEntry;
+	}
+
+	SpinLockRelease(&anchor->spinlock);
+
+	SyncHTRelease(cache->syncHashtable, (void *) anchor);
+
+	if (NULL != foundEntry)
+	{
+		Cache_AddPerfCounter(&cacheStats->noCacheHits, 1 /* delta */);
+		Cache_RegisterCleanup(cache, foundEntry, true /* isCachedEntry */);
+	}
+
+	return foundEntry;
+}
+
+/*
+ * Evict a cached entry.
+ *
+ * The entry is marked deleted so that lookups no longer return it. If no
+ * client is using it, it is removed from the cache and cleaned up right away;
+ * otherwise the last client to release it does that.
+ *
+ * The caller does not need to hold a pin on the entry. Returns false if the
+ * entry was no longer in the CACHED state when we got to it.
+ */
+bool
+Cache_Evict(Cache *cache, CacheEntry *entry)
+{
+	Assert(NULL != cache);
+	Assert(NULL != entry);
+
+	uint32 hashvalue = entry->hashvalue;
+	volatile CacheAnchor *anchor = SyncHTLookup(cache->syncHashtable, &hashvalue);
+	if (NULL == anchor)
+	{
+		return false;
+	}
+
+	/*
+	 * Cached entries are only linked and unlinked under the anchor lock, so
+	 * once we hold it, an entry that is still CACHED with this hashvalue is
+	 * on this chain and cannot go away under us.
+	 */
+	SpinLockAcquire(&anchor->spinlock);
+
+	if (CACHE_ENTRY_CACHED != entry->state || hashvalue != entry->hashvalue)
+	{
+		SpinLockRelease(&anchor->spinlock);
+		SyncHTRelease(cache->syncHashtable, (void *) anchor);
+		return false;
+	}
+
+	/* Pin the entry so that releasing it below deletes it if unused */
+	Cache_EntryAddRef(cache, entry);
+
+	uint32 expected = CACHE_ENTRY_CACHED;
+#ifdef USE_ASSERT_CHECKING
+	int32 casResult =
+#endif
+	pg_atomic_compare_exchange_u32((pg_atomic_uint32 *)&entry->state, &expected, CACHE_ENTRY_DELETED);
+	Assert(1 == casResult);
+
+	SpinLockRelease(&anchor->spinlock);
+	SyncHTRelease(cache->syncHashtable, (void *) anchor);
+
+	Cache_AddPerfCounter(&cache->cacheHdr->cacheStats.noEvicts, 1 /* delta */);
+	Cache_DecPerfCounter(&cache->cacheHdr->cacheStats.noCachedEntries, 1 /* delta */);
+	Cache_AddPerfCounter(&cache->cacheHdr->cacheStats.noDeletedEntries, 1 /* delta */);
+
+	Cache_ReleaseCached(cache, entry, false /* unregisterCleanup */);
+
+	return true;
+}
+
 /*
  * Unlink a cache entry from the chain anchored at a CacheAnchor.
  *
@@ -29,7 +29,10 @@
 #include "cdb/cdbappendonlystoragelayer.h"
 #include "cdb/cdbappendonlystorageread.h"
 #include "cdb/cdbappendonlystoragewrite.h"
+#include "cdb/cdbdecompresspool.h"
+#include "storage/gp_compress.h"
 #include "utils/datumstream.h"
+#include "utils/fmgroids.h"
 #include "utils/guc.h"
 #include "catalog/pg_compression.h"
 #include "utils/faultinjector.h"
@@ -41,6 +44,7 @@ typedef enum AOCSBK
 	AOCSBK_BLOB,
 }	AOCSBK;
 
+static void datumstreamread_forget_next_block(DatumStreamRead * acc);
 
 static void
 datumstreamread_check_large_varlena_integrity(
@@ -616,6 +620,8 @@ create_datumstreamwrite(
 							   acc->datumStreamVersion,
 							   acc->rle_want_compression,
 							   acc->delta_want_compression,
+							   acc->rle_want_compression && gp_aocs_dictionary_encoding,
+							   acc->rle_want_compression && gp_aocs_bitpack_encoding,
 							   initialMaxDatumPerBlock,
 							   maxDatumPerBlock,
 							   acc->maxAoBlockSize - acc->maxAoHeaderSize,
@@ -770,6 +776,12 @@ destroy_datumstreamwrite(DatumStreamWrite * ds)
 void
 destroy_datumstreamread(DatumStreamRead * ds)
 {
+	if (ds->decompressJob)
+	{
+		datumstreamread_forget_next_block(ds);
+		DecompressPool_ReleaseJob(ds->decompressJob);
+	}
+
 	DatumStreamBlockRead_Finish(&ds->blockRead);
 
 	if (ds->large_object_buffer)
@@ -831,6 +843,7 @@ datumstreamread_open_file(DatumStreamRead * ds, char *fn, int64 eof, int64 eofUn
 
 	if (ds->need_close_file)
 		datumstreamread_close_file(ds);
+	datumstreamread_forget_next_block(ds);
 
 	AppendOnlyStorageRead_OpenFile(&ds->ao_read, fn, version, ds->eof);
 
@@ -858,6 +871,8 @@ datumstreamwrite_close_file(DatumStreamWrite * ds)
 void
 datumstreamread_close_file(DatumStreamRead * ds)
 {
+	datumstreamread_forget_next_block(ds);
+
 	AppendOnlyStorageRead_CloseFile(&ds->ao_read);
 
 	ds->need_close_file = false;
@@ -1160,6 +1175,33 @@ datumstreamread_block_get_ready(DatumStreamRead * acc)
 	}
 }
 
+/*
+ * Make sure large_object_buffer can hold the decompressed content of the
+ * current block.
+ */
+static void
+datumstreamread_grow_content_buffer(DatumStreamRead * acc)
+{
+	MemoryContext oldCtxt;
+
+	if (acc->large_object_buffer_size >= acc->getBlockInfo.contentLen)
+		return;
+
+	oldCtxt = MemoryContextSwitchTo(acc->memctxt);
+
+	if (acc->large_object_buffer)
+	{
+		pfree(acc->large_object_buffer);
+		acc->large_object_buffer = NULL;
+
+		SIMPLE_FAULT_INJECTOR(MallocFailure);
+	}
+
+	acc->large_object_buffer_size = acc->getBlockInfo.contentLen;
+	acc->large_object_buffer = palloc(acc->getBlockInfo.contentLen);
+	MemoryContextSwitchTo(oldCtxt);
+}
+
 void
 datumstreamread_block_content(DatumStreamRead * acc)
 {
@@ -1182,24 +1224,7 @@ datumstreamread_block_content(DatumStreamRead * acc)
 		if (acc->getBlockInfo.isCompressed)
 		{
 			/* Compressed, need to decompress to our own buffer.  */
-			if (acc->large_object_buffer_size < acc->getBlockInfo.contentLen)
-			{
-				MemoryContext oldCtxt;
-
-				oldCtxt = MemoryContextSwitchTo(acc->memctxt);
-
-				if (acc->large_object_buffer)
-				{
-					pfree(acc->large_object_buffer);
-					acc->large_object_buffer = NULL;
-
-					SIMPLE_FAULT_INJECTOR(MallocFailure);
-				}
-
-				acc->large_object_buffer_size = acc->getBlockInfo.contentLen;
-				acc->large_object_buffer = palloc(acc->getBlockInfo.contentLen);
-				MemoryContextSwitchTo(oldCtxt);
-			}
+			datumstreamread_grow_content_buffer(acc);
 
 			AppendOnlyStorageRead_Content(
 										  &acc->ao_read,
@@ -1284,6 +1309,197 @@ datumstreamread_block_content(DatumStreamRead * acc)
 }
 
 
+/*
+ * Let the decompression worker pool decompress the next block of the stream
+ * while the executor is still busy with the current one.
+ *
+ * Returns false if the codec cannot run in a worker or the pool is not
+ * available, in which case the stream keeps decompressing by itself.  The
+ * pool holds two buffers of the maximum block size for each enabled stream,
+ * which the caller must account for.
+ */
+bool
+datumstreamread_enable_decompress_ahead(DatumStreamRead * acc)
+{
+	if (acc->decompressJob == NULL &&
+		DecompressPool_CodecSupported(acc->ao_attr.compressType))
+		acc->decompressJob = DecompressPool_AcquireJob(acc->ao_attr.compressType,
+													   acc->maxAoBlockSize);
+
+	return acc->decompressJob != NULL;
+}
+
+/*
+ * Drop the block read ahead by datumstreamread_decompress_ahead(), if any.
+ */
+static void
+datumstreamread_forget_next_block(DatumStreamRead * acc)
+{
+	if (acc->decompressJobSubmitted)
+	{
+		DecompressPool_Cancel(acc->decompressJob);
+		acc->decompressJobSubmitted = false;
+	}
+	acc->haveNextBlockInfo = false;
+}
+
+/*
+ * Read the header of the block after the current one and, if it is a small
+ * compressed block, hand it over to a decompression worker.
+ *
+ * This moves the storage read on to the next block, so it can only be done
+ * once the content of the current block is in our own buffer.
+ */
+static void
+datumstreamread_decompress_ahead(DatumStreamRead * acc)
+{
+	struct getBlockInfo *info = &acc->nextBlockInfo;
+	uint8	   *compressed;
+	int32		compressedLen;
+
+	Assert(!acc->haveNextBlockInfo);
+	Assert(!acc->decompressJobSubmitted);
+
+	if (acc->buffer_beginp != acc->large_object_buffer)
+		return;
+
+	acc->haveNextBlockInfo = true;
+	acc->nextBlockEof = !AppendOnlyStorageRead_GetBlockInfo(&acc->ao_read,
+															&info->contentLen,
+															&info->execBlockKind,
+															&info->firstRow,
+															&info->rowCnt,
+															&info->isLarge,
+															&info->isCompressed);
+	if (acc->nextBlockEof)
+		return;
+	acc->nextBlockFileOffset = acc->ao_read.current.headerOffsetInFile;
+
+	if (info->execBlockKind != AOCSBK_BLOCK || info->isLarge ||
+		!info->isCompressed || info->contentLen > acc->maxAoBlockSize)
+		return;
+
+	compressed = AppendOnlyStorageRead_GetCompressedBuffer(&acc->ao_read,
+														   &compressedLen);
+	if (compressedLen > acc->maxAoBlockSize)
+		return;
+
+	memcpy(DecompressPool_JobBuffer(acc->decompressJob), compressed,
+		   compressedLen);
+	DecompressPool_Submit(acc->decompressJob, compressedLen, info->contentLen);
+	acc->decompressJobSubmitted = true;
+}
+
+/*
+ * Get the header information of the next block into getBlockInfo, taking
+ * it from the read ahead if there was one.  Returns false at the end of the
+ * segment file.
+ */
+static bool
+datumstreamread_next_block_info(DatumStreamRead * acc)
+{
+	if (acc->haveNextBlockInfo)
+	{
+		acc->haveNextBlockInfo = false;
+		if (acc->nextBlockEof)
+			return false;
+
+		acc->getBlockInfo = acc->nextBlockInfo;
+		acc->blockFileOffset = acc->nextBlockFileOffset;
+		return true;
+	}
+
+	if (!AppendOnlyStorageRead_GetBlockInfo(&acc->ao_read,
+											&acc->getBlockInfo.contentLen,
+											&acc->getBlockInfo.execBlockKind,
+											&acc->getBlockInfo.firstRow,
+											&acc->getBlockInfo.rowCnt,
+											&acc->getBlockInfo.isLarge,
+											&acc->getBlockInfo.isCompressed))
+		return false;
+
+	acc->blockFileOffset = acc->ao_read.current.headerOffsetInFile;
+	return true;
+}
+
+/*
+ * Skip the block found by datumstreamread_next_block_info() without looking
+ * at its content.
+ */
+static void
+datumstreamread_skip_next_block(DatumStreamRead * acc)
+{
+	if (acc->decompressJobSubmitted)
+	{
+		DecompressPool_Cancel(acc->decompressJob);
+		acc->decompressJobSubmitted = false;
+	}
+
+	AppendOnlyStorageRead_SkipCurrentBlock(&acc->ao_read);
+}
+
+/*
+ * Take the content of the current block from the decompression worker.
+ */
+static void
+datumstreamread_decompressed_content(DatumStreamRead * acc)
+{
+	uint8	   *content;
+	bool		succeeded;
+
+	DatumStreamBlockRead_Reset(&acc->blockRead);
+	acc->largeObjectState = DatumStreamLargeObjectState_None;
+
+	datumstreamread_grow_content_buffer(acc);
+
+	content = DecompressPool_Wait(acc->decompressJob, &succeeded);
+	acc->decompressJobSubmitted = false;
+
+	if (succeeded)
+		memcpy(acc->large_object_buffer, content, acc->getBlockInfo.contentLen);
+	else
+	{
+		PGFunction *cfns = acc->ao_read.compression_functions;
+
+		if (cfns == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_INTERNAL_ERROR),
+					 errmsg("decompression information missing")));
+
+		/*
+		 * The worker only knows that the codec failed.  Decompress again
+		 * here, so that the failure is reported the usual way.
+		 */
+		gp_decompress_new(DecompressPool_JobBuffer(acc->decompressJob),
+						  DecompressPool_JobCompressedLen(acc->decompressJob),
+						  acc->large_object_buffer,
+						  acc->getBlockInfo.contentLen,
+						  cfns[COMPRESSION_DECOMPRESS],
+						  acc->ao_read.compressionState,
+						  acc->ao_read.bufferCount);
+	}
+
+	acc->buffer_beginp = acc->large_object_buffer;
+
+	datumstreamread_block_get_ready(acc);
+}
+
+/*
+ * Read in the content of the block found by datumstreamread_next_block_info()
+ * and get ready to read its first datum.  Then start on the block after it.
+ */
+static void
+datumstreamread_next_block_content(DatumStreamRead * acc)
+{
+	if (acc->decompressJobSubmitted)
+		datumstreamread_decompressed_content(acc);
+	else
+		datumstreamread_block_content(acc);
+
+	if (acc->decompressJob != NULL)
+		datumstreamread_decompress_ahead(acc);
+}
+
 int
 datumstreamread_block(DatumStreamRead * acc,
 					  AppendOnlyBlockDirectory *blockDirectory,
@@ -1295,13 +1511,7 @@ datumstreamread_block(DatumStreamRead * acc,
 
 	acc->blockFirstRowNum += acc->blockRowCount;
 
-	readOK = AppendOnlyStorageRead_GetBlockInfo(&acc->ao_read,
-												&acc->getBlockInfo.contentLen,
-											&acc->getBlockInfo.execBlockKind,
-												&acc->getBlockInfo.firstRow,
-												&acc->getBlockInfo.rowCnt,
-												&acc->getBlockInfo.isLarge,
-											&acc->getBlockInfo.isCompressed);
+	readOK = datumstreamread_next_block_info(acc);
 	if (!readOK)
 		return -1;
 
@@ -1325,7 +1535,6 @@ datumstreamread_block(DatumStreamRead * acc,
 	{
 		acc->blockFirstRowNum = acc->getBlockInfo.firstRow;
 	}
-	acc->blockFileOffset = acc->ao_read.current.headerOffsetInFile;
 	acc->blockRowCount = acc->getBlockInfo.rowCnt;
 
 	if (Debug_appendonly_print_scan)
@@ -1345,7 +1554,7 @@ datumstreamread_block(DatumStreamRead * acc,
 			 acc->blockFileOffset,
 			 acc->blockRowCount);
 
-	datumstreamread_block_content(acc);
+	datumstreamread_next_block_content(acc);
 
 	if (blockDirectory)
 	{
@@ -1360,6 +1569,337 @@ datumstreamread_block(DatumStreamRead * acc,
 	return 0;
 }
 
+/*
+ * Copy the next block of a read datum stream to the end of a write datum
+ * stream with the same column encoding, numbering its rows from firstRowNum.
+ *
+ * The content of the block is neither decoded nor, unless it is large
+ * content spread over several storage blocks, decompressed: only the
+ * storage block header is made anew.
+ *
+ * Returns the number of rows in the block, or -1 at the end of the file.
+ */
+int
+datumstreamread_copy_block(DatumStreamRead * acc,
+						   DatumStreamWrite * dest,
+						   int64 firstRowNum,
+						   AppendOnlyBlockDirectory *blockDirectory,
+						   int colGroupNo)
+{
+	int32		contentLen;
+	int32		compressedLen = 0;
+	uint8	   *data;
+
+	Assert(acc);
+	Assert(dest);
+	Assert(DatumStreamBlockWrite_Nth(&dest->blockWrite) == 0);
+
+	if (!datumstreamread_block_info(acc))
+		return -1;
+
+	/*
+	 * Blocks written before the first row number was stored may hold more
+	 * rows than their header says; only decoding them tells.
+	 */
+	if (acc->getBlockInfo.firstRow < 0)
+		elog(ERROR, "cannot copy Append-Only Column Store block without a first row number "
+			 "(segment file '%s', header offset in file " INT64_FORMAT ")",
+			 acc->ao_read.bufferedRead.filePathName,
+			 acc->blockFileOffset);
+
+	contentLen = acc->getBlockInfo.contentLen;
+
+	AppendOnlyStorageWrite_SetFirstRowNum(&dest->ao_write, firstRowNum);
+
+	if (acc->getBlockInfo.isLarge)
+	{
+		datumstreamread_grow_content_buffer(acc);
+		AppendOnlyStorageRead_Content(&acc->ao_read,
+									  acc->large_object_buffer,
+									  contentLen);
+
+		AppendOnlyStorageWrite_Content(&dest->ao_write,
+									   acc->large_object_buffer,
+									   contentLen,
+									   acc->getBlockInfo.execBlockKind,
+									   acc->getBlockInfo.rowCnt);
+	}
+	else
+	{
+		if (acc->getBlockInfo.isCompressed)
+			data = AppendOnlyStorageRead_GetCompressedBuffer(&acc->ao_read,
+															 &compressedLen);
+		else
+			data = AppendOnlyStorageRead_GetBuffer(&acc->ao_read);
+
+		AppendOnlyStorageWrite_CopyBlock(&dest->ao_write,
+										 AppendOnlyStorageRead_CurrentHeaderKind(&acc->ao_read),
+										 data,
+										 contentLen,
+										 compressedLen,
+										 acc->getBlockInfo.execBlockKind,
+										 acc->getBlockInfo.rowCnt);
+	}
+
+	AppendOnlyBlockDirectory_InsertEntry(blockDirectory,
+										 colGroupNo,
+										 firstRowNum,
+										 AppendOnlyStorageWrite_LogicalBlockStartOffset(&dest->ao_write),
+										 acc->getBlockInfo.rowCnt,
+										 false);
+
+	return acc->getBlockInfo.rowCnt;
+}
+
+/*
+ * Have all rows of the current block been returned already?
+ */
+static bool
+datumstreamread_block_exhausted(DatumStreamRead * acc)
+{
+	if (acc->largeObjectState == DatumStreamLargeObjectState_None)
+		return DatumStreamBlockRead_Nth(&acc->blockRead) + 1 >=
+			acc->blockRead.logical_row_count;
+
+	return acc->largeObjectState != DatumStreamLargeObjectState_HaveAoContent;
+}
+
+/*
+ * Mark the rest of the current block as consumed, so that the next
+ * datumstreamread_advance() reports exhaustion.
+ */
+static void
+datumstreamread_consume_block(DatumStreamRead * acc)
+{
+	if (acc->largeObjectState == DatumStreamLargeObjectState_Exhausted)
+		return;
+
+	while (datumstreamread_advance(acc) > 0)
+		;
+}
+
+/*
+ * Position the datum stream so that the next datumstreamread_advance()
+ * returns row targetRowNum (or the first row after it, if the row numbers
+ * have a gap there).
+ *
+ * Blocks that end before targetRowNum are skipped over without reading
+ * (and decompressing) their content.  Only used for blocks that carry
+ * their first row number, i.e. not for pre-4.0 blocks.
+ *
+ * Returns false if the end of the segment file was reached.
+ */
+bool
+datumstreamread_skip_to_row(DatumStreamRead * acc, int64 targetRowNum)
+{
+	Assert(acc);
+
+	/*
+	 * The current block may also be left over from the previous segment
+	 * file, in which case its row numbers mean nothing here.
+	 */
+	if (datumstreamread_block_exhausted(acc) ||
+		targetRowNum >= acc->blockFirstRowNum + acc->blockRowCount)
+	{
+		datumstreamread_consume_block(acc);
+
+		while (true)
+		{
+			acc->blockFirstRowNum += acc->blockRowCount;
+
+			if (!datumstreamread_next_block_info(acc))
+				return false;
+
+			if (acc->getBlockInfo.firstRow >= 0)
+				acc->blockFirstRowNum = acc->getBlockInfo.firstRow;
+			acc->blockRowCount = acc->getBlockInfo.rowCnt;
+
+			if (acc->blockFirstRowNum + acc->blockRowCount <= targetRowNum)
+			{
+				if (Debug_appendonly_print_datumstream)
+					elog(LOG,
+						 "datumstream_skip_to_row filePathName %s skipping block "
+						 "fileOffset " INT64_FORMAT " firstRowNum " INT64_FORMAT " rowCnt %u",
+						 acc->ao_read.bufferedRead.filePathName,
+						 acc->blockFileOffset,
+						 acc->blockFirstRowNum,
+						 acc->getBlockInfo.rowCnt);
+
+				datumstreamread_skip_next_block(acc);
+				continue;
+			}
+
+			datumstreamread_next_block_content(acc);
+			break;
+		}
+	}
+
+	while (targetRowNum > acc->blockFirstRowNum &&
+		   acc->blockFirstRowNum + datumstreamread_nth(acc) + 1 < targetRowNum)
+	{
+		if (datumstreamread_advance(acc) == 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_INTERNAL_ERROR),
+					 errmsg("Unexpected internal error,"
+							" could not skip to row " INT64_FORMAT " in block."
+							" blockFirstRowNum is " INT64_FORMAT
+							" blockRowCount is %d",
+							targetRowNum,
+							acc->blockFirstRowNum,
+							acc->blockRowCount)));
+	}
+
+	return true;
+}
+
+/*
+ * Number of values in the dictionary of the current block, or 0 if the block
+ * is not dictionary encoded.  The values are fetched with
+ * DatumStreamBlockRead_DictValue().
+ */
+int32
+datumstreamread_block_dictcount(DatumStreamRead * acc)
+{
+	if (acc->largeObjectState != DatumStreamLargeObjectState_None)
+		return 0;
+
+	return DatumStreamBlockRead_DictCount(&acc->blockRead);
+}
+
+/*
+ * Compute the minimum and maximum non-NULL value of the current block,
+ * using the btree comparison function cmpfn.
+ *
+ * This is only possible for blocks whose fixed-length, pass-by-value datums
+ * are stored as a plain array, which excludes large objects and blocks with
+ * delta compression.  Returns false if the block cannot be summarized; if
+ * the block holds only NULLs, *allNull is set and *min and *max are not.
+ */
+bool
+datumstreamread_block_minmax(DatumStreamRead * acc, FmgrInfo *cmpfn,
+							 Datum *min, Datum *max, bool *allNull)
+{
+	DatumStreamBlockRead *dsr = &acc->blockRead;
+	int32		datumlen = dsr->typeInfo.datumlen;
+	int64		n;
+	int64		i;
+
+	if (acc->largeObjectState != DatumStreamLargeObjectState_None ||
+		!dsr->typeInfo.byval ||
+		dsr->delta_block_was_compressed)
+		return false;
+
+	if (datumlen != 1 && datumlen != 2 && datumlen != 4 && datumlen != 8)
+		return false;
+
+	n = (dsr->datum_afterp - dsr->datum_beginp) / datumlen;
+	*allNull = (n == 0);
+	if (n == 0)
+		return true;
+
+	/*
+	 * The common integer and date/time comparators are evaluated inline;
+	 * everything else goes through the opclass support function.
+	 */
+	switch (cmpfn->fn_oid)
+	{
+		case F_BTINT2CMP:
+			{
+				int16	   *v = (int16 *) dsr->datum_beginp;
+				int16		lo = v[0];
+				int16		hi = v[0];
+
+				Assert(datumlen == sizeof(int16));
+				for (i = 1; i < n; i++)
+				{
+					if (v[i] < lo)
+						lo = v[i];
+					else if (v[i] > hi)
+						hi = v[i];
+				}
+				*min = Int16GetDatum(lo);
+				*max = Int16GetDatum(hi);
+				return true;
+			}
+
+		case F_BTINT4CMP:
+		case F_DATE_CMP:
+			{
+				int32	   *v = (int32 *) dsr->datum_beginp;
+				int32		lo = v[0];
+				int32		hi = v[0];
+
+				Assert(datumlen == sizeof(int32));
+				for (i = 1; i < n; i++)
+				{
+					if (v[i] < lo)
+						lo = v[i];
+					else if (v[i] > hi)
+						hi = v[i];
+				}
+				*min = Int32GetDatum(lo);
+				*max = Int32GetDatum(hi);
+				return true;
+			}
+
+		case F_BTINT8CMP:
+#ifdef HAVE_INT64_TIMESTAMP
+		case F_TIMESTAMP_CMP:
+#endif
+			{
+				int64		lo;
+				int64		hi;
+				int64		cur;
+
+				Assert(datumlen == sizeof(int64));
+				memcpy(&lo, dsr->datum_beginp, sizeof(int64));
+				hi = lo;
+				for (i = 1; i < n; i++)
+				{
+					memcpy(&cur, dsr->datum_beginp + i * sizeof(int64), sizeof(int64));
+					if (cur < lo)
+						lo = cur;
+					else if (cur > hi)
+						hi = cur;
+				}
+				*min = Int64GetDatum(lo);
+				*max = Int64GetDatum(hi);
+				return true;
+			}
+
+		default:
+			break;
+	}
+
+	for (i = 0; i < n; i++)
+	{
+		uint8	   *p = dsr->datum_beginp + i * datumlen;
+		Datum		d;
+
+		if (datumlen == 1)
+			d = *(uint8 *) p;
+		else if (datumlen == 2)
+			d = *(uint16 *) p;
+		else if (datumlen == 4)
+			d = *(uint32 *) p;
+		else
+			memcpy(&d, p, sizeof(Datum));
+
+		if (i == 0)
+		{
+			*min = *max = d;
+			continue;
+		}
+
+		if (DatumGetInt32(FunctionCall2(cmpfn, d, *min)) < 0)
+			*min = d;
+		else if (DatumGetInt32(FunctionCall2(cmpfn, d, *max)) > 0)
+			*max = d;
+	}
+
+	return true;
+}
+
 void
 datumstreamread_rewind_block(DatumStreamRead * datumStream)
 {
@@ -13,6 +13,7 @@
  */
 
 #include "postgres.h"
+#include "access/hash.h"
 #include "access/tupmacs.h"
 #include "access/tuptoaster.h"
 #include "utils/datumstreamblock.h"
@@ -396,13 +397,29 @@ DatumStreamBlockRead_Init(
 	Assert(dsr->delta_block_was_compressed == false);
 	Assert(dsr->delta_item == false);
 
+	Assert(!dsr->dict_block_was_compressed);
+	Assert(dsr->dict_entries == NULL);
+
+	Assert(!dsr->for_block_was_compressed);
+	Assert(dsr->for_buffer == NULL);
 }
 
 void
 DatumStreamBlockRead_Finish(
 							DatumStreamBlockRead * dsr)
 {
-	/* Place holder. */
+	if (dsr->dict_entries != NULL)
+	{
+		pfree(dsr->dict_entries);
+		dsr->dict_entries = NULL;
+	}
+
+	if (dsr->for_buffer != NULL)
+	{
+		pfree(dsr->for_buffer);
+		dsr->for_buffer = NULL;
+		dsr->for_buffer_size = 0;
+	}
 }
 
 /*
@@ -607,6 +624,204 @@ DatumStreamBlockRead_ResetDense(DatumStreamBlockRead * dsr)
 
 	dsr->delta_block_was_compressed = false;
 	dsr->delta_item = false;
+
+	dsr->dict_block_was_compressed = false;
+	dsr->dict_entry_count = 0;
+	dsr->dict_code_bits = 0;
+	dsr->dict_codes_size = 0;
+	dsr->dict_codesp = NULL;
+
+	dsr->for_block_was_compressed = false;
+}
+
+static inline uint64
+DatumStreamFor_Load64(uint8 * p)
+{
+	uint64		word;
+
+#ifdef WORDS_BIGENDIAN
+	int			i;
+
+	word = 0;
+	for (i = 7; i >= 0; i--)
+		word = (word << 8) | p[i];
+#else
+	memcpy(&word, p, sizeof(uint64));
+#endif
+
+	return word;
+}
+
+/*
+ * Decode the frame-of-reference packed datums into for_buffer as a plain
+ * array, which then serves as the datum area of the block.
+ *
+ * One loop per datum width, without branches in the loop body, so that the
+ * compiler can unroll and vectorize it.
+ */
+static void
+DatumStreamBlockRead_UnpackFor(
+							   DatumStreamBlockRead * dsr,
+							   uint8 * packed,
+							   int64 base,
+							   int32 bits)
+{
+	int32		count = dsr->physical_datum_count;
+	int32		datumlen = dsr->typeInfo.datumlen;
+	int32		size = count * datumlen;
+	uint64		mask;
+	uint64		ubase = (uint64) base;
+	int			i;
+
+	if (bits < 0 || bits > DATUMSTREAM_FOR_MAX_BITS ||
+		(datumlen != 2 && datumlen != 4 && datumlen != 8) ||
+		dsr->physical_data_size != DatumStreamFor_Size(count, bits))
+	{
+		ereport(ERROR,
+				(errmsg("Bad datum stream block frame-of-reference encoding "
+						"(bits %d, datum length %d, physical datum count %d, physical data size %d)",
+						bits,
+						datumlen,
+						count,
+						dsr->physical_data_size),
+				 errdetail_datumstreamblockread(dsr),
+				 errcontext_datumstreamblockread(dsr)));
+	}
+
+	if (size > dsr->for_buffer_size)
+	{
+		if (dsr->for_buffer != NULL)
+			pfree(dsr->for_buffer);
+		dsr->for_buffer_size = size;
+		dsr->for_buffer = MemoryContextAlloc(dsr->memctxt, dsr->for_buffer_size);
+	}
+
+	mask = (bits == 0) ? 0 : (((uint64) 1 << bits) - 1);
+
+	switch (datumlen)
+	{
+		case 2:
+			{
+				int16	   *out = (int16 *) dsr->for_buffer;
+
+				for (i = 0; i < count; i++)
+				{
+					uint64		bitPosition = (uint64) i * bits;
+					uint64		word = DatumStreamFor_Load64(packed + (bitPosition >> 3));
+
+					out[i] = (int16) (ubase + ((word >> (bitPosition & 7)) & mask));
+				}
+				break;
+			}
+		case 4:
+			{
+				int32	   *out = (int32 *) dsr->for_buffer;
+
+				for (i = 0; i < count; i++)
+				{
+					uint64		bitPosition = (uint64) i * bits;
+					uint64		word = DatumStreamFor_Load64(packed + (bitPosition >> 3));
+
+					out[i] = (int32) (ubase + ((word >> (bitPosition & 7)) & mask));
+				}
+				break;
+			}
+		default:
+			{
+				int64	   *out = (int64 *) dsr->for_buffer;
+
+				for (i = 0; i < count; i++)
+				{
+					uint64		bitPosition = (uint64) i * bits;
+					uint64		word = DatumStreamFor_Load64(packed + (bitPosition >> 3));
+
+					out[i] = (int64) (ubase + ((word >> (bitPosition & 7)) & mask));
+				}
+				break;
+			}
+	}
+
+	dsr->datum_beginp = dsr->for_buffer;
+	dsr->datum_afterp = dsr->for_buffer + size;
+}
+
+/*
+ * Set up the pointers to the dictionary entries, which are laid out in the
+ * datum area like the datums of a block without dictionary.
+ */
+static void
+DatumStreamBlockRead_UnpackDict(DatumStreamBlockRead * dsr)
+{
+	uint8	   *p;
+	int32		i;
+
+	if (dsr->dict_entry_count <= 0 ||
+		dsr->dict_entry_count > DATUMSTREAM_DICT_MAX_ENTRIES ||
+		dsr->dict_code_bits != DatumStreamDictCodes_Bits(dsr->dict_entry_count))
+	{
+		ereport(ERROR,
+				(errmsg("Bad datum stream block dictionary (entry count %d, code bits %d)",
+						dsr->dict_entry_count,
+						dsr->dict_code_bits),
+				 errdetail_datumstreamblockread(dsr),
+				 errcontext_datumstreamblockread(dsr)));
+	}
+
+	if (dsr->dict_entries == NULL)
+	{
+		dsr->dict_entries = (uint8 **)
+			MemoryContextAlloc(dsr->memctxt,
+							   DATUMSTREAM_DICT_MAX_ENTRIES * sizeof(uint8 *));
+	}
+
+	p = dsr->datum_beginp;
+	for (i = 0; i < dsr->dict_entry_count; i++)
+	{
+		if (p >= dsr->datum_afterp)
+		{
+			ereport(ERROR,
+					(errmsg("Datum stream block dictionary entry %d of %d begins beyond the end of the data "
+							"(physical data size %d)",
+							i,
+							dsr->dict_entry_count,
+							dsr->physical_data_size),
+					 errdetail_datumstreamblockread(dsr),
+					 errcontext_datumstreamblockread(dsr)));
+		}
+
+		dsr->dict_entries[i] = p;
+
+		if (dsr->typeInfo.datumlen == -1)
+		{
+			p += VARSIZE_ANY(p);
+
+			/*
+			 * Skip any possible zero paddings AFTER varlena data.
+			 */
+			if (p < dsr->datum_afterp && *p == 0)
+				p = (uint8 *) att_align_nominal(p, dsr->typeInfo.align);
+		}
+		else if (dsr->typeInfo.datumlen == -2)
+		{
+			p += strlen((char *) p) + 1;
+		}
+		else
+		{
+			p += dsr->typeInfo.datumlen;
+		}
+	}
+
+	if (p != dsr->datum_afterp)
+	{
+		ereport(ERROR,
+				(errmsg("Datum stream block dictionary of %d entries does not match physical data size %d "
+						"(found " INT64_FORMAT ")",
+						dsr->dict_entry_count,
+						dsr->physical_data_size,
+						(int64) (p - dsr->datum_beginp)),
+				 errdetail_datumstreamblockread(dsr),
+				 errcontext_datumstreamblockread(dsr)));
+	}
 }
 
 void
@@ -628,6 +843,8 @@ DatumStreamBlockRead_GetReadyDense(
 	DatumStreamBlock_Dense *blockDense;
 	DatumStreamBlock_Rle_Extension *rleExtension;
 	DatumStreamBlock_Delta_Extension *deltaExtension;
+	DatumStreamBlock_Dict_Extension *dictExtension;
+	DatumStreamBlock_For_Extension forExtension;
 
 	/*
 	 * PERFORMANCE EXPERIMENT: Only do integrity and trace checking for DEBUG
@@ -716,6 +933,30 @@ DatumStreamBlockRead_GetReadyDense(
 		deltaExtension = NULL;
 	}
 
+	/* Dictionary */
+	dsr->dict_block_was_compressed = ((blockDense->orig_4_bytes.flags & DSB_HAS_DICT_COMPRESSION) != 0);
+	if (dsr->dict_block_was_compressed)
+	{
+		dictExtension = (DatumStreamBlock_Dict_Extension *) p;
+		p += sizeof(DatumStreamBlock_Dict_Extension);
+
+		dsr->dict_entry_count = dictExtension->dict_entry_count;
+		dsr->dict_code_bits = dictExtension->dict_code_bits;
+		dsr->dict_codes_size = dictExtension->dict_codes_size;
+	}
+	else
+	{
+		dictExtension = NULL;
+	}
+
+	/* Frame-of-reference */
+	dsr->for_block_was_compressed = ((blockDense->orig_4_bytes.flags & DSB_HAS_FOR_COMPRESSION) != 0);
+	if (dsr->for_block_was_compressed)
+	{
+		memcpy(&forExtension, p, sizeof(DatumStreamBlock_For_Extension));
+		p += sizeof(DatumStreamBlock_For_Extension);
+	}
+
 	/* Set up acc */
 	dsr->nth = -1;				/* put it before first entry.  Caller will
 								 * advance */
@@ -940,6 +1181,76 @@ DatumStreamBlockRead_GetReadyDense(
 					 errcontext_datumstreamblockread(dsr)));
 		}
 	}
+
+	if (dsr->dict_block_was_compressed)
+	{
+		/*
+		 * Dictionary encoding was used for this block.  The datum area is
+		 * the dictionary.
+		 */
+		dsr->dict_codesp = p;
+		p += dsr->dict_codes_size;
+
+		unalignedHeaderSize = p - dsr->buffer_beginp;
+		alignedHeaderSize = MAXALIGN(unalignedHeaderSize);
+
+		/*
+		 * Skip over alignment padding.
+		 */
+		dsr->datum_beginp = dsr->buffer_beginp + alignedHeaderSize;
+		dsr->datum_afterp = dsr->datum_beginp + dsr->physical_data_size;
+
+		DatumStreamBlockRead_UnpackDict(dsr);
+
+		if (Debug_appendonly_print_scan)
+		{
+			ereport(LOG,
+					(errmsg("Datum stream block read unpack Dense with dictionary "
+							"(logical row count %d, physical datum count %d, physical data size = %d, "
+							"dictionary entry count %d, code bits %d, codes size %d, "
+						 "unaligned header size %d, aligned header size %d, "
+							"datum begin %p, datum after %p)",
+							dsr->logical_row_count,
+							dsr->physical_datum_count,
+							dsr->physical_data_size,
+							dsr->dict_entry_count,
+							dsr->dict_code_bits,
+							dsr->dict_codes_size,
+							unalignedHeaderSize,
+							alignedHeaderSize,
+							dsr->datum_beginp,
+							dsr->datum_afterp),
+					 errdetail_datumstreamblockread(dsr),
+					 errcontext_datumstreamblockread(dsr)));
+		}
+	}
+
+	if (dsr->for_block_was_compressed)
+	{
+		/*
+		 * Frame-of-reference encoding was used for this block.  Decode the
+		 * whole datum area up front.
+		 */
+		DatumStreamBlockRead_UnpackFor(dsr,
+									   dsr->datum_beginp,
+									   forExtension.for_base,
+									   forExtension.for_bits);
+
+		if (Debug_appendonly_print_scan)
+		{
+			ereport(LOG,
+					(errmsg("Datum stream block read unpack Dense with frame-of-reference encoding "
+							"(logical row count %d, physical datum count %d, physical data size = %d, "
+							"base " INT64_FORMAT ", bits %d)",
+							dsr->logical_row_count,
+							dsr->physical_datum_count,
+							dsr->physical_data_size,
+							forExtension.for_base,
+							forExtension.for_bits),
+					 errdetail_datumstreamblockread(dsr),
+					 errcontext_datumstreamblockread(dsr)));
+		}
+	}
 	dsr->datump = dsr->datum_beginp;
 }
 
@@ -3761,6 +4072,248 @@ DatumStreamBlockWrite_BlockOrig(
 	return writesz;
 }
 
+/*
+ * Number of slots of the hash table used to find the distinct values of a
+ * block.  Must be a power of 2 larger than DATUMSTREAM_DICT_MAX_ENTRIES.
+ */
+#define DATUMSTREAM_DICT_HASH_SIZE (2 * DATUMSTREAM_DICT_MAX_ENTRIES)
+
+/*
+ * Try to dictionary encode the physical datums of the block.
+ *
+ * Returns true with the dictionary in dict_buffer and the code of each
+ * physical datum in dict_codes if the block has at most
+ * DATUMSTREAM_DICT_MAX_ENTRIES distinct values, and the dictionary with its
+ * codes takes less space than the datums themselves.
+ */
+static bool
+DatumStreamBlockWrite_DictBuild(
+								DatumStreamBlockWrite * dsw)
+{
+	int32		datumlen = dsw->typeInfo->datumlen;
+	int32		physicalDataSize = dsw->datump - dsw->datum_buffer;
+	int32		codesSize;
+	uint8	   *p;
+	uint8	   *dictp;
+	int			i;
+
+	dsw->dict_entry_count = 0;
+
+	if (dsw->physical_datum_count < 2)
+		return false;
+
+	if (dsw->physical_datum_count > dsw->dict_codes_maxcount)
+	{
+		MemoryContext oldCtxt;
+
+		oldCtxt = MemoryContextSwitchTo(dsw->memctxt);
+		if (dsw->dict_codes != NULL)
+			pfree(dsw->dict_codes);
+		dsw->dict_codes_maxcount = dsw->physical_datum_count;
+		dsw->dict_codes = palloc(dsw->dict_codes_maxcount * sizeof(uint16));
+		MemoryContextSwitchTo(oldCtxt);
+	}
+
+	memset(dsw->dict_hash, 0, DATUMSTREAM_DICT_HASH_SIZE * sizeof(uint16));
+
+	p = dsw->datum_buffer;
+	dictp = dsw->dict_buffer;
+	for (i = 0; i < dsw->physical_datum_count; i++)
+	{
+		uint8	   *item = p;
+		int32		len;
+		uint32		slot;
+		int32		entry;
+
+		if (datumlen == -1)
+			len = VARSIZE_ANY(item);
+		else if (datumlen == -2)
+			len = strlen((char *) item) + 1;
+		else
+			len = datumlen;
+
+		p += len;
+
+		/*
+		 * Skip any possible zero paddings AFTER varlena data.
+		 */
+		if (datumlen == -1 && p < dsw->datump && *p == 0)
+			p = (uint8 *) att_align_nominal(p, dsw->typeInfo->align);
+
+		slot = DatumGetUInt32(hash_any(item, len)) & (DATUMSTREAM_DICT_HASH_SIZE - 1);
+		for (;;)
+		{
+			entry = (int32) dsw->dict_hash[slot] - 1;
+			if (entry < 0)
+				break;
+			if (dsw->dict_entry_lens[entry] == len &&
+				memcmp(dsw->dict_buffer + dsw->dict_entry_offsets[entry], item, len) == 0)
+				break;
+			slot = (slot + 1) & (DATUMSTREAM_DICT_HASH_SIZE - 1);
+		}
+
+		if (entry < 0)
+		{
+			/*
+			 * New value.  Lay it out like PutDense does, zero padding in
+			 * front of a varlena with a 4 byte header.
+			 */
+			if (dsw->dict_entry_count >= DATUMSTREAM_DICT_MAX_ENTRIES)
+				return false;
+
+			if (datumlen == -1 && !VARATT_IS_SHORT(item))
+				dictp = (uint8 *) att_align_zero((char *) dictp, dsw->typeInfo->align);
+
+			if ((dictp - dsw->dict_buffer) + len >= physicalDataSize)
+				return false;
+
+			entry = dsw->dict_entry_count++;
+			memcpy(dictp, item, len);
+			dsw->dict_entry_offsets[entry] = dictp - dsw->dict_buffer;
+			dsw->dict_entry_lens[entry] = len;
+			dictp += len;
+
+			dsw->dict_hash[slot] = (uint16) (entry + 1);
+		}
+
+		dsw->dict_codes[i] = (uint16) entry;
+	}
+	Assert(p == dsw->datump);
+
+	dsw->dict_data_size = dictp - dsw->dict_buffer;
+	dsw->dict_code_bits = DatumStreamDictCodes_Bits(dsw->dict_entry_count);
+
+	/*
+	 * Is it smaller, allowing for the worst case alignment padding of the
+	 * longer metadata?
+	 */
+	codesSize = DatumStreamDictCodes_Size(dsw->physical_datum_count,
+										  dsw->dict_code_bits);
+
+	return sizeof(DatumStreamBlock_Dict_Extension) + codesSize +
+		MAXIMUM_ALIGNOF + dsw->dict_data_size < physicalDataSize;
+}
+
+/*
+ * Bit-pack codeCount codes of codeBits bits each, least significant bit
+ * first.  Writes DatumStreamDictCodes_Size() bytes.
+ */
+static void
+DatumStreamDictCodes_Pack(
+						  uint8 * p,
+						  uint16 * codes,
+						  int32 codeCount,
+						  int32 codeBits)
+{
+	int64		bitPosition;
+	int			i;
+
+	if (codeBits == 0)
+		return;
+
+	memset(p, 0, DatumStreamDictCodes_Size(codeCount, codeBits));
+
+	bitPosition = 0;
+	for (i = 0; i < codeCount; i++)
+	{
+		uint8	   *b = p + (bitPosition >> 3);
+		uint32		word = ((uint32) codes[i]) << (bitPosition & 7);
+
+		b[0] |= (uint8) word;
+		b[1] |= (uint8) (word >> 8);
+		b[2] |= (uint8) (word >> 16);
+
+		bitPosition += codeBits;
+	}
+}
+
+static inline int64
+DatumStreamFor_Value(uint8 * datums, int32 datumlen, int32 index)
+{
+	if (datumlen == 2)
+		return ((int16 *) datums)[index];
+	else if (datumlen == 4)
+		return ((int32 *) datums)[index];
+	else
+		return ((int64 *) datums)[index];
+}
+
+/*
+ * Try to frame-of-reference encode the physical datums of the block: keep
+ * the smallest datum once, and each datum as its bit-packed difference from
+ * it.
+ *
+ * Returns true with the packed datums in for_buffer if that takes less space
+ * than the datums themselves.
+ */
+static bool
+DatumStreamBlockWrite_ForBuild(
+							   DatumStreamBlockWrite * dsw)
+{
+	int32		datumlen = dsw->typeInfo->datumlen;
+	int32		count = dsw->physical_datum_count;
+	int32		physicalDataSize = dsw->datump - dsw->datum_buffer;
+	int64		min;
+	int64		max;
+	uint64		range;
+	int32		bits;
+	int32		packedSize;
+	int			i;
+
+	if (count == 0)
+		return false;
+
+	Assert(datumlen == 2 || datumlen == 4 || datumlen == 8);
+	Assert(physicalDataSize == count * datumlen);
+
+	min = max = DatumStreamFor_Value(dsw->datum_buffer, datumlen, 0);
+	for (i = 1; i < count; i++)
+	{
+		int64		value = DatumStreamFor_Value(dsw->datum_buffer, datumlen, i);
+
+		if (value < min)
+			min = value;
+		else if (value > max)
+			max = value;
+	}
+
+	range = (uint64) max - (uint64) min;
+	bits = 0;
+	while (bits < 64 && (range >> bits) != 0)
+		bits++;
+
+	if (bits > DATUMSTREAM_FOR_MAX_BITS)
+		return false;
+
+	packedSize = DatumStreamFor_Size(count, bits);
+	if (sizeof(DatumStreamBlock_For_Extension) + MAXIMUM_ALIGNOF + packedSize >=
+		physicalDataSize)
+		return false;
+
+	memset(dsw->for_buffer, 0, packedSize);
+	if (bits > 0)
+	{
+		for (i = 0; i < count; i++)
+		{
+			uint64		bitPosition = (uint64) i * bits;
+			uint8	   *b = dsw->for_buffer + (bitPosition >> 3);
+			uint64		word;
+			int			k;
+
+			word = ((uint64) DatumStreamFor_Value(dsw->datum_buffer, datumlen, i) -
+					(uint64) min) << (bitPosition & 7);
+			for (k = 0; k < 8; k++)
+				b[k] |= (uint8) (word >> (8 * k));
+		}
+	}
+
+	dsw->for_base = min;
+	dsw->for_bits = bits;
+	dsw->for_data_size = packedSize;
+
+	return true;
+}
+
 static int64
 DatumStreamBlockWrite_BlockDense(
 								 DatumStreamBlockWrite * dsw,
@@ -3771,10 +4324,15 @@ DatumStreamBlockWrite_BlockDense(
 	DatumStreamBlock_Dense dense;
 	DatumStreamBlock_Rle_Extension rle_extension;
 	DatumStreamBlock_Delta_Extension delta_extension;
+	DatumStreamBlock_Dict_Extension dict_extension;
+	DatumStreamBlock_For_Extension for_extension;
+	bool		dict_has_compression;
+	bool		for_has_compression;
 	int32		headerSize;
 	int32		nullSize;
 	int32		rleSize;
 	int32		deltaSize;
+	int32		dictSize;
 	int32		metadataSize;
 	int32		metadataMaxAlignSize;
 	int32		nullPadSize;
@@ -3812,9 +4370,40 @@ DatumStreamBlockWrite_BlockDense(
 		dense.orig_4_bytes.flags |= DSB_HAS_DELTA_COMPRESSION;
 	}
 
+	/*
+	 * Dictionary encoding replaces the datums with codes, so it cannot be
+	 * combined with Delta compression, which replaces datums with deltas.
+	 */
+	dict_has_compression =
+		(dsw->dict_want_compression &&
+		 !dsw->delta_has_compression &&
+		 DatumStreamBlockWrite_DictBuild(dsw));
+	if (dict_has_compression)
+	{
+		dense.orig_4_bytes.flags |= DSB_HAS_DICT_COMPRESSION;
+	}
+
+	/*
+	 * Frame-of-reference encoding packs the datums themselves, whether they
+	 * remain after RLE_TYPE and Delta compression or not.
+	 */
+	for_has_compression =
+		(dsw->for_want_compression &&
+		 !dict_has_compression &&
+		 DatumStreamBlockWrite_ForBuild(dsw));
+	if (for_has_compression)
+	{
+		dense.orig_4_bytes.flags |= DSB_HAS_FOR_COMPRESSION;
+	}
+
 	dense.logical_row_count = dsw->nth;
 	dense.physical_datum_count = dsw->physical_datum_count;
-	dense.physical_data_size = dsw->datump - dsw->datum_buffer;
+	if (dict_has_compression)
+		dense.physical_data_size = dsw->dict_data_size;
+	else if (for_has_compression)
+		dense.physical_data_size = dsw->for_data_size;
+	else
+		dense.physical_data_size = dsw->datump - dsw->datum_buffer;
 
 	headerSize = sizeof(DatumStreamBlock_Dense);
 
@@ -3913,10 +4502,45 @@ DatumStreamBlockWrite_BlockDense(
 		deltaSize = 0;
 	}
 
+	if (dict_has_compression)
+	{
+		headerSize += sizeof(DatumStreamBlock_Dict_Extension);
+
+		dictSize = DatumStreamDictCodes_Size(dsw->physical_datum_count,
+											 dsw->dict_code_bits);
+
+		dict_extension.dict_entry_count = dsw->dict_entry_count;
+		dict_extension.dict_code_bits = dsw->dict_code_bits;
+		dict_extension.dict_codes_size = dictSize;
+
+		/*
+		 * The dictionary saves the difference between the datums and the
+		 * dictionary, less its metadata.
+		 */
+		dsw->savings += (dsw->datump - dsw->datum_buffer) - dsw->dict_data_size;
+		dsw->savings -= (sizeof(DatumStreamBlock_Dict_Extension) + dictSize);
+	}
+	else
+	{
+		dictSize = 0;
+	}
+
+	if (for_has_compression)
+	{
+		headerSize += sizeof(DatumStreamBlock_For_Extension);
+
+		memset(&for_extension, 0, sizeof(DatumStreamBlock_For_Extension));
+		for_extension.for_base = dsw->for_base;
+		for_extension.for_bits = dsw->for_bits;
+
+		dsw->savings += (dsw->datump - dsw->datum_buffer) - dsw->for_data_size;
+		dsw->savings -= sizeof(DatumStreamBlock_For_Extension);
+	}
+
 	/*
 	 * Align headers and meta-data (e.g. NULL bit-maps, etc).
 	 */
-	metadataSize = headerSize + nullSize + rleSize + deltaSize;
+	metadataSize = headerSize + nullSize + rleSize + deltaSize + dictSize;
 	metadataMaxAlignSize = MAXALIGN(metadataSize);
 
 	memcpy(p, &dense, sizeof(DatumStreamBlock_Dense));
@@ -3934,6 +4558,18 @@ DatumStreamBlockWrite_BlockDense(
 		p += sizeof(DatumStreamBlock_Delta_Extension);
 	}
 
+	if (dict_has_compression)
+	{
+		memcpy(p, &dict_extension, sizeof(DatumStreamBlock_Dict_Extension));
+		p += sizeof(DatumStreamBlock_Dict_Extension);
+	}
+
+	if (for_has_compression)
+	{
+		memcpy(p, &for_extension, sizeof(DatumStreamBlock_For_Extension));
+		p += sizeof(DatumStreamBlock_For_Extension);
+	}
+
 	if (dsw->has_null)
 	{
 		memcpy(p, dsw->null_bitmap_buffer, DatumStreamBitMapWrite_Size(&dsw->null_bitmap));
@@ -3997,6 +4633,16 @@ DatumStreamBlockWrite_BlockDense(
 		}
 	}
 
+	/* Add dictionary codes */
+	if (dict_has_compression)
+	{
+		DatumStreamDictCodes_Pack(p,
+								  dsw->dict_codes,
+								  dsw->physical_datum_count,
+								  dsw->dict_code_bits);
+		p += dictSize;
+	}
+
 	/*
 	 * Were our meta-data size calculations correct?
 	 */
@@ -4038,7 +4684,12 @@ DatumStreamBlockWrite_BlockDense(
 				 errcontext_datumstreamblockwrite(dsw)));
 	}
 
-	memcpy(p, dsw->datum_buffer, dense.physical_data_size);
+	if (dict_has_compression)
+		memcpy(p, dsw->dict_buffer, dense.physical_data_size);
+	else if (for_has_compression)
+		memcpy(p, dsw->for_buffer, dense.physical_data_size);
+	else
+		memcpy(p, dsw->datum_buffer, dense.physical_data_size);
 	p += dense.physical_data_size;
 
 	/* Calculate write size. */
@@ -4172,6 +4823,34 @@ DatumStreamBlockWrite_BlockDense(
 					 errdetail_datumstreamblockwrite(dsw),
 					 errcontext_datumstreamblockwrite(dsw)));
 		}
+
+		if (dict_has_compression)
+		{
+			ereport(LOG,
+					(errmsg("Datum stream write Dense block formatted with dictionary "
+							"(dictionary entry count %d, code bits %d, codes size %d, "
+							"dictionary size %d, datum data size %d)",
+							dsw->dict_entry_count,
+							dsw->dict_code_bits,
+							dictSize,
+							dsw->dict_data_size,
+							(int32) (dsw->datump - dsw->datum_buffer)),
+					 errdetail_datumstreamblockwrite(dsw),
+					 errcontext_datumstreamblockwrite(dsw)));
+		}
+
+		if (for_has_compression)
+		{
+			ereport(LOG,
+					(errmsg("Datum stream write Dense block formatted with frame-of-reference encoding "
+							"(base " INT64_FORMAT ", bits %d, packed size %d, datum data size %d)",
+							dsw->for_base,
+							dsw->for_bits,
+							dsw->for_data_size,
+							(int32) (dsw->datump - dsw->datum_buffer)),
+					 errdetail_datumstreamblockwrite(dsw),
+					 errcontext_datumstreamblockwrite(dsw)));
+		}
 	}
 
 #ifdef USE_ASSERT_CHECKING
@@ -4232,6 +4911,8 @@ DatumStreamBlockWrite_Init(
 						   DatumStreamVersion datumStreamVersion,
 						   bool rle_want_compression,
 						   bool delta_want_compression,
+						   bool dict_want_compression,
+						   bool for_want_compression,
 						   int32 initialMaxDatumPerBlock,
 						   int32 maxDatumPerBlock,
 						   int32 maxDataBlockSize,
@@ -4248,6 +4929,17 @@ DatumStreamBlockWrite_Init(
 
 	dsw->rle_want_compression = rle_want_compression;
 	dsw->delta_want_compression = delta_want_compression;
+	dsw->dict_want_compression = dict_want_compression;
+
+	/*
+	 * Frame-of-reference encoding only knows 2, 4 and 8 byte integers.
+	 */
+	dsw->for_want_compression =
+		(for_want_compression &&
+		 typeInfo->byval &&
+		 (typeInfo->datumlen == 2 ||
+		  typeInfo->datumlen == 4 ||
+		  typeInfo->datumlen == 8));
 
 	dsw->initialMaxDatumPerBlock = initialMaxDatumPerBlock;
 	dsw->maxDatumPerBlock = maxDatumPerBlock;
@@ -4396,6 +5088,38 @@ DatumStreamBlockWrite_Init(
 				Assert(dsw->delta_sign == NULL);
 			}
 
+			if (dsw->dict_want_compression)
+			{
+				/*
+				 * The dictionary is never larger than the datums it replaces.
+				 * The codes are sized when the first block is formatted.
+				 */
+				dsw->dict_buffer = palloc(dsw->maxDataBlockSize);
+				dsw->dict_entry_offsets =
+					palloc(DATUMSTREAM_DICT_MAX_ENTRIES * sizeof(int32));
+				dsw->dict_entry_lens =
+					palloc(DATUMSTREAM_DICT_MAX_ENTRIES * sizeof(int32));
+				dsw->dict_hash =
+					palloc(DATUMSTREAM_DICT_HASH_SIZE * sizeof(uint16));
+			}
+			else
+			{
+				Assert(dsw->dict_buffer == NULL);
+				Assert(dsw->dict_codes == NULL);
+			}
+
+			if (dsw->for_want_compression)
+			{
+				/*
+				 * Only used when smaller than the datums it replaces.
+				 */
+				dsw->for_buffer = palloc(dsw->maxDataBlockSize);
+			}
+			else
+			{
+				Assert(dsw->for_buffer == NULL);
+			}
+
 			if (Debug_appendonly_print_insert)
 			{
 				ereport(LOG,
@@ -4458,6 +5182,24 @@ DatumStreamBlockWrite_Finish(
 	if (dsw->delta_sign != NULL)
 		pfree(dsw->delta_sign);
 
+	if (dsw->dict_buffer != NULL)
+		pfree(dsw->dict_buffer);
+
+	if (dsw->dict_entry_offsets != NULL)
+		pfree(dsw->dict_entry_offsets);
+
+	if (dsw->dict_entry_lens != NULL)
+		pfree(dsw->dict_entry_lens);
+
+	if (dsw->dict_hash != NULL)
+		pfree(dsw->dict_hash);
+
+	if (dsw->dict_codes != NULL)
+		pfree(dsw->dict_codes);
+
+	if (dsw->for_buffer != NULL)
+		pfree(dsw->for_buffer);
+
 	MemoryContextSwitchTo(oldCtxt);
 }
 
@@ -4896,14 +5638,19 @@ DatumStreamBlock_IntegrityCheckDense(
 	bool		hasNull;
 	bool		hasRleCompression;
 	bool		hasDeltaCompression;
+	bool		hasDictCompression;
+	bool		hasForCompression;
 
 	int32		alignedHeaderSize;
 	int32		deltaOnCount;
+	int32		storedItemCount;
 	DatumStreamBlock_Delta_Extension *deltaExtension;
 	DatumStreamBlock_Rle_Extension *rleExtension;
+	DatumStreamBlock_Dict_Extension *dictExtension;
 
 	deltaExtension = NULL;
 	rleExtension = NULL;
+	dictExtension = NULL;
 
 	alignedHeaderSize = 0;
 
@@ -4942,6 +5689,135 @@ DatumStreamBlock_IntegrityCheckDense(
 	hasNull = ((blockDense->orig_4_bytes.flags & DSB_HAS_NULLBITMAP) != 0);
 	hasRleCompression = ((blockDense->orig_4_bytes.flags & DSB_HAS_RLE_COMPRESSION) != 0);
 	hasDeltaCompression = ((blockDense->orig_4_bytes.flags & DSB_HAS_DELTA_COMPRESSION) != 0);
+	hasDictCompression = ((blockDense->orig_4_bytes.flags & DSB_HAS_DICT_COMPRESSION) != 0);
+	hasForCompression = ((blockDense->orig_4_bytes.flags & DSB_HAS_FOR_COMPRESSION) != 0);
+
+	/*
+	 * With a dictionary, the datum area holds the dictionary entries instead
+	 * of the physical datums.
+	 */
+	storedItemCount = blockDense->physical_datum_count;
+	if (hasDictCompression)
+	{
+		int32		dictExtensionOffset;
+
+		if (hasDeltaCompression)
+		{
+			ereport(ERROR,
+					(errmsg("Bad datum stream Dense block flags.  Found both DELTA and dictionary compression (flags 0x%x)",
+							blockDense->orig_4_bytes.flags),
+					 errdetailCallback(errdetailArg),
+					 errcontextCallback(errcontextArg)));
+		}
+
+		dictExtensionOffset = minHeaderSize;
+		if (hasRleCompression)
+			dictExtensionOffset += sizeof(DatumStreamBlock_Rle_Extension);
+
+		if (bufferSize < dictExtensionOffset + sizeof(DatumStreamBlock_Dict_Extension))
+		{
+			ereport(ERROR,
+					(errmsg("Bad datum stream dictionary block header extension size. Found %d and expected the size to be at least %d",
+							bufferSize,
+							(int32) (dictExtensionOffset + sizeof(DatumStreamBlock_Dict_Extension))),
+					 errdetailCallback(errdetailArg),
+					 errcontextCallback(errcontextArg)));
+		}
+
+		dictExtension = (DatumStreamBlock_Dict_Extension *) (buffer + dictExtensionOffset);
+
+		if (dictExtension->dict_entry_count <= 0 ||
+			dictExtension->dict_entry_count > DATUMSTREAM_DICT_MAX_ENTRIES ||
+			dictExtension->dict_entry_count > blockDense->physical_datum_count)
+		{
+			ereport(ERROR,
+					(errmsg("Bad dictionary entry count %d (physical datum count %d, maximum %d)",
+							dictExtension->dict_entry_count,
+							blockDense->physical_datum_count,
+							DATUMSTREAM_DICT_MAX_ENTRIES),
+					 errdetailCallback(errdetailArg),
+					 errcontextCallback(errcontextArg)));
+		}
+
+		if (dictExtension->dict_code_bits !=
+			DatumStreamDictCodes_Bits(dictExtension->dict_entry_count) ||
+			dictExtension->dict_codes_size !=
+			DatumStreamDictCodes_Size(blockDense->physical_datum_count,
+									  dictExtension->dict_code_bits))
+		{
+			ereport(ERROR,
+					(errmsg("Bad dictionary codes (entry count %d, code bits %d, codes size %d, physical datum count %d)",
+							dictExtension->dict_entry_count,
+							dictExtension->dict_code_bits,
+							dictExtension->dict_codes_size,
+							blockDense->physical_datum_count),
+					 errdetailCallback(errdetailArg),
+					 errcontextCallback(errcontextArg)));
+		}
+
+		storedItemCount = dictExtension->dict_entry_count;
+	}
+
+	if (hasForCompression)
+	{
+		int32		forExtensionOffset;
+		DatumStreamBlock_For_Extension forExtension;
+
+		if (hasDictCompression)
+		{
+			ereport(ERROR,
+					(errmsg("Bad datum stream Dense block flags.  Found both dictionary and frame-of-reference compression (flags 0x%x)",
+							blockDense->orig_4_bytes.flags),
+					 errdetailCallback(errdetailArg),
+					 errcontextCallback(errcontextArg)));
+		}
+
+		forExtensionOffset = minHeaderSize;
+		if (hasRleCompression)
+			forExtensionOffset += sizeof(DatumStreamBlock_Rle_Extension);
+		if (hasDeltaCompression)
+			forExtensionOffset += sizeof(DatumStreamBlock_Delta_Extension);
+
+		if (bufferSize < forExtensionOffset + sizeof(DatumStreamBlock_For_Extension))
+		{
+			ereport(ERROR,
+					(errmsg("Bad datum stream frame-of-reference block header extension size. Found %d and expected the size to be at least %d",
+							bufferSize,
+							(int32) (forExtensionOffset + sizeof(DatumStreamBlock_For_Extension))),
+					 errdetailCallback(errdetailArg),
+					 errcontextCallback(errcontextArg)));
+		}
+
+		/* The extension is not necessarily 8-byte aligned. */
+		memcpy(&forExtension, buffer + forExtensionOffset,
+			   sizeof(DatumStreamBlock_For_Extension));
+
+		if (typeInfo->datumlen != 2 &&
+			typeInfo->datumlen != 4 &&
+			typeInfo->datumlen != 8)
+		{
+			ereport(ERROR,
+					(errmsg("Frame-of-reference compression found for datum length %d",
+							typeInfo->datumlen),
+					 errdetailCallback(errdetailArg),
+					 errcontextCallback(errcontextArg)));
+		}
+
+		if (forExtension.for_bits < 0 ||
+			forExtension.for_bits > DATUMSTREAM_FOR_MAX_BITS ||
+			blockDense->physical_data_size !=
+			DatumStreamFor_Size(blockDense->physical_datum_count,
+								forExtension.for_bits))
+		{
+			ereport(ERROR,
+					(errmsg("Bad frame-of-reference packing (bits %d, physical data size %d, physical datum count %d)",
+							forExtension.for_bits,
+							blockDense->physical_data_size,
+							blockDense->physical_datum_count),
+					 errdetailCallback(errdetailArg),
+					 errcontextCallback(errcontextArg)));
+		}
+	}
 
 	/*
 	 * Verify logical row count.
@@ -5018,32 +5894,36 @@ DatumStreamBlock_IntegrityCheckDense(
 
 		/*
 		 * This check will make it safer to do multiplication of datum count and datum length.
+		 *
+		 * Frame-of-reference packed datums can take less than a byte each; their
+		 * size was verified above.
 		 */
-		if (blockDense->physical_datum_count > blockDense->physical_data_size)
+		if (!hasForCompression &&
+			storedItemCount > blockDense->physical_data_size)
 		{
 			ereport(ERROR,
 					(errmsg("More physical items %d than physical bytes %d",
-							blockDense->physical_datum_count,
+							storedItemCount,
 							blockDense->physical_data_size),
 					 errdetailCallback(errdetailArg),
 					 errcontextCallback(errcontextArg)));
 		}
 
-		if (typeInfo->datumlen >= 0)
+		if (typeInfo->datumlen >= 0 && !hasForCompression)
 		{
 			int64		calculatedDataSize;
 
 			/*
 			 * Fixed-length items.
 			 */
-			calculatedDataSize = ((int64) blockDense->physical_datum_count) * typeInfo->datumlen;
+			calculatedDataSize = ((int64) storedItemCount) * typeInfo->datumlen;
 
 			if (calculatedDataSize > blockDense->physical_data_size)
 			{
 				ereport(ERROR,
 						(errmsg("Physical size doesn't match calculations for %d count of fixed-size %d items "
 								"(found " INT64_FORMAT ", expected %d)",
-								blockDense->physical_datum_count,
+								storedItemCount,
 								typeInfo->datumlen,
 								calculatedDataSize,
 								blockDense->physical_data_size),
@@ -5091,6 +5971,18 @@ DatumStreamBlock_IntegrityCheckDense(
 		{
 			deltaOnCount = 0;
 		}
+
+		if (hasDictCompression)
+		{
+			headerSize += sizeof(DatumStreamBlock_Dict_Extension);
+			p += sizeof(DatumStreamBlock_Dict_Extension);
+		}
+
+		if (hasForCompression)
+		{
+			headerSize += sizeof(DatumStreamBlock_For_Extension);
+			p += sizeof(DatumStreamBlock_For_Extension);
+		}
 		total_datum_count = blockDense->physical_datum_count + deltaOnCount;
 
 		if (!hasNull)
@@ -5266,6 +6158,18 @@ DatumStreamBlock_IntegrityCheckDense(
 			p += sizeof(DatumStreamBlock_Delta_Extension);
 		}
 
+		if (hasDictCompression)
+		{
+			headerSize += sizeof(DatumStreamBlock_Dict_Extension);
+			p += sizeof(DatumStreamBlock_Dict_Extension);
+		}
+
+		if (hasForCompression)
+		{
+			headerSize += sizeof(DatumStreamBlock_For_Extension);
+			p += sizeof(DatumStreamBlock_For_Extension);
+		}
+
 		if (!hasNull)
 		{
 			actualNullOnCount = 0;
@@ -5416,6 +6320,41 @@ DatumStreamBlock_IntegrityCheckDense(
 		/* UNDONE: Verify zero padding */
 	}
 
+	if (hasDictCompression)
+	{
+		int			i;
+
+		headerSize += dictExtension->dict_codes_size;
+		alignedHeaderSize = MAXALIGN(headerSize);
+
+		if (bufferSize < alignedHeaderSize)
+		{
+			ereport(ERROR,
+					(errmsg("Expected header size %d including dictionary codes is larger than buffer size %d",
+							alignedHeaderSize,
+							bufferSize),
+					 errdetailCallback(errdetailArg),
+					 errcontextCallback(errcontextArg)));
+		}
+
+		for (i = 0; i < blockDense->physical_datum_count; i++)
+		{
+			int32		code;
+
+			code = DatumStreamDictCodes_Get(p, dictExtension->dict_code_bits, i);
+			if (code >= dictExtension->dict_entry_count)
+			{
+				ereport(ERROR,
+						(errmsg("Dictionary code %d of physical datum %d is out of range (entry count %d)",
+								code,
+								i,
+								dictExtension->dict_entry_count),
+						 errdetailCallback(errdetailArg),
+						 errcontextCallback(errcontextArg)));
+			}
+		}
+	}
+
 	if (hasDeltaCompression)
 	{
 		DatumStreamBlock_IntegrityCheckDenseDelta(
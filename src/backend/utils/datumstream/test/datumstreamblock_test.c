@@ -167,13 +167,186 @@ test__DeltaCompression__Core(void **state)
 	free(dsw);
 }
 
+/*
+ * Unit test function to test the bit-packing of dictionary codes
+ */
+void
+test__DictCodes__PackGet(void **state)
+{
+	uint16		codes[1000];
+	uint8	   *p;
+	int32		bits;
+	int			i;
+
+	assert_int_equal(DatumStreamDictCodes_Bits(1), 0);
+	assert_int_equal(DatumStreamDictCodes_Bits(2), 1);
+	assert_int_equal(DatumStreamDictCodes_Bits(5), 3);
+	assert_int_equal(DatumStreamDictCodes_Bits(DATUMSTREAM_DICT_MAX_ENTRIES), 12);
+
+	/* A single value needs no codes at all */
+	assert_int_equal(DatumStreamDictCodes_Size(1000, 0), 0);
+	assert_int_equal(DatumStreamDictCodes_Get(NULL, 0, 999), 0);
+
+	for (bits = 1; bits <= 12; bits++)
+	{
+		for (i = 0; i < 1000; i++)
+			codes[i] = (i * 7919) & ((1 << bits) - 1);
+
+		p = malloc(DatumStreamDictCodes_Size(1000, bits));
+		DatumStreamDictCodes_Pack(p, codes, 1000, bits);
+
+		for (i = 0; i < 1000; i++)
+			assert_int_equal(DatumStreamDictCodes_Get(p, bits, i), codes[i]);
+
+		free(p);
+	}
+}
+
+/*
+ * Unit test function to test building the dictionary of a block
+ */
+void
+test__DictBuild(void **state)
+{
+	DatumStreamTypeInfo typeInfo;
+	int32	   *values;
+	int			i;
+
+	DatumStreamBlockWrite* dsw = malloc(sizeof(DatumStreamBlockWrite));
+	memset(dsw, 0, sizeof(DatumStreamBlockWrite));
+
+	typeInfo.datumlen = 4;
+	typeInfo.typid = INT4OID;
+	typeInfo.byval = true;
+	typeInfo.align = 'i';
+
+	dsw->typeInfo = &typeInfo;
+	dsw->memctxt = CurrentMemoryContext;
+	dsw->dict_want_compression = true;
+	dsw->datum_buffer = malloc(1000 * sizeof(int32));
+	dsw->dict_buffer = malloc(1000 * sizeof(int32));
+	dsw->dict_entry_offsets = malloc(DATUMSTREAM_DICT_MAX_ENTRIES * sizeof(int32));
+	dsw->dict_entry_lens = malloc(DATUMSTREAM_DICT_MAX_ENTRIES * sizeof(int32));
+	dsw->dict_hash = malloc(DATUMSTREAM_DICT_HASH_SIZE * sizeof(uint16));
+	dsw->dict_codes_maxcount = 1000;
+	dsw->dict_codes = malloc(dsw->dict_codes_maxcount * sizeof(uint16));
+
+	/* 1000 datums with 3 distinct values */
+	values = (int32 *) dsw->datum_buffer;
+	for (i = 0; i < 1000; i++)
+		values[i] = (i % 3) * 100;
+	dsw->physical_datum_count = 1000;
+	dsw->datump = dsw->datum_buffer + 1000 * sizeof(int32);
+
+	/* Every value hashes to the same slot, which exercises the probing */
+	expect_any_count(hash_any, k, -1);
+	expect_any_count(hash_any, keylen, -1);
+	will_return_count(hash_any, 0, -1);
+
+	assert_true(DatumStreamBlockWrite_DictBuild(dsw));
+	assert_int_equal(dsw->dict_entry_count, 3);
+	assert_int_equal(dsw->dict_code_bits, 2);
+	assert_int_equal(dsw->dict_data_size, 3 * sizeof(int32));
+	for (i = 0; i < 1000; i++)
+		assert_int_equal(((int32 *) dsw->dict_buffer)[dsw->dict_codes[i]], values[i]);
+
+	/* All values distinct, the dictionary would not save anything */
+	for (i = 0; i < 1000; i++)
+		values[i] = i;
+
+	assert_false(DatumStreamBlockWrite_DictBuild(dsw));
+
+	free(dsw->datum_buffer);
+	free(dsw->dict_buffer);
+	free(dsw->dict_entry_offsets);
+	free(dsw->dict_entry_lens);
+	free(dsw->dict_hash);
+	free(dsw->dict_codes);
+	free(dsw);
+}
+
+/*
+ * Unit test function to test frame-of-reference packing and unpacking of
+ * the datums of a block
+ */
+void
+test__ForBuild__Unpack(void **state)
+{
+	DatumStreamTypeInfo typeInfo;
+	int64	   *values;
+	int64	   *decoded;
+	int			i;
+
+	DatumStreamBlockWrite* dsw = malloc(sizeof(DatumStreamBlockWrite));
+	DatumStreamBlockRead* dsr = malloc(sizeof(DatumStreamBlockRead));
+	memset(dsw, 0, sizeof(DatumStreamBlockWrite));
+	memset(dsr, 0, sizeof(DatumStreamBlockRead));
+
+	typeInfo.datumlen = 8;
+	typeInfo.typid = INT8OID;
+	typeInfo.byval = true;
+	typeInfo.align = 'd';
+
+	dsw->typeInfo = &typeInfo;
+	dsw->for_want_compression = true;
+	dsw->datum_buffer = malloc(1000 * sizeof(int64));
+	dsw->for_buffer = malloc(1000 * sizeof(int64));
+
+	dsr->typeInfo = typeInfo;
+	dsr->for_buffer_size = 1000 * sizeof(int64);
+	dsr->for_buffer = malloc(dsr->for_buffer_size);
+
+	/* 1000 datums within a range of 1000 around a large negative base */
+	values = (int64 *) dsw->datum_buffer;
+	for (i = 0; i < 1000; i++)
+		values[i] = INT64CONST(-5000000000) + (i * 7919) % 1000;
+	dsw->physical_datum_count = 1000;
+	dsw->datump = dsw->datum_buffer + 1000 * sizeof(int64);
+
+	assert_true(DatumStreamBlockWrite_ForBuild(dsw));
+	assert_true(dsw->for_base == INT64CONST(-5000000000));
+	assert_int_equal(dsw->for_bits, 10);
+	assert_int_equal(dsw->for_data_size, DatumStreamFor_Size(1000, 10));
+
+	dsr->physical_datum_count = 1000;
+	dsr->physical_data_size = dsw->for_data_size;
+	DatumStreamBlockRead_UnpackFor(dsr, dsw->for_buffer, dsw->for_base, dsw->for_bits);
+
+	decoded = (int64 *) dsr->datum_beginp;
+	assert_true(dsr->datum_afterp == dsr->datum_beginp + 1000 * sizeof(int64));
+	for (i = 0; i < 1000; i++)
+		assert_true(decoded[i] == values[i]);
+
+	/* The same value everywhere takes no bits at all */
+	for (i = 0; i < 1000; i++)
+		values[i] = 42;
+
+	assert_true(DatumStreamBlockWrite_ForBuild(dsw));
+	assert_int_equal(dsw->for_bits, 0);
+
+	/* A range wider than the packing allows */
+	values[0] = PG_INT64_MIN;
+	values[1] = PG_INT64_MAX;
+
+	assert_false(DatumStreamBlockWrite_ForBuild(dsw));
+
+	free(dsw->datum_buffer);
+	free(dsw->for_buffer);
+	free(dsw);
+	free(dsr->for_buffer);
+	free(dsr);
+}
+
 int 
 main(int argc, char* argv[]) 
 {
 	cmockery_parse_arguments(argc, argv);
 
 	const UnitTest tests[] = {
-			unit_test(test__DeltaCompression__Core)
+			unit_test(test__DeltaCompression__Core),
+			unit_test(test__DictCodes__PackGet),
+			unit_test(test__DictBuild),
+			unit_test(test__ForBuild__Unpack)
 	};
 	return run_tests(tests);
 }
@@ -141,7 +141,15 @@ int			gp_max_local_distributed_cache = 1024;
 bool		gp_appendonly_verify_block_checksums = true;
 bool		gp_appendonly_verify_write_block = false;
 bool		gp_appendonly_compaction = true;
+bool		gp_enable_aocs_zonemaps = false;
+bool		gp_aocs_dictionary_encoding = false;
+bool		gp_aocs_bitpack_encoding = false;
+bool		gp_aocs_rewrite_copy_blocks = false;
 int			gp_appendonly_compaction_threshold = 0;
+int			gp_aocs_scan_batch_size = 1024;
+int			gp_appendonly_prefetch_reads = 4;
+int			gp_aocs_decompress_workers = 0;
+int			gp_appendonly_compaction_progress_interval = 0;
 bool		gp_heap_require_relhasoids_match = true;
 bool		Debug_appendonly_rezero_quicklz_compress_scratch = false;
 bool		Debug_appendonly_rezero_quicklz_decompress_scratch = false;
@@ -468,6 +476,7 @@ static char *gp_server_version_string;
 /* Query Metrics */
 bool		gp_enable_query_metrics = false;
 int			gp_instrument_shmem_size = 5120;
+int			gp_shareinput_shmem_size = 8192;
 
 /* Security */
 bool		gp_reject_internal_tcp_conn = true;
@@ -485,6 +494,7 @@ int			writable_external_table_bufsize = 64;
 /* Executor */
 bool		gp_enable_mk_sort = true;
 bool		gp_enable_motion_mk_sort = true;
+int			gp_mk_sort_workers = 0;
 
 static const struct config_enum_entry gp_log_format_options[] = {
 	{"text", 0},
@@ -674,6 +684,36 @@ struct config_bool ConfigureNamesBool_gp[] =
 		&gp_enable_hashjoin_size_heuristic,
 		false, NULL, NULL
 	},
+	{
+		{"gp_enable_runtime_filter", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables hash joins to filter the rows of a scan on their outer side with the keys of their inner side."),
+			gettext_noop("The filter is a Bloom filter over the hash values of the inner rows, "
+						 "plus the range of the inner values of a single integer key."),
+			GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_enable_runtime_filter,
+		false, NULL, NULL
+	},
+	{
+		{"gp_enable_hashjoin_radix", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables hash joins to partition large hash tables and probe them a partition at a time."),
+			gettext_noop("Outer rows are buffered and sorted by partition, so that each probe "
+						 "touches a part of the hash table that fits in cache."),
+			GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_enable_hashjoin_radix,
+		false, NULL, NULL
+	},
+	{
+		{"gp_motion_split_hot_keys", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables hash joins to spread the outer rows of their most common keys over all segments."),
+			gettext_noop("Keys whose statistics say they would overload a single segment are sent "
+						 "round-robin on the outer side, and broadcast on the inner side."),
+			GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_motion_split_hot_keys,
+		false, NULL, NULL
+	},
 	{
 		{"gp_enable_fallback_plan", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Plan types which are not enabled may be used when a "
@@ -712,6 +752,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		&gp_workfile_checksumming,
 		true, NULL, NULL
 	},
+	{
+		{"gp_workfile_caching", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Reuse the spilled results of identical hash aggregates across queries."),
+			gettext_noop("Only applies to plan subtrees that read append-only tables without motions, "
+						 "parameters or mutable functions."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_workfile_caching,
+		false, NULL, NULL
+	},
 	{
 		{"force_bitmap_table_scan", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Forces bitmap table scan instead of bitmap heap/ao/aoco scan."),
@@ -1101,6 +1151,45 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, NULL, NULL
 	},
 
+	{
+		{"gp_enable_aocs_zonemaps", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Skip column-oriented append-only blocks whose min/max values cannot satisfy the scan's quals."),
+			NULL
+		},
+		&gp_enable_aocs_zonemaps,
+		false, NULL, NULL
+	},
+
+	{
+		{"gp_aocs_dictionary_encoding", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Dictionary encode blocks of RLE_TYPE compressed columns that have few distinct values."),
+			NULL,
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_aocs_dictionary_encoding,
+		false, NULL, NULL
+	},
+
+	{
+		{"gp_aocs_bitpack_encoding", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Bit-pack the integer, date and timestamp values of RLE_TYPE compressed column blocks as offsets from the smallest value."),
+			NULL,
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_aocs_bitpack_encoding,
+		false, NULL, NULL
+	},
+
+	{
+		{"gp_aocs_rewrite_copy_blocks", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Copy the blocks of the columns an ALTER TABLE rewrite of a column-oriented append-only table leaves unchanged, instead of decoding and encoding them again."),
+			NULL,
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_aocs_rewrite_copy_blocks,
+		false, NULL, NULL
+	},
+
 	{
 		{"gp_heap_require_relhasoids_match", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Issue an error on discovery of a mismatch between relhasoids and a tuple header."),
@@ -3048,6 +3137,56 @@ struct config_int ConfigureNamesInt_gp[] =
 		10, 0, 100, NULL, NULL
 	},
 
+	{
+		{"gp_aocs_scan_batch_size", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Number of rows a column-oriented append-only table scan decodes per column at a time."),
+			gettext_noop("0 decodes one row at a time."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_aocs_scan_batch_size,
+		1024, 0, 65536, NULL, NULL
+	},
+
+	{
+		{"gp_appendonly_prefetch_reads", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Number of large reads to prefetch ahead of an append-only segment file read."),
+			gettext_noop("0 disables prefetching."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_appendonly_prefetch_reads,
+		4, 0, 64, NULL, NULL
+	},
+
+	{
+		{"gp_aocs_decompress_workers", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Number of threads that decompress column-oriented append-only table blocks ahead of a scan."),
+			gettext_noop("0 decompresses in the scan itself."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_aocs_decompress_workers,
+		0, 0, 32, NULL, NULL
+	},
+
+	{
+		{"gp_mk_sort_workers", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Number of threads that help a multi-key sort to sort its tuples in memory."),
+			gettext_noop("0 sorts in the backend alone. Only sorts on pass by value keys with built-in comparisons use the threads."),
+			GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_mk_sort_workers,
+		0, 0, 64, NULL, NULL
+	},
+
+	{
+		{"gp_appendonly_compaction_progress_interval", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Sets the interval between progress messages of append-only segment file compaction."),
+			gettext_noop("0 turns the progress messages off."),
+			GUC_UNIT_S | GUC_NOT_IN_SAMPLE
+		},
+		&gp_appendonly_compaction_progress_interval,
+		0, 0, INT_MAX, NULL, NULL
+	},
+
 	{
 		{"gp_workfile_max_entries", PGC_POSTMASTER, RESOURCES,
 			gettext_noop("Sets the maximum number of entries that can be stored in the workfile directory"),
@@ -3068,6 +3207,16 @@ struct config_int ConfigureNamesInt_gp[] =
 		100000, 0, INT_MAX, NULL, NULL,
 	},
 
+	{
+		{"gp_workfile_cache_size", PGC_SIGHUP, RESOURCES,
+			gettext_noop("Maximum disk space (in KB) used for cached workfile results per segment."),
+			gettext_noop("Least recently used results are evicted to stay within the limit."),
+			GUC_UNIT_KB
+		},
+		&gp_workfile_cache_size,
+		1048576, 0, INT_MAX, NULL, NULL,
+	},
+
 	{
 		{"gp_vmem_idle_resource_timeout", PGC_USERSET, CLIENT_CONN_OTHER,
 			gettext_noop("Sets the time a session can be idle (in milliseconds) before we release gangs on the segment DBs to free resources."),
@@ -3591,13 +3740,13 @@ struct config_int ConfigureNamesInt_gp[] =
 	},
 
 	{
-		{"gp_hashagg_groups_per_bucket", PGC_USERSET, GP_ARRAY_TUNING,
-			gettext_noop("Target density of hashtable used by Hashagg during execution"),
-			gettext_noop("A smaller value will tend to produce larger hashtables, which increases agg performance"),
-			GUC_NOT_IN_SAMPLE | GUC_NO_SHOW_ALL | GUC_GPDB_ADDOPT
+		{"gp_hashjoin_radix_partition_kb", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Target size of a partition of the hashtable of a Hashjoin, when gp_enable_hashjoin_radix is on."),
+			gettext_noop("Should be somewhat less than the size of the CPU cache."),
+			GUC_UNIT_KB | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
 		},
-		&gp_hashagg_groups_per_bucket,
-		5, 1, 25, NULL, NULL
+		&gp_hashjoin_radix_partition_kb,
+		512, 64, 65536, NULL, NULL
 	},
 
 	{
@@ -3670,6 +3819,17 @@ struct config_int ConfigureNamesInt_gp[] =
 		5120, 0, 131072, NULL, NULL
 	},
 
+	{
+		{"gp_shareinput_shmem_size", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the size of shmem for the tuples of cross-slice shared scans."),
+			gettext_noop("A shared scan whose tuples fit passes them to the other slices "
+						 "in memory rather than through a workfile. 0 disables it."),
+			GUC_UNIT_KB
+		},
+		&gp_shareinput_shmem_size,
+		8192, 0, 1048576, NULL, NULL
+	},
+
 	{
 		{"gp_vmem_protect_limit", PGC_POSTMASTER, RESOURCES_MEM,
 			gettext_noop("Virtual memory limit (in MB) of Greenplum memory protection."),
@@ -3798,6 +3958,16 @@ struct config_int ConfigureNamesInt_gp[] =
 		NUM_MINIPAGE_ENTRIES, 1, NUM_MINIPAGE_ENTRIES, NULL, NULL
 	},
 
+	{
+		{"gp_blockdirectory_cache_size", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Number of block directory minipages an append-only index or bitmap scan keeps in memory."),
+			gettext_noop("0 looks up every minipage that is not the current one in the block directory relation."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_blockdirectory_cache_size,
+		64, 0, 65536, NULL, NULL
+	},
+
 
 	{
 		{"gp_segworker_relative_priority", PGC_POSTMASTER, RESOURCES_MGM,
@@ -4137,6 +4307,17 @@ struct config_real ConfigureNamesReal_gp[] =
 		1.0, 1.0, DBL_MAX, NULL, NULL
 	},
 
+	{
+		{"gp_hashagg_stream_min_reduction", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Minimum reduction for the streaming bottom stage of two stage hashagg."),
+			gettext_noop("When a full hash table holds more than 1/N groups per input row, "
+						 "input rows are passed through unaggregated for a while. 1 disables this."),
+			GUC_NOT_IN_SAMPLE | GUC_NO_SHOW_ALL
+		},
+		&gp_hashagg_stream_min_reduction,
+		1.5, 1.0, DBL_MAX, NULL, NULL
+	},
+
 	{
 		{"gp_statistics_ndistinct_scaling_ratio_threshold", PGC_USERSET, STATS_ANALYZE,
 			gettext_noop("If the ratio of number of distinct values of an attribute to the number of rows is greater than this value, it is assumed that ndistinct will scale with table size."),
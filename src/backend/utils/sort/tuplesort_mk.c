@@ -111,13 +111,16 @@
 #include "executor/nodeSort.h"	/* gpmon */
 #include "miscadmin.h"
 #include "pg_trace.h"
+#include "utils/date.h"
 #include "utils/datum.h"
 #include "executor/execWorkfile.h"
 #include "utils/logtape.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/numeric.h"
 #include "utils/pg_rusage.h"
 #include "utils/syscache.h"
+#include "utils/timestamp.h"
 #include "utils/tuplesort.h"
 #include "utils/pg_locale.h"
 #include "utils/builtins.h"
@@ -505,6 +508,8 @@ static void readtup_datum(Tuplesortstate_mk *state, TuplesortPos_mk *pos, MKEntr
 
 static void tupsort_prepare_char(MKEntry *a, bool isChar);
 static int	tupsort_compare_char(MKEntry *v1, MKEntry *v2, MKLvContext *lvctxt, MKContext *mkContext);
+static void tupsort_prepare_abbrev(MKEntry *a, MKLvContext *lvctxt);
+static int	tupsort_compare_abbrev(MKEntry *v1, MKEntry *v2, MKLvContext *lvctxt, MKContext *mkContext);
 
 static Datum tupsort_fetch_datum_mtup(MKEntry *a, MKContext *mkctxt, MKLvContext *lvctxt, bool *isNullOut);
 static Datum tupsort_fetch_datum_itup(MKEntry *a, MKContext *mkctxt, MKLvContext *lvctxt, bool *isNullOut);
@@ -734,15 +739,39 @@ create_mksort_context(
 			sinfo->typByVal = tupdesc->attrs[sinfo->attno - 1]->attbyval;
 			sinfo->typLen = tupdesc->attrs[sinfo->attno - 1]->attlen;
 
-			if (sinfo->scanKey.sk_func.fn_addr == btint4cmp)
+			PGFunction	sortfn = sinfo->scanKey.sk_func.fn_addr;
+
+			if (sortfn == btint4cmp || sortfn == date_cmp)
 				sinfo->lvtype = MKLV_TYPE_INT32;
+			else if (sortfn == btint8cmp)
+				sinfo->lvtype = MKLV_TYPE_INT64;
+#ifdef HAVE_INT64_TIMESTAMP
+			else if (sortfn == timestamp_cmp || sortfn == time_cmp)
+				sinfo->lvtype = MKLV_TYPE_INT64;
+#endif
+			else if (sortfn == btfloat8cmp)
+				sinfo->lvtype = MKLV_TYPE_FLOAT8;
+#if SIZEOF_DATUM == 8
+			else if (sortfn == numeric_cmp)
+				sinfo->lvtype = MKLV_TYPE_ABBREV_NUMERIC;
+#endif
+
 			if (!lc_collate_is_c())
 			{
-				if (sinfo->scanKey.sk_func.fn_addr == bpcharcmp)
+				if (sortfn == bpcharcmp)
 					sinfo->lvtype = MKLV_TYPE_CHAR;
-				else if (sinfo->scanKey.sk_func.fn_addr == bttextcmp)
+				else if (sortfn == bttextcmp)
 					sinfo->lvtype = MKLV_TYPE_TEXT;
 			}
+#if SIZEOF_DATUM == 8
+			else
+			{
+				if (sortfn == bpcharcmp)
+					sinfo->lvtype = MKLV_TYPE_ABBREV_CHAR;
+				else if (sortfn == bttextcmp)
+					sinfo->lvtype = MKLV_TYPE_ABBREV_TEXT;
+			}
+#endif
 		}
 		else
 		{
@@ -3110,6 +3139,34 @@ tupsort_compare_datum(MKEntry *v1, MKEntry *v2, MKLvContext *lvctxt, MKContext *
 
 				return ((lvctxt->scanKey.sk_flags & SK_BT_DESC) != 0) ? -result : result;
 			}
+		case MKLV_TYPE_INT64:
+			{
+				int64		i1 = DatumGetInt64(v1->d);
+				int64		i2 = DatumGetInt64(v2->d);
+				int			result = (i1 < i2) ? -1 : ((i1 == i2) ? 0 : 1);
+
+				return ((lvctxt->scanKey.sk_flags & SK_BT_DESC) != 0) ? -result : result;
+			}
+		case MKLV_TYPE_FLOAT8:
+			{
+				float8		f1 = DatumGetFloat8(v1->d);
+				float8		f2 = DatumGetFloat8(v2->d);
+				int			result;
+
+				/* As in btfloat8cmp, NaNs are equal and larger than any non-NaN */
+				if (isnan(f1))
+					result = isnan(f2) ? 0 : 1;
+				else if (isnan(f2))
+					result = -1;
+				else
+					result = (f1 < f2) ? -1 : ((f1 == f2) ? 0 : 1);
+
+				return ((lvctxt->scanKey.sk_flags & SK_BT_DESC) != 0) ? -result : result;
+			}
+		case MKLV_TYPE_ABBREV_TEXT:
+		case MKLV_TYPE_ABBREV_CHAR:
+		case MKLV_TYPE_ABBREV_NUMERIC:
+			return tupsort_compare_abbrev(v1, v2, lvctxt, context);
 		default:
 			return tupsort_compare_char(v1, v2, lvctxt, context);
 	}
@@ -3145,7 +3202,7 @@ tupsort_cpfr(MKEntry *dst, MKEntry *src, MKLvContext *lvctxt)
 		{
 			if (mke_is_refc(src))
 				tupsort_refcnt(DatumGetPointer(dst->d), 1);
-			else if (!lvctxt->typByVal)
+			else if (!lvctxt->typByVal && !mk_lvtype_is_abbrev(lvctxt->lvtype))
 			{
 				Assert(src->d != 0);
 				dst->d = datumCopy(src->d, lvctxt->typByVal, lvctxt->typLen);
@@ -3255,6 +3312,41 @@ tupsort_compare_char(MKEntry *v1, MKEntry *v2, MKLvContext *lvctxt, MKContext *m
 	return ((lvctxt->scanKey.sk_flags & SK_BT_DESC) != 0) ? -result : result;
 }
 
+/*
+ * Compare the abbreviated keys of two entries; if they are equal, compare
+ * the full values with the sort function.
+ */
+static int
+tupsort_compare_abbrev(MKEntry *v1, MKEntry *v2, MKLvContext *lvctxt, MKContext *mkContext)
+{
+	uint64		k1 = (uint64) v1->d;
+	uint64		k2 = (uint64) v2->d;
+	Datum		p1Original,
+				p2Original;
+	bool		p1IsNull,
+				p2IsNull;
+
+	Assert(!mke_is_null(v1));
+	Assert(!mke_is_null(v2));
+	Assert(mkContext->fetchForPrep);
+
+	if (k1 != k2)
+	{
+		int			result = (k1 < k2) ? -1 : 1;
+
+		return ((lvctxt->scanKey.sk_flags & SK_BT_DESC) != 0) ? -result : result;
+	}
+
+	p1Original = (mkContext->fetchForPrep) (v1, mkContext, lvctxt, &p1IsNull);
+	p2Original = (mkContext->fetchForPrep) (v2, mkContext, lvctxt, &p2IsNull);
+
+	Assert(!p1IsNull);			/* should not have been prepared if null */
+	Assert(!p2IsNull);
+
+	return inlineApplySortFunction(&lvctxt->scanKey.sk_func, lvctxt->scanKey.sk_flags,
+								   p1Original, false, p2Original, false);
+}
+
 static int32
 estimateMaxPrepareSizeForEntry(MKEntry *a, struct MKContext *mkContext)
 {
@@ -3334,6 +3426,8 @@ tupsort_prepare(MKEntry *a, MKContext *mkctxt, int lv)
 		tupsort_prepare_char(a, true);
 	else if (lvctxt->lvtype == MKLV_TYPE_TEXT)
 		tupsort_prepare_char(a, false);
+	else if (mk_lvtype_is_abbrev(lvctxt->lvtype))
+		tupsort_prepare_abbrev(a, lvctxt);
 }
 
 /* "True" length (not counting trailing blanks) of a BpChar */
@@ -3565,6 +3659,55 @@ tupsort_prepare_char(MKEntry *a, bool isCHAR)
 	mke_set_refc(a);
 }
 
+/*
+ * Replace the datum of a prepared entry by its abbreviated key.
+ *
+ * For text and char in the C locale, the key is the first 8 bytes of the
+ * string (of char, without trailing blanks), big-endian and zero padded, so
+ * that comparing keys as integers is comparing the strings with memcmp.
+ */
+static void
+tupsort_prepare_abbrev(MKEntry *a, MKLvContext *lvctxt)
+{
+	uint64		key = 0;
+
+	if (mke_is_null(a))
+		return;
+
+	if (lvctxt->lvtype == MKLV_TYPE_ABBREV_NUMERIC)
+	{
+		Numeric		num = DatumGetNumeric(a->d);
+
+		key = numeric_abbrev_key(num);
+
+		if ((Pointer) num != DatumGetPointer(a->d))
+			pfree(num);
+	}
+	else
+	{
+		char	   *p;
+		void	   *tofree;
+		int			len;
+		int			i;
+
+		varattrib_untoast_ptr_len(a->d, &p, &len, &tofree);
+		if (lvctxt->lvtype == MKLV_TYPE_ABBREV_CHAR)
+			len = bcTruelen(p, len);
+
+		for (i = 0; i < sizeof(key); i++)
+		{
+			key <<= 8;
+			if (i < len)
+				key |= (unsigned char) p[i];
+		}
+
+		if (tofree)
+			pfree(tofree);
+	}
+
+	a->d = (Datum) key;
+}
+
 /*
  * tuplesort_inmem_limit_insert
  *	 Adds a tuple for sorting when we are doing LIMIT sort and we (still) fit in memory
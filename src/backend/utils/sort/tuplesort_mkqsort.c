@@ -8,6 +8,15 @@
  * 		Software Practice and Experience, Vol 23(11) Nov, 1993.
  * 	    [2] R. Sedgewick, J. Bentley. Quicksort is optimal.
  *
+ * With gp_mk_sort_workers set, a large in-memory sort is shared with helper
+ * threads.  The partitions of the quick sort are disjoint slices of the
+ * array, so once a range has been partitioned, its parts can be sorted by
+ * different threads without any merge afterwards, and without any memory
+ * beyond the array itself.  The helpers cannot run backend code that might
+ * palloc, elog or check for interrupts, so this is only done when every
+ * key is a pass by value type compared by a built-in function, and the
+ * sort neither removes nor rejects duplicates.
+ *
  * Portions Copyright (c) Greenplum Inc, 2008.
  * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
  *
@@ -18,14 +27,55 @@
  *-------------------------------------------------------------------------
  */
 
+#include <pthread.h>
+
 #include "postgres.h"
 #include "access/genam.h"
+#include "access/transam.h"
+#include "cdb/cdbgang.h"
+#include "cdb/cdbvars.h"
 #include "utils/tuplesort.h"
 #include "utils/tuplesort_mk.h"
 #include "utils/tuplesort_mk_details.h"
 
 #include "miscadmin.h"
 
+/* Arrays smaller than this are not worth the threads */
+#define MKQS_PARALLEL_MIN_ENTRIES	100000
+
+/* Most ranges waiting for a thread to sort them */
+#define MKQS_PARALLEL_MAX_TASKS		1024
+
+/* A range of the array to sort, as in the arguments of mk_qsort_impl */
+typedef struct MKQsortTask
+{
+	int			left;
+	int			right;
+	int			lv;
+	bool		lvdown;
+} MKQsortTask;
+
+/* State shared by the threads of a parallel sort */
+typedef struct MKQsortPool
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;		/* a task was queued, or all are done */
+
+	MKEntry    *a;
+	MKContext  *ctxt;
+
+	/* ranges up to this size are sorted by one thread */
+	int			cutoff;
+
+	/* Protected by mutex */
+	int			ntasks;			/* tasks waiting */
+	int			nbusy;			/* threads working on a task */
+	MKQsortTask tasks[MKQS_PARALLEL_MAX_TASKS];
+} MKQsortPool;
+
+static void mk_qsort_rec(MKEntry *a, int left, int right, int lv, bool lvdown,
+			 MKContext *ctxt, bool seenNull, bool inWorker);
+
 #ifdef MKQSORT_VERIFY 
 extern void mkqsort_verify(MKEntry *a, int l, int r, MKContext *mkctxt);
 #endif
@@ -263,91 +313,352 @@ static void mk_qsort_part3(MKEntry *a, int left, int right, int lv, MKContext *m
 
 void mk_qsort_impl(MKEntry *a, int left, int right, int lv, bool lvdown, MKContext *ctxt, bool seenNull)
 {
-	int lastInLow;
-	int firstInHigh;
+	mk_qsort_rec(a, left, right, lv, lvdown, ctxt, seenNull, false);
+}
+
+/*
+ * The quick sort proper.  inWorker is true when run by a thread of a
+ * parallel sort, which must leave interrupts to the backend.
+ *
+ * Of the three chunks a range is split into, the largest one is sorted by
+ * looping and only the other two by recursing.  Each of those is at most
+ * half of the range, so the recursion is at most log2(n) deep, which the
+ * small fixed stack of a sort helper thread can take.
+ */
+static void mk_qsort_rec(MKEntry *a, int left, int right, int lv, bool lvdown,
+			 MKContext *ctxt, bool seenNull, bool inWorker)
+{
+#ifdef MKQSORT_VERIFY 
+	int origLeft = left;
+	int origRight = right;
+	int origLv = lv;
+#endif
 
 	Assert(ctxt);
-	Assert(lv < ctxt->total_lv);
 
-	CHECK_FOR_INTERRUPTS();
+	for (;;)
+	{
+		int lastInLow;
+		int firstInHigh;
+		bool middleSeenNull;
+		int nlow;
+		int nmiddle;
+		int nhigh;
 
-	if (QueryFinishPending)
-		return;
+		Assert(lv < ctxt->total_lv);
 
-	if(right <= left)
-		return;
-	
-	/* Prepare at level lv */
-	if(lvdown)
-        mk_prepare_array(a, left, right, lv, ctxt);
-
-	/* 
-	 * According to Bentley & McIlroy [1] (1993), using insert sort for case 
-	 * n < 7 is a significant saving.  However, according to Sedgewick & 
-	 * Bentley [2] (2002), the wisdom of new millenium is not to special case
-	 * smaller cases.  Here, we do not special case it because we want to save
-	 * memtuple_getattr, and expensive comparisons that has been prepared.
-	 *
-	 * XXX Find out why we have a new wisdom in [2] and impl. & compare.
-	 */
-	mk_qsort_part3(a, left, right, lv, ctxt, &lastInLow, &firstInHigh);
+		if (!inWorker)
+		{
+			CHECK_FOR_INTERRUPTS();
 
-	/* recurse to left chunk */
-	mk_qsort_impl(a, left, lastInLow, lv, false, ctxt, seenNull);
+			if (QueryFinishPending)
+				return;
+		}
+
+		if(right <= left)
+			break;
+
+		/* Prepare at level lv */
+		if(lvdown)
+			mk_prepare_array(a, left, right, lv, ctxt);
+
+		/* 
+		 * According to Bentley & McIlroy [1] (1993), using insert sort for case 
+		 * n < 7 is a significant saving.  However, according to Sedgewick & 
+		 * Bentley [2] (2002), the wisdom of new millenium is not to special case
+		 * smaller cases.  Here, we do not special case it because we want to save
+		 * memtuple_getattr, and expensive comparisons that has been prepared.
+		 *
+		 * XXX Find out why we have a new wisdom in [2] and impl. & compare.
+		 */
+		mk_qsort_part3(a, left, right, lv, ctxt, &lastInLow, &firstInHigh);
 
-	/* recurse to middle (equal) chunk */
-	if(lv < ctxt->total_lv-1)
-	{
 		/*
-		 * [lastInLow+1,firstInHigh-1] defines the pivot region which was all equal at level lv.  So increase the level and compare that region!
+		 * [lastInLow+1,firstInHigh-1] defines the pivot region which was all
+		 * equal at level lv.  If there are more levels, increase the level and
+		 * compare that region!
 		 */
-		mk_qsort_impl(a, lastInLow+1, firstInHigh-1, lv+1, true, ctxt, seenNull || mke_is_null(a+lastInLow+1)); /* a + lastInLow + 1 points to the pivot */
-	}
-	else
-	{
-		/* values are all equal to the deepest level...no need for more compares, but check uniqueness if requested */
-		if(firstInHigh-1 > lastInLow+1 &&
-				!seenNull &&
-				!mke_is_null(a+lastInLow+1)) /* a + lastInLow + 1 points to the pivot */
+		middleSeenNull = seenNull || mke_is_null(a+lastInLow+1); /* a + lastInLow + 1 points to the pivot */
+		nlow = lastInLow - left + 1;
+		nmiddle = 0;
+		nhigh = right - firstInHigh + 1;
+
+		if(lv < ctxt->total_lv-1)
+			nmiddle = firstInHigh - lastInLow - 1;
+		else
 		{
-			if ( ctxt->enforceUnique )
-			{
-				Datum	values[INDEX_MAX_KEYS];
-				bool	isnull[INDEX_MAX_KEYS];
-		
-				index_deform_tuple((IndexTuple)(a+lastInLow+1)->ptr, ctxt->tupdesc, values, isnull);
-				ereport(ERROR,
-						(errcode(ERRCODE_UNIQUE_VIOLATION),
-						 errmsg("could not create unique index \"%s\"",
-								RelationGetRelationName(ctxt->indexRel)),
-						 errdetail("Key %s is duplicated.",
-								   BuildIndexValueDescription(ctxt->indexRel,
-															  values, isnull))));
-			}
-			else if ( ctxt->unique)
+			/* values are all equal to the deepest level...no need for more compares, but check uniqueness if requested */
+			if(firstInHigh-1 > lastInLow+1 &&
+					!seenNull &&
+					!mke_is_null(a+lastInLow+1)) /* a + lastInLow + 1 points to the pivot */
 			{
-				int toFreeIndex;
-				for ( toFreeIndex = lastInLow + 2; toFreeIndex < firstInHigh; toFreeIndex++) /* +2 because we want to keep one around! */
+				if ( ctxt->enforceUnique )
+				{
+					Datum	values[INDEX_MAX_KEYS];
+					bool	isnull[INDEX_MAX_KEYS];
+
+					index_deform_tuple((IndexTuple)(a+lastInLow+1)->ptr, ctxt->tupdesc, values, isnull);
+					Assert(!inWorker);
+					ereport(ERROR,
+							(errcode(ERRCODE_UNIQUE_VIOLATION),
+							 errmsg("could not create unique index \"%s\"",
+									RelationGetRelationName(ctxt->indexRel)),
+							 errdetail("Key %s is duplicated.",
+									   BuildIndexValueDescription(ctxt->indexRel,
+																  values, isnull))));
+				}
+				else if ( ctxt->unique)
 				{
-					MKEntry *toFree = a + toFreeIndex;
-					if ( ctxt->cpfr)
-						ctxt->cpfr(toFree, NULL, ctxt->lvctxt + lv); // todo: verify off-by-one
-					ctxt->freeTup(toFree);
-					mke_set_empty(toFree);
+					int toFreeIndex;
+
+					Assert(!inWorker);
+					for ( toFreeIndex = lastInLow + 2; toFreeIndex < firstInHigh; toFreeIndex++) /* +2 because we want to keep one around! */
+					{
+						MKEntry *toFree = a + toFreeIndex;
+						if ( ctxt->cpfr)
+							ctxt->cpfr(toFree, NULL, ctxt->lvctxt + lv); // todo: verify off-by-one
+						ctxt->freeTup(toFree);
+						mke_set_empty(toFree);
+					}
 				}
 			}
 		}
-	}
 
-	/* recurse to right chunk */
-	mk_qsort_impl(a, firstInHigh, right, lv, false, ctxt, seenNull);
+		/* recurse to the two smaller chunks, and loop on the largest one */
+		if(nmiddle > nlow && nmiddle > nhigh)
+		{
+			mk_qsort_rec(a, left, lastInLow, lv, false, ctxt, seenNull, inWorker);
+			mk_qsort_rec(a, firstInHigh, right, lv, false, ctxt, seenNull, inWorker);
+
+			left = lastInLow+1;
+			right = firstInHigh-1;
+			lv = lv+1;
+			lvdown = true;
+			seenNull = middleSeenNull;
+			continue;
+		}
+
+		if(nmiddle > 0)
+			mk_qsort_rec(a, lastInLow+1, firstInHigh-1, lv+1, true, ctxt, middleSeenNull, inWorker);
+
+		if(nlow > nhigh)
+		{
+			mk_qsort_rec(a, firstInHigh, right, lv, false, ctxt, seenNull, inWorker);
+			right = lastInLow;
+		}
+		else
+		{
+			mk_qsort_rec(a, left, lastInLow, lv, false, ctxt, seenNull, inWorker);
+			left = firstInHigh;
+		}
+		lvdown = false;
+	}
 
 #ifdef MKQSORT_VERIFY 
-	if(lv == 0)
-		mkqsort_verify(a, left, right, ctxt);
+	if(origLv == 0)
+		mkqsort_verify(a, origLeft, origRight, ctxt);
 #endif
 }
 
+/*
+ * Can the sort of this context be shared with helper threads?  See the
+ * notes at the top of the file.
+ */
+static bool mk_qsort_parallel_safe(MKContext *ctxt)
+{
+	int lv;
+
+	if (ctxt->unique || ctxt->enforceUnique || ctxt->bounded)
+		return false;
+
+	for (lv = 0; lv < ctxt->total_lv; ++lv)
+	{
+		MKLvContext *lvctxt = ctxt->lvctxt + lv;
+
+		if (!lvctxt->typByVal)
+			return false;
+		if (lvctxt->lvtype == MKLV_TYPE_INT32 ||
+			lvctxt->lvtype == MKLV_TYPE_INT64 ||
+			lvctxt->lvtype == MKLV_TYPE_FLOAT8)
+			continue;
+		if (lvctxt->lvtype != MKLV_TYPE_NONE ||
+			lvctxt->scanKey.sk_func.fn_oid >= FirstBootstrapObjectId)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Queue a range for any thread to sort.  If the queue is full, the calling
+ * thread sorts it right away.
+ */
+static void mk_qsort_push(MKQsortPool *pool, int left, int right, int lv, bool lvdown)
+{
+	if (right <= left)
+		return;
+
+	pthread_mutex_lock(&pool->mutex);
+	if (pool->ntasks < MKQS_PARALLEL_MAX_TASKS)
+	{
+		MKQsortTask *task = &pool->tasks[pool->ntasks++];
+
+		task->left = left;
+		task->right = right;
+		task->lv = lv;
+		task->lvdown = lvdown;
+		pthread_cond_signal(&pool->cond);
+		pthread_mutex_unlock(&pool->mutex);
+		return;
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	mk_qsort_rec(pool->a, left, right, lv, lvdown, pool->ctxt, false, true);
+}
+
+/*
+ * Sort a range.  While it is larger than the cutoff, partition it, queue
+ * the equal and high parts for other threads and go on with the low part.
+ */
+static void mk_qsort_run_task(MKQsortPool *pool, MKQsortTask *task)
+{
+	MKEntry *a = pool->a;
+	MKContext *ctxt = pool->ctxt;
+	int left = task->left;
+	int right = task->right;
+	int lv = task->lv;
+	bool lvdown = task->lvdown;
+
+	while (right - left + 1 > pool->cutoff)
+	{
+		int lastInLow;
+		int firstInHigh;
+
+		if (lvdown)
+			mk_prepare_array(a, left, right, lv, ctxt);
+		lvdown = false;
+
+		mk_qsort_part3(a, left, right, lv, ctxt, &lastInLow, &firstInHigh);
+
+		if (lv < ctxt->total_lv - 1)
+			mk_qsort_push(pool, lastInLow + 1, firstInHigh - 1, lv + 1, true);
+		mk_qsort_push(pool, firstInHigh, right, lv, false);
+
+		right = lastInLow;
+	}
+
+	mk_qsort_rec(a, left, right, lv, lvdown, ctxt, false, true);
+}
+
+/*
+ * Main loop of the threads of a parallel sort, the backend included.
+ * Returns when no task is left and no thread is working on one, as none
+ * can be queued any more.
+ */
+static void *mk_qsort_worker(void *arg)
+{
+	MKQsortPool *pool = (MKQsortPool *) arg;
+
+	pthread_mutex_lock(&pool->mutex);
+	for (;;)
+	{
+		MKQsortTask task;
+
+		while (pool->ntasks == 0 && pool->nbusy > 0)
+			pthread_cond_wait(&pool->cond, &pool->mutex);
+
+		if (pool->ntasks == 0)
+			break;
+
+		task = pool->tasks[--pool->ntasks];
+		pool->nbusy++;
+		pthread_mutex_unlock(&pool->mutex);
+
+		mk_qsort_run_task(pool, &task);
+
+		pthread_mutex_lock(&pool->mutex);
+		pool->nbusy--;
+		if (pool->ntasks == 0 && pool->nbusy == 0)
+			pthread_cond_broadcast(&pool->cond);
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	return NULL;
+}
+
+/*
+ * Start routine of the helper threads.  Signals are left to the backend.
+ */
+static void *mk_qsort_thread_main(void *arg)
+{
+	gp_set_thread_sigmasks();
+
+	return mk_qsort_worker(arg);
+}
+
+/*
+ * Sort the n entries of a with the help of gp_mk_sort_workers threads.
+ *
+ * Returns false, without touching the array, if the sort is too small or
+ * cannot be shared; the caller then sorts it as usual.
+ */
+bool mk_qsort_parallel(MKEntry *a, int n, MKContext *ctxt)
+{
+	MKQsortPool *pool;
+	pthread_t *threads;
+	int nworkers = gp_mk_sort_workers;
+	int nstarted = 0;
+	int i;
+
+	if (nworkers <= 0 || n < MKQS_PARALLEL_MIN_ENTRIES ||
+		!mk_qsort_parallel_safe(ctxt))
+		return false;
+
+	pool = (MKQsortPool *) palloc(sizeof(MKQsortPool));
+	threads = (pthread_t *) palloc(nworkers * sizeof(pthread_t));
+
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->cond, NULL);
+	pool->a = a;
+	pool->ctxt = ctxt;
+	pool->cutoff = Max(n / ((nworkers + 1) * 8), 1024);
+	pool->nbusy = 0;
+	pool->ntasks = 1;
+	pool->tasks[0].left = 0;
+	pool->tasks[0].right = n - 1;
+	pool->tasks[0].lv = 0;
+	pool->tasks[0].lvdown = true;
+
+	for (i = 0; i < nworkers; ++i)
+	{
+		int pthread_err;
+
+		pthread_err = gp_pthread_create(&threads[i], mk_qsort_thread_main, pool,
+										"mk_qsort_parallel");
+		if (pthread_err != 0)
+		{
+			elog(LOG, "could not start sort worker: error %d", pthread_err);
+			break;
+		}
+		nstarted++;
+	}
+
+	/* The backend sorts along with the helpers */
+	mk_qsort_worker(pool);
+
+	for (i = 0; i < nstarted; ++i)
+		pthread_join(threads[i], NULL);
+
+	pthread_cond_destroy(&pool->cond);
+	pthread_mutex_destroy(&pool->mutex);
+	pfree(threads);
+	pfree(pool);
+
+	CHECK_FOR_INTERRUPTS();
+
+	return true;
+}
+
 #ifdef MKQSORT_VERIFY 
 static int mkqsort_comp_entry_all_lv(MKEntry *a, MKEntry *b, MKContext *mkctxt)
 {
@@ -17,14 +17,24 @@
  *		Each page's slot table grows from end to beginning (using the same byte
  *		array) and the data grows from beginning to end. Therefore, all the slot
  *		indexes are negative.
+ *
+ *		The store of a cross-slice ShareInputScan (readerwriter) only creates
+ *		its files once it spills.  If it never does, flush copies its pages to
+ *		a pool in shared memory instead, and the readers on the segment load
+ *		their pages from there rather than from the files.
  */
 
 #include "postgres.h"
 #include "access/heapam.h"
+#include "access/xact.h"
 #include "executor/instrument.h"
 #include "executor/execWorkfile.h"
+#include "miscadmin.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
 #include "utils/tuplestorenew.h"
 #include "utils/memutils.h"
+#include "utils/faultinjector.h"
 
 #include "cdb/cdbvars.h"                /* currentSliceId */
 
@@ -226,6 +236,43 @@ static inline void update_page_slot_entry(NTupleStorePage *page, int len)
 	nts_page_set_dirty(page, true);
 }
 
+/*
+ * Shared memory pool for the pages of readerwriter stores.  Each published
+ * store takes an entry, named after its files, and a chain of pages linked
+ * through next_page.  The entry and its pages are freed when the writer and
+ * all readers that attached to it have let go.
+ */
+#define NTS_SHM_NAMELEN 64
+
+typedef struct NTupleStoreShmEntry
+{
+	char name[NTS_SHM_NAMELEN];	/* file name of the store, empty if not published */
+	int refcnt;					/* writer and attached readers, 0 if free */
+	int npages;
+	int first_page;				/* -1 if the store is empty */
+} NTupleStoreShmEntry;
+
+typedef struct NTupleStoreShmHeader
+{
+	int nentries;
+	int npages;
+	int nfree_pages;
+	int first_free_page;
+	NTupleStoreShmEntry entries[1];		/* VARIABLE LENGTH ARRAY */
+} NTupleStoreShmHeader;
+
+/* A backend's reference to a published store, in TopMemoryContext */
+typedef struct NTupleStoreShmRef
+{
+	int entry;
+	int npages;
+	NTupleStorePage **pages;	/* readers only: the pages by blockn */
+} NTupleStoreShmRef;
+
+static NTupleStoreShmHeader *ntsShm = NULL;
+static int *ntsShmNextPage = NULL;
+static NTupleStorePage *ntsShmPages = NULL;
+
 /* tuple store type */
 #define NTS_NOT_READERWRITER 1
 #define NTS_IS_WRITER 2
@@ -248,6 +295,9 @@ struct NTupleStore
 	bool workfiles_created; /* set if the operator created workfiles */
 	workfile_set *work_set; /* workfile set to use when using workfile manager */
 
+	char *rwfilename;	/* readerwriter writer: files to create if it spills */
+	NTupleStoreShmRef *shmref;	/* published to shared memory */
+
 	ExecWorkFile *pfile; 	/* underlying backed file */
 	ExecWorkFile *plobfile;  /* underlying backed file for lobs (entries does not fit one page) */
 	int64     lobbytes;  /* number of bytes written to lob file */
@@ -289,6 +339,11 @@ struct NTupleStoreAccessor
 
 static void ntuplestore_init_reader(NTupleStore *store, int maxBytes);
 static void ntuplestore_create_spill_files(NTupleStore *nts);
+static void ntuplestore_create_rw_files(NTupleStore *nts);
+static bool ntuplestore_publish_shmem(NTupleStore *nts);
+static NTupleStoreShmRef *ntuplestore_attach_shmem(const char *name);
+static void ntuplestore_release_shmem(NTupleStoreShmRef *ref);
+static void XCallBack_NTupleStore_Shmem(XactEvent ev, void *vp);
 
 void ntuplestore_setinstrument(NTupleStore *st, struct Instrumentation *instr)
 {
@@ -394,6 +449,21 @@ static bool ntsReadBlock(NTupleStore *ts, int blockn, NTupleStorePage *page)
 {
 	long diskblockn = blockn - ts->first_ondisk_blockn;
 
+	if(ts->shmref && ts->shmref->pages)
+	{
+		if(blockn >= ts->shmref->npages)
+			return false;
+
+		memcpy(page, ts->shmref->pages[blockn], BLCKSZ);
+		Assert(nts_page_blockn(page) == blockn);
+
+		nts_page_set_pin_cnt(page, 0);
+		nts_page_set_prev(page, NULL);
+		nts_page_set_next(page, NULL);
+
+		return true;
+	}
+
 	if(!ts->pfile)
 		return false;
 	
@@ -474,13 +544,18 @@ static NTupleStorePage *nts_get_free_page(NTupleStore *nts)
 
 	if(nts->page_cnt >= page_max)
 	{
-		if(!nts->pfile)
+		if(!nts->pfile && nts->rwflag != NTS_IS_READER)
 		{
 			if (nts->work_set != NULL)
 			{
 				/* We have a usable workfile_set. Use that to generate temp files */
 				ntuplestore_create_spill_files(nts);
 			}
+			else if (nts->rwfilename != NULL)
+			{
+				/* Writer of a readerwriter store, spill to the shared files */
+				ntuplestore_create_rw_files(nts);
+			}
 			else
 			{
 				char tmpprefix[MAXPGPATH];
@@ -696,6 +771,13 @@ ntuplestore_destroy(NTupleStore *ts)
 		p = pnext;
 	}
 
+	if(ts->shmref)
+	{
+		UnregisterXactCallbackOnce(XCallBack_NTupleStore_Shmem, ts->shmref);
+		ntuplestore_release_shmem(ts->shmref);
+		ts->shmref = NULL;
+	}
+
 	if(ts->pfile)
 	{
 		workfile_mgr_close_file(ts->work_set, ts->pfile);
@@ -722,6 +804,9 @@ ntuplestore_create(int64 maxBytes)
 	NTupleStore *store = (NTupleStore *) palloc(sizeof(NTupleStore));
 	store->mcxt = CurrentMemoryContext;
 
+	store->rwfilename = NULL;
+	store->shmref = NULL;
+
 	store->pfile = NULL;
 	store->first_ondisk_blockn = 0;
 
@@ -775,13 +860,10 @@ ntuplestore_create_readerwriter(const char *filename, int64 maxBytes, bool isWri
 
 	if(isWriter)
 	{
+		/* The files are created when the store spills or is flushed */
 		store = ntuplestore_create(maxBytes);
-		store->pfile = ExecWorkFile_Create(filename, BUFFILE,
-				true /*delOnClose */, 0 /* compressType */);
+		store->rwfilename = MemoryContextStrdup(store->mcxt, filename);
 		store->rwflag = NTS_IS_WRITER;
-
-		store->plobfile = ExecWorkFile_Create(filenamelob, BUFFILE,
-				true /* delOnClose */, 0 /* compressType */ );
 		store->lobbytes = 0;
 	}
 	else
@@ -790,14 +872,24 @@ ntuplestore_create_readerwriter(const char *filename, int64 maxBytes, bool isWri
 		store->mcxt = CurrentMemoryContext;
 		store->work_set = NULL;
 		store->workfiles_created = false;
+		store->rwfilename = NULL;
 
-		store->pfile = ExecWorkFile_Open(filename, BUFFILE,
-				false /* delOnClose */,
-				0 /* compressType */);
+		store->shmref = ntuplestore_attach_shmem(filename);
+		if(store->shmref)
+		{
+			store->pfile = NULL;
+			store->plobfile = NULL;
+		}
+		else
+		{
+			store->pfile = ExecWorkFile_Open(filename, BUFFILE,
+					false /* delOnClose */,
+					0 /* compressType */);
 
-		store->plobfile = ExecWorkFile_Open(filenamelob, BUFFILE,
-				false /* delOnClose */,
-				0 /* compressType */);
+			store->plobfile = ExecWorkFile_Open(filenamelob, BUFFILE,
+					false /* delOnClose */,
+					0 /* compressType */);
+		}
 
 		ntuplestore_init_reader(store, maxBytes);
 	}
@@ -813,8 +905,8 @@ static void
 ntuplestore_init_reader(NTupleStore *store, int maxBytes)
 {
 	Assert(NULL != store);
-	Assert(NULL != store->pfile);
-	Assert(NULL != store->plobfile);
+	Assert(NULL != store->shmref || NULL != store->pfile);
+	Assert(NULL != store->shmref || NULL != store->plobfile);
 	
 	store->first_ondisk_blockn = 0;
 	store->rwflag = NTS_IS_READER;
@@ -875,7 +967,16 @@ ntuplestore_flush(NTupleStore *ts)
 	NTupleStorePage *p = ts->first_page;
 
 	Assert(ts->rwflag != NTS_IS_READER || !"Flush attempted for Reader");
-	Assert(ts->pfile);
+
+	if(!ts->pfile)
+	{
+		/* Never spilled: hand the pages over in memory if they fit */
+		Assert(ts->rwfilename);
+		if(ntuplestore_publish_shmem(ts))
+			return;
+
+		ntuplestore_create_rw_files(ts);
+	}
 
 	while(p)
 	{
@@ -969,6 +1070,10 @@ static long ntuplestore_put_lob(NTupleStore *nts, char* data, NTupleStoreLobRef
 			/* We have a usable workfile_set. Use that to generate temp files */
 			ntuplestore_create_spill_files(nts);
 		}
+		else if (nts->rwfilename != NULL)
+		{
+			ntuplestore_create_rw_files(nts);
+		}
 		else
 		{
 			char tmpprefix[MAXPGPATH];
@@ -1424,4 +1529,306 @@ ntuplestore_create_spill_files(NTupleStore *nts)
 	MemoryContextSwitchTo(oldcxt);
 }
 
+/*
+ * Create the files of a readerwriter writer, once it spills or cannot be
+ * published to shared memory.
+ */
+static void
+ntuplestore_create_rw_files(NTupleStore *nts)
+{
+	char filenamelob[MAXPGPATH];
+	MemoryContext oldcxt;
+
+	Assert(nts->rwflag == NTS_IS_WRITER && nts->rwfilename != NULL);
+	Assert(nts->pfile == NULL && nts->plobfile == NULL);
+
+	snprintf(filenamelob, sizeof(filenamelob), "%s_LOB", nts->rwfilename);
+
+	oldcxt = MemoryContextSwitchTo(nts->mcxt);
+
+	nts->pfile = ExecWorkFile_Create(nts->rwfilename, BUFFILE,
+			true /*delOnClose */, 0 /* compressType */);
+	nts->plobfile = ExecWorkFile_Create(filenamelob, BUFFILE,
+			true /* delOnClose */, 0 /* compressType */ );
+
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * Shared memory of the readerwriter page pool, gp_shareinput_shmem_size KB
+ * of pages and an entry per backend.
+ */
+static int
+ntuplestore_shmem_pages(void)
+{
+	return (int) (((int64) gp_shareinput_shmem_size * 1024) / BLCKSZ);
+}
+
+Size
+NTupleStoreShmemSize(void)
+{
+	Size		size;
+	int			npages = ntuplestore_shmem_pages();
+
+	if (npages <= 0)
+		return 0;
+
+	size = offsetof(NTupleStoreShmHeader, entries);
+	size = add_size(size, mul_size(MaxBackends, sizeof(NTupleStoreShmEntry)));
+	size = MAXALIGN(size);
+	size = add_size(size, mul_size(npages, sizeof(int)));
+	size = MAXALIGN(size);
+	size = add_size(size, mul_size(npages, sizeof(NTupleStorePage)));
+
+	return size;
+}
+
+void
+NTupleStoreShmemInit(void)
+{
+	Size		size = NTupleStoreShmemSize();
+	int			npages = ntuplestore_shmem_pages();
+	char	   *p;
+	bool		found;
+	int			i;
+
+	if (size == 0)
+		return;
+
+	ntsShm = (NTupleStoreShmHeader *)
+		ShmemInitStruct("ShareInput Tuplestore Pages", size, &found);
+
+	p = (char *) ntsShm;
+	p += MAXALIGN(offsetof(NTupleStoreShmHeader, entries) +
+				  MaxBackends * sizeof(NTupleStoreShmEntry));
+	ntsShmNextPage = (int *) p;
+	p += MAXALIGN(npages * sizeof(int));
+	ntsShmPages = (NTupleStorePage *) p;
+
+	if (found)
+		return;
+
+	ntsShm->nentries = MaxBackends;
+	ntsShm->npages = npages;
+	ntsShm->nfree_pages = npages;
+	ntsShm->first_free_page = 0;
+
+	for (i = 0; i < MaxBackends; i++)
+	{
+		ntsShm->entries[i].name[0] = '\0';
+		ntsShm->entries[i].refcnt = 0;
+		ntsShm->entries[i].npages = 0;
+		ntsShm->entries[i].first_page = -1;
+	}
+
+	for (i = 0; i < npages; i++)
+		ntsShmNextPage[i] = (i + 1 < npages) ? i + 1 : -1;
+}
+
+static void
+XCallBack_NTupleStore_Shmem(XactEvent ev, void *vp)
+{
+	ntuplestore_release_shmem((NTupleStoreShmRef *) vp);
+}
+
+static NTupleStoreShmRef *
+ntuplestore_new_shmref(int entry, int npages)
+{
+	NTupleStoreShmRef *ref;
+
+	ref = (NTupleStoreShmRef *) MemoryContextAlloc(TopMemoryContext, sizeof(NTupleStoreShmRef));
+	ref->entry = entry;
+	ref->npages = npages;
+	ref->pages = NULL;
+
+	/* Let go of the entry at end of transaction if the store is not destroyed */
+	RegisterXactCallbackOnce(XCallBack_NTupleStore_Shmem, ref);
+
+	return ref;
+}
+
+/*
+ * Copy the pages of a writer that never spilled into the shared pool.
+ * Returns false, publishing nothing, if the pool has no room for them.
+ */
+static bool
+ntuplestore_publish_shmem(NTupleStore *nts)
+{
+	NTupleStoreShmEntry *e = NULL;
+	NTupleStorePage *p;
+	int			npages = 0;
+	int			entry;
+	int			pagen;
+	int			i;
+
+	Assert(nts->rwflag == NTS_IS_WRITER && nts->pfile == NULL);
+	Assert(nts->lobbytes == 0 && nts->shmref == NULL);
+
+	if (ntsShm == NULL || strlen(nts->rwfilename) >= NTS_SHM_NAMELEN)
+		return false;
+
+	for (p = nts->first_page; p != NULL && nts_page_slot_cnt(p) > 0; p = nts_page_next(p))
+	{
+		Assert(nts_page_blockn(p) == npages);
+		npages++;
+	}
+
+	LWLockAcquire(ShareInputShmemLock, LW_EXCLUSIVE);
+
+	for (entry = 0; entry < ntsShm->nentries; entry++)
+	{
+		if (ntsShm->entries[entry].refcnt == 0)
+		{
+			e = &ntsShm->entries[entry];
+			break;
+		}
+	}
+
+	if (e == NULL || npages > ntsShm->nfree_pages)
+	{
+		LWLockRelease(ShareInputShmemLock);
+		return false;
+	}
+
+	/* Take the pages off the free list, still unnamed so nobody finds them */
+	e->refcnt = 1;
+	e->npages = npages;
+	e->first_page = npages > 0 ? ntsShm->first_free_page : -1;
+	e->name[0] = '\0';
+
+	pagen = ntsShm->first_free_page;
+	for (i = 0; i < npages; i++)
+	{
+		if (i == npages - 1)
+		{
+			ntsShm->first_free_page = ntsShmNextPage[pagen];
+			ntsShmNextPage[pagen] = -1;
+		}
+		else
+			pagen = ntsShmNextPage[pagen];
+	}
+	ntsShm->nfree_pages -= npages;
+
+	LWLockRelease(ShareInputShmemLock);
+
+	pagen = e->first_page;
+	for (p = nts->first_page; p != NULL && nts_page_slot_cnt(p) > 0; p = nts_page_next(p))
+	{
+		NTupleStorePage *shmpage = &ntsShmPages[pagen];
+
+		memcpy(shmpage, p, BLCKSZ);
+		nts_page_set_dirty(shmpage, false);
+		pagen = ntsShmNextPage[pagen];
+	}
+
+	LWLockAcquire(ShareInputShmemLock, LW_EXCLUSIVE);
+
+	/* A store of an earlier run of this share can't be found anymore */
+	for (i = 0; i < ntsShm->nentries; i++)
+	{
+		if (strcmp(ntsShm->entries[i].name, nts->rwfilename) == 0)
+			ntsShm->entries[i].name[0] = '\0';
+	}
+	strlcpy(e->name, nts->rwfilename, NTS_SHM_NAMELEN);
+
+	LWLockRelease(ShareInputShmemLock);
+
+	nts->shmref = ntuplestore_new_shmref(entry, npages);
+
+	elog(DEBUG1, "ntuplestore %s published %d pages to shared memory",
+		 nts->rwfilename, npages);
+
+	SIMPLE_FAULT_INJECTOR(ShareInputShmemPublish);
+
+	return true;
+}
+
+/*
+ * Attach a reader to the published store of the given name, if any.
+ */
+static NTupleStoreShmRef *
+ntuplestore_attach_shmem(const char *name)
+{
+	NTupleStoreShmRef *ref;
+	int			entry;
+	int			pagen;
+	int			i;
+
+	if (ntsShm == NULL || strlen(name) >= NTS_SHM_NAMELEN)
+		return NULL;
+
+	LWLockAcquire(ShareInputShmemLock, LW_EXCLUSIVE);
+
+	for (entry = 0; entry < ntsShm->nentries; entry++)
+	{
+		if (ntsShm->entries[entry].refcnt > 0 &&
+			strcmp(ntsShm->entries[entry].name, name) == 0)
+			break;
+	}
+
+	if (entry == ntsShm->nentries)
+	{
+		LWLockRelease(ShareInputShmemLock);
+		return NULL;
+	}
+
+	ntsShm->entries[entry].refcnt++;
+
+	LWLockRelease(ShareInputShmemLock);
+
+	/* The page chain does not change while we hold a reference */
+	ref = ntuplestore_new_shmref(entry, ntsShm->entries[entry].npages);
+	ref->pages = (NTupleStorePage **)
+		MemoryContextAlloc(TopMemoryContext, Max(ref->npages, 1) * sizeof(NTupleStorePage *));
+
+	pagen = ntsShm->entries[entry].first_page;
+	for (i = 0; i < ref->npages; i++)
+	{
+		ref->pages[i] = &ntsShmPages[pagen];
+		pagen = ntsShmNextPage[pagen];
+	}
+
+	SIMPLE_FAULT_INJECTOR(ShareInputShmemAttach);
+
+	return ref;
+}
+
+/*
+ * Drop a reference to a published store.  The last one returns its pages to
+ * the free list.
+ */
+static void
+ntuplestore_release_shmem(NTupleStoreShmRef *ref)
+{
+	NTupleStoreShmEntry *e = &ntsShm->entries[ref->entry];
+
+	LWLockAcquire(ShareInputShmemLock, LW_EXCLUSIVE);
+
+	Assert(e->refcnt > 0);
+	if (--e->refcnt == 0)
+	{
+		if (e->npages > 0)
+		{
+			int			last = e->first_page;
+
+			while (ntsShmNextPage[last] != -1)
+				last = ntsShmNextPage[last];
+
+			ntsShmNextPage[last] = ntsShm->first_free_page;
+			ntsShm->first_free_page = e->first_page;
+			ntsShm->nfree_pages += e->npages;
+		}
+
+		e->name[0] = '\0';
+		e->npages = 0;
+		e->first_page = -1;
+	}
+
+	LWLockRelease(ShareInputShmemLock);
+
+	if (ref->pages)
+		pfree(ref->pages);
+	pfree(ref);
+}
+
 /* EOF */
@@ -0,0 +1,586 @@
+/*-------------------------------------------------------------------------
+ *
+ * workfile_cache.c
+ *	 Reuse of spilled operator results across queries.
+ *
+ * An operator that had to spill to compute its result can record its output
+ * tuples in a reusable workfile set. Once complete, the set is inserted in
+ * the workfile manager cache under a key made of a fingerprint of the plan
+ * subtree and a fingerprint of the relations it read. A later query running
+ * the same subtree over unchanged relations replays the cached tuples
+ * instead of executing the subtree.
+ *
+ * Only subtrees whose output is a function of the contents of the
+ * append-only relations they scan are eligible: no motions, parameters,
+ * subplans or mutable functions. Append-only relations change only through
+ * their aoseg and visimap auxiliary tables (or a new relfilenode), so the
+ * tuples of those tables visible to the query snapshot identify the data.
+ * Changes made by the current transaction are not committed yet and may be
+ * rolled back, so a query that sees any is neither stored nor looked up.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/utils/workfile_manager/workfile_cache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/heapam.h"
+#include "access/xact.h"
+#include "catalog/pg_appendonly_fn.h"
+#include "cdb/cdbllize.h"
+#include "cdb/cdbvars.h"
+#include "miscadmin.h"
+#include "optimizer/clauses.h"
+#include "optimizer/walkers.h"
+#include "parser/parsetree.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/tqual.h"
+#include "utils/workfile_mgr.h"
+
+/* Number of the file holding the result tuples in a result set */
+#define WORKFILE_NUM_RESULT_DATA 1
+
+/* 64-bit FNV-1a parameters used for the fingerprints */
+#define WORKFILE_FINGERPRINT_INIT UINT64CONST(0xcbf29ce484222325)
+#define WORKFILE_FINGERPRINT_PRIME UINT64CONST(0x100000001b3)
+
+/*
+ * A cached set being replayed. Readers are kept in TopMemoryContext and
+ * released through the ResourceOwner mechanism on abort, since cached sets
+ * are shared and not on the creator's list of open sets.
+ */
+typedef struct workfile_result_reader
+{
+	workfile_set *work_set;
+	ExecWorkFile *file;
+	ResourceOwner owner;
+	struct workfile_result_reader *next;
+	struct workfile_result_reader *prev;
+} workfile_result_reader;
+
+struct workfile_result
+{
+	/* Operator whose output is cached */
+	PlanState *ps;
+
+	/* Whether the operator's subtree can be cached, and under which key */
+	bool eligible;
+	workfile_set_hashkey_t key;
+
+	/* Set and file being written while recording a new result */
+	workfile_set *write_set;
+	ExecWorkFile *write_file;
+
+	/* Cached result being replayed */
+	workfile_result_reader *reader;
+
+	/* Buffer for tuples read back from a cached result */
+	char *buf;
+	uint32 buflen;
+};
+
+typedef struct workfile_result_walker_context
+{
+	plan_tree_base_prefix base; /* Required prefix for plan_tree_walker */
+	List	   *rtable;
+	List	   *relids;
+} workfile_result_walker_context;
+
+static workfile_result_reader *open_readers = NULL;
+static bool readers_resowner_callback_registered = false;
+
+static bool workfile_result_compute_key(PlanState *ps, workfile_set_hashkey_t *key);
+static bool workfile_result_walker(Node *node, workfile_result_walker_context *ctx);
+static bool workfile_result_fingerprint_relation(Oid relid, Snapshot snapshot, uint64 *fp);
+static bool workfile_result_fingerprint_tuples(Oid relid, Snapshot snapshot, uint64 *fp);
+static void workfile_result_close_reader(workfile_result_reader *reader);
+
+static inline uint64
+workfile_fingerprint(uint64 fp, const void *data, Size len)
+{
+	const unsigned char *p = (const unsigned char *) data;
+
+	for (Size i = 0; i < len; i++)
+	{
+		fp ^= p[i];
+		fp *= WORKFILE_FINGERPRINT_PRIME;
+	}
+	return fp;
+}
+
+static void
+workfile_result_reader_free_callback(ResourceReleasePhase phase,
+					 bool isCommit,
+					 bool isTopLevel,
+					 void *arg)
+{
+	workfile_result_reader *curr;
+	workfile_result_reader *next;
+
+	if (phase != RESOURCE_RELEASE_AFTER_LOCKS)
+		return;
+
+	next = open_readers;
+	while (next)
+	{
+		curr = next;
+		next = curr->next;
+
+		if (curr->owner == CurrentResourceOwner)
+		{
+			if (isCommit)
+				elog(WARNING, "workfile result reference leak: %p still referenced", curr);
+			workfile_result_close_reader(curr);
+		}
+	}
+}
+
+/*
+ * Set up result caching for an operator.
+ *
+ * The cache key is computed here, once per execution of the plan. The
+ * returned state is allocated in the current memory context.
+ */
+workfile_result *
+workfile_result_create(PlanState *ps)
+{
+	Assert(NULL != ps);
+
+	workfile_result *result = (workfile_result *) palloc0(sizeof(workfile_result));
+	result->ps = ps;
+	result->eligible = workfile_result_compute_key(ps, &result->key);
+
+	elog(gp_workfile_caching_loglevel, "workfile result caching %s, key=" UINT64_FORMAT "/" UINT64_FORMAT,
+		 result->eligible ? "enabled" : "not possible",
+		 result->key.plan, result->key.inputs);
+
+	return result;
+}
+
+/*
+ * Look for a cached result. On a hit, the result is opened for replay with
+ * workfile_result_get and true is returned.
+ */
+bool
+workfile_result_lookup(workfile_result *result)
+{
+	Assert(NULL != result);
+	Assert(NULL == result->reader && NULL == result->write_set);
+
+	if (!result->eligible)
+	{
+		return false;
+	}
+
+	workfile_set *work_set = workfile_mgr_lookup_set(&result->key);
+	if (NULL == work_set)
+	{
+		return false;
+	}
+
+	if (!readers_resowner_callback_registered)
+	{
+		RegisterResourceReleaseCallback(workfile_result_reader_free_callback, NULL);
+		readers_resowner_callback_registered = true;
+	}
+
+	MemoryContext oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+
+	workfile_result_reader *reader = (workfile_result_reader *) palloc0(sizeof(workfile_result_reader));
+	reader->work_set = work_set;
+	reader->owner = CurrentResourceOwner;
+
+	PG_TRY();
+	{
+		reader->file = workfile_mgr_open_fileno(work_set, WORKFILE_NUM_RESULT_DATA);
+	}
+	PG_CATCH();
+	{
+		workfile_mgr_release_set(work_set);
+		pfree(reader);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	MemoryContextSwitchTo(oldcxt);
+
+	reader->next = open_readers;
+	if (open_readers)
+		open_readers->prev = reader;
+	open_readers = reader;
+
+	result->reader = reader;
+	return true;
+}
+
+/*
+ * Start recording the output of the operator into a new reusable set.
+ */
+void
+workfile_result_begin_write(workfile_result *result)
+{
+	Assert(NULL != result);
+	Assert(NULL == result->reader && NULL == result->write_set);
+
+	if (!result->eligible)
+	{
+		return;
+	}
+
+	result->write_set = workfile_mgr_create_set(BUFFILE, true /* can_be_reused */, result->ps);
+	result->write_file = workfile_mgr_create_fileno(result->write_set, WORKFILE_NUM_RESULT_DATA);
+}
+
+/*
+ * Record an output tuple of the operator, if a result is being written.
+ */
+void
+workfile_result_put(workfile_result *result, TupleTableSlot *slot)
+{
+	Assert(NULL != result);
+
+	if (NULL == result->write_file)
+	{
+		return;
+	}
+
+	/* Toasted values are inlined so that the result stands on its own */
+	MemTuple tuple = ExecFetchSlotMemTuple(slot, true /* inline_toast */);
+	uint32 len = memtuple_get_size(tuple);
+
+	if (!ExecWorkFile_Write(result->write_file, &len, sizeof(len)) ||
+		!ExecWorkFile_Write(result->write_file, tuple, len))
+	{
+		workfile_mgr_report_error();
+	}
+}
+
+/*
+ * Return the next tuple of the cached result being replayed, or NULL at the
+ * end of it. The tuple stays valid until the next call.
+ */
+TupleTableSlot *
+workfile_result_get(workfile_result *result, TupleTableSlot *slot)
+{
+	Assert(NULL != result && NULL != result->reader);
+
+	ExecWorkFile *file = result->reader->file;
+	uint32 len;
+
+	uint64 nread = ExecWorkFile_Read(file, &len, sizeof(len));
+	if (0 == nread)
+	{
+		ExecClearTuple(slot);
+		return NULL;
+	}
+
+	if (nread != sizeof(len))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg("unexpected end of cached workfile \"%s\"",
+						ExecWorkFile_GetFileName(file))));
+	}
+
+	if (len > result->buflen)
+	{
+		if (NULL != result->buf)
+			pfree(result->buf);
+		result->buf = MemoryContextAlloc(result->ps->state->es_query_cxt, len);
+		result->buflen = len;
+	}
+
+	if (ExecWorkFile_Read(file, result->buf, len) != len)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg("unexpected end of cached workfile \"%s\"",
+						ExecWorkFile_GetFileName(file))));
+	}
+
+	return ExecStoreMinimalTuple((MemTuple) result->buf, slot, false /* shouldFree */);
+}
+
+/*
+ * The operator produced all of its output. Insert the recorded result in
+ * the cache for later queries.
+ */
+void
+workfile_result_finish(workfile_result *result)
+{
+	Assert(NULL != result);
+
+	if (NULL == result->write_set)
+	{
+		return;
+	}
+
+	workfile_set *work_set = result->write_set;
+
+	workfile_mgr_close_file(work_set, result->write_file);
+	result->write_file = NULL;
+
+	workfile_mgr_insert_set(work_set, &result->key);
+
+	result->write_set = NULL;
+	workfile_mgr_close_set(work_set);
+}
+
+/*
+ * Close any result being written or replayed. A result that was not
+ * finished is discarded.
+ */
+void
+workfile_result_close(workfile_result *result)
+{
+	Assert(NULL != result);
+
+	if (NULL != result->reader)
+	{
+		workfile_result_close_reader(result->reader);
+		result->reader = NULL;
+	}
+
+	if (NULL != result->write_set)
+	{
+		workfile_set *work_set = result->write_set;
+
+		if (NULL != result->write_file)
+		{
+			workfile_mgr_close_file(work_set, result->write_file);
+			result->write_file = NULL;
+		}
+
+		result->write_set = NULL;
+		workfile_mgr_close_set(work_set);
+	}
+}
+
+/*
+ * Close and free the result caching state of an operator.
+ */
+void
+workfile_result_free(workfile_result *result)
+{
+	Assert(NULL != result);
+
+	workfile_result_close(result);
+
+	if (NULL != result->buf)
+		pfree(result->buf);
+	pfree(result);
+}
+
+static void
+workfile_result_close_reader(workfile_result_reader *reader)
+{
+	if (reader->prev)
+		reader->prev->next = reader->next;
+	else
+		open_readers = reader->next;
+	if (reader->next)
+		reader->next->prev = reader->prev;
+
+	workfile_mgr_close_file(reader->work_set, reader->file);
+	workfile_mgr_release_set(reader->work_set);
+	pfree(reader);
+}
+
+/*
+ * Compute the cache key of the result of a plan subtree.
+ *
+ * Returns false if the result of the subtree cannot be cached.
+ */
+static bool
+workfile_result_compute_key(PlanState *ps, workfile_set_hashkey_t *key)
+{
+	EState	   *estate = ps->state;
+	workfile_result_walker_context ctx;
+	ListCell   *lc;
+
+	MemSet(key, 0, sizeof(*key));
+
+	if (!IsMVCCSnapshot(estate->es_snapshot))
+	{
+		return false;
+	}
+
+	exec_init_plan_tree_base(&ctx.base, estate->es_plannedstmt);
+	ctx.rtable = estate->es_range_table;
+	ctx.relids = NIL;
+
+	if (workfile_result_walker((Node *) ps->plan, &ctx) || NIL == ctx.relids)
+	{
+		list_free(ctx.relids);
+		return false;
+	}
+
+	char *plan_str = nodeToString(ps->plan);
+	uint64 plan_fp = WORKFILE_FINGERPRINT_INIT;
+	plan_fp = workfile_fingerprint(plan_fp, &MyDatabaseId, sizeof(MyDatabaseId));
+	plan_fp = workfile_fingerprint(plan_fp, plan_str, strlen(plan_str));
+	pfree(plan_str);
+
+	uint64 inputs_fp = WORKFILE_FINGERPRINT_INIT;
+	foreach(lc, ctx.relids)
+	{
+		if (!workfile_result_fingerprint_relation(lfirst_oid(lc), estate->es_snapshot, &inputs_fp))
+		{
+			list_free(ctx.relids);
+			return false;
+		}
+	}
+	list_free(ctx.relids);
+
+	key->plan = plan_fp;
+	key->inputs = inputs_fp;
+	return true;
+}
+
+/*
+ * Collect the relations scanned by a plan subtree. Returns true, ending the
+ * walk, if the output of the subtree may depend on anything else than the
+ * contents of those relations.
+ */
+static bool
+workfile_result_walker(Node *node, workfile_result_walker_context *ctx)
+{
+	if (NULL == node)
+		return false;
+
+	if (is_plan_node(node))
+	{
+		switch (nodeTag(node))
+		{
+			case T_SeqScan:
+			case T_AppendOnlyScan:
+			case T_AOCSScan:
+			case T_TableScan:
+				{
+					RangeTblEntry *rte = rt_fetch(((Scan *) node)->scanrelid, ctx->rtable);
+
+					ctx->relids = list_append_unique_oid(ctx->relids, rte->relid);
+					break;
+				}
+
+			case T_Sort:
+			case T_Material:
+				/* A shared producer also feeds ShareInputScans outside the subtree */
+				if (get_plan_share_type((Plan *) node) != SHARE_NOTSHARED)
+					return true;
+				break;
+
+			case T_Agg:
+			case T_Hash:
+			case T_HashJoin:
+			case T_MergeJoin:
+			case T_NestLoop:
+			case T_Result:
+			case T_Append:
+			case T_SubqueryScan:
+			case T_Limit:
+			case T_Unique:
+				break;
+
+			default:
+				/* Motions, external and function scans, ... */
+				return true;
+		}
+
+		return plan_tree_walker(node, workfile_result_walker, ctx);
+	}
+
+	if (IsA(node, Param) || IsA(node, SubPlan))
+		return true;
+
+	if (!IsA(node, List) && !IsA(node, Flow) && contain_mutable_functions(node))
+		return true;
+
+	return plan_tree_walker(node, workfile_result_walker, ctx);
+}
+
+/*
+ * Add the identity and the current contents of an append-only relation to a
+ * fingerprint. Returns false if the relation is not append-only, or if the
+ * current transaction changed it.
+ */
+static bool
+workfile_result_fingerprint_relation(Oid relid, Snapshot snapshot, uint64 *fp)
+{
+	Relation	rel;
+	Oid			segrelid;
+	Oid			visimaprelid;
+
+	rel = heap_open(relid, AccessShareLock);
+	if ((!RelationIsAoRows(rel) && !RelationIsAoCols(rel)) ||
+		rel->rd_createSubid != InvalidSubTransactionId ||
+		rel->rd_newRelfilenodeSubid != InvalidSubTransactionId)
+	{
+		heap_close(rel, AccessShareLock);
+		return false;
+	}
+
+	*fp = workfile_fingerprint(*fp, &relid, sizeof(relid));
+	*fp = workfile_fingerprint(*fp, &rel->rd_node, sizeof(rel->rd_node));
+	heap_close(rel, AccessShareLock);
+
+	GetAppendOnlyEntryAuxOids(relid, snapshot,
+							  &segrelid, NULL, NULL,
+							  &visimaprelid, NULL);
+
+	return workfile_result_fingerprint_tuples(segrelid, snapshot, fp) &&
+		workfile_result_fingerprint_tuples(visimaprelid, snapshot, fp);
+}
+
+/*
+ * Add the tuples of a relation visible to a snapshot to a fingerprint: their
+ * inserting transaction, their location and their contents. The inserting
+ * transaction tells apart versions of a row that happen to hold the same
+ * values. Other header fields are left out, so that hint bits do not change
+ * the fingerprint. Returns false if a visible tuple was inserted or deleted
+ * by the current transaction.
+ */
+static bool
+workfile_result_fingerprint_tuples(Oid relid, Snapshot snapshot, uint64 *fp)
+{
+	Relation	rel;
+	HeapScanDesc scan;
+	HeapTuple	tuple;
+	bool		result = true;
+
+	rel = heap_open(relid, AccessShareLock);
+	scan = heap_beginscan(rel, snapshot, 0, NULL);
+
+	while ((tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		Size		off = offsetof(HeapTupleHeaderData, t_bits);
+		int			natts = HeapTupleHeaderGetNatts(tuple->t_data);
+		TransactionId xmin = HeapTupleHeaderGetXmin(tuple->t_data);
+
+		if (TransactionIdIsCurrentTransactionId(xmin) ||
+			(!(tuple->t_data->t_infomask & (HEAP_XMAX_INVALID | HEAP_XMAX_IS_MULTI)) &&
+			 TransactionIdIsCurrentTransactionId(HeapTupleHeaderGetXmax(tuple->t_data))))
+		{
+			result = false;
+			break;
+		}
+
+		*fp = workfile_fingerprint(*fp, &xmin, sizeof(xmin));
+		*fp = workfile_fingerprint(*fp, &tuple->t_self, sizeof(tuple->t_self));
+		*fp = workfile_fingerprint(*fp, &natts, sizeof(natts));
+		*fp = workfile_fingerprint(*fp, (char *) tuple->t_data + off, tuple->t_len - off);
+	}
+
+	heap_endscan(scan);
+	heap_close(rel, AccessShareLock);
+
+	return result;
+}
+
+/* EOF */
@@ -20,6 +20,7 @@
 #include "utils/workfile_mgr.h"
 
 static void retrieve_file_no(workfile_set *work_set, uint32 file_no, char *workfile_name, uint32 workfile_name_len);
+static void build_file_name(workfile_set *work_set, uint32 file_no, char *workfile_name, uint32 workfile_name_len);
 static void update_workset_size(workfile_set *work_set, bool delOnClose, bool created, int64 size);
 static void adjust_size_temp_file_new(workfile_set *work_set, int64 size);
 static void adjust_size_persistent_file_new(workfile_set *work_set, int64 size);
@@ -55,7 +56,7 @@ workfile_mgr_create_fileno(workfile_set *work_set, uint32 file_no)
 
 	ExecWorkFile *ewfile = ExecWorkFile_Create(file_name,
 			work_set->metadata.type,
-			true /* del_on_close */,
+			!work_set->can_be_reused /* del_on_close */,
 			work_set->metadata.bfz_compress_type);
 
 	SIMPLE_FAULT_INJECTOR(WorkfileCreationFail);
@@ -65,6 +66,25 @@ workfile_mgr_create_fileno(workfile_set *work_set, uint32 file_no)
 	return ewfile;
 }
 
+/*
+ * Opens an existing numbered workfile of a cached set for reading
+ */
+ExecWorkFile *
+workfile_mgr_open_fileno(workfile_set *work_set, uint32 file_no)
+{
+	Assert(NULL != work_set);
+	Assert(Cache_IsCached(CACHE_ENTRY_HEADER(work_set)));
+	Assert(file_no < work_set->no_files);
+
+	char file_name[MAXPGPATH];
+	build_file_name(work_set, file_no, file_name, sizeof(file_name));
+
+	return ExecWorkFile_Open(file_name,
+			work_set->metadata.type,
+			false /* del_on_close */,
+			work_set->metadata.bfz_compress_type);
+}
+
 /*
  * Closes a given workfile and updates the diskspace accordingly
  *
@@ -231,6 +251,29 @@ retrieve_file_no(workfile_set *work_set, uint32 file_no, char *workfile_name, ui
 		work_set->no_files = file_no + 1;
 
 	}
-	snprintf(workfile_name, workfile_name_len,
+	build_file_name(work_set, file_no, workfile_name, workfile_name_len);
+}
+
+/*
+ *  Generates the name of the file_no file in the workset.
+ *
+ *  workfile_name is allocated by the caller. An error is raised if the
+ *  name does not fit in it.
+ */
+static void
+build_file_name(workfile_set *work_set, uint32 file_no, char *workfile_name, uint32 workfile_name_len)
+{
+	Assert(work_set);
+	Assert(workfile_name);
+
+	int len = snprintf(workfile_name, workfile_name_len,
 			"%s/spillfile_f%u", work_set->path, file_no);
+
+	if (len < 0 || (uint32) len >= workfile_name_len)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("workfile name is too long: \"%s/spillfile_f%u\"",
+						work_set->path, file_no)));
+	}
 }
@@ -38,6 +38,7 @@ typedef struct workset_info
 	TimestampTz session_start_time;
 	uint64 operator_work_mem;
 	char *dir_path;
+	bool can_be_reused;
 } workset_info;
 
 /* Counter to keep track of workfile segspace used without a workfile set. */
@@ -51,6 +52,7 @@ static void workfile_mgr_unlink_directory(const char *dirpath);
 static const char *get_name_from_nodeType(const NodeTag node_type);
 static uint64 get_operator_work_mem(PlanState *ps);
 static char *create_workset_directory(NodeTag node_type, int slice_id);
+static bool workfile_mgr_evict_lru(void);
 
 static workfile_set *open_workfile_sets = NULL;
 static bool workfile_sets_resowner_callback_registered = false;
@@ -106,7 +108,7 @@ workfile_mgr_cache_init(void)
 	cacheCtl.keySize = sizeof(((workfile_set *)0)->key);
 	cacheCtl.keyOffset = GPDB_OFFSET(workfile_set, key);
 
-	cacheCtl.hash = int32_hash;
+	cacheCtl.hash = tag_hash;
 	cacheCtl.keyCopy = (HashCopyFunc) memcpy;
 	cacheCtl.match = (HashCompareFunc) memcmp;
 	cacheCtl.cleanupEntry = workfile_mgr_cleanup_set;
@@ -180,7 +182,8 @@ get_name_from_nodeType(const NodeTag node_type)
  *   type is the WorkFileType for the files: BUFFILE or BFZ
  *   can_be_reused: if set to false, then we don't insert this set into the cache,
  *     since the caller is telling us there is no point. This can happen for
- *     example when spilling during index creation.
+ *     example when spilling during index creation. Files of a reusable set
+ *     are not deleted when closed, only when the whole set is dropped.
  *   ps is the PlanState for the subtree rooted at the operator
  *   snapshot contains snapshot information for the current transaction
  *
@@ -219,9 +222,16 @@ workfile_mgr_create_set(enum ExecWorkFileType type, bool can_be_reused, PlanStat
 	set_info.dir_path = dir_path;
 	set_info.session_start_time = GetCurrentTimestamp();
 	set_info.operator_work_mem = get_operator_work_mem(ps);
+	set_info.can_be_reused = can_be_reused;
 
 	CacheEntry *newEntry = Cache_AcquireEntry(workfile_mgr_cache, &set_info);
 
+	/* Cached sets hold on to entries; make room before giving up */
+	while (NULL == newEntry && workfile_mgr_evict_lru())
+	{
+		newEntry = Cache_AcquireEntry(workfile_mgr_cache, &set_info);
+	}
+
 	if (NULL == newEntry)
 	{
 		/* Clean up the directory we created. */
@@ -240,8 +250,8 @@ workfile_mgr_create_set(enum ExecWorkFileType type, bool can_be_reused, PlanStat
 	workfile_set *work_set = CACHE_ENTRY_PAYLOAD(newEntry);
 	Assert(work_set != NULL);
 
-	elog(gp_workfile_caching_loglevel, "new spill file set. key=0x%x prefix=%s opMemKB=" INT64_FORMAT,
-			work_set->key, work_set->path, work_set->metadata.operator_work_mem);
+	elog(gp_workfile_caching_loglevel, "new spill file set. prefix=%s opMemKB=" INT64_FORMAT,
+			work_set->path, work_set->metadata.operator_work_mem);
 
 	return work_set;
 }
@@ -311,9 +321,13 @@ workfile_mgr_populate_set(const void *resource, const void *param)
 
 	work_set->metadata.operator_work_mem = set_info->operator_work_mem;
 
+	MemSet(&work_set->key, 0, sizeof(work_set->key));
+	work_set->can_be_reused = set_info->can_be_reused;
+
 	work_set->no_files = 0;
 	work_set->size = 0L;
 	work_set->in_progress_size = 0L;
+	work_set->uncompressed_size = 0L;
 	work_set->node_type = set_info->nodeType;
 	work_set->metadata.type = set_info->file_type;
 	work_set->metadata.bfz_compress_type = gp_workfile_compress_algorithm;
@@ -321,6 +335,7 @@ workfile_mgr_populate_set(const void *resource, const void *param)
 	work_set->session_id = gp_session_id;
 	work_set->command_count = gp_command_count;
 	work_set->session_start_time = set_info->session_start_time;
+	work_set->last_used = set_info->session_start_time;
 
 	work_set->owner = CurrentResourceOwner;
 	work_set->next = open_workfile_sets;
@@ -401,9 +416,10 @@ workfile_mgr_cleanup_set(const void *resource)
 	workfile_set *work_set = (workfile_set *) resource;
 
 	ereport(gp_workfile_caching_loglevel,
-			(errmsg("workfile mgr cleanup deleting set: key=0x%0xd, size=" INT64_FORMAT
-					" in_progress_size=" INT64_FORMAT " path=%s",
-					work_set->key,
+			(errmsg("workfile mgr cleanup deleting set: key=" UINT64_FORMAT "/" UINT64_FORMAT
+					", size=" INT64_FORMAT " in_progress_size=" INT64_FORMAT " path=%s",
+					work_set->key.plan,
+					work_set->key.inputs,
 					work_set->size,
 					work_set->in_progress_size,
 					work_set->path),
@@ -449,14 +465,161 @@ workfile_mgr_close_set(workfile_set *work_set)
 		work_set->next->prev = work_set->prev;
 
 	elog(gp_workfile_caching_loglevel, "closing workfile set: location: %s, size=" INT64_FORMAT
-			" in_progress_size=" INT64_FORMAT,
+			" in_progress_size=" INT64_FORMAT " uncompressed_size=" INT64_FORMAT,
 		 work_set->path,
-		 work_set->size, work_set->in_progress_size);
+		 work_set->size, work_set->in_progress_size,
+		 work_set->uncompressed_size);
 
 	CacheEntry *cache_entry = CACHE_ENTRY_HEADER(work_set);
 	Cache_Release(workfile_mgr_cache, cache_entry);
 }
 
+/*
+ * Look up a completed workfile set in the cache.
+ *
+ * The set is returned pinned and must be given back with
+ * workfile_mgr_release_set. Returns NULL if there is no such set.
+ */
+workfile_set *
+workfile_mgr_lookup_set(workfile_set_hashkey_t *key)
+{
+	Assert(NULL != workfile_mgr_cache);
+
+	CacheEntry *entry = Cache_Lookup(workfile_mgr_cache, key);
+	if (NULL == entry)
+	{
+		return NULL;
+	}
+
+	workfile_set *work_set = CACHE_ENTRY_PAYLOAD(entry);
+
+	/* Racy, but only used to pick eviction victims */
+	work_set->last_used = GetCurrentTimestamp();
+
+	elog(gp_workfile_caching_loglevel, "workfile set cache hit: path=%s size=" INT64_FORMAT,
+		 work_set->path, work_set->size);
+
+	return work_set;
+}
+
+/*
+ * Insert a completed workfile set in the cache under the given key, so that
+ * later queries computing the same result can read it back.
+ *
+ * All files of the set must be closed. Least recently used sets are evicted
+ * to keep the cache within gp_workfile_cache_size. Returns false, leaving
+ * the set to be deleted when it is closed, if it does not fit or an equal
+ * set is already cached. Either way the caller still closes the set.
+ */
+bool
+workfile_mgr_insert_set(workfile_set *work_set, workfile_set_hashkey_t *key)
+{
+	Assert(NULL != work_set);
+	Assert(work_set->can_be_reused);
+
+	CacheEntry *entry = CACHE_ENTRY_HEADER(work_set);
+	Assert(CACHE_ENTRY_ACQUIRED == entry->state);
+
+	Cache_Stats *cacheStats = &workfile_mgr_cache->cacheHdr->cacheStats;
+	int64 budget = (int64) gp_workfile_cache_size * 1024;
+
+	if (work_set->size > budget)
+	{
+		return false;
+	}
+
+	/* Another query may have cached the same result concurrently */
+	CacheEntry *existing = Cache_Lookup(workfile_mgr_cache, key);
+	if (NULL != existing)
+	{
+		Cache_Release(workfile_mgr_cache, existing);
+		return false;
+	}
+
+	while (cacheStats->totalEntrySize + work_set->size > budget)
+	{
+		if (!workfile_mgr_evict_lru())
+		{
+			return false;
+		}
+	}
+
+	work_set->key = *key;
+	work_set->last_used = GetCurrentTimestamp();
+	entry->size = work_set->size;
+
+	Cache_Insert(workfile_mgr_cache, entry);
+
+	elog(gp_workfile_caching_loglevel, "inserted workfile set in cache: path=%s size=" INT64_FORMAT,
+		 work_set->path, work_set->size);
+
+	return true;
+}
+
+/*
+ * Give back a workfile set obtained from workfile_mgr_lookup_set.
+ *
+ * Unlike sets we created, looked up sets are shared with other backends and
+ * are not on our list of open sets.
+ */
+void
+workfile_mgr_release_set(workfile_set *work_set)
+{
+	Assert(NULL != work_set);
+
+	CacheEntry *cache_entry = CACHE_ENTRY_HEADER(work_set);
+	Assert(Cache_IsCached(cache_entry));
+
+	Cache_Release(workfile_mgr_cache, cache_entry);
+}
+
+/*
+ * Evict the least recently used cached workfile set nobody is reading.
+ *
+ * Returns false if there was nothing to evict.
+ */
+static bool
+workfile_mgr_evict_lru(void)
+{
+	CacheHdr *cacheHdr = workfile_mgr_cache->cacheHdr;
+	CacheEntry *victim = NULL;
+	TimestampTz victim_last_used = 0;
+
+	/*
+	 * The scan is not synchronized; Cache_Evict re-checks the state of the
+	 * victim under the proper lock.
+	 */
+	for (int i = 0; i < cacheHdr->nEntries; i++)
+	{
+		CacheEntry *crtEntry = Cache_GetEntryByIndex(cacheHdr, i);
+
+		if (CACHE_ENTRY_CACHED != crtEntry->state || crtEntry->pinCount > 0)
+		{
+			continue;
+		}
+
+		workfile_set *work_set = CACHE_ENTRY_PAYLOAD(crtEntry);
+		if (NULL == victim || work_set->last_used < victim_last_used)
+		{
+			victim = crtEntry;
+			victim_last_used = work_set->last_used;
+		}
+	}
+
+	if (NULL == victim)
+	{
+		return false;
+	}
+
+	elog(gp_workfile_caching_loglevel, "evicting workfile set %s from cache",
+		 ((workfile_set *) CACHE_ENTRY_PAYLOAD(victim))->path);
+
+	/* Losing a race for the victim is fine, the caller just tries again */
+	Cache_Evict(workfile_mgr_cache, victim);
+
+	return true;
+}
+
 /*
  * This function is called at transaction commit or abort to delete closed
  * workfiles.
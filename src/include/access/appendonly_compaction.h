@@ -18,9 +18,30 @@
 #include "utils/rel.h"
 #include "access/memtup.h"
 #include "executor/tuptable.h"
+#include "utils/timestamp.h"
 
 #define APPENDONLY_COMPACTION_SEGNO_INVALID (-1)
 
+/*
+ * Progress of the compaction of one segment file, reported every
+ * gp_appendonly_compaction_progress_interval seconds and at the end.
+ */
+typedef struct AppendOnlyCompactionProgress
+{
+	const char *relname;
+	int			segno;
+	int64		totalTupleCount;	/* tuples in the segfile, visible or not */
+
+	int64		scannedTupleCount;
+	int64		movedTupleCount;
+
+	/* The clock is only looked at every few thousand tuples */
+	int64		nextCheckTupleCount;
+
+	TimestampTz startTime;
+	TimestampTz lastReportTime;
+} AppendOnlyCompactionProgress;
+
 extern void AppendOnlyDrop(Relation aorel,
 			   List *compaction_segno);
 extern void AppendOnlyCompact(Relation aorel,
@@ -37,4 +58,9 @@ extern void AppendOnlyThrowAwayTuple(Relation rel, MemTuple tuple,
 extern void AppendOnlyTruncateToEOF(Relation aorel);
 extern bool HasLockForSegmentFileDrop(Relation aorel);
 extern bool AppendOnlyCompaction_IsRelationEmpty(Relation aorel);
+extern void AppendOnlyCompaction_StartProgress(AppendOnlyCompactionProgress *progress,
+								   Relation aorel, int segno,
+								   int64 totalTupleCount);
+extern void AppendOnlyCompaction_ReportProgress(AppendOnlyCompactionProgress *progress);
+extern void AppendOnlyCompaction_FinishProgress(AppendOnlyCompactionProgress *progress);
 #endif
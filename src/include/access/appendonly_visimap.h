@@ -109,6 +109,13 @@ bool AppendOnlyVisimap_IsVisible(
 							AppendOnlyVisimap *visiMap,
 							AOTupleId *tupleId);
 
+int AppendOnlyVisimap_GetVisibleRange(
+								  AppendOnlyVisimap *visiMap,
+								  int segno,
+								  int64 firstRowNum,
+								  int nrows,
+								  bool *visible);
+
 void AppendOnlyVisimap_Finish(
 						 AppendOnlyVisimap *visiMap,
 						 LOCKMODE lockmode);
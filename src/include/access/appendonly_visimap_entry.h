@@ -123,6 +123,12 @@ bool AppendOnlyVisimapEntry_IsVisible(
 								 AppendOnlyVisimapEntry *visiMapEntry,
 								 AOTupleId *aoTupleId);
 
+int AppendOnlyVisimapEntry_GetVisibleRange(
+									  AppendOnlyVisimapEntry *visiMapEntry,
+									  int64 firstRowNum,
+									  int nrows,
+									  bool *visible);
+
 HTSU_Result AppendOnlyVisimapEntry_HideTuple(
 								 AppendOnlyVisimapEntry *visiMapEntry,
 								 AOTupleId *aoTupleId);
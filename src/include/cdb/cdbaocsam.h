@@ -17,6 +17,7 @@
 
 #include "access/relscan.h"
 #include "access/sdir.h"
+#include "access/skey.h"
 #include "access/tupmacs.h"
 #include "access/xlogutils.h"
 #include "access/appendonlytid.h"
@@ -59,6 +60,12 @@ typedef struct AOCSInsertDescData
 
 	struct DatumStreamWrite **ds;
 
+	/*
+	 * Columns whose blocks are copied by aocs_insert_copy_segfile() instead
+	 * of being written by aocs_insert_values(), or NULL.
+	 */
+	bool	   *copiedCols;
+
 	AppendOnlyBlockDirectory blockDirectory;
 
 	/**
@@ -71,6 +78,46 @@ typedef struct AOCSInsertDescData
 
 typedef AOCSInsertDescData *AOCSInsertDesc;
 
+/*
+ * A simple "column op constant" or "column IN (constants)" restriction of a
+ * scan, used to skip blocks whose min/max range or dictionary cannot satisfy
+ * it.  See aocs_setzonemapkeys().
+ */
+typedef struct AOCSZoneMapKey
+{
+	int			attno;			/* column number, starting from 0 */
+	StrategyNumber strategy;	/* btree strategy of the operator */
+	Datum		value;			/* the constant */
+	Datum	   *values;			/* the IN list constants, or NULL */
+	int			nvalues;
+	FmgrInfo	cmpfn;			/* btree comparison function of the column */
+
+	/* file offset of the last block checked against this key */
+	int64		checkedBlockOffset;
+} AOCSZoneMapKey;
+
+/*
+ * A batch of rows returned by aocs_getnextbatch().  The values of each
+ * projected column are decoded into a contiguous array; the arrays of
+ * columns that are not projected are NULL.  Rows that are not visible
+ * according to the visibility map are still present, with visible[i]
+ * false.
+ *
+ * Pass-by-reference values point into the datum stream buffers and are
+ * only valid until the next call on the scan.
+ */
+typedef struct AOCSScanBatch
+{
+	int			maxRows;		/* capacity of the arrays */
+	int			nrows;			/* rows in the batch */
+	int			nvisible;		/* rows with visible[i] set */
+
+	Datum	  **values;			/* [attno][row] */
+	bool	  **isnull;			/* [attno][row] */
+	bool	   *visible;		/* [row] */
+	AOTupleId  *tids;			/* [row] */
+} AOCSScanBatch;
+
 /*
  * used for scan of append only relations using BufferedRead and VarBlocks
  */
@@ -126,6 +173,23 @@ typedef struct AOCSScanDescData
 
 	AppendOnlyVisimap visibilityMap;
 
+	/*
+	 * Zone map keys, sorted by attno.  Blocks of these columns whose min/max
+	 * range rules out a key are skipped, along with the same rows of all
+	 * other projected columns.
+	 */
+	AOCSZoneMapKey *zonemapKeys;
+	int			numZonemapKeys;
+
+	int64		zonemapBlocksRead;		/* blocks checked against the keys */
+	int64		zonemapBlocksSkipped;	/* blocks ruled out by the keys */
+
+	/* Batch returned by aocs_getnextbatch(), allocated on first use */
+	AOCSScanBatch *batch;
+
+	/* Buffer memory for decompressing blocks ahead, see aocs_setdecompressahead() */
+	int64		decompressAheadMem;
+
 }	AOCSScanDescData;
 
 typedef AOCSScanDescData *AOCSScanDesc;
@@ -211,7 +275,10 @@ extern AOCSScanDesc aocs_beginrangescan(Relation relation, Snapshot snapshot,
 extern void aocs_rescan(AOCSScanDesc scan);
 extern void aocs_endscan(AOCSScanDesc scan);
 
+extern void aocs_setzonemapkeys(AOCSScanDesc scan, AOCSZoneMapKey *keys, int nkeys);
+extern void aocs_setdecompressahead(AOCSScanDesc scan, int64 memLimit);
 extern void aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot);
+extern AOCSScanBatch *aocs_getnextbatch(AOCSScanDesc scan, int maxRows);
 extern AOCSInsertDesc aocs_insert_init(Relation rel, int segno, bool update_mode);
 extern Oid aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupleId);
 static inline Oid aocs_insert(AOCSInsertDesc idesc, TupleTableSlot *slot)
@@ -226,6 +293,11 @@ static inline Oid aocs_insert(AOCSInsertDesc idesc, TupleTableSlot *slot)
 	return oid;
 }
 extern void aocs_insert_finish(AOCSInsertDesc idesc);
+extern bool aocs_column_can_copy(Relation srcrel, TupleDesc srcTupDesc,
+					 Relation destrel, int attno);
+extern void aocs_insert_setcopiedcols(AOCSInsertDesc idesc, bool *copiedCols);
+extern int64 aocs_insert_copy_segfile(AOCSInsertDesc idesc, Relation srcrel,
+						 TupleDesc srcTupDesc, int segno);
 extern AOCSFetchDesc aocs_fetch_init(Relation relation,
 									 Snapshot snapshot,
 									 Snapshot appendOnlyMetaDataSnapshot,
@@ -222,6 +222,16 @@ typedef struct AppendOnlyScanDescData
 	 */ 
 	AppendOnlyVisimap visibilityMap;
 
+	/*
+	 * Visibility of the rows of the current block, looked up in the visi
+	 * map once when the block is read.
+	 */
+	bool	   *blockVisible;
+	int			blockVisibleMaxCount;
+	int			blockVisibleCount;
+	int64		blockVisibleFirstRowNum;
+	bool		blockAllVisible;
+
 }	AppendOnlyScanDescData;
 
 typedef AppendOnlyScanDescData *AppendOnlyScanDesc;
@@ -341,6 +351,8 @@ extern void appendonly_endscan(AppendOnlyScanDesc scan);
 extern MemTuple appendonly_getnext(AppendOnlyScanDesc scan, 
 									ScanDirection direction,
 									TupleTableSlot *slot);
+extern bool appendonly_tuple_visible_in_scan(AppendOnlyScanDesc scan,
+									AOTupleId *aoTupleId);
 extern AppendOnlyFetchDesc appendonly_fetch_init(
 	Relation 	relation,
 	Snapshot    snapshot,
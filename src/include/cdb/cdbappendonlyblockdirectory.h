@@ -18,9 +18,11 @@
 #include "access/aocssegfiles.h"
 #include "access/appendonlytid.h"
 #include "access/skey.h"
+#include "utils/hsearch.h"
 
 extern int gp_blockdirectory_entry_min_range;
 extern int gp_blockdirectory_minipage_size;
+extern int gp_blockdirectory_cache_size;
 
 typedef struct AppendOnlyBlockDirectoryEntry
 {
@@ -73,6 +75,41 @@ typedef struct MinipagePerColumnGroup
 	ItemPointerData tupleTid;
 } MinipagePerColumnGroup;
 
+/*
+ * A minipage kept in the search cache of a block directory, with the range
+ * of rows its entries cover.
+ */
+typedef struct MinipageCacheEntry
+{
+	int segmentFileNum;
+	int columnGroupNo;
+	int64 firstRowNum;
+	int64 lastRowNum;
+
+	uint64 lastUsed;
+
+	MinipagePerColumnGroup minipageInfo;
+} MinipageCacheEntry;
+
+/*
+ * The cached minipages of one column group of a segment file, sorted by
+ * their first row number.  Entry of the hash table that the minipage cache
+ * is searched by.
+ */
+typedef struct MinipageCacheKey
+{
+	int segmentFileNum;
+	int columnGroupNo;
+} MinipageCacheKey;
+
+typedef struct MinipageCacheGroup
+{
+	MinipageCacheKey key;
+
+	int numEntries;
+	MinipageCacheEntry **entries;
+} MinipageCacheGroup;
+
 /*
  * I don't know the ideal value here. But let us put approximate
  * 8 minipages per heap page.
@@ -109,6 +146,20 @@ typedef struct AppendOnlyBlockDirectory
 	 */
 	MinipagePerColumnGroup *minipages;
 
+	/*
+	 * Recently used minipages, so that searches going back and forth over
+	 * the same rows do not look them up in the block directory relation
+	 * again and again.  Least recently used minipages are replaced first.
+	 */
+	MinipageCacheEntry *minipageCache;
+	HTAB *minipageCacheGroups;
+	MinipageCacheEntry **minipageCacheFound;
+	int minipageCacheSize;
+	int numCachedMinipages;
+	uint64 minipageCacheClock;
+	int64 minipageCacheHits;
+	int64 minipageCacheMisses;
+
 	/*
 	 * Some temporary space to help form tuples to be inserted into
 	 * the block directory, and to help the index scan.
@@ -227,6 +227,13 @@ extern void AppendOnlyStorageWrite_Content(AppendOnlyStorageWrite *storageWrite,
 							   int32 contentLen,
 							   int executorBlockKind,
 							   int rowCount);
+extern void AppendOnlyStorageWrite_CopyBlock(AppendOnlyStorageWrite *storageWrite,
+								 int aoHeaderKind,
+								 uint8 *data,
+								 int32 contentLen,
+								 int32 compressedLen,
+								 int executorBlockKind,
+								 int rowCount);
 extern void AppendOnlyStorageWrite_SetFirstRowNum(AppendOnlyStorageWrite *storageWrite,
 									  int64 firstRowNum);
 
@@ -18,6 +18,7 @@
 #ifndef CDBBUFFEREDREAD_H
 #define CDBBUFFEREDREAD_H
 
+#include "portability/instr_time.h"
 #include "storage/fd.h"
 
 typedef struct BufferedRead
@@ -76,6 +77,18 @@ typedef struct BufferedRead
 	bool				haveTemporaryLimitInEffect;
 	int64				temporaryLimitFileLen;
 
+	/*
+	 * Read-ahead.  Everything before prefetchPosition in the current file
+	 * has already been handed to the kernel with FilePrefetch.
+	 */
+	int64				prefetchPosition;
+
+	/*
+	 * I/O statistics, accumulated over all files read.
+	 */
+	int64				numLargeReads;
+	instr_time			ioWaitTime;
+
 } BufferedRead;
 
 /*
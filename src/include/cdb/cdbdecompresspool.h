@@ -0,0 +1,38 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbdecompresspool.h
+ *	  Pool of threads that decompress Append-Only storage blocks ahead of
+ *	  the executor.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/cdb/cdbdecompresspool.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef CDBDECOMPRESSPOOL_H
+#define CDBDECOMPRESSPOOL_H
+
+/*
+ * A job is one block decompression.  Its source and destination buffers are
+ * owned by the pool, so that a worker never touches backend memory that an
+ * error could free from under it.
+ */
+typedef struct DecompressJob DecompressJob;
+
+extern bool DecompressPool_CodecSupported(const char *compressType);
+
+extern DecompressJob *DecompressPool_AcquireJob(const char *compressType,
+						  int32 bufferLen);
+extern void DecompressPool_ReleaseJob(DecompressJob *job);
+
+extern uint8 *DecompressPool_JobBuffer(DecompressJob *job);
+extern int32 DecompressPool_JobCompressedLen(DecompressJob *job);
+extern void DecompressPool_Submit(DecompressJob *job, int32 compressedLen,
+					  int32 uncompressedLen);
+extern uint8 *DecompressPool_Wait(DecompressJob *job, bool *succeeded);
+extern void DecompressPool_Cancel(DecompressJob *job);
+
+#endif   /* CDBDECOMPRESSPOOL_H */
@@ -340,6 +340,8 @@ typedef struct ChunkTransportStateEntry
 	uint64 stat_count_resent;
 	uint64 stat_max_resent;
 	uint64 stat_count_dropped;
+	uint64 stat_count_stalls;		/* sends that waited for a free buffer */
+	uint64 stat_ack_wait_time;		/* usecs spent waiting for acks */
 
 }	ChunkTransportStateEntry;
 
@@ -525,6 +527,9 @@ typedef struct ChunkTransportState
 	/* Estate pointer for this statement */
 	struct EState *estate;
 
+	/* Time spent in SetupInterconnect() for this statement, in usecs */
+	uint64		setupTimeUs;
+
 	/* Function pointers to our send/receive functions */
 	bool (*SendChunk)(struct ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn, TupleChunkListItem tcItem, int16 motionId);
 	TupleChunkListItem (*RecvTupleChunkFrom)(struct ChunkTransportState *transportStates, int16 motNodeID, int16 srcRoute);
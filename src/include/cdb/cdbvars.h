@@ -612,7 +612,27 @@ extern bool gp_adjust_selectivity_for_outerjoins;
  * Target density for hash-node (HJ).
  */
 extern int gp_hashjoin_tuples_per_bucket;
-extern int gp_hashagg_groups_per_bucket;
+
+/*
+ * Let hash joins filter the rows of a scan on their outer side with the
+ * keys of their inner side.
+ */
+extern bool gp_enable_runtime_filter;
+
+/*
+ * Partition the hash tables of hash joins by the high bits of their bucket
+ * numbers, and probe them a partition at a time; and the target size of a
+ * partition.
+ */
+extern bool gp_enable_hashjoin_radix;
+extern int gp_hashjoin_radix_partition_kb;
+
+/*
+ * Let the redistribute motions below a hash join spread the outer rows of
+ * the join's most common keys over all segments, and broadcast the matching
+ * inner rows, instead of sending them all to one segment.
+ */
+extern bool gp_motion_split_hot_keys;
 
 /*
  * Damping of selectivities of clauses which pertain to the same base
@@ -764,6 +784,9 @@ extern bool gp_enable_sort_distinct;
 extern bool gp_enable_mk_sort;
 extern bool gp_enable_motion_mk_sort;
 
+/* Helper threads of an in-memory MK sort */
+extern int gp_mk_sort_workers;
+
 #ifdef USE_ASSERT_CHECKING
 extern bool gp_mk_sort_check;
 #endif
@@ -809,6 +832,12 @@ extern int gp_max_plan_size;
 /* If we use two stage hashagg, we can stream the bottom half */
 extern bool gp_hashagg_streambottom;
 
+/*
+ * A streaming bottom stage hashagg whose groups reduce its input by less than
+ * this factor passes input rows straight through for a while instead.
+ */
+extern double gp_hashagg_stream_min_reduction;
+
 /* The default number of batches to use when the hybrid hashed aggregation
  * algorithm (re-)spills in-memory groups to disk.
  */
@@ -838,6 +867,7 @@ extern bool gp_enable_gpperfmon;
 extern int gp_gpperfmon_send_interval;
 extern bool gp_enable_query_metrics;
 extern int gp_instrument_shmem_size;
+extern int gp_shareinput_shmem_size;
 extern bool force_bitmap_table_scan;
 
 extern bool dml_ignore_target_partition_check;
@@ -859,6 +889,8 @@ extern bool gp_workfile_checksumming;
 extern double gp_workfile_limit_per_segment;
 extern double gp_workfile_limit_per_query;
 extern int gp_workfile_limit_files_per_query;
+extern bool gp_workfile_caching;
+extern int gp_workfile_cache_size;
 extern int gp_workfile_caching_loglevel;
 extern int gp_sessionstate_loglevel;
 extern int gp_workfile_bytes_to_checksum;
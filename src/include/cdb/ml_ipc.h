@@ -14,6 +14,7 @@
 #ifndef ML_IPC_H
 #define ML_IPC_H
 
+#include "lib/stringinfo.h"
 #include "cdb/cdbselect.h"
 #include "cdb/cdbinterconnect.h"
 #include "cdb/cdbmotion.h"
@@ -124,6 +125,72 @@ extern void SetupInterconnect(struct EState *estate);
 extern void TeardownInterconnect(ChunkTransportState *transportStates,
 								 bool forceEOS, bool hasError);
 
+/*
+ * Interconnect setup and teardown accounting for the current session.
+ *
+ * Updated by SetupInterconnect() and TeardownInterconnect(), and logged at
+ * teardown when gp_interconnect_log_stats is set.
+ */
+typedef struct ICSessionStats
+{
+	uint64		setupCount;		/* number of SetupInterconnect() calls */
+	uint64		setupTimeUs;	/* total time spent in setup, usecs */
+	uint64		teardownCount;	/* number of TeardownInterconnect() calls */
+	uint64		teardownTimeUs; /* total time spent in teardown, usecs */
+} ICSessionStats;
+
+extern ICSessionStats ic_session_stats;
+
+/*
+ * Cumulative interconnect statistics of this segment instance.
+ *
+ * Kept in shared memory; each backend adds the counters of a statement to
+ * it at interconnect teardown.  Exposed through the
+ * gp_toolkit.gp_interconnect_stats view.  Only the UDPIFC interconnect
+ * collects these.
+ *
+ * Ack times (the network round trip as seen by the sender) are also kept as
+ * a histogram, with bucket upper bounds of 100us, 1ms, 10ms and 100ms, the
+ * last bucket holding everything slower.
+ */
+#define IC_ACK_TIME_HIST_BUCKETS	5
+
+#define IC_ACK_TIME_BUCKET(us) \
+	((us) < 100 ? 0 : (us) < 1000 ? 1 : (us) < 10000 ? 2 : (us) < 100000 ? 3 : 4)
+
+typedef struct ICCumulativeStats
+{
+	uint64		numTeardowns;		/* interconnect instances torn down */
+	uint64		sndPktNum;			/* data packets sent */
+	uint64		recvPktNum;			/* data packets received */
+	uint64		recvAckNum;			/* acks received */
+	uint64		retransmits;		/* packets retransmitted */
+	uint64		crcErrors;			/* packets with a bad checksum */
+	uint64		mismatchNum;		/* packets for an unknown connection */
+	uint64		disorderedPktNum;	/* packets received out of order */
+	uint64		duplicatedPktNum;	/* duplicate packets received */
+	uint64		statusQueryMsgNum;	/* status queries sent */
+	uint64		capacityStalls;		/* sends that had to wait for a buffer */
+	uint64		ackWaitTimeUs;		/* time senders spent waiting for acks */
+	uint64		minAckTimeUs;		/* fastest ack, 0 if none */
+	uint64		maxAckTimeUs;		/* slowest ack */
+	uint64		ackTimeHist[IC_ACK_TIME_HIST_BUCKETS];
+} ICCumulativeStats;
+
+extern Size InterconnectShmemSize(void);
+extern void InterconnectShmemInit(void);
+extern void InterconnectAccumulateStats(const ICCumulativeStats *delta);
+extern void InterconnectGetStats(ICCumulativeStats *stats);
+extern void InterconnectExplainMotion(ChunkTransportState *transportStates,
+						  int motNodeID, StringInfo buf);
+
+/*
+ * Convert the numeric listener address of a peer QE into a sockaddr.
+ */
+extern void getInterconnectPeerAddr(const char *listenerAddr, int listenerPort,
+						int socktype, struct sockaddr_storage *peer,
+						socklen_t *peer_len);
+
 extern void WaitInterconnectQuit(void);
 
 extern void SetupSequenceServer(const char *host, int port);
@@ -330,6 +397,9 @@ extern void TeardownTCPInterconnect(ChunkTransportState *transportStates,
 extern void TeardownUDPIFCInterconnect(ChunkTransportState *transportStates,
 								 bool forceEOS);
 
+extern void ExplainUDPIFCMotionStats(ChunkTransportState *transportStates,
+						 int motNodeID, StringInfo buf);
+
 extern uint32 getActiveMotionConns(void);
 extern void adjustMasterRouting(Slice *recvSlice);
 
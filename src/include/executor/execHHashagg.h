@@ -41,7 +41,6 @@ typedef struct BatchFileInfo BatchFileInfo;
  */
 typedef struct HashAggEntry
 {
-	struct HashAggEntry *next; /* Next entry in chain. */
 	void *tuple_and_aggs; /* grouping keys and aggregate values.*/
 	HashKey hashvalue;
 	bool is_primodial; /* indicates if this entry is there before spilling. */
@@ -153,9 +152,16 @@ typedef struct HashAggTable
 	/* Hash table */
 	MemoryContext   entry_cxt;	/* memory context for hash table entries */
 
+	/*
+	 * Open addressed buckets.  tags has nbuckets + HHA_GROUP_WIDTH bytes, see
+	 * execHHashagg.c.
+	 */
 	unsigned nbuckets;
 	HashAggBucket  *buckets;
-	uint64 *bloom;
+	uint8 *tags;
+
+	/* How to compare each grouping key, see HashAggKeyCompare */
+	uint8 *key_compare;
 
 	/* hashkey bitshift amount to determine bucket - used when spilling */
 	unsigned pshift;
@@ -180,7 +186,6 @@ typedef struct HashAggTable
 
 	/* Variables during iteration */
 	int curr_bucket_idx;
-	HashAggEntry *next_entry;
 
 	/* buffer for calculating the hashkey */
 	HashKey *hashkey_buf;
@@ -207,8 +212,23 @@ typedef struct HashAggTable
 	bool expandable;  /* hash table buckets still have space to grow */
 	struct TupleTableSlot *prev_slot; /* a slot that is read previously. */
 
+	/*
+	 * Adaptive streaming. A streaming (bottom stage) hash table that fills up
+	 * without reducing its input by gp_hashagg_stream_min_reduction stops
+	 * hashing, and passes the next passthru_remaining input rows straight
+	 * through as one-row groups. It then hashes again to re-measure.
+	 */
+	bool passthru_enabled; /* this table may switch to pass-through */
+	bool passthrough; /* currently passing input rows through */
+	uint64 window_tuples; /* input tuples aggregated since the last reset */
+	uint64 passthru_remaining; /* rows left before hashing again */
+	uint32 passthru_backoff; /* pass-through length, in hashing windows */
+	AggStatePerGroup passthru_aggs; /* transition states for one row */
+	uint32 num_passthru_switches; /* number of times we switched to pass-through */
+	uint64 num_passthru_tuples; /* input tuples passed through unaggregated */
+
 	/* Statistics used for EXPLAIN ANALYZE */
-	CdbExplain_Agg      chainlength;
+	CdbExplain_Agg      probelength;
 	uint64 total_buckets; /* total of nbuckets across spills and reloads */
 } HashAggTable;
 
@@ -22,6 +22,7 @@
 #include "cdb/cdbdef.h"                 /* CdbVisitOpt */
 
 struct ChunkTransportState;             /* #include "cdb/cdbinterconnect.h" */
+struct BufferedRead;                    /* #include "cdb/cdbbufferedread.h" */
 
 /*
  * The "eflags" argument to ExecutorStart and the various ExecInitNode
@@ -385,6 +386,10 @@ extern TupleTableSlot *AppendOnlyScanNext(ScanState *scanState);
 extern void BeginScanAppendOnlyRelation(ScanState *scanState);
 extern void EndScanAppendOnlyRelation(ScanState *scanState);
 extern void ReScanAppendOnlyRelation(ScanState *scanState);
+extern void AccumAppendOnlyReadStats(struct BufferedRead *bufferedRead,
+						 int64 *numReads, double *waitTime);
+extern void ExplainAppendOnlyReads(struct StringInfoData *buf,
+					   int64 numReads, double waitTime);
 
 /*
  * prototypes from functions in execAOCSScan.c
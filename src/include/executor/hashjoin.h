@@ -79,6 +79,36 @@ typedef struct HashJoinTupleData
 #define HJTUPLE_MINTUPLE(hjtup)  \
 	((MemTuple) ((char *) (hjtup) + HJTUPLE_OVERHEAD))
 
+/*
+ * The tuples of the main hash table are not palloc'd one by one, but
+ * densely packed into chunks.  This saves the palloc overhead, and lets
+ * ExecHashIncreaseNumBatches walk the tuples in memory order.  Tuples larger
+ * than HASH_CHUNK_THRESHOLD get a chunk of their own.
+ *
+ * The bucket array is divided into 2^log2_nparts radix partitions, by the
+ * high bits of the bucket number, and each partition has its own list of
+ * chunks.  With more than one partition, the tuples of a partition are close
+ * together in memory, next to each other rather than spread over the whole
+ * table, and nodeHashjoin.c can probe the table a partition at a time to
+ * keep the probes within the CPU caches.
+ */
+typedef struct HashMemoryChunkData
+{
+	struct HashMemoryChunkData *next;	/* next chunk of the partition */
+	Size		maxlen;			/* size of the data area */
+	Size		used;			/* bytes of the data area used */
+	char		data[1];		/* tuples, each on a MAXALIGN boundary */
+} HashMemoryChunkData;
+
+typedef struct HashMemoryChunkData *HashMemoryChunk;
+
+#define HASH_CHUNK_HEADER_SIZE	offsetof(HashMemoryChunkData, data)
+#define HASH_CHUNK_SIZE			(32 * 1024L)
+#define HASH_CHUNK_THRESHOLD	(HASH_CHUNK_SIZE / 4)
+
+#define HJ_BUCKET_PARTITION(hashtable, bucketno) \
+	((bucketno) >> ((hashtable)->log2_nbuckets - (hashtable)->log2_nparts))
+
 /*
  * If the outer relation's distribution is sufficiently nonuniform, we attempt
  * to optimize the join by treating the hash values corresponding to the outer
@@ -136,6 +166,9 @@ typedef struct HashJoinTableStats
     int                     nonemptybatches;    /* num of nontrivial batches */
     Size                    workmem_max;        /* work_mem high water mark */
     CdbExplain_Agg          chainlength;        /* hash chain length stats */
+    uint64                  innerrows;          /* inner rows hashed in 1st pass */
+    uint64                  innerrows_spilled;  /* of those, written to batch files */
+    uint64                  innerrows_respilled; /* rows rewritten by later batches */
 } HashJoinTableStats;
 
 
@@ -151,6 +184,10 @@ typedef struct HashJoinTableData
 	struct HashJoinTupleData **buckets;
 	/* buckets array is per-batch storage, as are all the tuples */
 
+	int			log2_nparts;	/* log2 of number of radix partitions */
+	HashMemoryChunk *chunks;	/* per partition, list of chunks of tuples */
+	Size		radixProbeSpace;	/* memory set aside for radix probing */
+
 	bool		skewEnabled;	/* are we using skew optimization? */
 	HashSkewBucket **skewBucket;	/* hashtable of skew buckets */
 	int			skewBucketLen;	/* size of skewBucket array (a power of 2!) */
@@ -208,4 +245,84 @@ typedef struct HashJoinTableData
     bool first_pass; /* Is this the first pass (pre-rescan) */
 } HashJoinTableData;
 
+/* ----------------------------------------------------------------
+ *				runtime join filter
+ *
+ * Once the hash table of an inner or semi join is built, the join keys of
+ * the inner side are summarised in a runtime filter, which the scan feeding
+ * the outer side of the join checks before it returns a row.  Rows that
+ * cannot find a match are dropped at the scan, before the join computes
+ * their hash value, probes for them or writes them to a batch file.
+ *
+ * The filter is a Bloom filter over the hash values of the inner rows and,
+ * when the join has a single integer key, the range of the inner key
+ * values.  It is only attached when the scan is the direct outer child of
+ * the join, i.e. when both run in the same slice.
+ * ----------------------------------------------------------------
+ */
+typedef struct HashJoinRuntimeFilter
+{
+	HashJoinState *hjstate;		/* the join that builds the filter */
+	ExprContext *econtext;		/* to evaluate the outer keys at the scan */
+	bool		active;			/* built, and worth checking */
+	bool		abandoned;		/* turned off for removing too few rows */
+
+	/* Bloom filter over the hash values of the inner rows */
+	uint64	   *bloom;
+	int			bloom_nwords;	/* allocated size of bloom, in words */
+	int			bloom_log2bits;
+	bool		use_bloom;
+
+	/* Range of the values of a single integer key */
+	ExprState  *outer_key;
+	Oid			outer_keytype;
+	Oid			inner_keytype;
+	bool		use_range;
+	int64		min_value;
+	int64		max_value;
+
+	/* Counters for EXPLAIN ANALYZE */
+	double		nchecked;
+	double		nremoved;
+} HashJoinRuntimeFilter;
+
+/* ----------------------------------------------------------------
+ *				radix partitioned probing
+ *
+ * When the hash table is partitioned and much larger than a partition, the
+ * outer tuples of a batch are read ahead into a buffer, and returned in the
+ * order of the partition of their bucket.  The probes then walk the hash
+ * table a partition at a time instead of jumping all over it.
+ *
+ * The order of the outer tuples changes, but never across batches: the
+ * buffer is drained before the join moves on to the next batch.
+ *
+ * The buffer is only allocated once a batch is probed this way.  Its size,
+ * arrays and tuples together, is the radixProbeSpace that the hash table
+ * took out of its spaceAllowed: an eighth of it, up to HJ_RADIX_PROBE_BYTES.
+ * ----------------------------------------------------------------
+ */
+#define HJ_RADIX_PROBE_TUPLES	16384
+#define HJ_RADIX_PROBE_BYTES	(4 * 1024 * 1024L)
+
+typedef struct HashJoinRadixProbe
+{
+	Size		space;			/* radixProbeSpace it was sized for */
+	MemoryContext tupcxt;		/* holds the buffered tuples */
+	int			maxtuples;		/* capacity of the arrays below */
+	Size		maxbytes;		/* limit on the size of the buffered tuples */
+	int			ntuples;		/* number of tuples buffered */
+	int			next;			/* index of the next one to return */
+	bool		exhausted;		/* the batch has no more outer tuples */
+	double		nprobed;		/* tuples returned, for EXPLAIN ANALYZE */
+
+	/* buffered tuples and their hash values, as read */
+	MemTuple   *tuples;
+	uint32	   *hashvalues;
+
+	/* the same, in partition order */
+	MemTuple   *sorted_tuples;
+	uint32	   *sorted_hashvalues;
+} HashJoinRadixProbe;
+
 #endif   /* HASHJOIN_H */
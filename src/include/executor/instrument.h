@@ -73,6 +73,10 @@ typedef struct Instrumentation
 	bool		workfileCreated;	/* TRUE if workfiles are created in this
 									 * node */
 	int			numPartScanned; /* Number of part tables scanned */
+	int64		zonemapBlocksRead;		/* CDB: AOCS blocks checked by zone maps */
+	int64		zonemapBlocksSkipped;	/* CDB: AOCS blocks skipped by zone maps */
+	int64		aoLargeReads;	/* CDB: AO/AOCS segment file reads */
+	double		aoReadWaitTime;	/* CDB: seconds spent in those reads */
 	const char *sortMethod;		/* CDB: Type of sort */
 	const char *sortSpaceType;	/* CDB: Sort space type (Memory / Disk) */
 	long		sortSpaceUsed;	/* CDB: Memory / Disk used by sort(KBytes) */
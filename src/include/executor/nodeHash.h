@@ -51,11 +51,23 @@ extern void ExecChooseHashTableSize(double ntuples, int tupwidth, bool useskew,
 						int *numbatches,
 						int *num_skew_mcvs);
 extern int	ExecHashGetSkewBucket(HashJoinTable hashtable, uint32 hashvalue);
+extern bool ExecHashUseRadixProbe(HashJoinTable hashtable);
 
 extern void ExecHashTableExplainInit(HashState *hashState, HashJoinState *hjstate,
                                      HashJoinTable  hashtable);
 extern void ExecHashTableExplainBatchEnd(HashState *hashState, HashJoinTable hashtable);
 
+extern HashJoinRuntimeFilter *ExecHashRuntimeFilterCreate(HashJoinState *hjstate);
+extern void ExecHashRuntimeFilterReset(HashJoinRuntimeFilter *filter,
+						   double ntuples);
+extern void ExecHashRuntimeFilterAdd(HashJoinRuntimeFilter *filter,
+						 ExprContext *econtext, List *hashkeys,
+						 uint32 hashvalue);
+extern void ExecHashRuntimeFilterFinish(HashJoinRuntimeFilter *filter,
+							double ntuples);
+extern bool ExecHashRuntimeFilterCheck(HashJoinRuntimeFilter *filter,
+						   struct TupleTableSlot *slot);
+
 static inline int
 ExecHashRowSize(int tupwidth)
 {
@@ -1659,6 +1659,9 @@ typedef struct ScanState
 
 	/* The type of the table that is being scanned */
 	TableType	tableType;
+
+	/* Runtime filter of the hash join above, if any (see hashjoin.h) */
+	struct HashJoinRuntimeFilter *ss_runtimeFilter;
 } ScanState;
 
 /*
@@ -2112,6 +2115,20 @@ typedef struct AOCSScanOpaqueData
 	bool	   *proj;
 	int			ncol;
 
+	/*
+	 * Restrictions of the qual used to skip blocks by their min/max values.
+	 */
+	struct AOCSZoneMapKey *zonemapKeys;
+	int			numZonemapKeys;
+
+	/*
+	 * Rows are decoded batchSize at a time; batchNext is the next row of
+	 * the current batch to return.  batchSize 0 means one row at a time.
+	 */
+	int			batchSize;
+	struct AOCSScanBatch *batch;
+	int			batchNext;
+
 	struct AOCSScanDescData *scandesc;
 } AOCSScanOpaqueData;
 
@@ -2342,6 +2359,14 @@ typedef struct HashJoinState
 	bool		hj_InnerEmpty;  /* set to true if inner side is empty */
 	bool		prefetch_inner;
 	bool		hj_nonequijoin;
+	struct HashJoinRuntimeFilter *hj_RuntimeFilter;	/* NULL if none */
+	struct HashJoinRadixProbe *hj_RadixProbe;	/* NULL if not partitioning */
+
+	/* buffers for the tuples read back from inner and outer batch files */
+	char	   *hj_InnerReadBuf;
+	Size		hj_InnerReadBufLen;
+	char	   *hj_OuterReadBuf;
+	Size		hj_OuterReadBufLen;
 
 	/* set if the operator created workfiles */
 	bool workfiles_created;
@@ -2459,6 +2484,7 @@ typedef enum HashAggStatus
 	HASHAGG_IN_A_PASS,
 	HASHAGG_BETWEEN_PASSES,
 	HASHAGG_STREAMING,
+	HASHAGG_PASSTHROUGH,
 	HASHAGG_END_OF_PASSES
 } HashAggStatus;
 
@@ -2492,6 +2518,10 @@ typedef struct AggState
 	HashAggStatus hashaggstatus;
 	MemoryManagerContainer mem_manager;
 
+	/* Reuse of spilled results across queries, see workfile_cache.c */
+	struct workfile_result *wfresult;
+	bool		wfresult_replay;	/* returning a cached result */
+
 	/* ROLLUP */
 	AggStatePerGroup perpassthru; /* per-Aggref-per-pass-through-tuple working state */
 
@@ -2821,6 +2851,16 @@ typedef struct MotionState
 	Oid		   *outputFunArray;	/* output functions for each column (debug only) */
 
 	int			numInputSegs;	/* the number of segments on the sending slice */
+
+	/*
+	 * For a sending redistribute motion under EXPLAIN ANALYZE: rows sent to
+	 * each target and the most frequent hash keys, to report skew.
+	 */
+	struct MotionSkewStats *skewStats;
+
+	/* For a sending motion that splits hot keys (see Motion) */
+	int			hotKeyNextRoute;	/* next round-robin target */
+	int64		numHotKeyTuples;	/* rows split off by hot key */
 } MotionState;
 
 /*
@@ -1186,6 +1186,15 @@ typedef struct Motion
 	/* For Explicit */
 	AttrNumber segidColIdx;			/* index of the segid column in the target list */
 
+	/*
+	 * For Hash: full cdbhash values of join keys known to be heavily skewed.
+	 * Rows whose key hashes to one of these are broadcast to every output
+	 * segment if hotKeysBroadcast, else spread round-robin over them.
+	 */
+	int			numHotKeys;
+	uint32	   *hotKeyHashes;
+	bool		hotKeysBroadcast;
+
 	/* The following field is only used when sendSorted == true */
 	int			numSortCols;		/* number of sort key columns */
 	AttrNumber	*sortColIdx;		/* their indexes in target list */
@@ -95,6 +95,7 @@ typedef enum LWLockId
 	FilespaceHashLock,
 	TablespaceHashLock,
 	GpReplicationConfigFileLock,
+	ShareInputShmemLock,
 	/* must be last except for MaxDynamicLWLock: */
 	NumFixedLWLocks,
 
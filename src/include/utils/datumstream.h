@@ -15,6 +15,7 @@
 #ifndef DATUMSTREAM_H
 #define DATUMSTREAM_H
 
+#include "fmgr.h"
 #include "catalog/pg_attribute.h"
 #include "utils/datumstreamblock.h"
 
@@ -166,6 +167,19 @@ typedef struct DatumStreamRead
 	/* AO Storage */
 	bool		need_close_file;
 
+	/*
+	 * Decompression of the next block by the decompression worker pool, see
+	 * datumstreamread_enable_decompress_ahead().  While haveNextBlockInfo is
+	 * set, the storage read is already positioned on the next block.
+	 */
+	struct DecompressJob *decompressJob;
+	bool		decompressJobSubmitted;
+
+	bool		haveNextBlockInfo;
+	bool		nextBlockEof;
+	struct getBlockInfo nextBlockInfo;
+	int64		nextBlockFileOffset;
+
 }	DatumStreamRead;
 
 /*
@@ -309,14 +323,26 @@ extern int64 datumstreamwrite_lob(DatumStreamWrite *ds,
 extern int	datumstreamread_block(DatumStreamRead * ds,
 								  AppendOnlyBlockDirectory *blockDirectory,
 								  int colGroupNo);
+extern int	datumstreamread_copy_block(DatumStreamRead * ds,
+									   DatumStreamWrite * dest,
+									   int64 firstRowNum,
+									   AppendOnlyBlockDirectory *blockDirectory,
+									   int colGroupNo);
 extern void datumstreamread_find(DatumStreamRead * datumStream,
 					 int32 rowNumInBlock);
 extern void datumstreamread_rewind_block(DatumStreamRead * datumStream);
+extern bool datumstreamread_skip_to_row(DatumStreamRead * datumStream,
+							int64 targetRowNum);
+extern int32 datumstreamread_block_dictcount(DatumStreamRead * datumStream);
+extern bool datumstreamread_block_minmax(DatumStreamRead * datumStream,
+							 FmgrInfo *cmpfn, Datum *min, Datum *max,
+							 bool *allNull);
 extern bool datumstreamread_find_block(DatumStreamRead * datumStream,
 						   DatumStreamFetchDesc datumStreamFetchDesc,
 						   int64 rowNum);
 extern void *datumstreamread_get_upgrade_space(DatumStreamRead *datumStream,
 											   size_t len);
+extern bool datumstreamread_enable_decompress_ahead(DatumStreamRead * datumStream);
 
 /*
  * MPP-17061: make sure datumstream_read_block_info was called first for the CO block
@@ -196,6 +196,61 @@ typedef struct DatumStreamBlock_Delta_Extension
 	 */
 }	DatumStreamBlock_Delta_Extension;
 
+/*
+ * Datum Stream Block extension to DatumStreamBlock_Dense with a dictionary.
+ * 12 bytes more.
+ *
+ * With dictionary encoding, the datum area holds each distinct value of the
+ * block only once, and each physical datum is represented by a bit-packed
+ * code that is the index of its value in the dictionary.  The codes are the
+ * last of the meta-data.  Dictionary and Delta compression are not used
+ * together.
+ */
+typedef struct DatumStreamBlock_Dict_Extension
+{
+	int32		dict_entry_count;
+	/*
+	 * Number of distinct values in the dictionary.
+	 */
+
+	int32		dict_code_bits;
+	/*
+	 * Number of bits in each code.  0 when the dictionary has only one
+	 * value, in which case there are no codes at all.
+	 */
+
+	int32		dict_codes_size;
+	/*
+	 * Total size of the bit-packed codes, including the slack bytes
+	 * at the end.
+	 */
+}	DatumStreamBlock_Dict_Extension;
+
+/*
+ * Datum Stream Block extension to DatumStreamBlock_Dense with
+ * frame-of-reference encoding.
+ * 16 bytes more.
+ *
+ * The datum area holds, for each physical datum, its difference from the
+ * smallest datum of the block, bit-packed.  Only used for 2, 4 and 8 byte
+ * pass-by-value types, never together with dictionary encoding.  Since the
+ * extension may not be 8 byte aligned in the block, copy it out before use.
+ */
+typedef struct DatumStreamBlock_For_Extension
+{
+	int64		for_base;
+	/*
+	 * The smallest datum of the block, as a signed integer.
+	 */
+
+	int32		for_bits;
+	/*
+	 * Number of bits in each packed difference.
+	 */
+
+	int32		for_reserved;
+}	DatumStreamBlock_For_Extension;
+
 
 /* Flags */
 enum
@@ -203,8 +258,74 @@ enum
 	DSB_HAS_NULLBITMAP = 0x1,
 	DSB_HAS_RLE_COMPRESSION = 0x2,
 	DSB_HAS_DELTA_COMPRESSION = 0x4,
+	DSB_HAS_DICT_COMPRESSION = 0x8,
+	DSB_HAS_FOR_COMPRESSION = 0x10,
 };
 
+/*
+ * A block is only dictionary encoded when it has at most this many distinct
+ * values, so codes are at most 12 bits.
+ */
+#define DATUMSTREAM_DICT_MAX_ENTRIES 4096
+
+/*
+ * The codes are followed by a few zero bytes so that a code can always be
+ * fetched with a 3 byte load.
+ */
+#define DATUMSTREAM_DICT_CODES_SLACK 2
+
+static inline int32
+DatumStreamDictCodes_Bits(int32 entryCount)
+{
+	int32		bits = 0;
+
+	while ((1 << bits) < entryCount)
+		bits++;
+
+	return bits;
+}
+
+static inline int32
+DatumStreamDictCodes_Size(int32 codeCount, int32 codeBits)
+{
+	if (codeBits == 0)
+		return 0;
+
+	return (int32) (((int64) codeCount * codeBits + 7) / 8) +
+		DATUMSTREAM_DICT_CODES_SLACK;
+}
+
+static inline int32
+DatumStreamDictCodes_Get(uint8 * codes, int32 codeBits, int32 index)
+{
+	int64		bitPosition;
+	uint8	   *p;
+	uint32		word;
+
+	if (codeBits == 0)
+		return 0;
+
+	bitPosition = (int64) index * codeBits;
+	p = codes + (bitPosition >> 3);
+	word = (uint32) p[0] | ((uint32) p[1] << 8) | ((uint32) p[2] << 16);
+
+	return (int32) ((word >> (bitPosition & 7)) & ((1 << codeBits) - 1));
+}
+
+/*
+ * Frame-of-reference differences are packed least significant bit first,
+ * and unpacked with one 8 byte load each, so they are at most 56 bits and
+ * are followed by slack bytes.
+ */
+#define DATUMSTREAM_FOR_MAX_BITS 56
+#define DATUMSTREAM_FOR_SLACK 8
+
+static inline int32
+DatumStreamFor_Size(int32 count, int32 bits)
+{
+	return (int32) (((int64) count * bits + 7) / 8) + DATUMSTREAM_FOR_SLACK;
+}
+
 typedef struct DatumStreamBitMapWrite
 {
 	uint8	   *buffer;
@@ -1008,6 +1129,8 @@ typedef struct DatumStreamBlockWrite
 
 	bool		rle_want_compression;
 	bool		delta_want_compression;
+	bool		dict_want_compression;
+	bool		for_want_compression;
 
 	int32		initialMaxDatumPerBlock;
 	int32		maxDatumPerBlock;
@@ -1082,6 +1205,24 @@ typedef struct DatumStreamBlockWrite
 	bool	   *delta_sign;
 	int32		deltas_maxcount;
 
+	/* Dictionary buffers */
+	uint8	   *dict_buffer;
+	int32		dict_data_size;
+	int32		dict_entry_count;
+	int32		dict_code_bits;
+	int32	   *dict_entry_offsets;
+	int32	   *dict_entry_lens;
+	uint16	   *dict_hash;
+
+	uint16	   *dict_codes;
+	int32		dict_codes_maxcount;
+
+	/* Frame-of-reference buffers */
+	uint8	   *for_buffer;
+	int32		for_data_size;
+	int64		for_base;
+	int32		for_bits;
+
 	/* EOF of current file */
 	int64		savings;
 	int64		remember_savings;
@@ -1164,6 +1305,19 @@ typedef struct DatumStreamBlockRead
 	bool		delta_block_was_compressed;
 	DatumStreamBitMapRead delta_bitmap;
 
+	/* Dictionary variables */
+	bool		dict_block_was_compressed;
+	int32		dict_code_bits;
+	uint8	   *dict_codesp;
+	uint8	  **dict_entries;
+	int32		dict_entry_count;
+	int32		dict_codes_size;
+
+	/* Frame-of-reference variables */
+	bool		for_block_was_compressed;
+	uint8	   *for_buffer;
+	int32		for_buffer_size;
+
 	/*
 	 * Keep less frequently accessed fields down here for possible better CPU data cache
 	 * performance.
@@ -1918,6 +2072,18 @@ DatumStreamBlockRead_AdvanceDense(DatumStreamBlockRead * dsr)
 		}
 	}
 
+	if (dsr->dict_block_was_compressed)
+	{
+		/*
+		 * The item is the dictionary entry its code refers to.
+		 */
+		++dsr->physical_datum_index;
+		dsr->datump = dsr->dict_entries[DatumStreamDictCodes_Get(dsr->dict_codesp,
+														dsr->dict_code_bits,
+											  dsr->physical_datum_index)];
+		return 1;
+	}
+
 	Assert(dsr->datump >= dsr->datum_beginp);
 	Assert(dsr->datump < dsr->datum_afterp);
 
@@ -2062,6 +2228,38 @@ DatumStreamBlockRead_Nth(DatumStreamBlockRead * dsr)
 	return dsr->nth;
 }
 
+/*
+ * Number of values in the dictionary of the current block, or 0 if the
+ * block is not dictionary encoded.
+ */
+inline static int32
+DatumStreamBlockRead_DictCount(DatumStreamBlockRead * dsr)
+{
+	return dsr->dict_block_was_compressed ? dsr->dict_entry_count : 0;
+}
+
+inline static Datum
+DatumStreamBlockRead_DictValue(DatumStreamBlockRead * dsr, int32 index)
+{
+	uint8	   *p;
+
+	Assert(dsr->dict_block_was_compressed);
+	Assert(index >= 0 && index < dsr->dict_entry_count);
+
+	p = dsr->dict_entries[index];
+
+	if (!dsr->typeInfo.byval)
+		return PointerGetDatum(p);
+	else if (dsr->typeInfo.datumlen == 1)
+		return *(uint8 *) p;
+	else if (dsr->typeInfo.datumlen == 2)
+		return *(uint16 *) p;
+	else if (dsr->typeInfo.datumlen == 4)
+		return *(uint32 *) p;
+	else
+		return *(Datum *) p;
+}
+
 extern void DatumStreamBlockRead_GetReadyOrig(
 								  DatumStreamBlockRead * dsr,
 								  uint8 * buffer,
@@ -2152,6 +2350,8 @@ extern void DatumStreamBlockWrite_Init(
 						   DatumStreamVersion datumStreamVersion,
 						   bool rle_want_compression,
 						   bool delta_want_compression,
+						   bool dict_want_compression,
+						   bool for_want_compression,
 						   int32 initialMaxDatumPerBlock,
 						   int32 maxDatumPerBlock,
 						   int32 maxDataBlockSize,
@@ -134,6 +134,10 @@ FI_IDENT(ExecSortBeforeSorting, "execsort_before_sorting")
 FI_IDENT(ExecSortMKSortMergeRuns, "execsort_mksort_mergeruns")
 /* inject fault after shared input scan retrieved a tuple */
 FI_IDENT(ExecShareInputNext, "execshare_input_next")
+/* inject fault when a shared input store is published to shared memory */
+FI_IDENT(ShareInputShmemPublish, "shareinput_shmem_publish")
+/* inject fault when a shared input reader attaches to shared memory */
+FI_IDENT(ShareInputShmemAttach, "shareinput_shmem_attach")
 /* inject fault after creation of checkpoint when basebackup requested */
 FI_IDENT(BaseBackupPostCreateCheckpoint, "base_backup_post_create_checkpoint")
 /* inject fault after compaction, but before the drop of the
@@ -148,6 +152,8 @@ FI_IDENT(AppendOnlyInsert, "appendonly_insert")
 FI_IDENT(AppendOnlyDelete, "appendonly_delete")
 /* inject fault before an append-only update */
 FI_IDENT(AppendOnlyUpdate, "appendonly_update")
+/* inject fault when the blocks of an AOCS segment file are copied */
+FI_IDENT(AOCSRewriteCopyBlocks, "aocs_rewrite_copy_blocks")
 /* inject fault in append-only compression function */
 FI_IDENT(AppendOnlySkipCompression, "appendonly_skip_compression")
 /* inject fault while reindex db is in progress */
@@ -228,6 +228,14 @@ extern bool gp_local_distributed_cache_stats;
 extern bool gp_appendonly_verify_block_checksums;
 extern bool gp_appendonly_verify_write_block;
 extern bool gp_appendonly_compaction;
+extern bool gp_enable_aocs_zonemaps;
+extern bool gp_aocs_dictionary_encoding;
+extern bool gp_aocs_bitpack_encoding;
+extern bool gp_aocs_rewrite_copy_blocks;
+extern int	gp_aocs_scan_batch_size;
+extern int	gp_appendonly_prefetch_reads;
+extern int	gp_aocs_decompress_workers;
+extern int	gp_appendonly_compaction_progress_interval;
 
 /*
  * Threshold of the ratio of dirty data in a segment file
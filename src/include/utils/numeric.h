@@ -86,6 +86,7 @@ typedef NumericData *Numeric;
 extern double numeric_to_double_no_overflow(Numeric num);
 extern int64 numeric_to_pos_int8_trunc(Numeric num);
 extern int cmp_numerics(Numeric num1, Numeric num2);
+extern uint64 numeric_abbrev_key(Numeric num);
 extern float8 numeric_li_fraction(Numeric x, Numeric x0, Numeric x1, 
 								  bool *eq_bounds, bool *eq_abscissas);
 extern Numeric numeric_li_value(float8 f, Numeric y0, Numeric y1);
@@ -265,6 +265,8 @@ void Cache_Insert(Cache *cache, CacheEntry *entry);
 void Cache_Remove(Cache *cache, CacheEntry *entry);
 void Cache_Release(Cache *cache, CacheEntry *entry);
 CacheEntry *Cache_AcquireEntry(Cache *cache, void *populate_param);
+CacheEntry *Cache_Lookup(Cache *cache, const void *key);
+bool Cache_Evict(Cache *cache, CacheEntry *entry);
 bool Cache_IsCached(CacheEntry *entry);
 void Cache_SurrenderClientEntries(Cache *cache);
 
@@ -221,8 +221,27 @@ typedef enum MKLvType
     MKLV_TYPE_INT32, /* this level contains int32 values */
     MKLV_TYPE_CHAR,  /* this level contains char (blank padded) values */
     MKLV_TYPE_TEXT,  /* this level contains text values */
+    MKLV_TYPE_INT64, /* this level contains int64 values (int8, integer timestamps and times) */
+    MKLV_TYPE_FLOAT8, /* this level contains float8 values */
+
+    /*
+     * The datums of these levels are replaced by abbreviated keys: unsigned
+     * 64-bit prefixes of the values, in the same order.  Equal keys only
+     * mean the values may be equal, and are resolved by comparing the full
+     * values, fetched again from the tuples.
+     */
+    MKLV_TYPE_ABBREV_TEXT,    /* text in the C locale */
+    MKLV_TYPE_ABBREV_CHAR,    /* char (blank padded) in the C locale */
+    MKLV_TYPE_ABBREV_NUMERIC, /* numeric */
 } MKLvType;
 
+static inline bool mk_lvtype_is_abbrev(MKLvType lvtype)
+{
+    return lvtype == MKLV_TYPE_ABBREV_TEXT ||
+        lvtype == MKLV_TYPE_ABBREV_CHAR ||
+        lvtype == MKLV_TYPE_ABBREV_NUMERIC;
+}
+
 typedef struct MKLvContext
 {
 	/* Is the type of datums in this level passed by value instead of reference */
@@ -327,9 +346,11 @@ extern void create_mksort_context(
 
 /* MK quicksort stuff */
 extern void mk_qsort_impl(MKEntry *a, int left, int right, int lv, bool lvdown, MKContext *ctxt, bool seenNull);
+extern bool mk_qsort_parallel(MKEntry *a, int n, MKContext *ctxt);
 static inline void mk_qsort(MKEntry* a, int n, MKContext *ctxt)
 {
-    mk_qsort_impl(a, 0, n-1, 0, true, ctxt, false);
+    if (!mk_qsort_parallel(a, n, ctxt))
+        mk_qsort_impl(a, 0, n-1, 0, true, ctxt, false);
 }
 
 /* MK Heap stuff */
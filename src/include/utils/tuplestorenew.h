@@ -32,6 +32,10 @@ extern bool ntuplestore_is_readerwriter_reader(NTupleStore* nts);
 extern void ntuplestore_flush(NTupleStore *ts);
 extern void ntuplestore_destroy(NTupleStore *ts);
 
+/* Shared memory pool for the pages of readerwriter stores */
+extern Size NTupleStoreShmemSize(void);
+extern void NTupleStoreShmemInit(void);
+
 /* Tuple store accessor method 
  * Create Accessor: current we support 1 writer, many reader per store.  After created, the accessor
  * is positioned at the first tuple or eof (if there is no tuple).
@@ -52,7 +52,18 @@ typedef struct
 
 } workfile_set_op_metadata;
 
-typedef uint32 workfile_set_hashkey_t;
+/*
+ * Key of a workfile set in the cache. Sets that are never inserted in the
+ * cache have an all-zero key.
+ */
+typedef struct workfile_set_hashkey_t
+{
+	/* Fingerprint of the plan subtree that produced the set */
+	uint64 plan;
+
+	/* Fingerprint of the contents of the relations read by the subtree */
+	uint64 inputs;
+} workfile_set_hashkey_t;
 
 typedef struct workfile_set
 {
@@ -69,6 +80,9 @@ typedef struct workfile_set
 	/* Real-time size of the set as it is being created (for reporting only) */
 	int64 in_progress_size;
 
+	/* Bytes written to the files of the set, before any compression */
+	int64 uncompressed_size;
+
 	/* Prefix of files in the workfile set */
 	char path[MAXPGPATH];
 
@@ -87,6 +101,12 @@ typedef struct workfile_set
 	/* Timestamp when the workfile set was created */
 	TimestampTz session_start_time;
 
+	/* Timestamp of the last lookup hit, used for LRU eviction */
+	TimestampTz last_used;
+
+	/* Files are kept on close so that the set can be inserted in the cache */
+	bool can_be_reused;
+
 	/* Operator-specific metadata */
 	workfile_set_op_metadata metadata;
 
@@ -136,12 +156,28 @@ Size workfile_mgr_shmem_size(void);
 void workfile_mgr_cache_init(void);
 Cache *workfile_mgr_get_cache(void);
 void workfile_set_update_in_progress_size(workfile_set *work_set, int64 size);
+workfile_set *workfile_mgr_lookup_set(workfile_set_hashkey_t *key);
+bool workfile_mgr_insert_set(workfile_set *work_set, workfile_set_hashkey_t *key);
+void workfile_mgr_release_set(workfile_set *work_set);
 
 /* Workfile File operations */
 ExecWorkFile *workfile_mgr_create_file(workfile_set *work_set);
 ExecWorkFile *workfile_mgr_create_fileno(workfile_set *work_set, uint32 file_no);
+ExecWorkFile *workfile_mgr_open_fileno(workfile_set *work_set, uint32 file_no);
 int64 workfile_mgr_close_file(workfile_set *work_set, ExecWorkFile *file);
 
+/* Workfile result cache operations */
+typedef struct workfile_result workfile_result;
+
+workfile_result *workfile_result_create(PlanState *ps);
+bool workfile_result_lookup(workfile_result *result);
+void workfile_result_begin_write(workfile_result *result);
+void workfile_result_put(workfile_result *result, TupleTableSlot *slot);
+TupleTableSlot *workfile_result_get(workfile_result *result, TupleTableSlot *slot);
+void workfile_result_finish(workfile_result *result);
+void workfile_result_close(workfile_result *result);
+void workfile_result_free(workfile_result *result);
+
 /* Workfile diskspace operations */
 void WorkfileDiskspace_Init(void);
 Size WorkfileDiskspace_ShMemSize(void);
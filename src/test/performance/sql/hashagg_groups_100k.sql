@@ -0,0 +1,3 @@
+SET statement_mem = '1000MB';
+SET enable_groupagg = off;
+SELECT count(*) FROM (SELECT g100k, count(*) FROM hashagg_data GROUP BY g100k) s;
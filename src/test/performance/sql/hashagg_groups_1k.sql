@@ -0,0 +1,3 @@
+SET statement_mem = '1000MB';
+SET enable_groupagg = off;
+SELECT count(*) FROM (SELECT g1k, count(*) FROM hashagg_data GROUP BY g1k) s;
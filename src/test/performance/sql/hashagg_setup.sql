@@ -0,0 +1,10 @@
+--
+-- Create the table for the HashAgg benchmarks. Each grouping column splits
+-- the 4 million rows into a different number of groups, from a thousand to
+-- one group per row.
+--
+CREATE TABLE hashagg_data (a int, g1k int, g100k int, g1m int, g4m int, g1m_text text) DISTRIBUTED BY (a);
+
+INSERT INTO hashagg_data SELECT i, (i * 7919) % 1000, (i * 7919) % 100000, (i * 7919) % 1000000, (i * 7919) % 4000000, 'customer#' || ((i * 7919) % 1000000) FROM generate_series(1, 4000000) i;
+
+ANALYZE hashagg_data;
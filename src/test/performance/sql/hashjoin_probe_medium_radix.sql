@@ -0,0 +1,3 @@
+SET statement_mem = '1000MB';
+SET gp_enable_hashjoin_radix = on;
+SELECT count(*) FROM hj_outer o JOIN hj_inner_medium i ON o.m = i.k;
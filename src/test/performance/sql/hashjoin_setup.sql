@@ -0,0 +1,19 @@
+--
+-- Create the tables for the hash join probe benchmarks. Every row of the
+-- outer table matches exactly one row of each inner table, so each probe
+-- query counts all 8 million outer rows.
+--
+CREATE TABLE hj_outer (a int, s int, m int, l int) DISTRIBUTED BY (a);
+CREATE TABLE hj_inner_small (k int, pad text) DISTRIBUTED BY (k);
+CREATE TABLE hj_inner_medium (k int, pad text) DISTRIBUTED BY (k);
+CREATE TABLE hj_inner_large (k int, pad text) DISTRIBUTED BY (k);
+
+INSERT INTO hj_outer SELECT i, i % 10000, i % 500000, i % 4000000 FROM generate_series(1, 8000000) i;
+INSERT INTO hj_inner_small SELECT i, repeat('x', 40) FROM generate_series(0, 9999) i;
+INSERT INTO hj_inner_medium SELECT i, repeat('x', 40) FROM generate_series(0, 499999) i;
+INSERT INTO hj_inner_large SELECT i, repeat('x', 40) FROM generate_series(0, 3999999) i;
+
+ANALYZE hj_outer;
+ANALYZE hj_inner_small;
+ANALYZE hj_inner_medium;
+ANALYZE hj_inner_large;
@@ -0,0 +1,3 @@
+SET statement_mem = '1000MB';
+SET gp_enable_mk_sort = on;
+SELECT max(rn) FROM (SELECT row_number() OVER (ORDER BY k_date) AS rn FROM sort_data) s;
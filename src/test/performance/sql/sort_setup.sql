@@ -0,0 +1,10 @@
+--
+-- Create the table for the sort benchmarks. Every column holds 4 million
+-- values in no particular order; the text keys share a long common prefix
+-- so that comparisons have to look past it.
+--
+CREATE TABLE sort_data (a int, k_int8 int8, k_float8 float8, k_numeric numeric, k_text text, k_timestamp timestamp, k_date date) DISTRIBUTED BY (a);
+
+INSERT INTO sort_data SELECT i, (i * 7919) % 4000000, ((i * 7919) % 4000000) / 7.0, ((i * 7919) % 4000000) / 7.0, 'customer#' || md5(i::text), timestamp '2000-01-01' + ((i * 7919) % 4000000) * interval '1 minute', date '2000-01-01' + (i * 7919) % 40000 FROM generate_series(1, 4000000) i;
+
+ANALYZE sort_data;
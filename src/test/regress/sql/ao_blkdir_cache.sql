@@ -0,0 +1,45 @@
+--
+-- Index scans of append-only tables keep recently used block directory
+-- minipages in memory. Build block directories with many small minipages,
+-- and look up rows all over them with different cache sizes.
+--
+set gp_blockdirectory_minipage_size = 2;
+create table ao_blkdir_cache (a int, b int, c text)
+  with (appendonly=true, blocksize=8192) distributed by (a);
+create index ao_blkdir_cache_b on ao_blkdir_cache (b);
+insert into ao_blkdir_cache
+  select i, i % 1000, 'row' || i from generate_series(1, 20000) i;
+create table aocs_blkdir_cache (a int, b int, c text)
+  with (appendonly=true, orientation=column, blocksize=8192) distributed by (a);
+create index aocs_blkdir_cache_b on aocs_blkdir_cache (b);
+insert into aocs_blkdir_cache
+  select i, i % 1000, 'row' || i from generate_series(1, 20000) i;
+reset gp_blockdirectory_minipage_size;
+
+set enable_seqscan = off;
+set enable_bitmapscan = off;
+select count(*), sum(a) from ao_blkdir_cache where b between 10 and 12;
+select count(*), sum(a) from aocs_blkdir_cache where b between 10 and 12;
+select count(*), sum(a), count(distinct c) from ao_blkdir_cache where b in (7, 500, 993);
+select count(*), sum(a), count(distinct c) from aocs_blkdir_cache where b in (7, 500, 993);
+
+-- A single cached minipage is replaced on nearly every lookup.
+set gp_blockdirectory_cache_size = 1;
+select count(*), sum(a) from ao_blkdir_cache where b between 10 and 12;
+select count(*), sum(a) from aocs_blkdir_cache where b between 10 and 12;
+
+set gp_blockdirectory_cache_size = 0;
+select count(*), sum(a) from ao_blkdir_cache where b between 10 and 12;
+select count(*), sum(a) from aocs_blkdir_cache where b between 10 and 12;
+reset gp_blockdirectory_cache_size;
+
+set enable_indexscan = off;
+set enable_bitmapscan = on;
+select count(*), sum(a) from ao_blkdir_cache where b between 10 and 12;
+select count(*), sum(a) from aocs_blkdir_cache where b between 10 and 12;
+reset enable_indexscan;
+reset enable_bitmapscan;
+reset enable_seqscan;
+
+drop table ao_blkdir_cache;
+drop table aocs_blkdir_cache;
@@ -0,0 +1,45 @@
+--
+-- Compaction of append-only tables moves the visible rows of a segment
+-- file a block at a time. Make sure exactly the visible rows, and index
+-- entries for them, survive a VACUUM.
+--
+create table ao_compaction_batch (i int, t text)
+  with (appendonly=true) distributed by (i);
+create table aocs_compaction_batch (i int, t text)
+  with (appendonly=true, orientation=column) distributed by (i);
+create index ao_compaction_batch_i on ao_compaction_batch (i);
+create index aocs_compaction_batch_i on aocs_compaction_batch (i);
+insert into ao_compaction_batch
+  select i, 'row' || i from generate_series(1, 50000) i;
+insert into aocs_compaction_batch
+  select i, 'row' || i from generate_series(1, 50000) i;
+
+delete from ao_compaction_batch where i % 5 = 0;
+delete from ao_compaction_batch where i between 10000 and 20000;
+delete from aocs_compaction_batch where i % 5 = 0;
+delete from aocs_compaction_batch where i between 10000 and 20000;
+
+set gp_appendonly_compaction_progress_interval = 1;
+vacuum ao_compaction_batch;
+vacuum aocs_compaction_batch;
+reset gp_appendonly_compaction_progress_interval;
+
+select count(*), sum(i) from ao_compaction_batch;
+select count(*), sum(i) from aocs_compaction_batch;
+
+set enable_seqscan = off;
+select t from ao_compaction_batch where i = 33333;
+select t from aocs_compaction_batch where i = 33333;
+select count(*) from ao_compaction_batch where i = 15001;
+select count(*) from aocs_compaction_batch where i = 15001;
+reset enable_seqscan;
+
+-- The same compaction with single row batches.
+delete from aocs_compaction_batch where i % 3 = 0;
+set gp_aocs_scan_batch_size = 0;
+vacuum aocs_compaction_batch;
+reset gp_aocs_scan_batch_size;
+select count(*), sum(i) from aocs_compaction_batch;
+
+drop table ao_compaction_batch;
+drop table aocs_compaction_batch;
@@ -0,0 +1,34 @@
+--
+-- Scans of append-only tables look up the visibility of a whole block of
+-- rows at a time. Delete rows scattered over many blocks and visimap
+-- entries, and make sure the scans still see exactly the remaining ones.
+--
+create table ao_visimap_range (i int, t text)
+  with (appendonly=true) distributed by (i);
+create table aocs_visimap_range (i int, t text)
+  with (appendonly=true, orientation=column) distributed by (i);
+insert into ao_visimap_range
+  select i, 'row' || i from generate_series(1, 100000) i;
+insert into aocs_visimap_range
+  select i, 'row' || i from generate_series(1, 100000) i;
+
+delete from ao_visimap_range where i % 7 = 0;
+delete from ao_visimap_range where i between 40000 and 70000;
+delete from aocs_visimap_range where i % 7 = 0;
+delete from aocs_visimap_range where i between 40000 and 70000;
+
+select count(*), sum(i) from ao_visimap_range;
+select count(*) from ao_visimap_range where i between 32000 and 33000;
+select count(*) from ao_visimap_range where t = 'row49';
+
+select count(*), sum(i) from aocs_visimap_range;
+select count(*) from aocs_visimap_range where i between 32000 and 33000;
+select count(*) from aocs_visimap_range where t = 'row49';
+
+-- The same through single row scans of the column store.
+set gp_aocs_scan_batch_size = 0;
+select count(*), sum(i) from aocs_visimap_range;
+reset gp_aocs_scan_batch_size;
+
+drop table ao_visimap_range;
+drop table aocs_visimap_range;
@@ -0,0 +1,58 @@
+--
+-- Frame-of-reference bit-packing of integer, date and timestamp columns
+-- compressed with RLE_TYPE. The values of a block are stored as offsets
+-- from the smallest one, with just the bits their range needs.
+--
+set gp_aocs_bitpack_encoding = on;
+create table aocs_bitpack (
+  a int,
+  b int encoding (compresstype=rle_type),
+  c int8 encoding (compresstype=rle_type),
+  d date encoding (compresstype=rle_type),
+  e timestamp encoding (compresstype=rle_type),
+  f smallint encoding (compresstype=rle_type))
+  with (appendonly=true, orientation=column)
+  distributed by (a);
+insert into aocs_bitpack
+  select i, 1000000 + i % 500, 5000000000 - (i * 7919) % 100000,
+    date '2020-01-01' + i % 365,
+    timestamp '2020-01-01' + (i % 1000) * interval '1 second',
+    i % 100 - 50
+  from generate_series(1, 20000) i;
+insert into aocs_bitpack
+  select i, null, null, null, null, null
+  from generate_series(20001, 21000) i;
+reset gp_aocs_bitpack_encoding;
+
+-- Plain rows, written with the same values.
+create table aocs_nobitpack (
+  a int,
+  b int encoding (compresstype=rle_type),
+  c int8 encoding (compresstype=rle_type),
+  d date encoding (compresstype=rle_type),
+  e timestamp encoding (compresstype=rle_type),
+  f smallint encoding (compresstype=rle_type))
+  with (appendonly=true, orientation=column)
+  distributed by (a);
+insert into aocs_nobitpack select * from aocs_bitpack;
+
+select count(*), count(b), count(c), count(d), count(e), count(f) from aocs_bitpack;
+select min(b), max(b), sum(b) from aocs_bitpack;
+select min(c), max(c), sum(c) from aocs_bitpack;
+select count(*) from aocs_bitpack where d = date '2020-03-01';
+select count(distinct e) from aocs_bitpack;
+select min(f), max(f), sum(f) from aocs_bitpack;
+select b, c, d - date '2020-01-01' as days,
+  extract(epoch from e - timestamp '2020-01-01') as seconds, f
+  from aocs_bitpack where a = 12345;
+select count(*) from aocs_bitpack p join aocs_nobitpack n using (a)
+  where p.b is distinct from n.b or p.c is distinct from n.c
+    or p.d is distinct from n.d or p.e is distinct from n.e
+    or p.f is distinct from n.f;
+
+-- Bit-packing was chosen: the packed columns take far less space than the
+-- same values written plain.
+select pg_relation_size('aocs_bitpack') < 0.75 * pg_relation_size('aocs_nobitpack') as packed;
+
+drop table aocs_bitpack;
+drop table aocs_nobitpack;
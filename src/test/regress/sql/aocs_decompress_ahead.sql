@@ -0,0 +1,20 @@
+--
+-- Decompressing column blocks ahead of the scan in worker threads. The
+-- results must be the same as when the scan decompresses by itself.
+--
+create table aocs_decompress_ahead (a int, b text, c int8)
+  with (appendonly=true, orientation=column, compresstype=zlib,
+        compresslevel=1, blocksize=8192)
+  distributed by (a);
+insert into aocs_decompress_ahead
+  select i, repeat('x', i % 50) || i, i * 3
+  from generate_series(1, 50000) i;
+
+set gp_aocs_decompress_workers = 2;
+select count(*), sum(a), sum(length(b)), sum(c) from aocs_decompress_ahead;
+select b from aocs_decompress_ahead where a = 31234;
+select count(*) from aocs_decompress_ahead where c between 3000 and 30000;
+reset gp_aocs_decompress_workers;
+select count(*), sum(a), sum(length(b)), sum(c) from aocs_decompress_ahead;
+
+drop table aocs_decompress_ahead;
@@ -0,0 +1,83 @@
+--
+-- Dictionary encoding of RLE_TYPE compressed columns. Blocks with few
+-- distinct values are dictionary encoded, and equality and IN quals are
+-- checked against the dictionary of each block to skip it.
+--
+set gp_aocs_dictionary_encoding = on;
+create table aocs_dictionary (
+  a int,
+  b text encoding (compresstype=rle_type),
+  c int encoding (compresstype=rle_type))
+  with (appendonly=true, orientation=column)
+  distributed by (a);
+insert into aocs_dictionary
+  select i, 'color' || (i % 5), (i % 7) * 10
+  from generate_series(1, 20000) i;
+insert into aocs_dictionary
+  select i, null, null
+  from generate_series(20001, 21000) i;
+insert into aocs_dictionary
+  select i, 'other', 1
+  from generate_series(21001, 22000) i;
+reset gp_aocs_dictionary_encoding;
+
+-- Plain rows, written with the same values.
+create table aocs_nodictionary (
+  a int,
+  b text encoding (compresstype=rle_type),
+  c int encoding (compresstype=rle_type))
+  with (appendonly=true, orientation=column)
+  distributed by (a);
+insert into aocs_nodictionary select * from aocs_dictionary;
+
+set gp_enable_aocs_zonemaps = on;
+
+select b, count(*) from aocs_dictionary group by b order by b;
+select count(*) from aocs_dictionary where b = 'color3';
+select count(*) from aocs_dictionary where b = 'other';
+select count(*) from aocs_dictionary where b = 'nosuch';
+select count(*) from aocs_dictionary where b in ('color1', 'color4', 'nosuch');
+select count(*) from aocs_dictionary where c = 30;
+select sum(c) from aocs_dictionary where c in (0, 60);
+select min(b), max(b) from aocs_dictionary;
+select a, b, c from aocs_dictionary where a = 12345;
+select count(*) from aocs_dictionary d join aocs_nodictionary n using (a)
+  where d.b is distinct from n.b or d.c is distinct from n.c;
+
+set gp_enable_aocs_zonemaps = off;
+select count(*) from aocs_dictionary where b in ('color1', 'color4', 'nosuch');
+select count(*) from aocs_dictionary where b = 'other';
+reset gp_enable_aocs_zonemaps;
+
+-- Values larger than the block size are stored as large objects, which have
+-- no dictionary or min/max to skip them by.  They must come back whole, and
+-- in line with the other columns.
+set gp_aocs_dictionary_encoding = on;
+create table aocs_dictionary_large (
+  a int,
+  b text encoding (compresstype=rle_type),
+  c int)
+  with (appendonly=true, orientation=column, blocksize=8192)
+  distributed by (a);
+insert into aocs_dictionary_large
+  select i, case when i % 100 = 0 then repeat('large' || i, 3000)
+                 else 'small' || (i % 5) end, i
+  from generate_series(1, 2000) i;
+reset gp_aocs_dictionary_encoding;
+
+set gp_enable_aocs_zonemaps = on;
+select a, length(b), b = repeat('large' || a, 3000) as whole, c
+  from aocs_dictionary_large where b = repeat('large500', 3000);
+select a, length(b), c from aocs_dictionary_large
+  where b in (repeat('large700', 3000), 'small3') and a between 690 and 710
+  order by a;
+select count(*) from aocs_dictionary_large
+  where b in (repeat('large100', 3000), repeat('large1500', 3000), repeat('large2000', 3000))
+  and b = repeat('large' || a, 3000) and c = a;
+select count(*), sum(length(b)), sum(c) from aocs_dictionary_large
+  where b in ('small1', 'small2');
+reset gp_enable_aocs_zonemaps;
+
+drop table aocs_dictionary;
+drop table aocs_nodictionary;
+drop table aocs_dictionary_large;
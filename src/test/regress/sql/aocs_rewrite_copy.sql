@@ -0,0 +1,68 @@
+--
+-- ALTER TABLE rewrites of column oriented tables copy the blocks of the
+-- columns that come out unchanged. Make sure the copied columns still line
+-- up with the rewritten ones, row by row.
+--
+-- start_ignore
+CREATE EXTENSION IF NOT EXISTS gp_inject_fault;
+-- end_ignore
+set gp_aocs_rewrite_copy_blocks = on;
+
+create table aocs_rewrite_copy (
+  a int,
+  b bigint encoding (compresstype=rle_type),
+  t text encoding (compresstype=zlib, compresslevel=1))
+  with (appendonly=true, orientation=column) distributed by (t);
+insert into aocs_rewrite_copy
+  select i, i * 2, 'row' || i from generate_series(1, 20000) i;
+insert into aocs_rewrite_copy
+  select i, i * 2, 'row' || i from generate_series(20001, 30000) i;
+-- Values larger than the block size are stored as large content.
+insert into aocs_rewrite_copy
+  select i, i * 2, repeat('row' || i, 10000) from generate_series(30001, 30010) i;
+
+-- Compaction moves the rows to a second segment file, and the next rows
+-- go to the first one again.
+delete from aocs_rewrite_copy where a % 3 = 0;
+vacuum aocs_rewrite_copy;
+insert into aocs_rewrite_copy
+  select i, i * 2, 'row' || i from generate_series(30011, 40000) i;
+insert into aocs_rewrite_copy
+  select i, i * 2, repeat('row' || i, 10000) from generate_series(40001, 40010) i;
+select count(distinct segno) from gp_toolkit.__gp_aocsseg_name('aocs_rewrite_copy')
+  where tupcount > 0;
+
+-- The blocks of both segment files of the first segment are copied.
+select gp_inject_fault('aocs_rewrite_copy_blocks', 'reset', 2);
+select gp_inject_fault('aocs_rewrite_copy_blocks', 'skip', '', '', '', 2, 0, 2);
+alter table aocs_rewrite_copy alter column a type bigint;
+select gp_inject_fault('aocs_rewrite_copy_blocks', 'status', 2);
+select count(*), sum(a), sum(b), sum(length(t)) from aocs_rewrite_copy;
+select count(*) from aocs_rewrite_copy
+  where b <> a * 2 or t not in ('row' || a, repeat('row' || a, 10000));
+
+-- The new values of a column are computed from another column.
+alter table aocs_rewrite_copy alter column a type numeric using b / 2;
+select count(*) from aocs_rewrite_copy
+  where b <> a * 2 or t not in ('row' || a, repeat('row' || a, 10000));
+
+-- Rows hidden by a DELETE rule out copying.
+delete from aocs_rewrite_copy where b % 14 = 0;
+select gp_inject_fault('aocs_rewrite_copy_blocks', 'reset', 2);
+select gp_inject_fault('aocs_rewrite_copy_blocks', 'skip', 2);
+alter table aocs_rewrite_copy alter column a type int;
+select gp_inject_fault('aocs_rewrite_copy_blocks', 'status', 2);
+select gp_inject_fault('aocs_rewrite_copy_blocks', 'reset', 2);
+select count(*), sum(a) from aocs_rewrite_copy;
+select count(*) from aocs_rewrite_copy
+  where b <> a * 2 or t not in ('row' || a, repeat('row' || a, 10000));
+
+-- And the same without copying.
+set gp_aocs_rewrite_copy_blocks = off;
+alter table aocs_rewrite_copy alter column a type bigint;
+select count(*), sum(a) from aocs_rewrite_copy;
+select count(*) from aocs_rewrite_copy
+  where b <> a * 2 or t not in ('row' || a, repeat('row' || a, 10000));
+
+reset gp_aocs_rewrite_copy_blocks;
+drop table aocs_rewrite_copy;
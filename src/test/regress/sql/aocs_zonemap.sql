@@ -0,0 +1,79 @@
+--
+-- Block skipping with min/max zone maps on column-oriented tables. The
+-- results must be the same whether blocks are skipped or not.
+--
+
+-- start_ignore
+create language plpythonu;
+-- end_ignore
+
+-- whether EXPLAIN ANALYZE reports blocks checked and skipped by zone maps
+create or replace function aocs_zonemap_blocks(explain_query text)
+returns text as
+$$
+import re
+rv = plpy.execute(explain_query)
+for r in rv:
+    m = re.search(r'Zone maps skipped (\d+) of (\d+) blocks', r['QUERY PLAN'])
+    if m:
+        skipped, checked = int(m.group(1)), int(m.group(2))
+        if skipped > checked:
+            return 'skipped more than checked'
+        return 'some skipped' if skipped > 0 else 'none skipped'
+return 'not checked'
+$$
+language plpythonu;
+
+create table aocs_zonemap (a int, b int8, c text, d date)
+  with (appendonly=true, orientation=column, blocksize=8192)
+  distributed by (b);
+insert into aocs_zonemap
+  select i, i * 2, 'row' || i, date '2000-01-01' + i % 1000
+  from generate_series(1, 100000) i;
+-- A second insert leaves a gap in the row numbers of each segment file.
+insert into aocs_zonemap
+  select i, i * 2, 'row' || i, null
+  from generate_series(100001, 110000) i;
+insert into aocs_zonemap
+  select null, null, 'null' || i, null
+  from generate_series(1, 5000) i;
+
+set gp_enable_aocs_zonemaps = on;
+select aocs_zonemap_blocks('explain analyze select count(*) from aocs_zonemap where a < 100');
+select count(*) from aocs_zonemap where a < 100;
+select sum(b) from aocs_zonemap where a < 100;
+select count(*) from aocs_zonemap where a between 50000 and 50010;
+select c from aocs_zonemap where a = 12345;
+select c from aocs_zonemap where 12345 = a;
+select count(*) from aocs_zonemap where a > 110000;
+select count(*) from aocs_zonemap where a >= 105001;
+select count(*) from aocs_zonemap where a < 0;
+select count(*) from aocs_zonemap where b >= 199990 and a > 99990;
+select count(*) from aocs_zonemap where a > 109990 and d is null;
+select count(*) from aocs_zonemap where d < date '2000-01-03';
+
+-- Every block may hold rows that satisfy the qual, so none is skipped.
+create table aocs_zonemap_noskip (a int, b int)
+  with (appendonly=true, orientation=column, blocksize=8192)
+  distributed by (b);
+insert into aocs_zonemap_noskip select i % 1000, i from generate_series(1, 100000) i;
+select aocs_zonemap_blocks('explain analyze select count(*) from aocs_zonemap_noskip where a >= 0');
+select count(*) from aocs_zonemap_noskip where a >= 0;
+drop table aocs_zonemap_noskip;
+
+set gp_enable_aocs_zonemaps = off;
+select aocs_zonemap_blocks('explain analyze select count(*) from aocs_zonemap where a < 100');
+select count(*) from aocs_zonemap where a < 100;
+select count(*) from aocs_zonemap where b >= 199990 and a > 99990;
+select count(*) from aocs_zonemap where d < date '2000-01-03';
+set gp_enable_aocs_zonemaps = on;
+
+-- Rows decoded one at a time instead of in batches.
+set gp_aocs_scan_batch_size = 0;
+select count(*) from aocs_zonemap where a < 100;
+select c from aocs_zonemap where a = 12345;
+reset gp_aocs_scan_batch_size;
+reset gp_enable_aocs_zonemaps;
+
+drop table aocs_zonemap;
+drop function aocs_zonemap_blocks(text);
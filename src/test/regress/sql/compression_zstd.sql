@@ -30,3 +30,31 @@ SELECT * FROM zstdtest_19 ORDER BY id DESC LIMIT 5;
 CREATE TABLE zstdtest_invalid (id int4) WITH (appendonly=true, compresstype=zstd, compresslevel=-1);
 CREATE TABLE zstdtest_invalid (id int4) WITH (appendonly=true, compresstype=zstd, compresslevel=0);
 CREATE TABLE zstdtest_invalid (id int4) WITH (appendonly=true, compresstype=zstd, compresslevel=20);
+
+
+-- Spill a hash join and a hash aggregate to zstd compressed workfiles.
+CREATE TABLE zstd_spill (i1 int, i2 int, t text) DISTRIBUTED BY (i1);
+INSERT INTO zstd_spill SELECT i, i, 'spill' || i FROM generate_series(1, 200000) i;
+
+SET gp_workfile_type_hashjoin=bfz;
+SET gp_workfile_compress_algorithm=zstd;
+SET statement_mem=5000;
+
+SELECT COUNT(t1.*) FROM zstd_spill AS t1, zstd_spill AS t2 WHERE t1.i1 = t2.i2;
+SELECT COUNT(*) FROM (SELECT i2, MAX(t) FROM zstd_spill GROUP BY i2) s;
+
+-- Once all the input is spilled, the spill files of the hash aggregate take
+-- less space on disk than was written to them.
+BEGIN;
+DECLARE zstd_spill_cur CURSOR FOR SELECT i2, MAX(t) FROM zstd_spill GROUP BY i2;
+MOVE FORWARD 1 IN zstd_spill_cur;
+SELECT COUNT(*) > 0 AS spilled, bool_and(uncompressed_size > size) AS compressed
+  FROM gp_toolkit.gp_workfile_entries
+ WHERE sess_id = current_setting('gp_session_id')::int AND optype = 'HashAggregate';
+CLOSE zstd_spill_cur;
+COMMIT;
+
+RESET statement_mem;
+RESET gp_workfile_compress_algorithm;
+RESET gp_workfile_type_hashjoin;
+DROP TABLE zstd_spill;
@@ -0,0 +1,24 @@
+--
+-- HashAgg looks groups up in an open addressed hash table. Check that
+-- high-cardinality grouping on integer, date and text keys, with NULLs,
+-- finds every group once, also when the table spills.
+--
+create table hashagg_probe (a int, b int8, c text, d date) distributed by (a);
+insert into hashagg_probe
+  select i % 20000, i % 7000, 'g' || (i % 300), date '2000-01-01' + i % 1000
+  from generate_series(1, 100000) i;
+insert into hashagg_probe
+  select null, null, null, null from generate_series(1, 10);
+
+set enable_groupagg = off;
+select count(*), sum(n) from (select a, count(*) n from hashagg_probe group by a) s;
+select count(*), sum(n) from (select b, c, count(*) n from hashagg_probe group by b, c) s;
+select count(*), sum(n) from (select c, d, count(*) n from hashagg_probe group by c, d) s;
+
+set statement_mem = 2560;
+select count(*), sum(n) from (select a, d, count(*) n from hashagg_probe group by a, d) s;
+select count(*), sum(n) from (select b, c, count(*) n from hashagg_probe group by b, c) s;
+reset statement_mem;
+reset enable_groupagg;
+
+drop table hashagg_probe;
@@ -0,0 +1,56 @@
+--
+-- The bottom stage of a two stage HashAgg streams its groups out when its
+-- hash table fills up. When the grouping keys are nearly unique, it passes
+-- input rows through unaggregated for a while instead, and goes back to
+-- hashing when the input starts to reduce again. Results must not change.
+--
+create schema hashagg_stream;
+set search_path to hashagg_stream;
+
+-- start_ignore
+create language plpythonu;
+-- end_ignore
+
+-- true if the bottom HashAgg passed rows through on any segment
+create or replace function hashagg_stream.passed_through(explain_query text)
+returns bool as
+$$
+rv = plpy.execute(explain_query)
+return any('pass-through' in r['QUERY PLAN'] for r in rv)
+$$
+language plpythonu;
+
+create table hs (a int, b int, c text) distributed by (a);
+-- unique keys first, then a few keys repeated many times
+insert into hs select i, i, 'v' || i from generate_series(1, 100000) i;
+insert into hs select i, i % 50, 'w' || i from generate_series(100001, 200000) i;
+
+-- start_ignore
+set optimizer = off;
+-- end_ignore
+set enable_groupagg = off;
+set gp_eager_two_phase_agg = on;
+set statement_mem = 2560;
+
+select hashagg_stream.passed_through('explain analyze select b, count(*), sum(a), avg(a), max(c) from hs group by b');
+
+select count(*), sum(n), sum(s), round(sum(av), 2), max(m)
+from (select b, count(*) n, sum(a) s, avg(a) av, max(c) m from hs group by b) t;
+select b, count(*), sum(a), round(avg(a), 4), max(c) from hs where b < 5 group by b order by b;
+select b, count(*) from hs group by b having count(*) > 2000 order by b limit 3;
+
+-- The same queries with pass-through disabled
+set gp_hashagg_stream_min_reduction = 1;
+select hashagg_stream.passed_through('explain analyze select b, count(*), sum(a), avg(a), max(c) from hs group by b');
+
+select count(*), sum(n), sum(s), round(sum(av), 2), max(m)
+from (select b, count(*) n, sum(a) s, avg(a) av, max(c) m from hs group by b) t;
+select b, count(*), sum(a), round(avg(a), 4), max(c) from hs where b < 5 group by b order by b;
+select b, count(*) from hs group by b having count(*) > 2000 order by b limit 3;
+
+reset gp_hashagg_stream_min_reduction;
+reset statement_mem;
+reset gp_eager_two_phase_agg;
+reset enable_groupagg;
+
+drop schema hashagg_stream cascade;
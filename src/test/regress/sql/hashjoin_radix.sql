@@ -0,0 +1,61 @@
+--
+-- Radix partitioned hash joins: the hash table is split into partitions by
+-- the high bits of the bucket numbers, and the outer rows are probed a
+-- partition at a time.  The results must be the same, whether the hash
+-- table fits in memory or spills to batch files.
+--
+
+-- start_ignore
+CREATE LANGUAGE plpythonu;
+-- end_ignore
+
+-- The radix probing line of EXPLAIN ANALYZE, with the numbers masked
+CREATE OR REPLACE FUNCTION hjr_probed(explain_query text)
+RETURNS text AS
+$$
+import re
+rv = plpy.execute(explain_query)
+for r in rv:
+    m = re.search(r'Probed .* partition at a time.*', r['QUERY PLAN'])
+    if m:
+        return re.sub(r'[0-9]+', 'N', m.group(0))
+return 'not partitioned'
+$$
+LANGUAGE plpythonu;
+
+SET gp_enable_hashjoin_radix = on;
+SET gp_hashjoin_radix_partition_kb = 64;
+SET enable_nestloop = off;
+SET enable_mergejoin = off;
+
+CREATE TABLE hjr_outer (id int, k int) DISTRIBUTED BY (id);
+INSERT INTO hjr_outer SELECT i, i % 60000 FROM generate_series(1, 200000) i;
+CREATE TABLE hjr_inner (k int, pad text) DISTRIBUTED BY (k);
+INSERT INTO hjr_inner SELECT i, repeat('x', 100) FROM generate_series(0, 49999) i;
+ANALYZE hjr_outer;
+ANALYZE hjr_inner;
+
+-- In memory
+SET statement_mem = '20MB';
+SELECT count(*), sum(o.id), sum(length(i.pad)) FROM hjr_outer o JOIN hjr_inner i ON o.k = i.k;
+SELECT count(*), count(i.k) FROM hjr_outer o LEFT JOIN hjr_inner i ON o.k = i.k;
+SELECT hjr_probed('EXPLAIN ANALYZE SELECT count(*) FROM hjr_outer o JOIN hjr_inner i ON o.k = i.k');
+
+-- Spilled to batch files
+SET statement_mem = '2MB';
+SELECT count(*), sum(o.id), sum(length(i.pad)) FROM hjr_outer o JOIN hjr_inner i ON o.k = i.k;
+SELECT count(*), count(i.k) FROM hjr_outer o LEFT JOIN hjr_inner i ON o.k = i.k;
+
+-- The same without partitioning
+SET gp_enable_hashjoin_radix = off;
+SELECT count(*), sum(o.id), sum(length(i.pad)) FROM hjr_outer o JOIN hjr_inner i ON o.k = i.k;
+SELECT hjr_probed('EXPLAIN ANALYZE SELECT count(*) FROM hjr_outer o JOIN hjr_inner i ON o.k = i.k');
+
+RESET statement_mem;
+RESET gp_enable_hashjoin_radix;
+RESET gp_hashjoin_radix_partition_kb;
+RESET enable_nestloop;
+RESET enable_mergejoin;
+DROP TABLE hjr_outer;
+DROP TABLE hjr_inner;
+DROP FUNCTION hjr_probed(text);
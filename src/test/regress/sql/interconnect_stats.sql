@@ -0,0 +1,54 @@
+--
+-- The UDPIFC interconnect adds the counters of every query to the
+-- gp_toolkit.gp_interconnect_stats view, and reports the flow control of
+-- each sending motion in EXPLAIN ANALYZE.
+--
+create schema interconnect_stats;
+set search_path to interconnect_stats;
+
+-- start_ignore
+create language plpythonu;
+-- end_ignore
+
+-- number of sending motions of the plan that acked more than 0 packets
+create or replace function interconnect_stats.acked_motions(explain_query text)
+returns int as
+$$
+import re
+rv = plpy.execute(explain_query)
+n = 0
+for r in rv:
+    m = re.search(r'Interconnect: (\d+) acks', r['QUERY PLAN'])
+    if m and int(m.group(1)) > 0:
+        n += 1
+return n
+$$
+language plpythonu;
+
+create table ics_a (a int, b int) distributed by (a);
+create table ics_b (a int, b int) distributed by (a);
+insert into ics_a select i, i % 1000 from generate_series(1, 100000) i;
+insert into ics_b select i, i from generate_series(1, 1000) i;
+
+create temp table ics_before as
+select segid, num_teardowns, snd_pkt_num, recv_pkt_num, recv_ack_num
+from gp_toolkit.gp_interconnect_stats distributed randomly;
+
+-- a join on a column that is not the distribution key of ics_a moves one
+-- side, then the result is gathered: two sending motions
+select count(*) from ics_a join ics_b on ics_a.b = ics_b.a;
+
+-- every segment sent and acked packets in it, and the master received some
+select count(*) = (select count(*) from gp_segment_configuration where role = 'p' and content >= 0)
+from gp_toolkit.gp_interconnect_stats s join ics_before b using (segid)
+where s.segid >= 0 and s.num_teardowns > b.num_teardowns
+  and s.snd_pkt_num > b.snd_pkt_num and s.recv_pkt_num > b.recv_pkt_num
+  and s.recv_ack_num > b.recv_ack_num;
+select count(*)
+from gp_toolkit.gp_interconnect_stats s join ics_before b using (segid)
+where s.segid = -1 and s.recv_pkt_num > b.recv_pkt_num;
+
+-- both sending motions print an Interconnect line with their acks
+select interconnect_stats.acked_motions('explain analyze select count(*) from ics_a join ics_b on ics_a.b = ics_b.a');
+
+drop schema interconnect_stats cascade;
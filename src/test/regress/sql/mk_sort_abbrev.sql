@@ -0,0 +1,61 @@
+--
+-- Multi-key sorts on abbreviated keys.  Many of the values below share a
+-- long prefix, so most comparisons fall back to the full values.  Each
+-- query checks that every row sorts after the one before it.
+--
+SET gp_enable_mk_sort = on;
+SET statement_mem = '200MB';
+
+CREATE TABLE mksa (a int, n numeric, t text, c char(20), f float8, b bigint, ts timestamp, d date) DISTRIBUTED BY (a);
+INSERT INTO mksa SELECT i,
+  CASE i % 4 WHEN 0 THEN 12345678901234.5678 + (i % 997) * 0.00001
+             WHEN 1 THEN -(i % 1009) * 1e-30
+             WHEN 2 THEN (i % 1013) * 1e40
+             ELSE -12345678901234.5678 - (i % 991) * 0.00001 END,
+  'common prefix ' || (i % 1021),
+  'pre' || repeat(' ', i % 3) || (i % 1031),
+  (i % 1033) / 7.0 - 50,
+  (i * 7919) % 100003 - 50000,
+  timestamp '2000-01-01' + (i % 1039) * interval '1 second',
+  date '2000-01-01' + (i % 1049)
+FROM generate_series(1, 100000) i;
+INSERT INTO mksa VALUES (0, 'NaN', NULL, NULL, 'NaN', NULL, NULL, NULL);
+INSERT INTO mksa VALUES (0, 0, '', '', '-Infinity', 0, 'infinity', '-infinity');
+ANALYZE mksa;
+
+-- numeric with both signs, tiny and huge weights, and NaN
+SELECT count(*) FROM (
+  SELECT n, lag(n) OVER w AS pn
+  FROM mksa WINDOW w AS (ORDER BY n)) s
+WHERE pn > n;
+SELECT count(*) FROM (
+  SELECT n, lag(n) OVER w AS pn
+  FROM mksa WINDOW w AS (ORDER BY n DESC)) s
+WHERE pn < n;
+
+-- text and char keys sharing a prefix longer than the key
+SELECT count(*) FROM (
+  SELECT t, a, lag(t) OVER w AS pt, lag(a) OVER w AS pa
+  FROM mksa WINDOW w AS (ORDER BY t, a)) s
+WHERE (pt, pa) > (t, a);
+SELECT count(*) FROM (
+  SELECT c, lag(c) OVER w AS pc
+  FROM mksa WINDOW w AS (ORDER BY c DESC)) s
+WHERE pc < c;
+
+-- float8 with NaN and infinities, bigint, timestamp and date
+SELECT count(*) FROM (
+  SELECT f, lag(f) OVER w AS pf
+  FROM mksa WINDOW w AS (ORDER BY f)) s
+WHERE pf > f;
+SELECT count(*) FROM (
+  SELECT b, ts, d, lag(b) OVER w AS pb, lag(ts) OVER w AS pts, lag(d) OVER w AS pd
+  FROM mksa WINDOW w AS (ORDER BY d, ts DESC, b)) s
+WHERE pd > d OR (pd = d AND (pts < ts OR (pts = ts AND pb > b)));
+
+-- the smallest and largest keys
+SELECT min(n), max(n), min(f), max(f) FROM mksa;
+
+RESET gp_enable_mk_sort;
+RESET statement_mem;
+DROP TABLE mksa;
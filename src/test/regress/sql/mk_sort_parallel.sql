@@ -0,0 +1,47 @@
+--
+-- In-memory multi-key sorts shared with helper threads.  Each query checks
+-- that every row sorts after the one before it.
+--
+SET gp_enable_mk_sort = on;
+SET gp_mk_sort_workers = 4;
+SET statement_mem = '200MB';
+
+CREATE TABLE mksp (a int, b bigint, c float8, t text) DISTRIBUTED BY (a);
+INSERT INTO mksp SELECT i % 1000, (i * 7919) % 100003, (i % 977) / 7.0, 'v' || (i % 313)
+FROM generate_series(1, 400000) i;
+INSERT INTO mksp SELECT NULL, i, NULL, NULL FROM generate_series(1, 101) i;
+ANALYZE mksp;
+
+-- int and bigint keys
+SELECT count(*) FROM (
+  SELECT a, b, lag(a) OVER w AS pa, lag(b) OVER w AS pb
+  FROM mksp WINDOW w AS (ORDER BY a, b)) s
+WHERE (pa, pb) > (a, b);
+
+-- descending float8 key
+SELECT count(*) FROM (
+  SELECT c, lag(c) OVER w AS pc
+  FROM mksp WINDOW w AS (ORDER BY c DESC)) s
+WHERE pc < c;
+
+-- NULLS FIRST and NULLS LAST: the 101 NULL keys must sort at the ends
+SELECT count(*) FROM (
+  SELECT a, b, lag(a) OVER w AS pa, lag(b) OVER w AS pb, row_number() OVER w AS rn
+  FROM mksp WINDOW w AS (ORDER BY a NULLS FIRST, b)) s
+WHERE (pa, pb) > (a, b) OR (a IS NULL) <> (rn <= 101);
+
+SELECT count(*) FROM (
+  SELECT a, lag(a) OVER w AS pa, row_number() OVER w AS rn
+  FROM mksp WINDOW w AS (ORDER BY a DESC NULLS LAST)) s
+WHERE pa < a OR (a IS NULL) <> (rn > 400000);
+
+-- text keys are not sorted by the threads, but must still work
+SELECT count(*) FROM (
+  SELECT t, a, lag(t) OVER w AS pt, lag(a) OVER w AS pa
+  FROM mksp WINDOW w AS (ORDER BY t, a)) s
+WHERE (pt, pa) > (t, a);
+
+RESET gp_enable_mk_sort;
+RESET gp_mk_sort_workers;
+RESET statement_mem;
+DROP TABLE mksp;
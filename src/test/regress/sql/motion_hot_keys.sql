@@ -0,0 +1,76 @@
+--
+-- With gp_motion_split_hot_keys, a hash join whose inputs are both
+-- redistributed on the join key spreads the outer rows of its most common
+-- keys over all segments, and broadcasts the matching inner rows.  Results
+-- must not change, and the split must not be used when the join's output
+-- is expected to stay distributed by the join key.
+--
+create schema motion_hot_keys;
+set search_path to motion_hot_keys;
+
+-- start_ignore
+create language plpythonu;
+-- end_ignore
+
+-- true if a motion of the plan spread rows of a hot key over the segments
+create or replace function motion_hot_keys.split(explain_query text)
+returns bool as
+$$
+import re
+rv = plpy.execute(explain_query)
+for r in rv:
+    m = re.search(r'Spread (\d+) rows of \d+ hot keys', r['QUERY PLAN'])
+    if m and int(m.group(1)) > 0:
+        return True
+return False
+$$
+language plpythonu;
+
+-- key 1 makes up 60% of fact; neither table is distributed by the key, and
+-- both are too large to broadcast
+create table fact (a int, k int) distributed by (a);
+insert into fact select i, case when i % 10 < 6 then 1 else i % 1000 end
+from generate_series(1, 300000) i;
+create table dim (v text, k int) distributed by (v);
+insert into dim select 'd' || i, i from generate_series(1, 200000) i
+where i < 500 or i >= 1000;
+analyze fact;
+analyze dim;
+
+-- start_ignore
+set optimizer = off;
+-- end_ignore
+set enable_nestloop = off;
+set enable_mergejoin = off;
+set gp_motion_split_hot_keys = on;
+
+select motion_hot_keys.split('explain analyze select count(*), sum(length(v)) from fact join dim using (k)');
+select count(*), sum(length(v)) from fact join dim using (k);
+select count(*), count(v) from fact left join dim using (k);
+select count(*) from fact where k in (select k from dim);
+select count(*) from fact where not exists (select 1 from dim where dim.k = fact.k);
+
+-- A cross-type join redistributes the outer rows on k::numeric, whose hash
+-- values the int4 MCVs of k don't give, so nothing is split
+create table dim_n (v text, k numeric) distributed by (v);
+insert into dim_n select v, k from dim;
+analyze dim_n;
+select motion_hot_keys.split('explain analyze select count(*), sum(length(v)) from fact join dim_n using (k)');
+select count(*), sum(length(v)) from fact join dim_n using (k);
+
+-- Grouping by the join key relies on the join's distribution
+select motion_hot_keys.split('explain analyze select k, count(*) from fact join dim using (k) group by k');
+select count(*), sum(n) from (select k, count(*) n from fact join dim using (k) group by k) t;
+select k, count(*) from fact join dim using (k) group by k order by 2 desc, 1 limit 3;
+
+-- The same queries without the split
+set gp_motion_split_hot_keys = off;
+select motion_hot_keys.split('explain analyze select count(*), sum(length(v)) from fact join dim using (k)');
+select count(*), sum(length(v)) from fact join dim using (k);
+select count(*), count(v) from fact left join dim using (k);
+
+reset gp_motion_split_hot_keys;
+reset enable_mergejoin;
+reset enable_nestloop;
+
+drop schema motion_hot_keys cascade;
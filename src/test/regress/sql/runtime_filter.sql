@@ -0,0 +1,91 @@
+--
+-- Runtime join filters: a hash join summarises the keys of its inner side,
+-- and the scan right below it on the outer side drops the rows that cannot
+-- find a match.
+--
+
+-- start_ignore
+CREATE LANGUAGE plpythonu;
+-- end_ignore
+
+-- The runtime filter line of EXPLAIN ANALYZE, with the row counts masked
+CREATE OR REPLACE FUNCTION rf_removed(explain_query text)
+RETURNS text AS
+$$
+import re
+rv = plpy.execute(explain_query)
+for r in rv:
+    m = re.search(r'Runtime filter removed .*', r['QUERY PLAN'])
+    if m:
+        return re.sub(r'[0-9]+(\.[0-9]+)?', 'N', m.group(0))
+return 'no runtime filter'
+$$
+LANGUAGE plpythonu;
+
+SET gp_enable_runtime_filter = on;
+SET enable_nestloop = off;
+SET enable_mergejoin = off;
+
+CREATE TABLE rf_fact (id int, k int, v int) DISTRIBUTED BY (k);
+INSERT INTO rf_fact SELECT i, i % 1000, i FROM generate_series(1, 100000) i;
+INSERT INTO rf_fact VALUES (0, NULL, 0);
+CREATE TABLE rf_fact_ao (id int, k int, v int) WITH (appendonly=true) DISTRIBUTED BY (k);
+INSERT INTO rf_fact_ao SELECT * FROM rf_fact;
+CREATE TABLE rf_fact_co (id int, k int, v int) WITH (appendonly=true, orientation=column) DISTRIBUTED BY (k);
+INSERT INTO rf_fact_co SELECT * FROM rf_fact;
+
+CREATE TABLE rf_dim (k int, name text) DISTRIBUTED BY (k);
+INSERT INTO rf_dim SELECT i, 'dim' || i FROM generate_series(1, 1000, 100) i;
+CREATE TABLE rf_dim_all (k int) DISTRIBUTED BY (k);
+INSERT INTO rf_dim_all SELECT i FROM generate_series(0, 999) i;
+CREATE TABLE rf_dim8 (k bigint) DISTRIBUTED BY (k);
+INSERT INTO rf_dim8 VALUES (1), (101), (5000), (-7);
+CREATE TABLE rf_pairs (id int, k int) DISTRIBUTED BY (k);
+INSERT INTO rf_pairs SELECT id, k FROM rf_fact WHERE id % 7 = 0;
+
+ANALYZE rf_fact;
+ANALYZE rf_fact_ao;
+ANALYZE rf_fact_co;
+ANALYZE rf_dim;
+ANALYZE rf_dim_all;
+ANALYZE rf_dim8;
+ANALYZE rf_pairs;
+
+-- Heap, AO and AOCS scans on the outer side
+SELECT count(*), sum(f.v) FROM rf_fact f JOIN rf_dim d ON f.k = d.k;
+SELECT count(*), sum(f.v) FROM rf_fact_ao f JOIN rf_dim d ON f.k = d.k;
+SELECT count(*), sum(f.v) FROM rf_fact_co f JOIN rf_dim d ON f.k = d.k;
+
+-- A scan with a qual and a projection
+SELECT count(*), sum(f.v + 1) FROM rf_fact f JOIN rf_dim d ON f.k = d.k WHERE f.v > 50000;
+
+-- Semi join
+SELECT count(*) FROM rf_fact f WHERE f.k IN (SELECT k FROM rf_dim);
+
+-- Keys of different integer types
+SELECT count(*) FROM rf_fact f JOIN rf_dim8 d ON f.k = d.k;
+
+-- Two keys, so only the Bloom filter is used
+SELECT count(*) FROM rf_fact f JOIN rf_pairs p ON f.k = p.k AND f.id = p.id;
+
+-- Every outer row has a match; the filter turns itself off
+SELECT count(*) FROM rf_fact f JOIN rf_dim_all d ON f.k = d.k;
+
+-- An outer join keeps every outer row, so it gets no filter
+SELECT count(*), count(d.k) FROM rf_fact f LEFT JOIN rf_dim d ON f.k = d.k;
+
+-- EXPLAIN ANALYZE reports how many outer rows the filter removed
+SELECT rf_removed('EXPLAIN ANALYZE SELECT count(*) FROM rf_fact f JOIN rf_dim d ON f.k = d.k');
+SELECT rf_removed('EXPLAIN ANALYZE SELECT count(*) FROM rf_fact_co f JOIN rf_dim d ON f.k = d.k');
+SELECT rf_removed('EXPLAIN ANALYZE SELECT count(*) FROM rf_fact f JOIN rf_pairs p ON f.k = p.k AND f.id = p.id');
+SELECT rf_removed('EXPLAIN ANALYZE SELECT count(*) FROM rf_fact f JOIN rf_dim_all d ON f.k = d.k');
+SELECT rf_removed('EXPLAIN ANALYZE SELECT count(*), count(d.k) FROM rf_fact f LEFT JOIN rf_dim d ON f.k = d.k');
+
+-- Spill the join to batch files
+SET statement_mem = '1MB';
+SELECT count(*) FROM rf_fact f JOIN rf_pairs p ON f.k = p.k AND f.id = p.id;
+RESET statement_mem;
+
+RESET enable_mergejoin;
+RESET enable_nestloop;
+RESET gp_enable_runtime_filter;
@@ -0,0 +1,46 @@
+--
+-- Cross-slice shared scans pass small results in shared memory and larger
+-- ones through workfiles; both must return the same rows.  The faults
+-- show which path the first segment took.
+--
+-- start_ignore
+CREATE EXTENSION IF NOT EXISTS gp_inject_fault;
+-- end_ignore
+SET gp_cte_sharing = on;
+
+CREATE TABLE ssm (a int, b int, t text) DISTRIBUTED BY (a);
+INSERT INTO ssm SELECT i, i % 100, repeat('x', i % 50) FROM generate_series(1, 20000) i;
+ANALYZE ssm;
+
+-- a small shared result, published to shared memory and read from there
+select gp_inject_fault('shareinput_shmem_publish', 'reset', 2);
+select gp_inject_fault('shareinput_shmem_attach', 'reset', 2);
+select gp_inject_fault('shareinput_shmem_publish', 'skip', 2);
+select gp_inject_fault('shareinput_shmem_attach', 'skip', 2);
+WITH c AS (SELECT b, count(*) AS n FROM ssm GROUP BY b)
+SELECT count(*), sum(c1.n + c2.n) FROM c c1 JOIN c c2 ON c1.b = c2.n % 100;
+select gp_inject_fault('shareinput_shmem_publish', 'status', 2);
+select gp_inject_fault('shareinput_shmem_attach', 'status', 2);
+
+-- an empty one
+WITH c AS (SELECT * FROM ssm WHERE a < 0)
+SELECT count(*) FROM c c1 JOIN c c2 ON c1.a = c2.b;
+
+-- a larger one, also with too little memory to keep it
+WITH c AS (SELECT a, b, t FROM ssm)
+SELECT count(*), sum(length(c1.t)) FROM c c1 JOIN c c2 ON c1.a = c2.b + 1;
+SET statement_mem = '1MB';
+select gp_inject_fault('shareinput_shmem_publish', 'reset', 2);
+select gp_inject_fault('shareinput_shmem_attach', 'reset', 2);
+select gp_inject_fault('shareinput_shmem_publish', 'skip', 2);
+select gp_inject_fault('shareinput_shmem_attach', 'skip', 2);
+WITH c AS (SELECT a, b, t FROM ssm)
+SELECT count(*), sum(length(c1.t)) FROM c c1 JOIN c c2 ON c1.a = c2.b + 1;
+select gp_inject_fault('shareinput_shmem_publish', 'status', 2);
+select gp_inject_fault('shareinput_shmem_attach', 'status', 2);
+select gp_inject_fault('shareinput_shmem_publish', 'reset', 2);
+select gp_inject_fault('shareinput_shmem_attach', 'reset', 2);
+
+RESET statement_mem;
+RESET gp_cte_sharing;
+DROP TABLE ssm;
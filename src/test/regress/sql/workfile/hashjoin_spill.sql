@@ -28,6 +28,21 @@ return result
 $$
 language plpythonu;
 
+-- true if some hash join wrote part of its inner side to batch files
+create or replace function hashjoin_spill.inner_rows_spilled(explain_query text)
+returns bool as
+$$
+import re
+p = re.compile('Inner rows spilled to batch files: (\d+) of (\d+)')
+rv = plpy.execute(explain_query)
+for r in rv:
+    m = p.search(r['QUERY PLAN'])
+    if m and 0 < int(m.group(1)) <= int(m.group(2)):
+        return True
+return False
+$$
+language plpythonu;
+
 CREATE TABLE test_hj_spill (i1 int, i2 int, i3 int, i4 int, i5 int, i6 int, i7 int, i8 int);
 insert into test_hj_spill SELECT i,i,i%1000,i,i,i,i,i from
 	(select generate_series(1, nsegments * 15000) as i from
@@ -51,4 +66,6 @@ select avg(i3) from (SELECT t1.* FROM test_hj_spill AS t1 RIGHT JOIN test_hj_spi
 select * from hashjoin_spill.is_workfile_created('explain (analyze, verbose) SELECT t1.* FROM test_hj_spill AS t1 RIGHT JOIN test_hj_spill AS t2 ON t1.i1=t2.i2');
 select * from hashjoin_spill.is_workfile_created('explain (analyze, verbose) SELECT t1.* FROM test_hj_spill AS t1 RIGHT JOIN test_hj_spill AS t2 ON t1.i1=t2.i2 LIMIT 15000;');
 
+select hashjoin_spill.inner_rows_spilled('explain analyze SELECT t1.* FROM test_hj_spill AS t1 RIGHT JOIN test_hj_spill AS t2 ON t1.i1=t2.i2');
+
 drop schema hashjoin_spill cascade;
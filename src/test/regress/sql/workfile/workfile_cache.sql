@@ -0,0 +1,75 @@
+--
+-- With gp_workfile_caching on, the result of a HashAgg that spilled while
+-- reading append-only tables is kept, and an identical later query reads it
+-- back instead of aggregating again. It must not be reused once the tables
+-- change.
+--
+create schema workfile_cache;
+set search_path to workfile_cache;
+
+-- start_ignore
+create language plpythonu;
+-- end_ignore
+
+-- true if the HashAgg spilled on any segment
+create or replace function workfile_cache.hashagg_spilled(explain_query text)
+returns bool as
+$$
+rv = plpy.execute(explain_query)
+return any('spilling' in r['QUERY PLAN'].lower() for r in rv)
+$$
+language plpythonu;
+
+create table wfc_ao (a int, b int) with (appendonly=true) distributed by (a);
+insert into wfc_ao select i % 150000, i from generate_series(1, 300000) i;
+create table wfc_co (a int, b int) with (appendonly=true, orientation=column) distributed by (a);
+insert into wfc_co select * from wfc_ao;
+create table wfc_heap (a int, b int) distributed by (a);
+insert into wfc_heap select * from wfc_ao;
+
+set enable_groupagg = off;
+set statement_mem = 1800;
+set gp_workfile_caching = on;
+
+-- The first run spills and records its result, the second one replays it
+select workfile_cache.hashagg_spilled('explain analyze select count(*), sum(n), sum(m) from (select a, count(*) n, max(b) m from wfc_ao group by a) s');
+select workfile_cache.hashagg_spilled('explain analyze select count(*), sum(n), sum(m) from (select a, count(*) n, max(b) m from wfc_ao group by a) s');
+select count(*), sum(n), sum(m) from (select a, count(*) n, max(b) m from wfc_ao group by a) s;
+select count(*), sum(n), sum(m) from (select a, count(*) n, max(b) m from wfc_ao group by a) s;
+
+-- Inserts and deletes change the input, so the result is computed again
+insert into wfc_ao values (1, 1000000), (150001, 1);
+select workfile_cache.hashagg_spilled('explain analyze select count(*), sum(n), sum(m) from (select a, count(*) n, max(b) m from wfc_ao group by a) s');
+select count(*), sum(n), sum(m) from (select a, count(*) n, max(b) m from wfc_ao group by a) s;
+delete from wfc_ao where a < 1000;
+select workfile_cache.hashagg_spilled('explain analyze select count(*), sum(n), sum(m) from (select a, count(*) n, max(b) m from wfc_ao group by a) s');
+select count(*), sum(n), sum(m) from (select a, count(*) n, max(b) m from wfc_ao group by a) s;
+truncate wfc_ao;
+select count(*), sum(n), sum(m) from (select a, count(*) n, max(b) m from wfc_ao group by a) s;
+
+-- Column-oriented tables are handled the same way
+select workfile_cache.hashagg_spilled('explain analyze select count(*), sum(n) from (select a, count(*) n from wfc_co group by a) s');
+select workfile_cache.hashagg_spilled('explain analyze select count(*), sum(n) from (select a, count(*) n from wfc_co group by a) s');
+update wfc_co set b = b + 1 where a = 7;
+select count(*), sum(n), sum(m) from (select a, count(*) n, max(b) m from wfc_co group by a) s;
+
+-- Changes of the current transaction may still roll back, so results that see them are not cached
+begin;
+insert into wfc_co values (1, 1);
+select workfile_cache.hashagg_spilled('explain analyze select count(*), sum(n) from (select a, count(*) n from wfc_co group by a) s');
+select workfile_cache.hashagg_spilled('explain analyze select count(*), sum(n) from (select a, count(*) n from wfc_co group by a) s');
+rollback;
+
+-- Heap tables are never cached
+select workfile_cache.hashagg_spilled('explain analyze select count(*), sum(n) from (select a, count(*) n from wfc_heap group by a) s');
+select workfile_cache.hashagg_spilled('explain analyze select count(*), sum(n) from (select a, count(*) n from wfc_heap group by a) s');
+
+-- Nor is anything when caching is off
+set gp_workfile_caching = off;
+select workfile_cache.hashagg_spilled('explain analyze select count(*), sum(n) from (select a, count(*) n from wfc_co group by a) s');
+
+reset gp_workfile_caching;
+reset statement_mem;
+reset enable_groupagg;
+
+drop schema workfile_cache cascade;